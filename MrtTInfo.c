@@ -1,12 +1,14 @@
-#include <windows.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <wchar.h>
-#include "MrtTInfo.h"
+#include "MrtTInfoInternal.h"
 
+#ifdef _WIN32
 static ULONG CountTLSSlots(PVOID tlsPointer);
+#endif
 
 // --- Main API ---
+#ifdef _WIN32
 static DWORD WrapGetCurrentProcessorNumber() {
     static PFN_GetCurrentProcessorNumber pFunc = NULL;
     if (!pFunc) {
@@ -17,6 +19,7 @@ static DWORD WrapGetCurrentProcessorNumber() {
     }
     return pFunc();
 }
+#endif
 
 void MrtHelper_PrintSEHChain(PVOID exceptionList)
 {
@@ -62,23 +65,20 @@ void MrtHelper_PrintModules(PEB_LDR_DATA* ldr)
     }
 }
 
+#ifdef _WIN32
 static BOOL MrtTInfo_QueryCurrentThreadLive(MRT_THREAD_INFO* out)
 {
     if (!out)
         return FALSE;
 
-    PFN_NtQueryInformationThread NtQueryInformationThread =
-        (PFN_NtQueryInformationThread)GetProcAddress(
-            GetModuleHandleW(L"ntdll.dll"),
-            "NtQueryInformationThread"
-        );
-    if (!NtQueryInformationThread)
+    const MRT_NTAPI* nt = NULL;
+    if (!NT_SUCCESS(MrtNt_Resolve(&nt)))
         return FALSE;
 
     THREAD_BASIC_INFORMATION tbi;
     ZeroMemory(&tbi, sizeof(tbi));
 
-    NTSTATUS status = NtQueryInformationThread(
+    NTSTATUS status = nt->NtQueryInformationThread(
         GetCurrentThread(),
         ThreadBasicInformation,
         &tbi,
@@ -115,11 +115,6 @@ static BOOL MrtTInfo_QueryCurrentThreadLive(MRT_THREAD_INFO* out)
     if (out->PebAddress) {
         memcpy(&peb, out->PebAddress, sizeof(PEB_PARTIAL));
 
-        if (peb.Ldr) {
-            PEB_LDR_DATA* ldr = (PEB_LDR_DATA*)peb.Ldr;
-            MrtHelper_PrintModules(ldr);
-        }
-
         out->PebBeingDebugged = peb.BeingDebugged;
         out->PebSessionId    = peb.SessionId;
         out->PebLdr = peb.Ldr;
@@ -147,6 +142,7 @@ static BOOL MrtTInfo_QueryCurrentThreadLive(MRT_THREAD_INFO* out)
 
     return TRUE;
 }
+#endif
 
 BOOL MrtTInfo_QueryProcessPEB(MRT_PROCESS_INFO* proc)
 {
@@ -188,59 +184,7 @@ BOOL MrtTInfo_QueryProcessPEB(MRT_PROCESS_INFO* proc)
     return TRUE;
 }
 
-const char* MrtHelper_ThreadStateToString(ULONG state) {
-    switch (state) {
-        case 0: return "Initialized";
-        case 1: return "Ready";
-        case 2: return "Running";
-        case 3: return "Standby";
-        case 4: return "Terminated";
-        case 5: return "Waiting";
-        case 6: return "Transition";
-        case 7: return "Unknown"; // Rare, reserved
-        case 8: return "Waiting (Suspended)";
-        case 9: return "UserRequest";
-        case 10: return "Unknown";
-        case 11: return "DeferredReady";
-        case 12: return "WaitingForCompletion";
-        case 13: return "WaitingForDispatch";
-        case 14: return "WaitingForExecution";
-        case 15: return "WaitingForResource";
-        case 16: return "WaitingForTimer";
-        case 23: return "Suspended";
-        case 27: return "WaitingForEvent";
-        default: return "Unknown";
-    }
-}
-
-const char* MrtHelper_WaitReasonToString(ULONG reason) {
-    switch (reason) {
-        case 0: return "Executive";
-        case 1: return "FreePage";
-        case 2: return "PageIn";
-        case 3: return "PoolAllocation";
-        case 4: return "ExecutionDelay";
-        case 5: return "Suspended";
-        case 6: return "UserRequest";
-        case 7: return "EventPairHigh";
-        case 8: return "EventPairLow";
-        case 9: return "LpcReceive";
-        case 10: return "LpcReply";
-        case 11: return "VirtualMemory";
-        case 12: return "PageOut";
-        case 13: return "Unknown";
-        case 14: return "SuspendedExecution";
-        case 15: return "DelayExecution";
-        case 16: return "QueueWait";
-        case 17: return "Unknown";
-        case 18: return "LpcReplyMessage";
-        case 31: return "Unknown";
-        case 42: return "Timer";
-        case 91: return "WaitForLoaderLock";
-        default: return "Other";
-    }
-}
-
+#ifdef _WIN32
 // Walk TLS slots and count how many are actually used
 static ULONG CountTLSSlots(PVOID tlsPointer)
 {
@@ -257,91 +201,536 @@ static ULONG CountTLSSlots(PVOID tlsPointer)
     }
     return count;
 }
+#endif
 
-NTSTATUS MrtTInfo_GetAllProcesses(MRT_PROCESS_INFO** Processes, ULONG* Count)
+void* MrtBuild_Alloc(MRT_BUILD* build, SIZE_T size)
 {
-    if (!Processes || !Count)
+    MRT_STAT_ADD(build, Allocations, 1);
+    MRT_STAT_ADD(build, BytesAllocated, size);
+    if (build && build->Arena)
+        return MrtArena_Alloc(build->Arena, size);
+    return calloc(1, size);
+}
+
+wchar_t* MrtBuild_CopyUnicodeString(MRT_BUILD* build, const UNICODE_STRING* ustr)
+{
+    if (!ustr || !ustr->Buffer || ustr->Length == 0) return NULL;
+    size_t len = ustr->Length / sizeof(WCHAR);
+    wchar_t* str = (wchar_t*)MrtBuild_Alloc(build, (len + 1) * sizeof(WCHAR));
+    if (!str) return NULL;
+    MRT_STAT_ADD(build, StringsCopied, 1);
+    memcpy(str, ustr->Buffer, len * sizeof(WCHAR));
+    str[len] = L'\0';
+    return str;
+}
+
+ULONG MrtUtf8_ToWchar(const char* src, ULONG length, WCHAR* out)
+{
+    ULONG n = 0;
+    for (ULONG i = 0; i < length;) {
+        unsigned char c = (unsigned char)src[i];
+        ULONG cp = 0xFFFD;
+        ULONG extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+
+        if (c < 0x80) {
+            cp = c;
+            i++;
+        } else if (c >= 0xC0 && c < 0xF8 && i + extra < length) {
+            ULONG value = c & (0x3F >> extra);
+            ULONG k = 1;
+            for (; k <= extra && ((unsigned char)src[i + k] & 0xC0) == 0x80; k++)
+                value = (value << 6) | ((unsigned char)src[i + k] & 0x3F);
+            if (k > extra)
+                cp = value;
+            i += k;
+        } else {
+            i++;
+        }
+
+        if (sizeof(WCHAR) == 2 && cp > 0xFFFF) {
+            cp -= 0x10000;
+            if (out) {
+                out[n] = (WCHAR)(0xD800 + (cp >> 10));
+                out[n + 1] = (WCHAR)(0xDC00 + (cp & 0x3FF));
+            }
+            n += 2;
+        } else {
+            if (out)
+                out[n] = (WCHAR)cp;
+            n++;
+        }
+    }
+    return n;
+}
+
+NTSTATUS MrtNt_Resolve(const MRT_NTAPI** Api)
+{
+    // Entry points never move for the life of the process, resolve them once.
+    // Concurrent first calls race benignly: they store identical values.
+    static MRT_NTAPI api;
+    static volatile LONG resolved = 0;
+
+    if (!Api)
         return STATUS_INVALID_PARAMETER;
 
-    *Processes = NULL;
-    *Count = 0;
+#ifndef _WIN32
+    (void)api;
+    (void)resolved;
+    *Api = NULL;
+    return STATUS_NOT_SUPPORTED;
+#else
+    if (!resolved) {
+        HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+        if (!ntdll)
+            return STATUS_DLL_NOT_FOUND;
+
+        api.NtQuerySystemInformation =
+            (PFN_NTQUERYSYSTEMINFORMATION)GetProcAddress(
+                ntdll, "NtQuerySystemInformation");
+
+        api.NtQueryInformationThread =
+            (PFN_NtQueryInformationThread)GetProcAddress(
+                ntdll, "NtQueryInformationThread");
+
+        if (!api.NtQuerySystemInformation || !api.NtQueryInformationThread)
+            return STATUS_PROCEDURE_NOT_FOUND;
+
+        resolved = 1;
+    }
+
+    *Api = &api;
+    return STATUS_SUCCESS;
+#endif
+}
 
-    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
-    if (!ntdll)
-        return STATUS_DLL_NOT_FOUND;
+// ntdll provider: the live SystemProcessInformation query
+static NTSTATUS MrtNt_ProviderQuery(void* Context, void* Buffer, ULONG Capacity, ULONG* Needed)
+{
+    (void)Context;
 
-    PFN_NTQUERYSYSTEMINFORMATION NtQuerySystemInformation =
-        (PFN_NTQUERYSYSTEMINFORMATION)GetProcAddress(
-            ntdll, "NtQuerySystemInformation");
+    const MRT_NTAPI* api = NULL;
+    NTSTATUS status = MrtNt_Resolve(&api);
+    if (!NT_SUCCESS(status))
+        return status;
 
-    PFN_NtQueryInformationThread NtQueryInformationThread =
-        (PFN_NtQueryInformationThread)GetProcAddress(
-            ntdll, "NtQueryInformationThread");
+    return api->NtQuerySystemInformation(MrtSystemProcessInformation, Buffer, Capacity, Needed);
+}
 
-    if (!NtQuerySystemInformation || !NtQueryInformationThread)
-        return STATUS_PROCEDURE_NOT_FOUND;
+static const MRT_PROVIDER g_NtProvider = { "ntdll", MrtNt_ProviderQuery, NULL, TRUE };
+
+const MRT_PROVIDER* MrtTInfo_GetDefaultProvider(void)
+{
+#ifdef _WIN32
+    return &g_NtProvider;
+#else
+    (void)g_NtProvider;
+    return MrtTInfo_GetProcfsProvider();
+#endif
+}
+
+NTSTATUS MrtProvider_Query(const MRT_PROVIDER* provider, MRT_QUERY_BUFFER* qb)
+{
+    if (!qb)
+        return STATUS_INVALID_PARAMETER;
+    if (!provider)
+        return STATUS_NOT_SUPPORTED;
 
-    ULONG bufferSize = 0x10000;
-    MRT_SYSTEM_PROCESS_INFORMATION* buffer = NULL;
     NTSTATUS status;
+    ULONG needed = 0;
+    qb->Length = 0;
+    qb->Retries = 0;
+
+    for (;;) {
+        if (!qb->Data) {
+            if (qb->Capacity < MRT_QUERY_BUFFER_INITIAL)
+                qb->Capacity = MRT_QUERY_BUFFER_INITIAL;
+            qb->Data = malloc(qb->Capacity);
+            if (!qb->Data) {
+                qb->Capacity = 0;
+                return STATUS_NO_MEMORY;
+            }
+        }
+
+        needed = 0;
+        status = provider->Query(provider->Context, qb->Data, qb->Capacity, &needed);
+
+        if (status != STATUS_INFO_LENGTH_MISMATCH)
+            break;
+        qb->Retries++;
+
+        // Grow with headroom so processes spawned between the two calls
+        // (and the next few refreshes) still fit. The buffer never shrinks.
+        ULONG grown = qb->Capacity * 2;
+        ULONG wanted = needed + needed / 4 + MRT_QUERY_BUFFER_HEADROOM;
+        free(qb->Data);
+        qb->Data = NULL;
+        qb->Capacity = grown > wanted ? grown : wanted;
+    }
+
+    if (NT_SUCCESS(status))
+        qb->Length = (needed && needed <= qb->Capacity) ? needed : qb->Capacity;
+    return status;
+}
 
-    do {
-        buffer = (MRT_SYSTEM_PROCESS_INFORMATION*)malloc(bufferSize);
-        if (!buffer)
+void MrtNt_FreeQueryBuffer(MRT_QUERY_BUFFER* qb)
+{
+    if (!qb)
+        return;
+    free(qb->Data);
+    qb->Data = NULL;
+    qb->Capacity = 0;
+    qb->Length = 0;
+}
+
+#ifdef _WIN32
+// Per-thread TEB / start address / PEB / affinity enrichment (live system only).
+// counts belongs to the calling worker.
+static void MrtTInfo_EnrichThread(MRT_BUILD* build, MRT_PROCESS_INFO* mp, MRT_THREAD_INFO* mt,
+                                  MRT_HANDLE_ENTRY* cached, MRT_STATS_COUNTERS* counts)
+{
+    PFN_NtQueryInformationThread NtQueryInformationThread =
+        build->Nt->NtQueryInformationThread;
+    ULONG flags = build->Flags;
+
+    // --- TEB extraction ---
+    HANDLE hThread;
+    if (cached && cached->Opened) {
+        hThread = cached->Handle;
+        MRT_STAT(counts->HandlesReused++);
+    } else {
+        hThread = OpenThread(THREAD_QUERY_INFORMATION, FALSE, mt->TID);
+        MRT_STAT(if (hThread) counts->HandlesOpened++; else counts->HandlesFailed++);
+        if (cached) {
+            cached->Handle = hThread;
+            cached->Opened = TRUE;
+        }
+    }
+
+    if (hThread) {
+        BOOL basicOk = TRUE;
+        if (flags & MRT_QUERY_TEB) {
+            THREAD_BASIC_INFORMATION tbi;
+            MRT_STAT(counts->EnrichCalls++);
+            basicOk = NT_SUCCESS(
+                NtQueryInformationThread(
+                    hThread,
+                    ThreadBasicInformation,
+                    &tbi,
+                    sizeof(tbi),
+                    NULL));
+            if (basicOk)
+                mt->TebAddress = tbi.TebBaseAddress;
+        }
+
+        if (basicOk)
+        {
+            if (flags & MRT_QUERY_START_ADDRESS) {
+                PVOID startAddr = NULL;
+                MRT_STAT(counts->EnrichCalls++);
+                if (NT_SUCCESS(NtQueryInformationThread(
+                        hThread,
+                        9,
+                        &startAddr,
+                        sizeof(startAddr),
+                        NULL)))
+                {
+                    mt->StartAddress = startAddr;
+                }
+            }
+
+            if (mt->TebAddress && mp->PID == GetCurrentProcessId())
+            {
+                TEB_PARTIAL* teb =
+                    (TEB_PARTIAL*)mt->TebAddress;
+
+                mt->StackBase      = teb->NtTib.StackBase;
+                mt->StackLimit     = teb->NtTib.StackLimit;
+                mt->TlsPointer     = teb->ThreadLocalStoragePointer;
+                mt->PebAddress     = teb->ProcessEnvironmentBlock;
+                mt->LastErrorValue = teb->LastErrorValue;
+                mt->ArbitraryUserPointer          = teb->NtTib.ArbitraryUserPointer;
+                mt->CountOfOwnedCriticalSections  = teb->CountOfOwnedCriticalSections;
+                mt->Win32ThreadInfo               = teb->Win32ThreadInfo;
+                mt->TLSSlotCount = CountTLSSlots(mt->TlsPointer);
+                mt->ExceptionList = teb->NtTib.ExceptionList;
+                mt->SubSystemTib  = teb->SubSystemTib;
+                mt->Self = mt->TebAddress;
+            }
+
+                if (mt->PebAddress && (flags & MRT_QUERY_PEB)) {
+                    PEB_PARTIAL* peb = (PEB_PARTIAL*)mt->PebAddress;
+
+                    mt->PebBeingDebugged = peb->BeingDebugged;
+                    mt->PebSessionId     = peb->SessionId;
+
+                    // --- Loader info ---
+                    if (peb->Ldr) {
+                        mt->PebLdr = peb->Ldr;
+                        PEB_LDR_DATA* ldr = (PEB_LDR_DATA*)peb->Ldr;
+                        mt->PebLdr_EntryInProgress = ldr->EntryInProgress;
+                    }
+
+                    // --- Shutdown info ---
+                    mt->ShutdownInProgress = peb->ShutdownInProgress;
+                    mt->ShutdownThreadId   = peb->ShutdownThreadId;
+
+                    // Process parameters are copied by MrtTInfo_CaptureProcessStrings
+                    // once all workers are done: allocation is single-threaded.
+                }
+
+            // ---------------- CPU / Affinity info ----------------
+            // Query-only classes on the handle already open: scheduling state
+            // is never modified, and threads of other processes work as well.
+            if (flags & MRT_QUERY_AFFINITY) {
+                GROUP_AFFINITY group;
+                MRT_STAT(counts->EnrichCalls += 2);
+                if (NT_SUCCESS(NtQueryInformationThread(
+                        hThread, MRT_THREAD_GROUP_INFORMATION, &group, sizeof(group), NULL))) {
+                    mt->AffinityMask = group.Mask;
+                    mt->ProcessorGroup = group.Group;
+                }
+
+                PROCESSOR_NUMBER ideal;
+                if (NT_SUCCESS(NtQueryInformationThread(
+                        hThread, MRT_THREAD_IDEAL_PROCESSOR_EX, &ideal, sizeof(ideal), NULL))) {
+                    mt->IdealProcessor = ideal.Number;
+                }
+
+                if (mt->TID == build->CallerTid)
+                    mt->CurrentProcessor = build->CallerProcessor;
+            }
+
+        }
+        if (!cached)
+            CloseHandle(hThread);
+    } else {
+        MRT_STAT(counts->EnrichSkipped++);
+    }
+}
+
+// Command line / image path, copied once per process: every thread of a
+// process shares its PEB, so the threads only point at the process copy
+static void MrtTInfo_CaptureProcessStrings(MRT_BUILD* build, MRT_PROCESS_INFO* mp)
+{
+    // Other processes' PEBs are only reachable through the remote pass
+    if (!(build->Flags & MRT_QUERY_PEB_STRINGS) || mp->PID != GetCurrentProcessId())
+        return;
+
+    PEB_PARTIAL* peb = NULL;
+    for (ULONG t = 0; t < mp->ThreadCount && !peb; t++)
+        peb = (PEB_PARTIAL*)mp->Threads[t].PebAddress;
+    if (!peb)
+        return;
+
+    mp->PebAddress = peb;
+
+    // --- Process parameters ---
+    if (peb->ProcessParameters) {
+        RTL_USER_PROCESS_PARAMETERS* params =
+            (RTL_USER_PROCESS_PARAMETERS*)peb->ProcessParameters;
+
+        mp->PebCommandLine =
+            MrtBuild_CopyUnicodeString(build, &params->CommandLine);
+        mp->PebImagePath =
+            MrtBuild_CopyUnicodeString(build, &params->ImagePathName);
+    }
+
+    for (ULONG t = 0; t < mp->ThreadCount; t++) {
+        MRT_THREAD_INFO* mt = &mp->Threads[t];
+        if (mt->PebAddress == peb) {
+            mt->PebCommandLine = mp->PebCommandLine;
+            mt->PebImagePath = mp->PebImagePath;
+        }
+    }
+}
+
+typedef struct _MRT_ENRICH_JOB {
+    MRT_BUILD* Build;
+    MRT_ENRICH_ITEM* Items;
+} MRT_ENRICH_JOB;
+
+static void MrtTInfo_EnrichRange(void* ctx, ULONG begin, ULONG end)
+{
+    MRT_ENRICH_JOB* job = (MRT_ENRICH_JOB*)ctx;
+    MRT_STATS_COUNTERS counts;
+    MRT_STAT(memset(&counts, 0, sizeof(counts)));
+    for (ULONG i = begin; i < end; i++)
+        MrtTInfo_EnrichThread(job->Build, job->Items[i].Process, job->Items[i].Thread, job->Items[i].Handle, &counts);
+
+    // Chunks of other workers merge into the same frame
+    MRT_STAT(if (job->Build->Stats) MrtStats_Merge(&job->Build->Stats->Counts, &counts));
+}
+
+// Enrichment phase: every thread is an independent work item writing only
+// to its own MRT_THREAD_INFO slot, so the pool needs no output locking and
+// the result does not depend on the worker count.
+static NTSTATUS MrtTInfo_EnrichAll(MRT_BUILD* build, MRT_PROCESS_INFO* procs, ULONG count)
+{
+    ULONG total = 0;
+    for (ULONG i = 0; i < count; i++)
+        total += procs[i].ThreadCount;
+    if (total == 0)
+        return STATUS_SUCCESS;
+
+    MRT_ENRICH_ITEM* items = NULL;
+    BOOL ownItems = FALSE;
+
+    if (build->Scratch) {
+        if (build->Scratch->Capacity < total) {
+            ULONG cap = total + total / 4;
+            MRT_ENRICH_ITEM* grown = (MRT_ENRICH_ITEM*)malloc(cap * sizeof(MRT_ENRICH_ITEM));
+            if (!grown)
+                return STATUS_NO_MEMORY;
+            free(build->Scratch->Items);
+            build->Scratch->Items = grown;
+            build->Scratch->Capacity = cap;
+        }
+        items = build->Scratch->Items;
+    } else {
+        items = (MRT_ENRICH_ITEM*)malloc(total * sizeof(MRT_ENRICH_ITEM));
+        if (!items)
             return STATUS_NO_MEMORY;
+        ownItems = TRUE;
+    }
 
-        status = NtQuerySystemInformation(
-            MrtSystemProcessInformation,
-            buffer,
-            bufferSize,
-            &bufferSize
-        );
+    // Cache slots are claimed here, before the workers start; without memory
+    // for the table this build simply runs uncached.
+    MRT_HANDLE_CACHE* handles = build->Handles;
+    if (handles && !NT_SUCCESS(MrtHandles_Begin(handles, total)))
+        handles = NULL;
 
-        if (status == STATUS_INFO_LENGTH_MISMATCH) {
-            free(buffer);
-            buffer = NULL;
+    ULONG n = 0;
+    for (ULONG i = 0; i < count; i++) {
+        for (ULONG t = 0; t < procs[i].ThreadCount; t++) {
+            MRT_THREAD_INFO* mt = &procs[i].Threads[t];
+            items[n].Process = &procs[i];
+            items[n].Thread = mt;
+            items[n].Handle = handles
+                ? MrtHandles_Claim(handles, mt->TID, MrtFileTimeToU64(&mt->CreateTime)) : NULL;
+            n++;
         }
-    } while (status == STATUS_INFO_LENGTH_MISMATCH);
+    }
 
-    if (!NT_SUCCESS(status))
-        return status;
+    // Workers are not the caller: its own record is recognized by the TID
+    // taken here, whichever worker picks it up
+    build->CallerTid = GetCurrentThreadId();
+    build->CallerProcessor = (build->Flags & MRT_QUERY_AFFINITY)
+        ? WrapGetCurrentProcessorNumber() : (ULONG)-1;
+
+    MRT_STAT(ULONGLONG t0 = MrtPlatform_NowNs());
+    MRT_ENRICH_JOB job = { build, items };
+    MrtPool_Run(build->Pool, n, MRT_ENRICH_CHUNK, MrtTInfo_EnrichRange, &job);
+
+    if (handles)
+        MrtHandles_End(handles);
+    MRT_STAT(MrtStats_Phase(build->Stats, MRT_PHASE_ENRICH, t0));
+
+    // Remote reads and string copies allocate: single-threaded, after the workers
+    if (build->Reader && (build->Flags & MRT_QUERY_REMOTE)) {
+        MRT_REMOTE_STATS remote;
+        memset(&remote, 0, sizeof(remote));
+        MRT_STAT(t0 = MrtPlatform_NowNs());
+        MrtRemote_ReadAll(build, procs, count, GetCurrentProcessId(), &remote);
+        MRT_STAT(MrtStats_Phase(build->Stats, MRT_PHASE_REMOTE, t0));
+        MRT_STAT_ADD(build, RemoteReads, remote.Reads);
+        MRT_STAT_ADD(build, RemoteFailures, remote.Failures);
+    }
+
+    MRT_STAT(t0 = MrtPlatform_NowNs());
+    for (ULONG i = 0; i < count; i++)
+        MrtTInfo_CaptureProcessStrings(build, &procs[i]);
+    MRT_STAT(MrtStats_Phase(build->Stats, MRT_PHASE_STRINGS, t0));
+
+    if (ownItems)
+        free(items);
+    return STATUS_SUCCESS;
+}
+#endif
 
-    // Count processes
+NTSTATUS MrtTInfo_BuildFromBuffer(
+    MRT_BUILD* build,
+    const MRT_SYSTEM_PROCESS_INFORMATION* buffer,
+    MRT_PROCESS_INFO** Processes,
+    ULONG* Count
+)
+{
+    if (!build || !buffer || !Processes || !Count)
+        return STATUS_INVALID_PARAMETER;
+
+    *Processes = NULL;
+    *Count = 0;
+    MRT_STAT(ULONGLONG t0 = MrtPlatform_NowNs());
+
+#ifdef _WIN32
+    // No entry points (replayed buffer): counters only
+    PFN_NtQueryInformationThread NtQueryInformationThread =
+        build->Nt ? build->Nt->NtQueryInformationThread : NULL;
+#endif
+
+    // Count processes (the filter sees raw entries, nothing is copied yet).
+    // A filtered build keeps the offsets of the matching entries, so the
+    // filter runs once per entry and the fill pass visits only those.
+    ULONG localMatches[MRT_MATCH_STACK];
+    ULONG* matches = build->Filter ? localMatches : NULL;
+    ULONG matchCapacity = MRT_MATCH_STACK;
     ULONG processCount = 0;
-    MRT_SYSTEM_PROCESS_INFORMATION* p = buffer;
+    const MRT_SYSTEM_PROCESS_INFORMATION* p = buffer;
     while (1) {
-        processCount++;
+        if (!matches) {
+            processCount++;
+        } else if (MrtFilter_Match(build->Filter, p)) {
+            if (processCount == matchCapacity) {
+                ULONG* grown = (ULONG*)malloc((SIZE_T)matchCapacity * 2 * sizeof(ULONG));
+                if (!grown) {
+                    if (matches != localMatches)
+                        free(matches);
+                    return STATUS_NO_MEMORY;
+                }
+                memcpy(grown, matches, (SIZE_T)processCount * sizeof(ULONG));
+                if (matches != localMatches)
+                    free(matches);
+                matches = grown;
+                matchCapacity *= 2;
+            }
+            matches[processCount++] = (ULONG)((const BYTE*)p - (const BYTE*)buffer);
+        }
         if (!p->NextEntryOffset)
             break;
-        p = (MRT_SYSTEM_PROCESS_INFORMATION*)((BYTE*)p + p->NextEntryOffset);
+        p = (const MRT_SYSTEM_PROCESS_INFORMATION*)((const BYTE*)p + p->NextEntryOffset);
     }
 
-    MRT_PROCESS_INFO* procArray =
-        (MRT_PROCESS_INFO*)calloc(processCount, sizeof(MRT_PROCESS_INFO));
+    MRT_PROCESS_INFO* procArray = NULL;
+    if (processCount)
+        procArray = (MRT_PROCESS_INFO*)MrtBuild_Alloc(build, processCount * sizeof(MRT_PROCESS_INFO));
     if (!procArray) {
-        free(buffer);
-        return STATUS_NO_MEMORY;
+        if (matches != localMatches)
+            free(matches);
+        return processCount ? STATUS_NO_MEMORY : STATUS_SUCCESS;
     }
 
+    // Image names are interned; without a long-lived pool they are still
+    // shared within this snapshot
+    MRT_STRING_POOL* strings = build->Strings ? build->Strings : MrtIntern_CreateInBuild(build, processCount);
+    if (strings)
+        MrtIntern_Begin(strings, processCount);
+
     // Fill process info
     p = buffer;
     for (ULONG i = 0; i < processCount; i++) {
+        if (matches)
+            p = (const MRT_SYSTEM_PROCESS_INFORMATION*)((const BYTE*)buffer + matches[i]);
         MRT_PROCESS_INFO* mp = &procArray[i];
 
         mp->PID       = (DWORD)(ULONG_PTR)p->UniqueProcessId;
         mp->ParentPID = (DWORD)(ULONG_PTR)p->InheritedFromUniqueProcessId;
 
-        // FIX: deep-copy ImageName so it survives free(buffer) below
-        mp->ImageName.Length        = p->ImageName.Length;
-        mp->ImageName.MaximumLength = p->ImageName.Length + sizeof(WCHAR);
-        if (p->ImageName.Buffer && p->ImageName.Length > 0) {
-            mp->ImageName.Buffer = (PWSTR)malloc(mp->ImageName.MaximumLength);
-            if (mp->ImageName.Buffer) {
-                memcpy(mp->ImageName.Buffer, p->ImageName.Buffer, p->ImageName.Length);
-                mp->ImageName.Buffer[p->ImageName.Length / sizeof(WCHAR)] = L'\0';
-            }
-        } else {
-            mp->ImageName.Buffer = NULL;
+        // Interned copy, never the raw buffer: heap and arena builds share one
+        // copy per distinct name within this snapshot (freed with it); a
+        // collector's owning pool keeps names across refreshes
+        mp->ImageName.Buffer = MrtIntern_Get(strings, build, p->ImageName.Buffer, p->ImageName.Length);
+        if (mp->ImageName.Buffer) {
+            mp->ImageName.Length        = p->ImageName.Length;
+            mp->ImageName.MaximumLength = p->ImageName.Length + sizeof(WCHAR);
         }
 
         LARGE_INTEGER_TO_FILETIME u;
@@ -366,10 +755,12 @@ NTSTATUS MrtTInfo_GetAllProcesses(MRT_PROCESS_INFO** Processes, ULONG* Count)
         mp->ThreadCount = p->NumberOfThreads;
         if (mp->ThreadCount) {
             mp->Threads = (MRT_THREAD_INFO*)
-                calloc(mp->ThreadCount, sizeof(MRT_THREAD_INFO));
+                MrtBuild_Alloc(build, mp->ThreadCount * sizeof(MRT_THREAD_INFO));
+            if (!mp->Threads)
+                mp->ThreadCount = 0;
 
             for (ULONG t = 0; t < mp->ThreadCount; t++) {
-                MRT_SYSTEM_THREAD_INFORMATION* st = &p->Threads[t];
+                const MRT_SYSTEM_THREAD_INFORMATION* st = &p->Threads[t];
                 MRT_THREAD_INFO* mt = &mp->Threads[t];
 
                 mt->TID       = (DWORD)(ULONG_PTR)st->ClientId.UniqueThread;
@@ -388,156 +779,232 @@ NTSTATUS MrtTInfo_GetAllProcesses(MRT_PROCESS_INFO** Processes, ULONG* Count)
                 mt->StartAddress = st->StartAddress;
                 mt->TebAddress = NULL;
 
-                // --- TEB extraction ---
-                HANDLE hThread =
-                    OpenThread(THREAD_QUERY_INFORMATION, FALSE, mt->TID);
-
-                if (hThread) {
-                    THREAD_BASIC_INFORMATION tbi;
-                    if (NT_SUCCESS(
-                        NtQueryInformationThread(
-                            hThread,
-                            ThreadBasicInformation,
-                            &tbi,
-                            sizeof(tbi),
-                            NULL)))
-                    {
-                        mt->TebAddress = tbi.TebBaseAddress;
-
-                        PVOID startAddr = NULL;
-                        if (NT_SUCCESS(NtQueryInformationThread(
-                                hThread,
-                                9,
-                                &startAddr,
-                                sizeof(startAddr),
-                                NULL)))
-                        {
-                            mt->StartAddress = startAddr;
-                        }
-
-                        if (mt->TebAddress && mp->PID == GetCurrentProcessId())
-                        {
-                            TEB_PARTIAL* teb =
-                                (TEB_PARTIAL*)mt->TebAddress;
-
-                            mt->StackBase      = teb->NtTib.StackBase;
-                            mt->StackLimit     = teb->NtTib.StackLimit;
-                            mt->TlsPointer     = teb->ThreadLocalStoragePointer;
-                            mt->PebAddress     = teb->ProcessEnvironmentBlock;
-                            mt->LastErrorValue = teb->LastErrorValue;
-                            mt->ArbitraryUserPointer          = teb->NtTib.ArbitraryUserPointer;
-                            mt->CountOfOwnedCriticalSections  = teb->CountOfOwnedCriticalSections;
-                            mt->Win32ThreadInfo               = teb->Win32ThreadInfo;
-                            mt->TLSSlotCount = CountTLSSlots(mt->TlsPointer);
-                            mt->ExceptionList = teb->NtTib.ExceptionList;
-                            mt->SubSystemTib  = teb->SubSystemTib;
-                            mt->Self = mt->TebAddress;
-                        }
-
-                            if (mt->PebAddress) {
-                                PEB_PARTIAL* peb = (PEB_PARTIAL*)mt->PebAddress;
-
-                                mt->PebBeingDebugged = peb->BeingDebugged;
-                                mt->PebSessionId     = peb->SessionId;
-
-                                // --- Loader info ---
-                                if (peb->Ldr) {
-                                    mt->PebLdr = peb->Ldr;
-                                    PEB_LDR_DATA* ldr = (PEB_LDR_DATA*)peb->Ldr;
-                                    mt->PebLdr_EntryInProgress = ldr->EntryInProgress;
-                                }
-
-                                // --- Shutdown info ---
-                                mt->ShutdownInProgress = peb->ShutdownInProgress;
-                                mt->ShutdownThreadId   = peb->ShutdownThreadId;
-
-                                // --- Process parameters ---
-                                if (peb->ProcessParameters) {
-                                    RTL_USER_PROCESS_PARAMETERS* params =
-                                        (RTL_USER_PROCESS_PARAMETERS*)peb->ProcessParameters;
-
-                                    mt->PebCommandLine =
-                                        MrtTInfo_UnicodeStringToWString(&params->CommandLine);
-                                    mt->PebImagePath =
-                                        MrtTInfo_UnicodeStringToWString(&params->ImagePathName);
-                                }
-                            }
-
-                        // ---------------- CPU / Affinity info ----------------
-                        if (mt->ParentPID == GetCurrentProcessId()) {
-                            HANDLE hQueryThread = OpenThread(
-                                THREAD_QUERY_INFORMATION | THREAD_SET_INFORMATION,
-                                FALSE,
-                                mt->TID
-                            );
-
-                            if (hQueryThread) {
-                                // ----- Affinity -----
-                                DWORD_PTR oldAffinity = SetThreadAffinityMask(hQueryThread, (DWORD_PTR)-1);
-                                if (oldAffinity != 0) {
-                                    mt->AffinityMask = oldAffinity;
-                                    SetThreadAffinityMask(hQueryThread, oldAffinity);
-                                } else {
-                                    mt->AffinityMask = 0;
-                                }
-
-                                // ----- Ideal Processor -----
-                                DWORD oldIdeal = SetThreadIdealProcessor(hQueryThread, MAXIMUM_PROCESSORS);
-                                if (oldIdeal != (DWORD)-1) {
-                                    mt->IdealProcessor = oldIdeal;
-                                    SetThreadIdealProcessor(hQueryThread, oldIdeal);
-                                } else {
-                                    mt->IdealProcessor = 0;
-                                }
-                        
-                                // ----- Current CPU -----
-                                if (GetCurrentThreadId() == mt->TID) {
-                                    mt->CurrentProcessor = WrapGetCurrentProcessorNumber();
-                                } else {
-                                    mt->CurrentProcessor = (ULONG)-1;
-                                }
-
-                                CloseHandle(hQueryThread);
-                            } else {
-                                mt->AffinityMask = 0;
-                                mt->IdealProcessor = 0;
-                                mt->CurrentProcessor = (ULONG)-1;
-                            }
-                        } else {
-                            mt->AffinityMask = 0;
-                            mt->IdealProcessor = (ULONG)-1;
-                            mt->CurrentProcessor = (ULONG)-1;
-                        }
-
-                    }
-                    CloseHandle(hThread);
-                }
+                // Unknown until the affinity query fills them in
+                mt->IdealProcessor   = (ULONG)-1;
+                mt->CurrentProcessor = (ULONG)-1;
             }
         }
 
-        if (!p->NextEntryOffset)
-            break;
+        p = (const MRT_SYSTEM_PROCESS_INFORMATION*)
+            ((const BYTE*)p + p->NextEntryOffset);
+    }
 
-        p = (MRT_SYSTEM_PROCESS_INFORMATION*)
-            ((BYTE*)p + p->NextEntryOffset);
+    if (matches != localMatches)
+        free(matches);
+    if (strings) {
+        MrtIntern_End(strings);
+        if (!build->Strings)
+            MrtIntern_Destroy(strings);
+    }
+    MRT_STAT(MrtStats_Phase(build->Stats, MRT_PHASE_CONVERT, t0));
+    MRT_STAT(BOOL enriched = FALSE);
+
+#ifdef _WIN32
+    // Counters-only snapshots never open a thread handle
+    if (NtQueryInformationThread && (build->Flags & MRT_QUERY_ENRICH_MASK)) {
+        NTSTATUS status = MrtTInfo_EnrichAll(build, procArray, processCount);
+        if (!NT_SUCCESS(status)) {
+            // Arena records go with the arena; heap records (never pool-interned) are ours
+            if (!build->Arena)
+                MrtTInfo_FreeProcesses(procArray, processCount);
+            return status;
+        }
+        MRT_STAT(enriched = TRUE);
     }
+#endif
+
+    // Enrichment asked for but impossible here (replayed or non-NT records)
+    MRT_STAT(
+        if (!enriched && (build->Flags & MRT_QUERY_ENRICH_MASK) && build->Stats) {
+            for (ULONG i = 0; i < processCount; i++)
+                build->Stats->Counts.EnrichSkipped += procArray[i].ThreadCount;
+        }
+    );
 
     *Processes = procArray;
     *Count = processCount;
+    return STATUS_SUCCESS;
+}
+
+// Recorded buffer standing in for the live query (MrtTInfo_SetReplayBuffer)
+static const void* g_ReplayBuffer;
+static ULONG g_ReplayLength;
+
+// Provider used by the one-shot snapshot functions, NULL = platform default
+static const MRT_PROVIDER* g_Provider;
+
+// Memory reader used by the one-shot snapshot functions, NULL = platform default
+static const MRT_MEMORY_READER* g_Reader;
+
+NTSTATUS MrtTInfo_SetMemoryReader(const MRT_MEMORY_READER* Reader)
+{
+    if (Reader && !Reader->Read)
+        return STATUS_INVALID_PARAMETER;
+
+    g_Reader = Reader;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_SetProvider(const MRT_PROVIDER* Provider)
+{
+    if (Provider && !Provider->Query)
+        return STATUS_INVALID_PARAMETER;
+
+    g_Provider = Provider;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_SetReplayBuffer(const void* Buffer, ULONG Length)
+{
+    if (Buffer) {
+        NTSTATUS status = MrtCursor_Validate(Buffer, Length);
+        if (!NT_SUCCESS(status))
+            return status;
+    }
 
-    free(buffer); // safe now — ImageName.Buffer has its own allocation
+    g_ReplayBuffer = Buffer;
+    g_ReplayLength = Buffer ? Length : 0;
     return STATUS_SUCCESS;
 }
 
+static NTSTATUS MrtTInfo_QueryAndBuild(MRT_BUILD* build, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    // Replayed records describe another moment (or host): no live enrichment
+    if (g_ReplayBuffer) {
+        build->Nt = NULL;
+        return MrtTInfo_BuildFromBuffer(
+            build, (const MRT_SYSTEM_PROCESS_INFORMATION*)g_ReplayBuffer, Processes, Count);
+    }
+
+    const MRT_PROVIDER* provider = g_Provider ? g_Provider : MrtTInfo_GetDefaultProvider();
+    if (!provider)
+        return STATUS_NOT_SUPPORTED;
+
+    // Only records of live local threads can be enriched through ntdll
+    build->Nt = NULL;
+    build->Reader = g_Reader ? g_Reader : MrtTInfo_GetDefaultMemoryReader();
+    NTSTATUS status;
+    if (provider->Enrich && (build->Flags & MRT_QUERY_ENRICH_MASK)) {
+        status = MrtNt_Resolve(&build->Nt);
+        if (!NT_SUCCESS(status))
+            return status;
+    }
+
+    MRT_QUERY_BUFFER qb = { NULL, 0, 0, 0 };
+    MRT_STAT(ULONGLONG t0 = MrtPlatform_NowNs());
+    status = MrtProvider_Query(provider, &qb);
+    MRT_STAT(MrtStats_Query(build->Stats, &qb, t0));
+    if (NT_SUCCESS(status)) {
+        // ImageName and PEB strings are deep-copied, the buffer can go right after
+        status = MrtTInfo_BuildFromBuffer(
+            build, (const MRT_SYSTEM_PROCESS_INFORMATION*)qb.Data, Processes, Count);
+    }
+
+    MrtNt_FreeQueryBuffer(&qb);
+    return status;
+}
+
+static NTSTATUS MrtTInfo_BuildAllProcesses(MRT_BUILD* build, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    if (!Processes || !Count)
+        return STATUS_INVALID_PARAMETER;
+
+    *Processes = NULL;
+    *Count = 0;
+
+    MRT_STAT(MRT_STATS_FRAME frame; MrtStats_Begin(&frame); build->Stats = &frame);
+    NTSTATUS status = MrtTInfo_QueryAndBuild(build, Processes, Count);
+    MRT_STAT(MrtStats_Commit(&frame, status); build->Stats = NULL);
+    return status;
+}
+
+ULONG MrtTInfo_NormalizeQueryFlags(ULONG Flags)
+{
+    // Every enrichment step depends on the one before it
+    if (Flags & MRT_QUERY_PEB_STRINGS)
+        Flags |= MRT_QUERY_PEB;
+    if (Flags & (MRT_QUERY_PEB | MRT_QUERY_REMOTE))
+        Flags |= MRT_QUERY_TEB;
+    return Flags & MRT_QUERY_ALL_REMOTE;
+}
+
+NTSTATUS MrtTInfo_GetAllProcesses(MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    return MrtTInfo_GetAllProcessesEx(MRT_QUERY_ALL, Processes, Count);
+}
+
+NTSTATUS MrtTInfo_GetAllProcessesEx(ULONG Flags, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    MRT_BUILD build = { .Flags = MrtTInfo_NormalizeQueryFlags(Flags) };
+    return MrtTInfo_BuildAllProcesses(&build, Processes, Count);
+}
+
+NTSTATUS MrtTInfo_GetProcessesFiltered(const MRT_PROCESS_FILTER* Filter, ULONG Flags, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    if (!Filter)
+        return MrtTInfo_GetAllProcessesEx(Flags, Processes, Count);
+
+    MRT_FILTER* filter = NULL;
+    NTSTATUS status = MrtFilter_Create(Filter, &filter);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    MRT_BUILD build = { .Flags = MrtTInfo_NormalizeQueryFlags(Flags), .Filter = filter };
+    status = MrtTInfo_BuildAllProcesses(&build, Processes, Count);
+    MrtFilter_Free(filter);
+    return status;
+}
+
+NTSTATUS MrtTInfo_GetAllProcessesInArena(MRT_ARENA* Arena, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    if (!Arena)
+        return STATUS_INVALID_PARAMETER_1;
+
+    MRT_BUILD build = { .Arena = Arena, .Flags = MRT_QUERY_ALL };
+    return MrtTInfo_BuildAllProcesses(&build, Processes, Count);
+}
+
+static int MrtTInfo_ComparePointers(const void* a, const void* b)
+{
+    ULONG_PTR x = (ULONG_PTR)*(void* const*)a;
+    ULONG_PTR y = (ULONG_PTR)*(void* const*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Interned image names: several records may share one buffer
+static void MrtTInfo_FreeImageNames(MRT_PROCESS_INFO* Processes, ULONG Count)
+{
+    void** names = (void**)malloc((SIZE_T)Count * sizeof(void*));
+    if (names) {
+        for (ULONG i = 0; i < Count; i++)
+            names[i] = Processes[i].ImageName.Buffer;
+        qsort(names, Count, sizeof(void*), MrtTInfo_ComparePointers);
+        for (ULONG i = 0; i < Count; i++) {
+            if (i == 0 || names[i] != names[i - 1])
+                free(names[i]);
+        }
+        free(names);
+        return;
+    }
+
+    // No memory for the sort: the first record using a buffer frees it
+    for (ULONG i = 0; i < Count; i++) {
+        void* name = Processes[i].ImageName.Buffer;
+        ULONG j = 0;
+        while (j < i && Processes[j].ImageName.Buffer != name)
+            j++;
+        if (j == i)
+            free(name);
+    }
+}
+
 void MrtTInfo_FreeProcesses(MRT_PROCESS_INFO* Processes, ULONG Count) {
     if (!Processes) return;
+    MrtTInfo_FreeImageNames(Processes, Count);
     for (ULONG i = 0; i < Count; i++) {
-        // FIX: free the deep-copied ImageName buffer
-        free(Processes[i].ImageName.Buffer);
-        for (ULONG t = 0; t < Processes[i].ThreadCount; t++) {
-            free(Processes[i].Threads[t].PebCommandLine);
-            free(Processes[i].Threads[t].PebImagePath);
-        }
+        // Thread PEB strings point at these
+        free(Processes[i].PebCommandLine);
+        free(Processes[i].PebImagePath);
         free(Processes[i].Threads);
     }
     free(Processes);
@@ -590,13 +1057,16 @@ MRT_THREAD_INFO* MrtTInfo_FindThreadByTID(
         }
     }
 
+#ifdef _WIN32
     if (tid == GetCurrentThreadId()) {
-        static MRT_THREAD_INFO liveThread;
+        // Per thread: concurrent callers each get their own record
+        static _Thread_local MRT_THREAD_INFO liveThread;
         ZeroMemory(&liveThread, sizeof(liveThread));
 
         if (MrtTInfo_QueryCurrentThreadLive(&liveThread))
             return &liveThread;
     }
+#endif
 
     return NULL;
 }
\ No newline at end of file
@@ -1,11 +1,90 @@
 #pragma once
+#ifdef _WIN32
 #ifndef _WIN32_WINNT
 #define _WIN32_WINNT 0x0601
 #endif
 #include <windows.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
 #include <stdlib.h>
 #include <wchar.h>
 
+#ifndef _WIN32
+// -----------------------------
+// Win32 base types for non-Windows builds
+// (replayed buffers, procfs provider, benchmarks). WCHAR is the native
+// wchar_t, so UNICODE_STRING lengths stay in bytes of WCHAR on every host.
+// -----------------------------
+typedef uint8_t   BYTE;
+typedef uint8_t   BOOLEAN;
+typedef int       BOOL;
+typedef uint16_t  USHORT;
+typedef uint16_t  WORD;
+typedef int32_t   LONG;
+typedef uint32_t  ULONG;
+typedef uint32_t  DWORD;
+typedef ULONG*    PULONG;
+typedef int64_t   LONGLONG;
+typedef uint64_t  ULONGLONG;
+typedef uintptr_t ULONG_PTR;
+typedef uintptr_t DWORD_PTR;
+typedef size_t    SIZE_T;
+typedef void*     PVOID;
+typedef void*     HANDLE;
+typedef void*     HMODULE;
+typedef wchar_t   WCHAR;
+typedef WCHAR*    PWSTR;
+
+typedef union _LARGE_INTEGER {
+    struct {
+        DWORD LowPart;
+        LONG  HighPart;
+    } u;
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct _FILETIME {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME;
+
+typedef struct _IO_COUNTERS {
+    ULONGLONG ReadOperationCount;
+    ULONGLONG WriteOperationCount;
+    ULONGLONG OtherOperationCount;
+    ULONGLONG ReadTransferCount;
+    ULONGLONG WriteTransferCount;
+    ULONGLONG OtherTransferCount;
+} IO_COUNTERS;
+
+typedef struct _LIST_ENTRY {
+    struct _LIST_ENTRY* Flink;
+    struct _LIST_ENTRY* Blink;
+} LIST_ENTRY;
+
+typedef struct _NT_TIB {
+    PVOID ExceptionList;
+    PVOID StackBase;
+    PVOID StackLimit;
+    PVOID SubSystemTib;
+    PVOID FiberData;
+    PVOID ArbitraryUserPointer;
+    struct _NT_TIB* Self;
+} NT_TIB;
+
+#define TRUE  1
+#define FALSE 0
+#define WINAPI
+#define NTAPI
+#define MAXIMUM_PROCESSORS 64
+#define ZeroMemory(Destination, Length) memset((Destination), 0, (Length))
+#define CONTAINING_RECORD(address, type, field) \
+    ((type*)((char*)(address) - offsetof(type, field)))
+#endif
+
 // -----------------------------
 // basic NTSTATUS and macross
 // -----------------------------
@@ -80,6 +159,21 @@ typedef ULONG MRT_WAIT_REASON;
 #ifndef STATUS_NO_MEMORY
 #define STATUS_NO_MEMORY                 ((NTSTATUS)0xC0000017L)
 #endif
+#ifndef STATUS_END_OF_FILE
+#define STATUS_END_OF_FILE               ((NTSTATUS)0xC0000011L)
+#endif
+#ifndef STATUS_DATA_ERROR
+#define STATUS_DATA_ERROR                ((NTSTATUS)0xC000003EL)
+#endif
+#ifndef STATUS_REVISION_MISMATCH
+#define STATUS_REVISION_MISMATCH         ((NTSTATUS)0xC0000059L)
+#endif
+#ifndef STATUS_INVALID_IMAGE_FORMAT
+#define STATUS_INVALID_IMAGE_FORMAT      ((NTSTATUS)0xC000007BL)
+#endif
+#ifndef STATUS_PARTIAL_COPY
+#define STATUS_PARTIAL_COPY              ((NTSTATUS)0x8000000DL)
+#endif
 #ifndef STATUS_INVALID_PARAMETER_1
 #define STATUS_INVALID_PARAMETER_1       ((NTSTATUS)0xC00000EFL)
 #endif
@@ -113,6 +207,8 @@ typedef DWORD SUBSYSTEM_TIB;
 #define Running    2
 #define Executive  0
 #define ThreadBasicInformation 0
+#define MRT_THREAD_GROUP_INFORMATION  30   // GROUP_AFFINITY
+#define MRT_THREAD_IDEAL_PROCESSOR_EX 33   // PROCESSOR_NUMBER
 #define MRT_MAX_APCS 16
 
 // -----------------------------
@@ -202,8 +298,8 @@ typedef struct _MRT_THREAD_INFO {
     PVOID TlsPointer;
     BYTE  PebBeingDebugged;
     ULONG PebSessionId;
-    wchar_t* PebCommandLine;
-    wchar_t* PebImagePath;
+    wchar_t* PebCommandLine;        // the owning MRT_PROCESS_INFO's copy, not a separate allocation
+    wchar_t* PebImagePath;          // likewise
     PVOID PebAddress;
     PVOID PebLdr; 
     PVOID PebLdr_EntryInProgress;
@@ -212,9 +308,10 @@ typedef struct _MRT_THREAD_INFO {
     ULONG CountOfOwnedCriticalSections; 
     PVOID Win32ThreadInfo;             
     ULONG TLSSlotCount;        
-    KAFFINITY AffinityMask;
-    ULONG IdealProcessor;
+    KAFFINITY AffinityMask;         // within ProcessorGroup
+    ULONG IdealProcessor;           // number within its group, -1 if unknown
     ULONG CurrentProcessor;  
+    USHORT ProcessorGroup;
     PVOID ExceptionList; 
     SUBSYSTEM_TIB SubSystemTib;
     PVOID Self;
@@ -246,6 +343,8 @@ typedef struct _MRT_PROCESS_INFO {
     PVOID PebAddress;
     BOOLEAN PebBeingDebugged;
     ULONG   PebSessionId;
+    wchar_t* PebCommandLine;        // captured once per process (MRT_QUERY_PEB_STRINGS)
+    wchar_t* PebImagePath;
     PVOID   PebLdr;
     PVOID   PebLdr_EntryInProgress;
     BOOLEAN ShutdownInProgress;
@@ -353,6 +452,698 @@ typedef DWORD (WINAPI *PFN_GetCurrentProcessorNumber)(
     void
 );
 
+// -----------------------------
+// Query flags
+// -----------------------------
+// Select the per-thread enrichment a snapshot performs. Everything in
+// MRT_PROCESS_INFO and the SYSTEM_THREAD_INFORMATION counters of
+// MRT_THREAD_INFO is always filled; it comes from the single query call.
+// Costs are per thread on the live system:
+//   any flag below            +1 OpenThread/CloseHandle pair
+//   MRT_QUERY_TEB             +1 NtQueryInformationThread (basic info); TEB fields
+//                                are read directly for the current process
+//   MRT_QUERY_START_ADDRESS   +1 NtQueryInformationThread (class 9)
+//   MRT_QUERY_PEB             PEB/loader reads, no syscall (current process)
+//   MRT_QUERY_PEB_STRINGS     +2 string copies per process
+//   MRT_QUERY_AFFINITY        +2 NtQueryInformationThread (group affinity, ideal
+//                                processor); read-only, any process
+//   MRT_QUERY_REMOTE          TEB (and PEB) fields of other processes through the
+//                                memory reader: one open per process (PROCESS_VM_READ
+//                                by default), reads coalesced by page (a few per
+//                                process, not per field). Opt-in: not part of
+//                                MRT_QUERY_ALL, see MRT_QUERY_ALL_REMOTE
+// "make bench" on Windows prints measured per-flag snapshot times.
+typedef enum _MRT_QUERY_FLAGS {
+    MRT_QUERY_COUNTERS      = 0x00,
+    MRT_QUERY_TEB           = 0x01,
+    MRT_QUERY_START_ADDRESS = 0x02,
+    MRT_QUERY_PEB           = 0x04,  // implies MRT_QUERY_TEB
+    MRT_QUERY_PEB_STRINGS   = 0x08,  // implies MRT_QUERY_PEB
+    MRT_QUERY_AFFINITY      = 0x10,
+    MRT_QUERY_REMOTE        = 0x20,  // implies MRT_QUERY_TEB
+    MRT_QUERY_ALL           = 0x1F,  // everything but MRT_QUERY_REMOTE
+    MRT_QUERY_ALL_REMOTE    = 0x3F
+} MRT_QUERY_FLAGS;
+
+#define MRT_QUERY_ENRICH_MASK MRT_QUERY_ALL_REMOTE
+
+#define MRT_MAX_WORKERS 64
+
+// -----------------------------
+// Snapshot arena
+// -----------------------------
+// Bump allocator that backs every record and string of a snapshot.
+// Releasing a snapshot is a single MrtTInfo_ArenaReset; the blocks are kept
+// and reused by the next snapshot, so steady-state polling does not touch the heap.
+typedef struct _MRT_ARENA MRT_ARENA;
+
+typedef struct _MRT_ALLOC_STATS {
+    ULONGLONG Allocations;      // records/strings handed out since the last reset
+    ULONGLONG BytesUsed;        // bytes handed out since the last reset
+    ULONGLONG HeapAllocations;  // blocks obtained from the heap (lifetime)
+    ULONGLONG HeapBytes;        // bytes obtained from the heap (lifetime)
+    ULONG     BlockCount;       // blocks currently owned by the arena
+    SIZE_T    BytesReserved;    // total capacity of owned blocks
+} MRT_ALLOC_STATS;
+
+// Collector thread handle cache (see MrtTInfo_CollectorEnableHandleCache)
+typedef struct _MRT_HANDLE_CACHE_STATS {
+    ULONGLONG Hits;             // threads enriched with a handle kept from an earlier refresh
+    ULONGLONG Misses;           // threads that needed a fresh OpenThread
+    ULONGLONG Evictions;        // handles closed because their thread left the snapshot
+    ULONG     OpenHandles;      // handles currently held
+    ULONG     MaxHandles;       // 0 when the cache is disabled
+} MRT_HANDLE_CACHE_STATS;
+
+// Collector image-name pool (see MrtTInfo_CollectorGetStringPoolStats)
+typedef struct _MRT_STRING_POOL_STATS {
+    ULONGLONG Hits;             // names that reused a stored copy
+    ULONGLONG Misses;           // names copied into the pool
+    ULONG     Strings;          // distinct names currently held
+    SIZE_T    Bytes;            // string storage currently held
+} MRT_STRING_POOL_STATS;
+
+// -----------------------------
+// Collector
+// -----------------------------
+// Long-lived snapshot context: ntdll entry points are resolved once, the query
+// buffer only grows, and snapshots are built in an owned arena. A steady-state
+// refresh is one NtQuerySystemInformation call and no heap allocations.
+typedef struct _MRT_COLLECTOR MRT_COLLECTOR;
+
+// -----------------------------
+// Snapshot index
+// -----------------------------
+// Hash tables PID -> process and TID -> (process, thread) over one snapshot.
+// O(1) replacement for MrtTInfo_FindProcessByPID / MrtTInfo_FindThreadByTID;
+// the index references the snapshot and must not outlive it.
+typedef struct _MRT_SNAPSHOT_INDEX MRT_SNAPSHOT_INDEX;
+
+// -----------------------------
+// Snapshot diff
+// -----------------------------
+// Identity is (PID, CreateTime) for processes and (TID, CreateTime) for
+// threads, so a reused PID shows up as one exit plus one creation.
+// Only created, exited and changed records are emitted. Counter fields are
+// new - old; for created records they are the new totals, for exited
+// records they are zero.
+#define MRT_DIFF_NONE ((ULONG)-1)
+
+typedef enum _MRT_DELTA_KIND {
+    MRT_DELTA_CREATED = 1,
+    MRT_DELTA_EXITED  = 2,
+    MRT_DELTA_CHANGED = 3
+} MRT_DELTA_KIND;
+
+typedef struct _MRT_PROCESS_DELTA {
+    MRT_DELTA_KIND Kind;
+    DWORD PID;
+    DWORD ParentPID;
+    FILETIME CreateTime;
+    ULONG OldIndex;             // index in the old snapshot or MRT_DIFF_NONE
+    ULONG NewIndex;             // index in the new snapshot or MRT_DIFF_NONE
+    LONGLONG KernelTime;        // 100ns units
+    LONGLONG UserTime;
+    LONGLONG CycleTime;
+    LONGLONG ContextSwitches;   // summed thread deltas; threads gone by the new snapshot add nothing
+    LONGLONG PageFaultCount;
+    LONGLONG HardFaultCount;
+    LONGLONG WorkingSetSize;
+    LONG HandleCount;
+    LONG ThreadCount;
+    IO_COUNTERS IoCounters;     // unsigned deltas
+} MRT_PROCESS_DELTA;
+
+typedef struct _MRT_THREAD_DELTA {
+    MRT_DELTA_KIND Kind;
+    DWORD TID;
+    DWORD PID;
+    FILETIME CreateTime;
+    ULONG OldProcess;           // positions in the old snapshot or MRT_DIFF_NONE
+    ULONG OldThread;
+    ULONG NewProcess;           // positions in the new snapshot or MRT_DIFF_NONE
+    ULONG NewThread;
+    LONGLONG KernelTime;
+    LONGLONG UserTime;
+    ULONG ContextSwitches;      // wrap-safe difference
+    MRT_THREAD_STATE OldState;
+    MRT_THREAD_STATE NewState;
+    MRT_WAIT_REASON OldWaitReason;
+    MRT_WAIT_REASON NewWaitReason;
+} MRT_THREAD_DELTA;
+
+typedef struct _MRT_SNAPSHOT_DIFF {
+    MRT_PROCESS_DELTA* Processes;   // sorted by PID
+    ULONG ProcessCount;
+    MRT_THREAD_DELTA* Threads;      // sorted by TID
+    ULONG ThreadCount;
+    ULONG ProcessesCreated;
+    ULONG ProcessesExited;
+    ULONG ThreadsCreated;
+    ULONG ThreadsExited;
+} MRT_SNAPSHOT_DIFF;
+
+// -----------------------------
+// Sampler
+// -----------------------------
+// Background refresh at a fixed interval with per-process and per-thread rates
+// derived from two consecutive snapshots. The last HistoryDepth samples are kept
+// in a ring whose slots are reused, so a steady-state tick does not allocate.
+// CPU figures are fractions of one CPU (1.0 = one core fully busy); records for
+// processes/threads first seen in a sample have zero rates and New set.
+typedef struct _MRT_SAMPLER MRT_SAMPLER;
+
+#define MRT_SAMPLER_DEFAULT_DEPTH 8
+
+typedef struct _MRT_PROCESS_RATE {
+    DWORD PID;
+    DWORD ParentPID;
+    FILETIME CreateTime;
+    ULONG ThreadCount;
+    BOOLEAN New;
+    double KernelCpu;
+    double UserCpu;
+    double CyclesPerSec;
+    double ContextSwitchesPerSec;   // summed over the process' threads
+    double ReadBytesPerSec;
+    double WriteBytesPerSec;
+    double OtherBytesPerSec;
+    double IoOpsPerSec;             // read + write + other operations
+} MRT_PROCESS_RATE;
+
+typedef struct _MRT_THREAD_RATE {
+    DWORD TID;
+    DWORD PID;
+    FILETIME CreateTime;
+    MRT_THREAD_STATE ThreadState;
+    MRT_WAIT_REASON WaitReason;
+    BOOLEAN New;
+    double KernelCpu;
+    double UserCpu;
+    double ContextSwitchesPerSec;
+} MRT_THREAD_RATE;
+
+typedef struct _MRT_SAMPLE {
+    ULONGLONG Sequence;             // 1 for the first sample
+    ULONGLONG TimestampNs;          // monotonic clock
+    ULONGLONG IntervalNs;           // time since the previous sample, 0 for the first
+    MRT_PROCESS_RATE* Processes;    // sorted by PID
+    ULONG ProcessCount;
+    MRT_THREAD_RATE* Threads;       // sorted by TID
+    ULONG ThreadCount;
+} MRT_SAMPLE;
+
+// -----------------------------
+// Refresher
+// -----------------------------
+// Full snapshots shared between threads. Each refresh is built off to the
+// side in an arena of its own and published with one atomic pointer swap, so
+// readers never see a snapshot being built and never wait for the builder.
+// Readers take a counted reference to the latest snapshot; it stays valid and
+// unchanged until released, however many refreshes happen meanwhile. A
+// snapshot nobody references any more is recycled by a later refresh.
+typedef struct _MRT_REFRESHER MRT_REFRESHER;
+
+// Snapshots referenced at once (latest plus readers' older ones); a refresh
+// finding all of them in use is skipped
+#define MRT_REFRESHER_MAX_SNAPSHOTS 16
+
+typedef struct _MRT_SHARED_SNAPSHOT {
+    ULONGLONG Sequence;                 // 1 for the first snapshot
+    ULONGLONG TimestampNs;              // monotonic clock, when it was published
+    const MRT_PROCESS_INFO* Processes;
+    ULONG Count;
+    const MRT_SNAPSHOT_INDEX* Index;    // always built
+} MRT_SHARED_SNAPSHOT;
+
+// -----------------------------
+// Snapshot files
+// -----------------------------
+// Position-independent image of a snapshot: header, fixed-width process and
+// thread records and a UTF-16 string table (NUL-terminated entries). Little
+// endian, every 64-bit field 8-byte aligned. Written with one sequential write
+// and opened read-only by mapping the file; opening only validates the header,
+// records are used in place.
+#define MRT_SNAPSHOT_MAGIC      0x5353524DUL    // "MRSS"
+#define MRT_SNAPSHOT_VERSION    1
+#define MRT_SNAPSHOT_NO_STRING  ((ULONG)-1)
+
+typedef struct _MRT_SNAPSHOT_HEADER {
+    ULONG Magic;
+    USHORT Version;
+    USHORT HeaderSize;
+    ULONG ByteOrder;            // 0x01020304 in the writer's byte order
+    ULONG ProcessRecordSize;
+    ULONG ThreadRecordSize;
+    ULONG ProcessCount;
+    ULONG ThreadCount;
+    ULONG StringCount;          // UTF-16 units in the string table
+    ULONGLONG ProcessOffset;    // byte offsets from the start of the image
+    ULONGLONG ThreadOffset;
+    ULONGLONG StringOffset;
+    ULONGLONG ImageSize;
+    ULONGLONG CaptureTime;      // FILETIME ticks, 0 if unknown
+} MRT_SNAPSHOT_HEADER;
+
+typedef struct _MRT_SNAPSHOT_PROCESS {
+    ULONG PID;
+    ULONG ParentPID;
+    ULONGLONG CreateTime;       // FILETIME ticks
+    LONGLONG UserTime;
+    LONGLONG KernelTime;
+    ULONGLONG CycleTime;
+    ULONGLONG WorkingSetSize;
+    ULONGLONG VirtualSize;
+    ULONGLONG PeakWorkingSetSize;
+    ULONGLONG PrivatePageCount;
+    ULONGLONG PageFaultCount;
+    ULONGLONG PeakVirtualSize;
+    IO_COUNTERS IoCounters;
+    ULONG HandleCount;
+    ULONG SessionId;
+    ULONG HardFaultCount;
+    LONG BasePriority;
+    ULONG FirstThread;          // index into the thread table
+    ULONG ThreadCount;
+    ULONG ImageName;            // string table offset (UTF-16 units) or MRT_SNAPSHOT_NO_STRING
+    ULONG ImageNameLength;      // UTF-16 units, no terminator
+} MRT_SNAPSHOT_PROCESS;
+
+typedef struct _MRT_SNAPSHOT_THREAD {
+    ULONG TID;
+    ULONG PID;
+    ULONGLONG CreateTime;
+    LONGLONG KernelTime;
+    LONGLONG UserTime;
+    ULONGLONG StartAddress;
+    ULONGLONG TebAddress;
+    LONG BasePriority;
+    LONG Priority;
+    ULONG ContextSwitches;
+    MRT_THREAD_STATE ThreadState;
+    MRT_WAIT_REASON WaitReason;
+    ULONG CommandLine;          // string table offsets / lengths as for ImageName
+    ULONG CommandLineLength;
+    ULONG ImagePath;
+    ULONG ImagePathLength;
+    ULONG Reserved;
+} MRT_SNAPSHOT_THREAD;
+
+typedef struct _MRT_SNAPSHOT_VIEW {
+    const MRT_SNAPSHOT_HEADER* Header;
+    const MRT_SNAPSHOT_PROCESS* Processes;
+    const MRT_SNAPSHOT_THREAD* Threads;
+    const USHORT* Strings;
+    ULONG ProcessCount;
+    ULONG ThreadCount;
+    ULONG StringCount;
+    const void* Mapping;        // set when opened from a file
+    SIZE_T MappingSize;
+} MRT_SNAPSHOT_VIEW;
+
+// -----------------------------
+// Text export
+// -----------------------------
+// One row per process followed by one row per thread of it, for log
+// pipelines. Strings are converted to UTF-8; numbers are decimal, times in
+// FILETIME ticks (100 ns), addresses 0x-prefixed hex. CSV starts with a header
+// row; process rows leave the thread columns empty and thread rows the process
+// ones. NDJSON rows are objects with "kind" "process" or "thread" and omit
+// absent strings and addresses.
+typedef enum _MRT_EXPORT_FORMAT {
+    MRT_EXPORT_CSV,
+    MRT_EXPORT_NDJSON,
+} MRT_EXPORT_FORMAT;
+
+// Growable output, reused across exports: an append writes after Length and
+// grows Data as needed. Zero-initialize; free with MrtTInfo_ExportBufferFree.
+typedef struct _MRT_EXPORT_BUFFER {
+    char* Data;                 // not NUL-terminated
+    SIZE_T Capacity;
+    SIZE_T Length;
+} MRT_EXPORT_BUFFER;
+
+// -----------------------------
+// Loaded modules (current process)
+// -----------------------------
+// Flat copy of the loader's module list. A cache rebuilds it only when the
+// list changed since the previous call: a loader notification bumps a
+// generation on Windows (with a list length / tail check as fallback), the
+// dl_iterate_phdr add/remove counters serve the same purpose elsewhere.
+// Names are views into storage owned by the cache.
+typedef struct _MRT_MODULE_CACHE MRT_MODULE_CACHE;
+
+typedef struct _MRT_MODULE_INFO {
+    PVOID Base;
+    SIZE_T Size;
+    PVOID EntryPoint;           // NULL if the image has none
+    UNICODE_STRING FullName;
+    UNICODE_STRING BaseName;    // points into FullName
+} MRT_MODULE_INFO;
+
+// -----------------------------
+// Address index (module symbolisation)
+// -----------------------------
+// Maps addresses to "module + offset" over a module array. Ranges are sorted
+// and clipped so they do not overlap, then laid out in Eytzinger (BFS) order
+// padded to a full tree: every lookup runs the same number of branch-free
+// steps, and batches advance several lookups per step so their misses overlap.
+// Module numbers are indexes into the array the index was built from.
+typedef struct _MRT_ADDRESS_INDEX MRT_ADDRESS_INDEX;
+
+#define MRT_NO_MODULE ((ULONG)-1)
+
+typedef struct _MRT_ADDRESS_SYMBOL {
+    ULONG Module;               // MRT_NO_MODULE if no range contains the address
+    ULONG_PTR Offset;           // from the module base, or the address itself
+} MRT_ADDRESS_SYMBOL;
+
+// -----------------------------
+// Data providers
+// -----------------------------
+// Source of the SystemProcessInformation-layout buffer every snapshot is built
+// from. Query follows NtQuerySystemInformation: it fills Buffer and sets *Needed
+// to the bytes used, or returns STATUS_INFO_LENGTH_MISMATCH with *Needed set to
+// the size required. Enrich marks records of live threads on this host, so the
+// TEB/PEB enrichment selected by MRT_QUERY_FLAGS may run on them.
+typedef NTSTATUS (*MRT_PROVIDER_QUERY)(void* Context, void* Buffer, ULONG Capacity, ULONG* Needed);
+
+typedef struct _MRT_PROVIDER {
+    const char* Name;
+    MRT_PROVIDER_QUERY Query;
+    void* Context;
+    BOOLEAN Enrich;
+} MRT_PROVIDER;
+
+// -----------------------------
+// Memory readers
+// -----------------------------
+// Source of another process's memory for TEB/PEB parsing (MRT_QUERY_REMOTE).
+// Open returns a per-process target (a process handle for ReadProcessMemory);
+// Read copies Size bytes at Address and fails unless every byte was read.
+// Open and Close may be NULL. Structures are read with the collector's own
+// pointer size. Reads go through a small page cache, so Address and Size are
+// page-aligned multiples of 4096 bytes.
+typedef NTSTATUS (*MRT_READER_OPEN)(void* Context, DWORD Pid, void** Target);
+typedef NTSTATUS (*MRT_READER_READ)(void* Context, void* Target, ULONG_PTR Address, void* Buffer, SIZE_T Size);
+typedef void (*MRT_READER_CLOSE)(void* Context, void* Target);
+
+typedef struct _MRT_MEMORY_READER {
+    const char* Name;
+    MRT_READER_OPEN Open;
+    MRT_READER_READ Read;
+    MRT_READER_CLOSE Close;
+    void* Context;
+} MRT_MEMORY_READER;
+
+// In-memory reader over caller-described regions, for tests and replays. A
+// read succeeds when every page it touches overlaps a region of the process
+// (Pid 0 matches any); bytes of those pages outside the regions read as zero.
+typedef struct _MRT_MEMORY_REGION {
+    DWORD Pid;
+    ULONG_PTR Address;
+    const void* Data;
+    SIZE_T Size;
+} MRT_MEMORY_REGION;
+
+typedef struct _MRT_FAKE_MEMORY {
+    const MRT_MEMORY_REGION* Regions;
+    ULONG RegionCount;
+    ULONG Reads;                // Read calls served (successful or not)
+    ULONGLONG BytesRead;
+} MRT_FAKE_MEMORY;
+
+typedef struct _MRT_REMOTE_STATS {
+    ULONG Processes;            // processes opened
+    ULONG Requests;             // structure and string reads requested
+    ULONG Reads;                // reader calls made for them
+    ULONG Failures;             // requests that could not be satisfied
+} MRT_REMOTE_STATS;
+
+// -----------------------------
+// Process filter
+// -----------------------------
+// Evaluated against each raw SystemProcessInformation entry before anything
+// is allocated, copied or enriched, so processes that do not match cost one
+// look at their header. Every criterion that is set must match.
+typedef enum _MRT_PROCESS_FIELD {
+    MRT_FIELD_NONE = 0,
+    MRT_FIELD_THREAD_COUNT,
+    MRT_FIELD_HANDLE_COUNT,
+    MRT_FIELD_WORKING_SET,          // bytes
+    MRT_FIELD_PEAK_WORKING_SET,
+    MRT_FIELD_PRIVATE_BYTES,        // PrivatePageCount
+    MRT_FIELD_VIRTUAL_SIZE,
+    MRT_FIELD_PAGE_FAULTS,
+    MRT_FIELD_HARD_FAULTS,
+    MRT_FIELD_USER_TIME,            // 100ns ticks
+    MRT_FIELD_KERNEL_TIME,
+    MRT_FIELD_CPU_TIME,             // user + kernel
+    MRT_FIELD_CYCLE_TIME,
+    MRT_FIELD_READ_BYTES,
+    MRT_FIELD_WRITE_BYTES,
+    MRT_FIELD_READ_OPS,
+    MRT_FIELD_WRITE_OPS,
+    MRT_FIELD_CONTEXT_SWITCHES,     // summed over the process' threads
+    MRT_FIELD_COUNT
+} MRT_PROCESS_FIELD;
+
+#define MRT_ANY_SESSION ((ULONG)-1)
+
+// Start from MrtTInfo_FilterInit (matches everything), then narrow
+typedef struct _MRT_PROCESS_FILTER {
+    const DWORD* Pids;              // PID set, NULL/0 = any PID
+    ULONG PidCount;
+    const wchar_t* ImageName;       // case-insensitive, '*' and '?' wildcards, NULL = any
+    ULONG SessionId;                // MRT_ANY_SESSION = any
+    MRT_PROCESS_FIELD Field;        // MRT_FIELD_NONE = no threshold
+    ULONGLONG Min;                  // inclusive bounds on Field
+    ULONGLONG Max;
+} MRT_PROCESS_FILTER;
+
+// -----------------------------
+// Aggregation
+// -----------------------------
+// Group-by and top-N over a snapshot (or a diff) in one pass. Groups come in
+// first-seen order from a single result block; top-N keeps a bounded min-heap
+// in the caller's buffer, so ranking allocates nothing and never sorts the input.
+typedef enum _MRT_THREAD_FIELD {
+    MRT_THREAD_FIELD_NONE = 0,
+    MRT_THREAD_FIELD_KERNEL_TIME,   // 100ns ticks
+    MRT_THREAD_FIELD_USER_TIME,
+    MRT_THREAD_FIELD_CPU_TIME,      // user + kernel
+    MRT_THREAD_FIELD_CONTEXT_SWITCHES,
+    MRT_THREAD_FIELD_PRIORITY,
+    MRT_THREAD_FIELD_BASE_PRIORITY,
+    MRT_THREAD_FIELD_COUNT
+} MRT_THREAD_FIELD;
+
+typedef enum _MRT_GROUP_BY {
+    MRT_GROUP_ALL = 0,              // one group
+    MRT_GROUP_IMAGE_NAME,           // case-insensitive; threads use their process' name
+    MRT_GROUP_SESSION,
+    MRT_GROUP_PARENT_PID,
+    MRT_GROUP_THREAD_STATE,         // thread records only; states from MRT_STATE_BUCKETS - 1 up share one group
+    MRT_GROUP_COUNT
+} MRT_GROUP_BY;
+
+typedef struct _MRT_AGGREGATE_SPEC {
+    MRT_GROUP_BY GroupBy;
+    BOOLEAN Threads;                // aggregate thread records instead of processes
+    MRT_PROCESS_FIELD ProcessField; // value of a process record (MRT_FIELD_NONE: count only)
+    MRT_THREAD_FIELD ThreadField;   // value of a thread record
+} MRT_AGGREGATE_SPEC;
+
+typedef struct _MRT_GROUP {
+    ULONGLONG Key;                  // session, parent PID or thread state
+    UNICODE_STRING Name;            // image-name groups: first member's name, points into the snapshot
+    ULONG Count;                    // records in the group
+    ULONGLONG Sum;
+    ULONGLONG Min;
+    ULONGLONG Max;
+} MRT_GROUP;
+
+typedef struct _MRT_AGGREGATE {
+    MRT_GROUP* Groups;
+    ULONG GroupCount;
+} MRT_AGGREGATE;
+
+// Ranked record: positions in the snapshot, or in the diff's arrays for deltas
+typedef struct _MRT_TOP_ENTRY {
+    LONGLONG Value;
+    ULONG Process;                  // MRT_DIFF_NONE for thread deltas
+    ULONG Thread;                   // MRT_DIFF_NONE for process entries
+} MRT_TOP_ENTRY;
+
+// -----------------------------
+// Columnar thread snapshot
+// -----------------------------
+// Struct-of-arrays copy of the hot thread counters: one contiguous, 64-byte
+// aligned array per field, so a scan over one counter reads only that counter.
+// Rarely scanned fields live in a separate Cold array. Row i of every column
+// describes the same thread; rows follow snapshot (or buffer) order.
+typedef struct _MRT_THREAD_COLD {
+    ULONGLONG CreateTime;           // FILETIME ticks
+    PVOID StartAddress;
+    LONG BasePriority;
+    const MRT_THREAD_INFO* Record;  // TEB/PEB fields; NULL when built from a raw buffer
+} MRT_THREAD_COLD;
+
+typedef struct _MRT_THREAD_COLUMNS {
+    ULONG ThreadCount;
+    ULONG ProcessCount;
+    DWORD* Tid;
+    ULONG* Process;                 // owning process index
+    LONGLONG* KernelTime;
+    LONGLONG* UserTime;
+    ULONG* ContextSwitches;
+    BYTE* ThreadState;              // values above 255 are stored as 255
+    BYTE* WaitReason;
+    LONG* Priority;
+    MRT_THREAD_COLD* Cold;
+} MRT_THREAD_COLUMNS;
+
+// -----------------------------
+// Process tree
+// -----------------------------
+// Parent/child hierarchy of one snapshot in compressed sparse row form, built
+// in linear time. A process hangs under the process whose PID is its
+// ParentPID only if that one was not created after it; otherwise the parent
+// exited and its PID was reused, and the process is a root, as are processes
+// whose parent is not in the snapshot. Every per-process array is indexed by
+// snapshot position. Order lists processes in preorder, so the descendants of
+// a process follow it contiguously.
+#define MRT_TREE_NONE ((ULONG)-1)
+
+typedef struct _MRT_TREE_SLOT MRT_TREE_SLOT;
+
+typedef struct _MRT_PROCESS_TREE {
+    const MRT_PROCESS_INFO* Processes;
+    ULONG Count;
+    ULONG RootCount;
+    ULONG* Parent;                  // parent's index, MRT_TREE_NONE for roots
+    ULONG* ChildStart;              // Count + 2 offsets: children of i are Children[ChildStart[i] .. ChildStart[i + 1]); i = Count lists the roots
+    ULONG* Children;                // Count indexes, siblings in snapshot order
+    ULONG* Order;                   // preorder, roots in snapshot order
+    ULONG* Position;                // place in Order
+    ULONG* Subtree;                 // processes in the subtree, itself included
+    ULONG PidMask;                  // PID lookup, internal
+    MRT_TREE_SLOT* PidSlots;
+} MRT_PROCESS_TREE;
+
+// -----------------------------
+// Thread states and contention
+// -----------------------------
+// Counts of threads per ThreadState and, for waiting threads, per WaitReason,
+// per process and system-wide, from one counting pass. Raw values index the
+// arrays directly; values past the end share the last bucket. Wait reasons are
+// also rolled up into classes so paging storms and loader-lock convoys stand
+// out. Loader-lock waits are inferred: non-paging waits in a process whose PEB
+// shows a module load in progress (PebLdr_EntryInProgress, MRT_QUERY_PEB).
+#define MRT_STATE_BUCKETS 32
+#define MRT_WAIT_BUCKETS  96
+
+typedef enum _MRT_WAIT_CLASS {
+    MRT_WAIT_CLASS_OTHER = 0,
+    MRT_WAIT_CLASS_PAGING,          // FreePage, PageIn, WrFreePage, WrPageIn, WrVirtualMemory, WrPageOut
+    MRT_WAIT_CLASS_LOADER_LOCK,     // any other wait while the process' loader is busy
+    MRT_WAIT_CLASS_COUNT
+} MRT_WAIT_CLASS;
+
+typedef struct _MRT_STATE_COUNTS {
+    ULONG Threads;
+    ULONG States[MRT_STATE_BUCKETS];
+    ULONG WaitReasons[MRT_WAIT_BUCKETS];        // waiting threads only
+    ULONG Classes[MRT_WAIT_CLASS_COUNT];        // waiting threads only
+} MRT_STATE_COUNTS;
+
+typedef struct _MRT_CONTENTION_REPORT {
+    MRT_STATE_COUNTS System;
+    MRT_STATE_COUNTS* Processes;    // parallel to the snapshot's process array
+    ULONG ProcessCount;
+} MRT_CONTENTION_REPORT;
+
+// Between two snapshots (from their diff). Threads whose record did not change
+// at all are not in a diff and do not appear here.
+typedef struct _MRT_STATE_TRANSITIONS {
+    ULONG States[MRT_STATE_BUCKETS][MRT_STATE_BUCKETS];    // [old][new], state changes only
+    ULONG EnteredWait[MRT_WAIT_BUCKETS];    // waits started (new wait, or new reason)
+    ULONG LeftWait[MRT_WAIT_BUCKETS];       // waits ended
+    ULONG Created[MRT_STATE_BUCKETS];       // new threads by current state
+    ULONG Exited[MRT_STATE_BUCKETS];        // gone threads by last state
+} MRT_STATE_TRANSITIONS;
+
+// -----------------------------
+// Instrumentation
+// -----------------------------
+// Process-wide counters and per-phase timings of every snapshot build
+// (one-shot, arena and collector). Recording is a few plain adds and one
+// monotonic timestamp per phase, folded into the totals once per snapshot.
+// Build with MRT_STATS_ENABLED defined as 0 (make STATS=0) to compile it out
+// entirely; MrtTInfo_GetStats then returns STATUS_NOT_SUPPORTED.
+#ifndef MRT_STATS_ENABLED
+#define MRT_STATS_ENABLED 1
+#endif
+
+typedef enum _MRT_STATS_PHASE {
+    MRT_PHASE_SNAPSHOT,     // whole build, query included
+    MRT_PHASE_QUERY,        // provider query with its retries
+    MRT_PHASE_CONVERT,      // raw entries to records, image names
+    MRT_PHASE_ENRICH,       // OpenThread / NtQueryInformationThread pass
+    MRT_PHASE_REMOTE,       // TEB/PEB reads of other processes
+    MRT_PHASE_STRINGS,      // PEB string capture of the current process
+    MRT_PHASE_COUNT
+} MRT_STATS_PHASE;
+
+// Histogram[i] counts durations of 2^i to 2^(i+1)-1 ns; the last bucket is open
+#define MRT_STATS_BUCKETS 32
+
+typedef struct _MRT_PHASE_STATS {
+    ULONGLONG Count;
+    ULONGLONG TotalNs;
+    ULONGLONG MaxNs;
+    ULONGLONG Histogram[MRT_STATS_BUCKETS];
+} MRT_PHASE_STATS;
+
+typedef struct _MRT_STATS_COUNTERS {
+    ULONGLONG Snapshots;        // builds that completed
+    ULONGLONG Failures;         // builds that returned an error
+    ULONGLONG Queries;          // provider queries (replayed builds make none)
+    ULONGLONG QueryRetries;     // STATUS_INFO_LENGTH_MISMATCH rounds
+    ULONGLONG HandlesOpened;    // OpenThread successes
+    ULONGLONG HandlesFailed;    // OpenThread failures
+    ULONGLONG HandlesReused;    // handles (or failures) kept by a collector cache
+    ULONGLONG EnrichCalls;      // NtQueryInformationThread calls
+    ULONGLONG EnrichSkipped;    // threads left unenriched though the flags asked for it
+    ULONGLONG RemoteReads;      // memory reader calls
+    ULONGLONG RemoteFailures;   // remote reads that could not be satisfied
+    ULONGLONG Allocations;      // records and strings allocated (heap or arena)
+    ULONGLONG BytesAllocated;
+    ULONGLONG StringsCopied;    // strings copied into a snapshot or string pool
+    ULONGLONG StringsShared;    // image names served by the string pool
+} MRT_STATS_COUNTERS;
+
+typedef struct _MRT_STATS {
+    MRT_STATS_COUNTERS Totals;  // cumulative since process start
+    ULONG QueryBufferSize;      // capacity of the last successful query buffer
+    ULONG QueryLength;          // bytes it returned
+    MRT_PHASE_STATS Phases[MRT_PHASE_COUNT];
+} MRT_STATS;
+
+// -----------------------------
+// Zero-copy cursor
+// -----------------------------
+// Walks the NextEntryOffset chain of a SystemProcessInformation buffer in place.
+// Entries are bounds-checked against the buffer length; a malformed chain stops
+// the walk and sets Corrupt. Works on any buffer (live, recorded or synthetic).
+typedef struct _MRT_PROCESS_CURSOR {
+    const BYTE* Base;
+    ULONG Length;
+    ULONG Offset;       // offset of the next entry
+    BOOLEAN Done;
+    BOOLEAN Corrupt;
+} MRT_PROCESS_CURSOR;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -361,6 +1152,10 @@ extern "C" {
 // API declarations
 // -----------------------------
 NTSTATUS MrtTInfo_GetAllProcesses(MRT_PROCESS_INFO** Processes, ULONG* Count);
+NTSTATUS MrtTInfo_GetAllProcessesEx(ULONG Flags, MRT_PROCESS_INFO** Processes, ULONG* Count);
+ULONG MrtTInfo_NormalizeQueryFlags(ULONG Flags);
+// Image names may be shared between records (one copy per distinct name) and
+// thread PEB strings point at their process's copy; each buffer is freed once.
 void MrtTInfo_FreeProcesses(MRT_PROCESS_INFO* Processes, ULONG Count);
 wchar_t* MrtTInfo_UnicodeStringToWString(UNICODE_STRING* ustr);
 const char* MrtHelper_WaitReasonToString(MRT_WAIT_REASON reason);
@@ -368,8 +1163,249 @@ const char* MrtHelper_ThreadStateToString(MRT_THREAD_STATE state);
 void MrtHelper_PrintSEHChain(PVOID exceptionList);
 void MrtHelper_PrintModules(PEB_LDR_DATA* ldr);
 MRT_PROCESS_INFO* MrtTInfo_FindProcessByPID(MRT_PROCESS_INFO* processes, ULONG count, DWORD pid);
+// For the calling thread's own TID missing from the array, the record comes
+// from a live query into thread-local storage, valid until the next such call
+// on the same thread.
 MRT_THREAD_INFO* MrtTInfo_FindThreadByTID(MRT_PROCESS_INFO* processes, ULONG count, DWORD tid);
 
+// Arena snapshots: records live in the arena, do NOT call MrtTInfo_FreeProcesses on them.
+MRT_ARENA* MrtTInfo_ArenaCreate(SIZE_T blockSize); // 0 = default block size
+void MrtTInfo_ArenaReset(MRT_ARENA* arena);        // releases every snapshot built in the arena
+void MrtTInfo_ArenaDestroy(MRT_ARENA* arena);
+void MrtTInfo_ArenaGetStats(const MRT_ARENA* arena, MRT_ALLOC_STATS* stats);
+NTSTATUS MrtTInfo_GetAllProcessesInArena(MRT_ARENA* Arena, MRT_PROCESS_INFO** Processes, ULONG* Count);
+
+// Collector snapshots are owned by the collector and stay valid until the next
+// refresh or destroy.
+NTSTATUS MrtTInfo_CollectorCreate(MRT_COLLECTOR** Collector);
+NTSTATUS MrtTInfo_CollectorRefresh(MRT_COLLECTOR* Collector, MRT_PROCESS_INFO** Processes, ULONG* Count);
+void MrtTInfo_CollectorDestroy(MRT_COLLECTOR* Collector);
+void MrtTInfo_CollectorSetQueryFlags(MRT_COLLECTOR* Collector, ULONG Flags); // default MRT_QUERY_ALL (no remote reads)
+// Threads used for per-thread enrichment, including the refreshing one.
+// 1 (default) = serial, 0 = one per CPU. Results are identical for any count.
+NTSTATUS MrtTInfo_CollectorSetWorkerCount(MRT_COLLECTOR* Collector, ULONG Workers);
+void MrtTInfo_CollectorGetAllocStats(const MRT_COLLECTOR* Collector, MRT_ALLOC_STATS* stats);
+ULONG MrtTInfo_CollectorGetBufferSize(const MRT_COLLECTOR* Collector);
+// Opt-in: keeps thread handles open across refreshes, keyed by (TID, CreateTime),
+// so a steady-state refresh makes no OpenThread/CloseHandle calls. Handles of
+// threads missing from the latest snapshot are closed after it is built;
+// threads beyond MaxHandles get a handle for that refresh only. OpenThread
+// failures are cached too. 0 disables the cache and closes every handle.
+NTSTATUS MrtTInfo_CollectorEnableHandleCache(MRT_COLLECTOR* Collector, ULONG MaxHandles);
+void MrtTInfo_CollectorGetHandleCacheStats(const MRT_COLLECTOR* Collector, MRT_HANDLE_CACHE_STATS* stats);
+
+// Image names are interned: processes with the same name share one buffer,
+// within a snapshot and across refreshes (names unused for a few refreshes are
+// dropped). Equal names can be compared by ImageName.Buffer.
+void MrtTInfo_CollectorGetStringPoolStats(const MRT_COLLECTOR* Collector, MRT_STRING_POOL_STATS* stats);
+
+// Refreshes only the raw SystemProcessInformation buffer (no conversion, no
+// enrichment). The buffer belongs to the collector and is overwritten by the
+// next refresh of either kind.
+NTSTATUS MrtTInfo_CollectorQueryRaw(MRT_COLLECTOR* Collector, const void** Buffer, ULONG* Length);
+
+NTSTATUS MrtTInfo_IndexBuild(MRT_PROCESS_INFO* processes, ULONG count, MRT_SNAPSHOT_INDEX** Index);
+void MrtTInfo_IndexFree(MRT_SNAPSHOT_INDEX* Index);
+MRT_PROCESS_INFO* MrtTInfo_IndexFindProcess(const MRT_SNAPSHOT_INDEX* Index, DWORD pid);
+MRT_THREAD_INFO* MrtTInfo_IndexFindThread(const MRT_SNAPSHOT_INDEX* Index, DWORD tid, MRT_PROCESS_INFO** Owner);
+// Batched lookups: results[i] is NULL for unknown IDs, returns the number found.
+ULONG MrtTInfo_IndexFindProcesses(const MRT_SNAPSHOT_INDEX* Index, const DWORD* pids, ULONG count, MRT_PROCESS_INFO** results);
+ULONG MrtTInfo_IndexFindThreads(const MRT_SNAPSHOT_INDEX* Index, const DWORD* tids, ULONG count, MRT_THREAD_INFO** results, MRT_PROCESS_INFO** owners);
+
+// Collector-built index: rebuilt in the collector's arena on every refresh
+// when enabled, NULL otherwise.
+void MrtTInfo_CollectorEnableIndex(MRT_COLLECTOR* Collector, BOOL enable);
+const MRT_SNAPSHOT_INDEX* MrtTInfo_CollectorGetIndex(const MRT_COLLECTOR* Collector);
+
+// Diff of two snapshots (any source). Matching is a sorted merge-join after a
+// radix sort of the identity keys: linear in the number of records.
+NTSTATUS MrtTInfo_Diff(
+    const MRT_PROCESS_INFO* Old, ULONG OldCount,
+    const MRT_PROCESS_INFO* New, ULONG NewCount,
+    MRT_SNAPSHOT_DIFF** Diff
+);
+void MrtTInfo_FreeDiff(MRT_SNAPSHOT_DIFF* Diff);
+
+// Sampler. IntervalMs 0 creates a manual sampler advanced by MrtTInfo_SamplerTick;
+// otherwise a background thread ticks until MrtTInfo_SamplerDestroy.
+// Acquired samples stay valid and unchanged until released.
+NTSTATUS MrtTInfo_SamplerCreate(ULONG IntervalMs, ULONG HistoryDepth, MRT_SAMPLER** Sampler);
+void MrtTInfo_SamplerDestroy(MRT_SAMPLER* Sampler);
+NTSTATUS MrtTInfo_SamplerTick(MRT_SAMPLER* Sampler);
+NTSTATUS MrtTInfo_SamplerGetLastStatus(MRT_SAMPLER* Sampler);   // status of the last tick
+const MRT_SAMPLE* MrtTInfo_SamplerAcquire(MRT_SAMPLER* Sampler, ULONG Age); // 0 = latest, NULL if gone
+// Ticks read Buffer instead of the live system (see MrtTInfo_CollectorSetReplayBuffer)
+NTSTATUS MrtTInfo_SamplerSetReplayBuffer(MRT_SAMPLER* Sampler, const void* Buffer, ULONG Length);
+// Heap figures include the sampler's arrays; none grow once every slot was written
+void MrtTInfo_SamplerGetAllocStats(MRT_SAMPLER* Sampler, MRT_ALLOC_STATS* stats);
+void MrtTInfo_SamplerRelease(MRT_SAMPLER* Sampler, const MRT_SAMPLE* Sample);
+const MRT_PROCESS_RATE* MrtTInfo_SampleFindProcess(const MRT_SAMPLE* Sample, DWORD pid);
+const MRT_THREAD_RATE* MrtTInfo_SampleFindThread(const MRT_SAMPLE* Sample, DWORD tid);
+
+// Refresher. Collector (NULL: a default one) supplies the query settings and
+// belongs to the refresher once creation succeeds. IntervalMs 0 creates a manual
+// refresher advanced by MrtTInfo_RefresherTick. Acquire never blocks and
+// returns NULL before the first snapshot; release every snapshot before
+// MrtTInfo_RefresherDestroy.
+NTSTATUS MrtTInfo_RefresherCreate(MRT_COLLECTOR* Collector, ULONG IntervalMs, MRT_REFRESHER** Refresher);
+void MrtTInfo_RefresherDestroy(MRT_REFRESHER* Refresher);
+NTSTATUS MrtTInfo_RefresherTick(MRT_REFRESHER* Refresher);
+NTSTATUS MrtTInfo_RefresherGetLastStatus(MRT_REFRESHER* Refresher);
+const MRT_SHARED_SNAPSHOT* MrtTInfo_RefresherAcquire(MRT_REFRESHER* Refresher);
+void MrtTInfo_RefresherRelease(MRT_REFRESHER* Refresher, const MRT_SHARED_SNAPSHOT* Snapshot);
+
+// Snapshot files. Encode with Buffer NULL (or too small) returns
+// STATUS_BUFFER_TOO_SMALL and the required size.
+NTSTATUS MrtTInfo_SnapshotEncode(const MRT_PROCESS_INFO* Processes, ULONG Count, void* Buffer, SIZE_T Capacity, SIZE_T* Size);
+NTSTATUS MrtTInfo_SnapshotWrite(const MRT_PROCESS_INFO* Processes, ULONG Count, const char* path);
+NTSTATUS MrtTInfo_SnapshotOpen(const char* path, MRT_SNAPSHOT_VIEW* View);
+NTSTATUS MrtTInfo_SnapshotView(const void* image, SIZE_T size, MRT_SNAPSHOT_VIEW* View);
+void MrtTInfo_SnapshotClose(MRT_SNAPSHOT_VIEW* View);
+// Bounds-checked accessors; NULL when the record points outside the image
+const USHORT* MrtTInfo_SnapshotString(const MRT_SNAPSHOT_VIEW* View, ULONG offset, ULONG length);
+const MRT_SNAPSHOT_THREAD* MrtTInfo_SnapshotThreads(const MRT_SNAPSHOT_VIEW* View, const MRT_SNAPSHOT_PROCESS* Process);
+
+// Text export. Encode into a fixed buffer returns STATUS_BUFFER_TOO_SMALL and
+// the required size when it does not fit (Buffer may be NULL to size only).
+// ExportToFd streams in chunks of MRT_EXPORT_CHUNK bytes through write (_write
+// on Windows), for files, pipes and sockets alike.
+#define MRT_EXPORT_CHUNK (64 * 1024)
+NTSTATUS MrtTInfo_ExportEncode(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format,
+                               void* Buffer, SIZE_T Capacity, SIZE_T* Size);
+NTSTATUS MrtTInfo_ExportAppend(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format,
+                               MRT_EXPORT_BUFFER* Buffer);
+NTSTATUS MrtTInfo_ExportToFd(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format, int fd);
+void MrtTInfo_ExportBufferFree(MRT_EXPORT_BUFFER* Buffer);
+
+// Raw SystemProcessInformation recordings. Loading relocates ImageName into the
+// returned heap buffer and converts it to the host WCHAR; free with MrtTInfo_FreeRawBuffer.
+NTSTATUS MrtTInfo_RecordRawBuffer(const char* path, const void* Buffer, ULONG Length);
+NTSTATUS MrtTInfo_LoadRawBuffer(const char* path, void** Buffer, ULONG* Length);
+void MrtTInfo_FreeRawBuffer(void* Buffer);
+// Synthetic buffer for benchmarks and tests: Processes entries (the first is
+// the idle process) of ThreadsPerProcess threads each, with realistic image
+// names, PIDs/TIDs in steps of 4 and mostly waiting threads. The same Seed
+// gives the same buffer. Free with MrtTInfo_FreeRawBuffer.
+NTSTATUS MrtTInfo_GenerateRawBuffer(ULONG Processes, ULONG ThreadsPerProcess, ULONG Seed, void** Buffer, ULONG* Length);
+
+// Replay: snapshots are converted from Buffer instead of the live query
+// (counters only, no enrichment). The buffer must outlive the replay; NULL
+// returns to the live system. Not synchronized with concurrent snapshots.
+NTSTATUS MrtTInfo_SetReplayBuffer(const void* Buffer, ULONG Length);
+NTSTATUS MrtTInfo_CollectorSetReplayBuffer(MRT_COLLECTOR* Collector, const void* Buffer, ULONG Length);
+
+// Module cache. The array returned by GetModules stays valid until the next
+// GetModules or Destroy on the same cache; a cache is not synchronized.
+NTSTATUS MrtTInfo_ModuleCacheCreate(MRT_MODULE_CACHE** Cache);
+void MrtTInfo_ModuleCacheDestroy(MRT_MODULE_CACHE* Cache);
+NTSTATUS MrtTInfo_GetModules(MRT_MODULE_CACHE* Cache, const MRT_MODULE_INFO** Modules, ULONG* Count);
+ULONG MrtTInfo_ModuleCacheRebuilds(const MRT_MODULE_CACHE* Cache);  // list rebuilds so far
+
+// Address index. Modules may be freed once the index is built. ResolveStartAddresses
+// walks threads in snapshot order (only PID's threads unless PID is 0), writing one
+// symbol per walked thread and adding each to ModuleThreads[module]; both outputs
+// are optional and ModuleThreads must hold the module count. Returns the number walked.
+NTSTATUS MrtTInfo_AddressIndexBuild(const MRT_MODULE_INFO* Modules, ULONG Count, MRT_ADDRESS_INDEX** Index);
+void MrtTInfo_AddressIndexFree(MRT_ADDRESS_INDEX* Index);
+ULONG MrtTInfo_AddressIndexModuleCount(const MRT_ADDRESS_INDEX* Index);
+MRT_ADDRESS_SYMBOL MrtTInfo_AddressIndexLookup(const MRT_ADDRESS_INDEX* Index, PVOID Address);
+ULONG MrtTInfo_AddressIndexLookupBatch(const MRT_ADDRESS_INDEX* Index, const PVOID* Addresses, ULONG Count, MRT_ADDRESS_SYMBOL* Symbols); // returns resolved count
+ULONG MrtTInfo_ResolveStartAddresses(const MRT_ADDRESS_INDEX* Index, const MRT_PROCESS_INFO* Processes, ULONG Count, DWORD PID, MRT_ADDRESS_SYMBOL* Symbols, ULONG* ModuleThreads);
+
+// Providers. The default is ntdll on Windows and /proc on Linux (NULL elsewhere);
+// a replay buffer takes precedence over any provider. Passing NULL restores the default.
+const MRT_PROVIDER* MrtTInfo_GetDefaultProvider(void);
+const MRT_PROVIDER* MrtTInfo_GetProcfsProvider(void);   // NULL where /proc is not available
+NTSTATUS MrtTInfo_SetProvider(const MRT_PROVIDER* Provider);
+NTSTATUS MrtTInfo_CollectorSetProvider(MRT_COLLECTOR* Collector, const MRT_PROVIDER* Provider);
+
+// Memory readers for MRT_QUERY_REMOTE. The default is ReadProcessMemory on
+// Windows and NULL elsewhere (no remote reads). Passing NULL restores it.
+const MRT_MEMORY_READER* MrtTInfo_GetDefaultMemoryReader(void);
+NTSTATUS MrtTInfo_SetMemoryReader(const MRT_MEMORY_READER* Reader);
+NTSTATUS MrtTInfo_CollectorSetMemoryReader(MRT_COLLECTOR* Collector, const MRT_MEMORY_READER* Reader);
+void MrtTInfo_FakeReaderInit(MRT_FAKE_MEMORY* Memory, MRT_MEMORY_READER* Reader);
+
+// Fills the TEB fields (and PEB fields and strings, per Flags) of every thread
+// of Process whose TebAddress is set, from Reader. Strings are heap copies
+// owned by Process (freed by MrtTInfo_FreeProcesses). Stats is optional and
+// accumulates.
+NTSTATUS MrtTInfo_ReadProcessEnvironment(const MRT_MEMORY_READER* Reader, MRT_PROCESS_INFO* Process, ULONG Flags, MRT_REMOTE_STATS* Stats);
+
+// Filtered snapshots. The filter is copied; the result is freed with
+// MrtTInfo_FreeProcesses. A collector filter applies to every later refresh
+// (NULL removes it).
+void MrtTInfo_FilterInit(MRT_PROCESS_FILTER* Filter);
+NTSTATUS MrtTInfo_GetProcessesFiltered(const MRT_PROCESS_FILTER* Filter, ULONG Flags, MRT_PROCESS_INFO** Processes, ULONG* Count);
+NTSTATUS MrtTInfo_CollectorSetFilter(MRT_COLLECTOR* Collector, const MRT_PROCESS_FILTER* Filter);
+ULONGLONG MrtTInfo_GetProcessField(const MRT_PROCESS_INFO* Process, MRT_PROCESS_FIELD Field);
+
+// Aggregation. Group names point into the snapshot, which must outlive the result.
+// Top* fill at most N entries of Top, largest value first (ties: earlier
+// record first), and return how many were filled.
+NTSTATUS MrtTInfo_Aggregate(const MRT_PROCESS_INFO* Processes, ULONG Count, const MRT_AGGREGATE_SPEC* Spec, MRT_AGGREGATE** Result);
+void MrtTInfo_FreeAggregate(MRT_AGGREGATE* Result);
+ULONGLONG MrtTInfo_GetThreadField(const MRT_THREAD_INFO* Thread, MRT_THREAD_FIELD Field);
+ULONG MrtTInfo_TopProcesses(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_PROCESS_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top);
+ULONG MrtTInfo_TopThreads(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_THREAD_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top);
+// Deltas: Process indexes Diff->Processes, Thread indexes Diff->Threads (the
+// other one is MRT_DIFF_NONE).
+// Fields a delta does not carry (peak/private/virtual sizes, priorities) rank as 0.
+ULONG MrtTInfo_TopProcessDeltas(const MRT_SNAPSHOT_DIFF* Diff, MRT_PROCESS_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top);
+ULONG MrtTInfo_TopThreadDeltas(const MRT_SNAPSHOT_DIFF* Diff, MRT_THREAD_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top);
+
+// Columnar snapshots: one allocation, freed with MrtTInfo_ColumnsFree. Built
+// from records (Cold[i].Record points into them) or straight from a raw
+// SystemProcessInformation buffer without any per-thread record.
+NTSTATUS MrtTInfo_ColumnsBuild(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_THREAD_COLUMNS** Columns);
+NTSTATUS MrtTInfo_ColumnsBuildFromBuffer(const void* Buffer, ULONG Length, MRT_THREAD_COLUMNS** Columns);
+void MrtTInfo_ColumnsFree(MRT_THREAD_COLUMNS* Columns);
+
+// Reduction kernels over one column (independent accumulators, no branches in
+// the loop body, so compilers vectorise them). Max of an empty column is 0.
+LONGLONG MrtTInfo_ColumnSumI64(const LONGLONG* Values, ULONG Count);
+ULONGLONG MrtTInfo_ColumnSumU32(const ULONG* Values, ULONG Count);
+LONGLONG MrtTInfo_ColumnMaxI64(const LONGLONG* Values, ULONG Count);
+ULONG MrtTInfo_ColumnMaxU32(const ULONG* Values, ULONG Count);
+void MrtTInfo_ColumnHistogramU8(const BYTE* Values, ULONG Count, ULONG Histogram[256]); // adds to Histogram
+
+// Process tree: one allocation, freed with MrtTInfo_TreeFree; the snapshot
+// must outlive it. The first process with a given PID wins, as in the index.
+// Rollup fills Totals[i * FieldCount + f] with Fields[f] summed over the
+// subtree of process i in one pass (MRT_FIELD_NONE counts processes).
+// Descendants points *Descendants into Order and returns how many there are
+// (0 for a leaf or an unknown PID).
+NTSTATUS MrtTInfo_TreeBuild(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_PROCESS_TREE** Tree);
+void MrtTInfo_TreeFree(MRT_PROCESS_TREE* Tree);
+ULONG MrtTInfo_TreeFind(const MRT_PROCESS_TREE* Tree, DWORD pid);    // index or MRT_TREE_NONE
+NTSTATUS MrtTInfo_TreeRollup(const MRT_PROCESS_TREE* Tree, const MRT_PROCESS_FIELD* Fields, ULONG FieldCount, ULONGLONG* Totals);
+ULONG MrtTInfo_TreeDescendants(const MRT_PROCESS_TREE* Tree, DWORD pid, const ULONG** Descendants);
+
+// Thread state decoding (table lookups) and contention reporting
+ULONG MrtTInfo_StateBucket(MRT_THREAD_STATE State);
+ULONG MrtTInfo_WaitBucket(MRT_WAIT_REASON WaitReason);
+MRT_WAIT_CLASS MrtTInfo_WaitReasonClass(MRT_WAIT_REASON WaitReason);    // by reason alone: never LOADER_LOCK
+NTSTATUS MrtTInfo_ContentionReport(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_CONTENTION_REPORT** Report);
+void MrtTInfo_FreeContentionReport(MRT_CONTENTION_REPORT* Report);
+void MrtTInfo_StateTransitions(const MRT_SNAPSHOT_DIFF* Diff, MRT_STATE_TRANSITIONS* Transitions);
+
+// Copy of the instrumentation totals. Each field is read atomically, not
+// the set: compare two copies taken between snapshots for per-interval rates.
+NTSTATUS MrtTInfo_GetStats(MRT_STATS* Stats);
+
+// Cursor API. Returned entries and name views point into the walked buffer.
+BOOL MrtTInfo_CursorInit(MRT_PROCESS_CURSOR* cursor, const void* buffer, ULONG length);
+const MRT_SYSTEM_PROCESS_INFORMATION* MrtTInfo_CursorNext(MRT_PROCESS_CURSOR* cursor);
+void MrtTInfo_CursorReset(MRT_PROCESS_CURSOR* cursor);
+ULONG MrtTInfo_CursorCount(const MRT_PROCESS_CURSOR* cursor);
+DWORD MrtTInfo_RawProcessId(const MRT_SYSTEM_PROCESS_INFORMATION* p);
+DWORD MrtTInfo_RawParentProcessId(const MRT_SYSTEM_PROCESS_INFORMATION* p);
+ULONG MrtTInfo_RawThreadCount(const MRT_SYSTEM_PROCESS_INFORMATION* p);
+const MRT_SYSTEM_THREAD_INFORMATION* MrtTInfo_RawThread(const MRT_SYSTEM_PROCESS_INFORMATION* p, ULONG index);
+DWORD MrtTInfo_RawThreadId(const MRT_SYSTEM_THREAD_INFORMATION* t);
+DWORD MrtTInfo_RawThreadProcessId(const MRT_SYSTEM_THREAD_INFORMATION* t);
+UNICODE_STRING MrtTInfo_RawImageName(const MRT_PROCESS_CURSOR* cursor, const MRT_SYSTEM_PROCESS_INFORMATION* p);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
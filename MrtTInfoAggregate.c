@@ -0,0 +1,392 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// Groups are sized to what the snapshot holds: keys taken from the process
+// (name, session, parent PID) are numbered in a first hashing pass over the
+// processes, thread states have at most MRT_STATE_BUCKETS groups.
+#define MRT_EMPTY_SLOT ((ULONG)-1)
+
+ULONGLONG MrtTInfo_GetThreadField(const MRT_THREAD_INFO* Thread, MRT_THREAD_FIELD Field)
+{
+    if (!Thread)
+        return 0;
+
+    switch (Field) {
+    case MRT_THREAD_FIELD_KERNEL_TIME:      return (ULONGLONG)Thread->KernelTime.QuadPart;
+    case MRT_THREAD_FIELD_USER_TIME:        return (ULONGLONG)Thread->UserTime.QuadPart;
+    case MRT_THREAD_FIELD_CPU_TIME:         return (ULONGLONG)Thread->KernelTime.QuadPart + (ULONGLONG)Thread->UserTime.QuadPart;
+    case MRT_THREAD_FIELD_CONTEXT_SWITCHES: return Thread->ContextSwitches;
+    case MRT_THREAD_FIELD_PRIORITY:         return (ULONGLONG)(LONGLONG)Thread->Priority;
+    case MRT_THREAD_FIELD_BASE_PRIORITY:    return (ULONGLONG)(LONGLONG)Thread->BasePriority;
+    default:                                return 0;
+    }
+}
+
+static ULONG AggregateHashName(const UNICODE_STRING* name)
+{
+    // FNV-1a over folded characters
+    ULONG h = 2166136261u;
+    ULONG length = name->Buffer ? name->Length / sizeof(WCHAR) : 0;
+    for (ULONG i = 0; i < length; i++) {
+        h ^= (ULONG)MrtFilter_Fold(name->Buffer[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static BOOL AggregateSameName(const UNICODE_STRING* a, const UNICODE_STRING* b)
+{
+    // Interned names: one buffer per distinct name
+    if (a->Buffer == b->Buffer && a->Length == b->Length)
+        return TRUE;
+
+    ULONG la = a->Buffer ? a->Length / sizeof(WCHAR) : 0;
+    ULONG lb = b->Buffer ? b->Length / sizeof(WCHAR) : 0;
+    if (la != lb)
+        return FALSE;
+    for (ULONG i = 0; i < la; i++) {
+        if (MrtFilter_Fold(a->Buffer[i]) != MrtFilter_Fold(b->Buffer[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void AggregateAdd(MRT_GROUP* g, ULONGLONG value)
+{
+    g->Count++;
+    g->Sum += value;
+    if (value < g->Min)
+        g->Min = value;
+    if (value > g->Max)
+        g->Max = value;
+}
+
+static ULONGLONG AggregateKey(MRT_GROUP_BY groupBy, const MRT_PROCESS_INFO* p, const MRT_THREAD_INFO* t)
+{
+    switch (groupBy) {
+    case MRT_GROUP_SESSION:      return p->SessionId;
+    case MRT_GROUP_PARENT_PID:   return p->ParentPID;
+    case MRT_GROUP_THREAD_STATE: return t ? (ULONGLONG)t->ThreadState : 0;
+    default:                     return 0;
+    }
+}
+
+static ULONG AggregateHashKey(MRT_GROUP_BY groupBy, const MRT_PROCESS_INFO* p)
+{
+    if (groupBy == MRT_GROUP_IMAGE_NAME)
+        return AggregateHashName(&p->ImageName);
+    return (ULONG)((AggregateKey(groupBy, p, NULL) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static BOOL AggregateSameKey(MRT_GROUP_BY groupBy, const MRT_PROCESS_INFO* a, const MRT_PROCESS_INFO* b)
+{
+    if (groupBy == MRT_GROUP_IMAGE_NAME)
+        return AggregateSameName(&a->ImageName, &b->ImageName);
+    return AggregateKey(groupBy, a, NULL) == AggregateKey(groupBy, b, NULL);
+}
+
+// Group number of every process in first-seen order (MRT_EMPTY_SLOT for a
+// process that adds no record); slots keep the first process of each key.
+// Returns the number of distinct groups.
+static ULONG AggregateNumber(const MRT_PROCESS_INFO* Processes, ULONG Count, const MRT_AGGREGATE_SPEC* Spec,
+                             ULONG* slots, ULONG mask, ULONG* groupOf)
+{
+    ULONG groups = 0;
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* p = &Processes[i];
+        groupOf[i] = MRT_EMPTY_SLOT;
+        if (Spec->Threads && (!p->Threads || !p->ThreadCount))
+            continue;
+
+        for (ULONG s = AggregateHashKey(Spec->GroupBy, p) & mask;; s = (s + 1) & mask) {
+            ULONG first = slots[s];
+            if (first == MRT_EMPTY_SLOT) {
+                slots[s] = i;
+                groupOf[i] = groups++;
+                break;
+            }
+            if (AggregateSameKey(Spec->GroupBy, &Processes[first], p)) {
+                groupOf[i] = groupOf[first];
+                break;
+            }
+        }
+    }
+    return groups;
+}
+
+static void AggregateInit(MRT_GROUP* g, ULONGLONG key, const UNICODE_STRING* name)
+{
+    memset(g, 0, sizeof(*g));
+    g->Key = key;
+    if (name)
+        g->Name = *name;
+    g->Min = (ULONGLONG)-1;
+}
+
+NTSTATUS MrtTInfo_Aggregate(const MRT_PROCESS_INFO* Processes, ULONG Count, const MRT_AGGREGATE_SPEC* Spec, MRT_AGGREGATE** Result)
+{
+    if (!Result)
+        return STATUS_INVALID_PARAMETER;
+
+    *Result = NULL;
+
+    if (!Spec || (!Processes && Count) ||
+        (ULONG)Spec->GroupBy >= MRT_GROUP_COUNT ||
+        (ULONG)Spec->ProcessField >= MRT_FIELD_COUNT ||
+        (ULONG)Spec->ThreadField >= MRT_THREAD_FIELD_COUNT ||
+        (Spec->GroupBy == MRT_GROUP_THREAD_STATE && !Spec->Threads) ||
+        Count > 0x40000000UL)
+        return STATUS_INVALID_PARAMETER;
+
+    // Session, parent PID and image name come from the process, also for
+    // thread records: number the distinct ones first
+    BOOL byProcess = Spec->GroupBy == MRT_GROUP_IMAGE_NAME ||
+                     Spec->GroupBy == MRT_GROUP_SESSION ||
+                     Spec->GroupBy == MRT_GROUP_PARENT_PID;
+    ULONG* scratch = NULL;
+    ULONG* groupOf = NULL;
+    ULONG maxGroups = Spec->GroupBy == MRT_GROUP_THREAD_STATE ? MRT_STATE_BUCKETS : 1;
+
+    if (byProcess) {
+        ULONG slots = 16;
+        while (slots < Count * 2)
+            slots *= 2;
+        scratch = (ULONG*)malloc(((SIZE_T)slots + Count) * sizeof(ULONG));
+        if (!scratch)
+            return STATUS_NO_MEMORY;
+        memset(scratch, 0xFF, slots * sizeof(ULONG));
+        groupOf = scratch + slots;
+        maxGroups = AggregateNumber(Processes, Count, Spec, scratch, slots - 1, groupOf);
+    }
+
+    BYTE* block = (BYTE*)malloc(sizeof(MRT_AGGREGATE) + (SIZE_T)(maxGroups ? maxGroups : 1) * sizeof(MRT_GROUP));
+    if (!block) {
+        free(scratch);
+        return STATUS_NO_MEMORY;
+    }
+
+    MRT_AGGREGATE* result = (MRT_AGGREGATE*)block;
+    MRT_GROUP* groups = (MRT_GROUP*)(block + sizeof(MRT_AGGREGATE));
+    ULONG groupCount = 0;
+
+    // Numbered groups are made up front in their first-seen order; state and
+    // single groups appear when their first record does
+    ULONG bucketGroup[MRT_STATE_BUCKETS];
+    memset(bucketGroup, 0xFF, sizeof(bucketGroup));
+    if (byProcess) {
+        for (ULONG i = 0; i < Count && groupCount < maxGroups; i++) {
+            if (groupOf[i] == groupCount) {
+                const MRT_PROCESS_INFO* p = &Processes[i];
+                AggregateInit(&groups[groupCount++], AggregateKey(Spec->GroupBy, p, NULL),
+                              Spec->GroupBy == MRT_GROUP_IMAGE_NAME ? &p->ImageName : NULL);
+            }
+        }
+    }
+
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* p = &Processes[i];
+        MRT_GROUP* processGroup = byProcess && groupOf[i] != MRT_EMPTY_SLOT ? &groups[groupOf[i]] : NULL;
+
+        if (!Spec->Threads) {
+            if (!processGroup) {
+                if (bucketGroup[0] == MRT_EMPTY_SLOT) {
+                    bucketGroup[0] = groupCount;
+                    AggregateInit(&groups[groupCount++], 0, NULL);
+                }
+                processGroup = &groups[bucketGroup[0]];
+            }
+            AggregateAdd(processGroup, MrtTInfo_GetProcessField(p, Spec->ProcessField));
+            continue;
+        }
+
+        if (!p->Threads)
+            continue;
+
+        for (ULONG t = 0; t < p->ThreadCount; t++) {
+            const MRT_THREAD_INFO* mt = &p->Threads[t];
+            MRT_GROUP* g = processGroup;
+            if (!g) {
+                // Raw states past the table share its last bucket, as in the state counts
+                ULONG bucket = 0;
+                if (Spec->GroupBy == MRT_GROUP_THREAD_STATE) {
+                    bucket = (ULONG)mt->ThreadState < MRT_STATE_BUCKETS - 1
+                        ? (ULONG)mt->ThreadState : MRT_STATE_BUCKETS - 1;
+                }
+                if (bucketGroup[bucket] == MRT_EMPTY_SLOT) {
+                    bucketGroup[bucket] = groupCount;
+                    AggregateInit(&groups[groupCount++], bucket, NULL);
+                }
+                g = &groups[bucketGroup[bucket]];
+            }
+            AggregateAdd(g, MrtTInfo_GetThreadField(mt, Spec->ThreadField));
+        }
+    }
+
+    free(scratch);
+    result->Groups = groupCount ? groups : NULL;
+    result->GroupCount = groupCount;
+    *Result = result;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_FreeAggregate(MRT_AGGREGATE* Result)
+{
+    free(Result);
+}
+
+// -----------------------------
+// Top-N: bounded min-heap in the caller's buffer
+// -----------------------------
+// The root is the weakest kept entry; a candidate only costs a compare unless
+// it beats the root. Ties rank the earlier record higher.
+static BOOL TopLess(const MRT_TOP_ENTRY* a, const MRT_TOP_ENTRY* b)
+{
+    if (a->Value != b->Value)
+        return a->Value < b->Value;
+    if (a->Process != b->Process)
+        return a->Process > b->Process;
+    return a->Thread > b->Thread;
+}
+
+static void TopSiftDown(MRT_TOP_ENTRY* heap, ULONG n, ULONG i)
+{
+    MRT_TOP_ENTRY e = heap[i];
+    for (;;) {
+        ULONG c = 2 * i + 1;
+        if (c >= n)
+            break;
+        if (c + 1 < n && TopLess(&heap[c + 1], &heap[c]))
+            c++;
+        if (!TopLess(&heap[c], &e))
+            break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = e;
+}
+
+static void TopSiftUp(MRT_TOP_ENTRY* heap, ULONG i)
+{
+    MRT_TOP_ENTRY e = heap[i];
+    while (i) {
+        ULONG parent = (i - 1) / 2;
+        if (!TopLess(&e, &heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = e;
+}
+
+typedef struct _MRT_TOP_HEAP {
+    MRT_TOP_ENTRY* Entries;
+    ULONG Capacity;
+    ULONG Count;
+} MRT_TOP_HEAP;
+
+static void TopPush(MRT_TOP_HEAP* heap, LONGLONG value, ULONG process, ULONG thread)
+{
+    MRT_TOP_ENTRY e = { value, process, thread };
+    if (heap->Count < heap->Capacity) {
+        heap->Entries[heap->Count] = e;
+        TopSiftUp(heap->Entries, heap->Count++);
+    } else if (TopLess(&heap->Entries[0], &e)) {
+        heap->Entries[0] = e;
+        TopSiftDown(heap->Entries, heap->Count, 0);
+    }
+}
+
+// Heap sort in place: popping the minimum to the back leaves the largest first
+static ULONG TopFinish(MRT_TOP_HEAP* heap)
+{
+    for (ULONG n = heap->Count; n > 1; n--) {
+        MRT_TOP_ENTRY min = heap->Entries[0];
+        heap->Entries[0] = heap->Entries[n - 1];
+        heap->Entries[n - 1] = min;
+        TopSiftDown(heap->Entries, n - 1, 0);
+    }
+    return heap->Count;
+}
+
+ULONG MrtTInfo_TopProcesses(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_PROCESS_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top)
+{
+    if (!Processes || !Top || !N)
+        return 0;
+
+    MRT_TOP_HEAP heap = { Top, N, 0 };
+    for (ULONG i = 0; i < Count; i++)
+        TopPush(&heap, (LONGLONG)MrtTInfo_GetProcessField(&Processes[i], Field), i, MRT_DIFF_NONE);
+    return TopFinish(&heap);
+}
+
+ULONG MrtTInfo_TopThreads(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_THREAD_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top)
+{
+    if (!Processes || !Top || !N)
+        return 0;
+
+    MRT_TOP_HEAP heap = { Top, N, 0 };
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* p = &Processes[i];
+        if (!p->Threads)
+            continue;
+        for (ULONG t = 0; t < p->ThreadCount; t++)
+            TopPush(&heap, (LONGLONG)MrtTInfo_GetThreadField(&p->Threads[t], Field), i, t);
+    }
+    return TopFinish(&heap);
+}
+
+static LONGLONG TopProcessDeltaValue(const MRT_PROCESS_DELTA* d, MRT_PROCESS_FIELD field)
+{
+    switch (field) {
+    case MRT_FIELD_THREAD_COUNT:     return d->ThreadCount;
+    case MRT_FIELD_HANDLE_COUNT:     return d->HandleCount;
+    case MRT_FIELD_WORKING_SET:      return d->WorkingSetSize;
+    case MRT_FIELD_PAGE_FAULTS:      return d->PageFaultCount;
+    case MRT_FIELD_HARD_FAULTS:      return d->HardFaultCount;
+    case MRT_FIELD_USER_TIME:        return d->UserTime;
+    case MRT_FIELD_KERNEL_TIME:      return d->KernelTime;
+    case MRT_FIELD_CPU_TIME:         return d->UserTime + d->KernelTime;
+    case MRT_FIELD_CYCLE_TIME:       return d->CycleTime;
+    case MRT_FIELD_READ_BYTES:       return (LONGLONG)d->IoCounters.ReadTransferCount;
+    case MRT_FIELD_WRITE_BYTES:      return (LONGLONG)d->IoCounters.WriteTransferCount;
+    case MRT_FIELD_READ_OPS:         return (LONGLONG)d->IoCounters.ReadOperationCount;
+    case MRT_FIELD_WRITE_OPS:        return (LONGLONG)d->IoCounters.WriteOperationCount;
+    case MRT_FIELD_CONTEXT_SWITCHES: return d->ContextSwitches;
+    default:                         return 0;
+    }
+}
+
+static LONGLONG TopThreadDeltaValue(const MRT_THREAD_DELTA* d, MRT_THREAD_FIELD field)
+{
+    switch (field) {
+    case MRT_THREAD_FIELD_KERNEL_TIME:      return d->KernelTime;
+    case MRT_THREAD_FIELD_USER_TIME:        return d->UserTime;
+    case MRT_THREAD_FIELD_CPU_TIME:         return d->KernelTime + d->UserTime;
+    case MRT_THREAD_FIELD_CONTEXT_SWITCHES: return d->ContextSwitches;
+    default:                                return 0;
+    }
+}
+
+ULONG MrtTInfo_TopProcessDeltas(const MRT_SNAPSHOT_DIFF* Diff, MRT_PROCESS_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top)
+{
+    if (!Diff || !Top || !N)
+        return 0;
+
+    MRT_TOP_HEAP heap = { Top, N, 0 };
+    for (ULONG i = 0; i < Diff->ProcessCount; i++)
+        TopPush(&heap, TopProcessDeltaValue(&Diff->Processes[i], Field), i, MRT_DIFF_NONE);
+    return TopFinish(&heap);
+}
+
+ULONG MrtTInfo_TopThreadDeltas(const MRT_SNAPSHOT_DIFF* Diff, MRT_THREAD_FIELD Field, ULONG N, MRT_TOP_ENTRY* Top)
+{
+    if (!Diff || !Top || !N)
+        return 0;
+
+    // Thread deltas are one flat array: only Thread carries a position
+    MRT_TOP_HEAP heap = { Top, N, 0 };
+    for (ULONG i = 0; i < Diff->ThreadCount; i++)
+        TopPush(&heap, TopThreadDeltaValue(&Diff->Threads[i], Field), MRT_DIFF_NONE, i);
+    return TopFinish(&heap);
+}
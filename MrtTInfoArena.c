@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+#define MRT_ARENA_DEFAULT_BLOCK (256 * 1024)
+#define MRT_ARENA_ALIGN 16
+
+typedef struct _MRT_ARENA_BLOCK {
+    struct _MRT_ARENA_BLOCK* Next;
+    SIZE_T Size;   // usable bytes after the header
+    SIZE_T Used;
+} MRT_ARENA_BLOCK;
+
+// Header size rounded up so block payloads stay aligned
+#define MRT_ARENA_HEADER \
+    ((sizeof(MRT_ARENA_BLOCK) + MRT_ARENA_ALIGN - 1) & ~(SIZE_T)(MRT_ARENA_ALIGN - 1))
+
+struct _MRT_ARENA {
+    MRT_ARENA_BLOCK* First;
+    MRT_ARENA_BLOCK* Current;   // block new allocations are carved from
+    SIZE_T BlockSize;
+    MRT_ALLOC_STATS Stats;
+};
+
+static MRT_ARENA_BLOCK* ArenaNewBlock(MRT_ARENA* arena, SIZE_T minSize)
+{
+    SIZE_T size = arena->BlockSize;
+    if (size < minSize)
+        size = minSize;
+
+    MRT_ARENA_BLOCK* block = (MRT_ARENA_BLOCK*)malloc(MRT_ARENA_HEADER + size);
+    if (!block)
+        return NULL;
+
+    block->Next = NULL;
+    block->Size = size;
+    block->Used = 0;
+
+    arena->Stats.HeapAllocations++;
+    arena->Stats.HeapBytes += MRT_ARENA_HEADER + size;
+    arena->Stats.BlockCount++;
+    arena->Stats.BytesReserved += size;
+    return block;
+}
+
+MRT_ARENA* MrtTInfo_ArenaCreate(SIZE_T blockSize)
+{
+    MRT_ARENA* arena = (MRT_ARENA*)calloc(1, sizeof(MRT_ARENA));
+    if (!arena)
+        return NULL;
+
+    arena->BlockSize = blockSize ? blockSize : MRT_ARENA_DEFAULT_BLOCK;
+    return arena;
+}
+
+void* MrtArena_Alloc(MRT_ARENA* arena, SIZE_T size)
+{
+    if (!arena)
+        return NULL;
+
+    size = (size + MRT_ARENA_ALIGN - 1) & ~(SIZE_T)(MRT_ARENA_ALIGN - 1);
+    if (size == 0)
+        size = MRT_ARENA_ALIGN;
+
+    // Walk forward through blocks kept from earlier snapshots before growing
+    MRT_ARENA_BLOCK* block = arena->Current;
+    while (block && block->Size - block->Used < size) {
+        block = block->Next;
+        if (block)
+            block->Used = 0;
+    }
+
+    if (!block) {
+        block = ArenaNewBlock(arena, size);
+        if (!block)
+            return NULL;
+
+        if (arena->Current) {
+            // Splice after the current block; any tail blocks are already full
+            // or too small for this request, keep them for the next reset.
+            block->Next = arena->Current->Next;
+            arena->Current->Next = block;
+        } else {
+            arena->First = block;
+        }
+    }
+
+    arena->Current = block;
+
+    BYTE* ptr = (BYTE*)block + MRT_ARENA_HEADER + block->Used;
+    block->Used += size;
+    memset(ptr, 0, size);
+
+    arena->Stats.Allocations++;
+    arena->Stats.BytesUsed += size;
+    return ptr;
+}
+
+void MrtTInfo_ArenaReset(MRT_ARENA* arena)
+{
+    if (!arena)
+        return;
+
+    // Blocks are kept so the next snapshot reuses them without touching the heap
+    if (arena->First)
+        arena->First->Used = 0;
+    arena->Current = arena->First;
+
+    arena->Stats.Allocations = 0;
+    arena->Stats.BytesUsed = 0;
+}
+
+void MrtTInfo_ArenaDestroy(MRT_ARENA* arena)
+{
+    if (!arena)
+        return;
+
+    MRT_ARENA_BLOCK* block = arena->First;
+    while (block) {
+        MRT_ARENA_BLOCK* next = block->Next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
+
+void MrtTInfo_ArenaGetStats(const MRT_ARENA* arena, MRT_ALLOC_STATS* stats)
+{
+    if (!stats)
+        return;
+
+    if (!arena) {
+        ZeroMemory(stats, sizeof(*stats));
+        return;
+    }
+
+    *stats = arena->Stats;
+}
@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include "MrtTInfoInternal.h"
+
+struct _MRT_COLLECTOR {
+    const MRT_PROVIDER* Provider;   // NULL when the platform has no live source
+    const MRT_NTAPI* Nt;        // enrichment entry points, NULL off Windows
+    const void* Replay;         // recorded buffer used instead of the live query
+    ULONG ReplayLength;
+    MRT_QUERY_BUFFER Query;     // grow-only, reused by every refresh
+    MRT_ARENA* Arena;           // backs the current snapshot
+    MRT_PROCESS_INFO* Processes;
+    ULONG Count;
+    ULONG Flags;                // normalized MRT_QUERY_FLAGS
+    BOOLEAN BuildIndex;
+    MRT_SNAPSHOT_INDEX* Index;  // arena-backed, NULL unless BuildIndex
+    MRT_WORKER_POOL* Pool;      // NULL: enrichment on the refreshing thread
+    ULONG WorkerCount;
+    MRT_ENRICH_SCRATCH Scratch;
+    MRT_HANDLE_CACHE* Handles;  // NULL unless enabled
+    MRT_FILTER* Filter;         // NULL: every process
+    MRT_STRING_POOL* Strings;   // interned image names, shared across refreshes
+    const MRT_MEMORY_READER* Reader;    // MRT_QUERY_REMOTE source, NULL: none
+};
+
+// Raw buffer for the next snapshot: the replay buffer or a fresh provider query
+static NTSTATUS MrtCollector_Query(MRT_COLLECTOR* c, MRT_STATS_FRAME* stats, const void** Buffer, ULONG* Length)
+{
+    if (c->Replay) {
+        *Buffer = c->Replay;
+        *Length = c->ReplayLength;
+        return STATUS_SUCCESS;
+    }
+
+    MRT_STAT(ULONGLONG t0 = MrtPlatform_NowNs());
+    NTSTATUS status = MrtProvider_Query(c->Provider, &c->Query);
+    MRT_STAT(MrtStats_Query(stats, &c->Query, t0));
+    if (!NT_SUCCESS(status))
+        return status;
+
+    *Buffer = c->Query.Data;
+    *Length = c->Query.Length;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorCreate(MRT_COLLECTOR** Collector)
+{
+    if (!Collector)
+        return STATUS_INVALID_PARAMETER;
+
+    *Collector = NULL;
+
+    MRT_COLLECTOR* c = (MRT_COLLECTOR*)calloc(1, sizeof(MRT_COLLECTOR));
+    if (!c)
+        return STATUS_NO_MEMORY;
+
+    // A collector without a live source can still replay recorded buffers
+    c->Provider = MrtTInfo_GetDefaultProvider();
+    c->Reader = MrtTInfo_GetDefaultMemoryReader();
+    MrtNt_Resolve(&c->Nt);
+    c->Flags = MRT_QUERY_ALL;
+    c->WorkerCount = 1;
+    c->Arena = MrtTInfo_ArenaCreate(0);
+    c->Strings = MrtIntern_Create(TRUE);
+    if (!c->Arena || !c->Strings) {
+        MrtTInfo_ArenaDestroy(c->Arena);
+        MrtIntern_Destroy(c->Strings);
+        free(c);
+        return STATUS_NO_MEMORY;
+    }
+
+    *Collector = c;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtCollector_BuildInto(
+    MRT_COLLECTOR* Collector,
+    MRT_ARENA* Arena,
+    MRT_STRING_POOL* Strings,
+    MRT_STATS_FRAME* stats,
+    MRT_PROCESS_INFO** Processes,
+    ULONG* Count,
+    BOOL withIndex,
+    MRT_SNAPSHOT_INDEX** Index
+)
+{
+    const void* data = NULL;
+    ULONG length = 0;
+    NTSTATUS status = MrtCollector_Query(Collector, stats, &data, &length);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    // The previous snapshot in this arena dies here; its blocks are recycled
+    MrtTInfo_ArenaReset(Arena);
+    *Processes = NULL;
+    *Count = 0;
+    *Index = NULL;
+
+    // Only records of live local threads can be enriched
+    const MRT_NTAPI* nt = (!Collector->Replay && Collector->Provider->Enrich) ? Collector->Nt : NULL;
+    MRT_BUILD build = {
+        .Arena   = Arena,
+        .Nt      = nt,
+        .Flags   = Collector->Flags,
+        .Pool    = Collector->Pool,
+        .Scratch = &Collector->Scratch,
+        .Handles = Collector->Handles,
+        .Filter  = Collector->Filter,
+        .Strings = Strings,
+        .Reader  = Collector->Reader,
+        .Stats   = stats,
+    };
+    status = MrtTInfo_BuildFromBuffer(
+        &build,
+        (const MRT_SYSTEM_PROCESS_INFORMATION*)data,
+        Processes,
+        Count
+    );
+    if (!NT_SUCCESS(status))
+        return status;
+
+    if (withIndex)
+        status = MrtIndex_Build(&build, *Processes, *Count, Index);
+    return status;
+}
+
+NTSTATUS MrtTInfo_CollectorRefresh(MRT_COLLECTOR* Collector, MRT_PROCESS_INFO** Processes, ULONG* Count)
+{
+    if (!Collector || !Processes || !Count)
+        return STATUS_INVALID_PARAMETER;
+
+    *Processes = NULL;
+    *Count = 0;
+
+    MRT_STATS_FRAME* stats = NULL;
+    MRT_STAT(MRT_STATS_FRAME frame; MrtStats_Begin(&frame); stats = &frame);
+    NTSTATUS status = MrtCollector_BuildInto(
+        Collector, Collector->Arena, Collector->Strings, stats,
+        &Collector->Processes, &Collector->Count,
+        Collector->BuildIndex, &Collector->Index);
+    MRT_STAT(MrtStats_Commit(&frame, status));
+    if (!NT_SUCCESS(status))
+        return status;
+
+    *Processes = Collector->Processes;
+    *Count = Collector->Count;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorQueryRaw(MRT_COLLECTOR* Collector, const void** Buffer, ULONG* Length)
+{
+    if (!Collector || !Buffer || !Length)
+        return STATUS_INVALID_PARAMETER;
+
+    *Buffer = NULL;
+    *Length = 0;
+
+    return MrtCollector_Query(Collector, NULL, Buffer, Length);
+}
+
+NTSTATUS MrtTInfo_CollectorSetReplayBuffer(MRT_COLLECTOR* Collector, const void* Buffer, ULONG Length)
+{
+    if (!Collector)
+        return STATUS_INVALID_PARAMETER;
+
+    if (Buffer) {
+        NTSTATUS status = MrtCursor_Validate(Buffer, Length);
+        if (!NT_SUCCESS(status))
+            return status;
+    }
+
+    Collector->Replay = Buffer;
+    Collector->ReplayLength = Buffer ? Length : 0;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorSetProvider(MRT_COLLECTOR* Collector, const MRT_PROVIDER* Provider)
+{
+    if (!Collector || (Provider && !Provider->Query))
+        return STATUS_INVALID_PARAMETER;
+
+    Collector->Provider = Provider ? Provider : MrtTInfo_GetDefaultProvider();
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorSetMemoryReader(MRT_COLLECTOR* Collector, const MRT_MEMORY_READER* Reader)
+{
+    if (!Collector || (Reader && !Reader->Read))
+        return STATUS_INVALID_PARAMETER;
+
+    Collector->Reader = Reader ? Reader : MrtTInfo_GetDefaultMemoryReader();
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_CollectorSetQueryFlags(MRT_COLLECTOR* Collector, ULONG Flags)
+{
+    if (Collector)
+        Collector->Flags = MrtTInfo_NormalizeQueryFlags(Flags);
+}
+
+NTSTATUS MrtTInfo_CollectorSetWorkerCount(MRT_COLLECTOR* Collector, ULONG Workers)
+{
+    if (!Collector)
+        return STATUS_INVALID_PARAMETER;
+
+    if (Workers == 0)
+        Workers = MrtPlatform_CpuCount();
+    if (Workers > MRT_MAX_WORKERS)
+        Workers = MRT_MAX_WORKERS;
+    if (Workers == Collector->WorkerCount)
+        return STATUS_SUCCESS;
+
+    // The refreshing thread is one of the workers
+    MRT_WORKER_POOL* pool = NULL;
+    if (Workers > 1) {
+        pool = MrtPool_Create(Workers - 1);
+        if (!pool)
+            return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    MrtPool_Destroy(Collector->Pool);
+    Collector->Pool = pool;
+    Collector->WorkerCount = Workers;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorSetFilter(MRT_COLLECTOR* Collector, const MRT_PROCESS_FILTER* Filter)
+{
+    if (!Collector)
+        return STATUS_INVALID_PARAMETER;
+
+    MRT_FILTER* filter = NULL;
+    if (Filter) {
+        NTSTATUS status = MrtFilter_Create(Filter, &filter);
+        if (!NT_SUCCESS(status))
+            return status;
+    }
+
+    MrtFilter_Free(Collector->Filter);
+    Collector->Filter = filter;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_CollectorEnableHandleCache(MRT_COLLECTOR* Collector, ULONG MaxHandles)
+{
+    if (!Collector)
+        return STATUS_INVALID_PARAMETER;
+
+    // A new cap starts from an empty cache; the old handles are closed
+    MRT_HANDLE_CACHE* handles = NULL;
+    if (MaxHandles) {
+        handles = MrtHandles_Create(MaxHandles);
+        if (!handles)
+            return STATUS_NO_MEMORY;
+    }
+
+    MrtHandles_Destroy(Collector->Handles);
+    Collector->Handles = handles;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_CollectorGetHandleCacheStats(const MRT_COLLECTOR* Collector, MRT_HANDLE_CACHE_STATS* stats)
+{
+    MrtHandles_GetStats(Collector ? Collector->Handles : NULL, stats);
+}
+
+void MrtTInfo_CollectorGetStringPoolStats(const MRT_COLLECTOR* Collector, MRT_STRING_POOL_STATS* stats)
+{
+    MrtIntern_GetStats(Collector ? Collector->Strings : NULL, stats);
+}
+
+void MrtTInfo_CollectorEnableIndex(MRT_COLLECTOR* Collector, BOOL enable)
+{
+    if (Collector)
+        Collector->BuildIndex = enable ? TRUE : FALSE;
+}
+
+const MRT_SNAPSHOT_INDEX* MrtTInfo_CollectorGetIndex(const MRT_COLLECTOR* Collector)
+{
+    return Collector ? Collector->Index : NULL;
+}
+
+void MrtTInfo_CollectorGetAllocStats(const MRT_COLLECTOR* Collector, MRT_ALLOC_STATS* stats)
+{
+    MrtTInfo_ArenaGetStats(Collector ? Collector->Arena : NULL, stats);
+}
+
+ULONG MrtTInfo_CollectorGetBufferSize(const MRT_COLLECTOR* Collector)
+{
+    return Collector ? Collector->Query.Capacity : 0;
+}
+
+void MrtTInfo_CollectorDestroy(MRT_COLLECTOR* Collector)
+{
+    if (!Collector)
+        return;
+
+    MrtPool_Destroy(Collector->Pool);
+    MrtHandles_Destroy(Collector->Handles);
+    MrtFilter_Free(Collector->Filter);
+    free(Collector->Scratch.Items);
+    MrtNt_FreeQueryBuffer(&Collector->Query);
+    MrtTInfo_ArenaDestroy(Collector->Arena);
+    MrtIntern_Destroy(Collector->Strings);
+    free(Collector);
+}
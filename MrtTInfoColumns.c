@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+#define MRT_COLUMN_ALIGN 64
+
+static SIZE_T ColumnsAlign(SIZE_T size)
+{
+    return (size + MRT_COLUMN_ALIGN - 1) & ~(SIZE_T)(MRT_COLUMN_ALIGN - 1);
+}
+
+static BYTE ColumnsNarrow(ULONG value)
+{
+    return value > 0xFF ? (BYTE)0xFF : (BYTE)value;
+}
+
+// One block: header, then every column starting on its own cache line
+static MRT_THREAD_COLUMNS* ColumnsAllocate(ULONG threads, ULONG processes)
+{
+    SIZE_T n = threads ? threads : 1;
+    SIZE_T header = ColumnsAlign(sizeof(MRT_THREAD_COLUMNS));
+    SIZE_T sizes[] = {
+        ColumnsAlign(n * sizeof(DWORD)),
+        ColumnsAlign(n * sizeof(ULONG)),
+        ColumnsAlign(n * sizeof(LONGLONG)),
+        ColumnsAlign(n * sizeof(LONGLONG)),
+        ColumnsAlign(n * sizeof(ULONG)),
+        ColumnsAlign(n * sizeof(BYTE)),
+        ColumnsAlign(n * sizeof(BYTE)),
+        ColumnsAlign(n * sizeof(LONG)),
+        ColumnsAlign(n * sizeof(MRT_THREAD_COLD)),
+    };
+
+    SIZE_T total = header + MRT_COLUMN_ALIGN;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        total += sizes[i];
+
+    BYTE* raw = (BYTE*)malloc(total);
+    if (!raw)
+        return NULL;
+
+    // The block start is kept just before the aligned header for free()
+    BYTE* base = (BYTE*)ColumnsAlign((SIZE_T)(raw + sizeof(void*)));
+    ((void**)base)[-1] = raw;
+
+    MRT_THREAD_COLUMNS* c = (MRT_THREAD_COLUMNS*)base;
+    memset(c, 0, sizeof(*c));
+    c->ThreadCount = threads;
+    c->ProcessCount = processes;
+
+    BYTE* p = base + header;
+    c->Tid             = (DWORD*)p;            p += sizes[0];
+    c->Process         = (ULONG*)p;            p += sizes[1];
+    c->KernelTime      = (LONGLONG*)p;         p += sizes[2];
+    c->UserTime        = (LONGLONG*)p;         p += sizes[3];
+    c->ContextSwitches = (ULONG*)p;            p += sizes[4];
+    c->ThreadState     = (BYTE*)p;             p += sizes[5];
+    c->WaitReason      = (BYTE*)p;             p += sizes[6];
+    c->Priority        = (LONG*)p;             p += sizes[7];
+    c->Cold            = (MRT_THREAD_COLD*)p;
+    return c;
+}
+
+void MrtTInfo_ColumnsFree(MRT_THREAD_COLUMNS* Columns)
+{
+    if (Columns)
+        free(((void**)Columns)[-1]);
+}
+
+NTSTATUS MrtTInfo_ColumnsBuild(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_THREAD_COLUMNS** Columns)
+{
+    if (!Columns || (!Processes && Count))
+        return STATUS_INVALID_PARAMETER;
+
+    *Columns = NULL;
+
+    ULONG threads = 0;
+    for (ULONG i = 0; i < Count; i++)
+        threads += Processes[i].Threads ? Processes[i].ThreadCount : 0;
+
+    MRT_THREAD_COLUMNS* c = ColumnsAllocate(threads, Count);
+    if (!c)
+        return STATUS_NO_MEMORY;
+
+    ULONG row = 0;
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* p = &Processes[i];
+        if (!p->Threads)
+            continue;
+
+        for (ULONG t = 0; t < p->ThreadCount; t++, row++) {
+            const MRT_THREAD_INFO* mt = &p->Threads[t];
+            c->Tid[row]             = mt->TID;
+            c->Process[row]         = i;
+            c->KernelTime[row]      = mt->KernelTime.QuadPart;
+            c->UserTime[row]        = mt->UserTime.QuadPart;
+            c->ContextSwitches[row] = mt->ContextSwitches;
+            c->ThreadState[row]     = ColumnsNarrow(mt->ThreadState);
+            c->WaitReason[row]      = ColumnsNarrow(mt->WaitReason);
+            c->Priority[row]        = mt->Priority;
+            c->Cold[row].CreateTime   = MrtFileTimeToU64(&mt->CreateTime);
+            c->Cold[row].StartAddress = mt->StartAddress;
+            c->Cold[row].BasePriority = mt->BasePriority;
+            c->Cold[row].Record       = mt;
+        }
+    }
+
+    *Columns = c;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_ColumnsBuildFromBuffer(const void* Buffer, ULONG Length, MRT_THREAD_COLUMNS** Columns)
+{
+    if (!Columns)
+        return STATUS_INVALID_PARAMETER;
+
+    *Columns = NULL;
+
+    NTSTATUS status = MrtCursor_Validate(Buffer, Length);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    MRT_PROCESS_CURSOR cursor;
+    MrtTInfo_CursorInit(&cursor, Buffer, Length);
+
+    // First walk sizes the block, the second fills it
+    ULONG processes = 0;
+    ULONG threads = 0;
+    const MRT_SYSTEM_PROCESS_INFORMATION* p;
+    while ((p = MrtTInfo_CursorNext(&cursor)) != NULL) {
+        processes++;
+        threads += p->NumberOfThreads;
+    }
+
+    MRT_THREAD_COLUMNS* c = ColumnsAllocate(threads, processes);
+    if (!c)
+        return STATUS_NO_MEMORY;
+
+    MrtTInfo_CursorReset(&cursor);
+    ULONG row = 0;
+    for (ULONG i = 0; (p = MrtTInfo_CursorNext(&cursor)) != NULL; i++) {
+        for (ULONG t = 0; t < p->NumberOfThreads; t++, row++) {
+            const MRT_SYSTEM_THREAD_INFORMATION* st = &p->Threads[t];
+            c->Tid[row]             = (DWORD)(ULONG_PTR)st->ClientId.UniqueThread;
+            c->Process[row]         = i;
+            c->KernelTime[row]      = st->KernelTime.QuadPart;
+            c->UserTime[row]        = st->UserTime.QuadPart;
+            c->ContextSwitches[row] = st->ContextSwitches;
+            c->ThreadState[row]     = ColumnsNarrow(st->ThreadState);
+            c->WaitReason[row]      = ColumnsNarrow(st->WaitReason);
+            c->Priority[row]        = st->Priority;
+            c->Cold[row].CreateTime   = (ULONGLONG)st->CreateTime.QuadPart;
+            c->Cold[row].StartAddress = st->StartAddress;
+            c->Cold[row].BasePriority = st->BasePriority;
+            c->Cold[row].Record       = NULL;
+        }
+    }
+
+    *Columns = c;
+    return STATUS_SUCCESS;
+}
+
+// -----------------------------
+// Reduction kernels
+// -----------------------------
+// Four independent accumulators break the loop-carried dependency; the
+// branch-free bodies let the compiler turn each group of four into SIMD lanes.
+LONGLONG MrtTInfo_ColumnSumI64(const LONGLONG* Values, ULONG Count)
+{
+    if (!Values)
+        return 0;
+
+    ULONGLONG a0 = 0, a1 = 0, a2 = 0, a3 = 0;   // unsigned: wrap is defined
+    ULONG i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        a0 += (ULONGLONG)Values[i];
+        a1 += (ULONGLONG)Values[i + 1];
+        a2 += (ULONGLONG)Values[i + 2];
+        a3 += (ULONGLONG)Values[i + 3];
+    }
+    for (; i < Count; i++)
+        a0 += (ULONGLONG)Values[i];
+    return (LONGLONG)(a0 + a1 + a2 + a3);
+}
+
+ULONGLONG MrtTInfo_ColumnSumU32(const ULONG* Values, ULONG Count)
+{
+    if (!Values)
+        return 0;
+
+    ULONGLONG a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    ULONG i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        a0 += Values[i];
+        a1 += Values[i + 1];
+        a2 += Values[i + 2];
+        a3 += Values[i + 3];
+    }
+    for (; i < Count; i++)
+        a0 += Values[i];
+    return a0 + a1 + a2 + a3;
+}
+
+LONGLONG MrtTInfo_ColumnMaxI64(const LONGLONG* Values, ULONG Count)
+{
+    if (!Values || !Count)
+        return 0;
+
+    LONGLONG m0 = Values[0], m1 = Values[0], m2 = Values[0], m3 = Values[0];
+    ULONG i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        m0 = Values[i]     > m0 ? Values[i]     : m0;
+        m1 = Values[i + 1] > m1 ? Values[i + 1] : m1;
+        m2 = Values[i + 2] > m2 ? Values[i + 2] : m2;
+        m3 = Values[i + 3] > m3 ? Values[i + 3] : m3;
+    }
+    for (; i < Count; i++)
+        m0 = Values[i] > m0 ? Values[i] : m0;
+
+    m0 = m1 > m0 ? m1 : m0;
+    m2 = m3 > m2 ? m3 : m2;
+    return m2 > m0 ? m2 : m0;
+}
+
+ULONG MrtTInfo_ColumnMaxU32(const ULONG* Values, ULONG Count)
+{
+    if (!Values || !Count)
+        return 0;
+
+    ULONG m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+    ULONG i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        m0 = Values[i]     > m0 ? Values[i]     : m0;
+        m1 = Values[i + 1] > m1 ? Values[i + 1] : m1;
+        m2 = Values[i + 2] > m2 ? Values[i + 2] : m2;
+        m3 = Values[i + 3] > m3 ? Values[i + 3] : m3;
+    }
+    for (; i < Count; i++)
+        m0 = Values[i] > m0 ? Values[i] : m0;
+
+    m0 = m1 > m0 ? m1 : m0;
+    m2 = m3 > m2 ? m3 : m2;
+    return m2 > m0 ? m2 : m0;
+}
+
+// Four sub-histograms: runs of equal values (most threads share a state)
+// would otherwise serialise on one counter's load/store.
+void MrtTInfo_ColumnHistogramU8(const BYTE* Values, ULONG Count, ULONG Histogram[256])
+{
+    if (!Values || !Histogram)
+        return;
+
+    ULONG h[4][256];
+    memset(h, 0, sizeof(h));
+
+    ULONG i = 0;
+    for (; i + 4 <= Count; i += 4) {
+        h[0][Values[i]]++;
+        h[1][Values[i + 1]]++;
+        h[2][Values[i + 2]]++;
+        h[3][Values[i + 3]]++;
+    }
+    for (; i < Count; i++)
+        h[0][Values[i]]++;
+
+    for (ULONG v = 0; v < 256; v++)
+        Histogram[v] += h[0][v] + h[1][v] + h[2][v] + h[3][v];
+}
@@ -0,0 +1,144 @@
+#include <stddef.h>
+#include "MrtTInfoInternal.h"
+
+// Bytes of an entry before its thread array
+#define MRT_RAW_PROCESS_HEADER offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads)
+
+BOOL MrtTInfo_CursorInit(MRT_PROCESS_CURSOR* cursor, const void* buffer, ULONG length)
+{
+    if (!cursor)
+        return FALSE;
+
+    cursor->Base    = (const BYTE*)buffer;
+    cursor->Length  = length;
+    cursor->Offset  = 0;
+    cursor->Done    = (!buffer || length < MRT_RAW_PROCESS_HEADER);
+    cursor->Corrupt = FALSE;
+    return !cursor->Done;
+}
+
+const MRT_SYSTEM_PROCESS_INFORMATION* MrtTInfo_CursorNext(MRT_PROCESS_CURSOR* cursor)
+{
+    if (!cursor || cursor->Done)
+        return NULL;
+
+    ULONG offset = cursor->Offset;
+    ULONG remaining = cursor->Length - offset;
+    const MRT_SYSTEM_PROCESS_INFORMATION* p =
+        (const MRT_SYSTEM_PROCESS_INFORMATION*)(cursor->Base + offset);
+
+    // The entry (header + its threads) must end before the next entry / the buffer end
+    ULONG limit = p->NextEntryOffset ? p->NextEntryOffset : remaining;
+    SIZE_T needed = MRT_RAW_PROCESS_HEADER +
+        (SIZE_T)p->NumberOfThreads * sizeof(MRT_SYSTEM_THREAD_INFORMATION);
+
+    if (remaining < MRT_RAW_PROCESS_HEADER || limit > remaining || needed > limit) {
+        cursor->Done = TRUE;
+        cursor->Corrupt = TRUE;
+        return NULL;
+    }
+
+    if (p->NextEntryOffset) {
+        if (p->NextEntryOffset % sizeof(ULONG_PTR) != 0 ||
+            remaining - p->NextEntryOffset < MRT_RAW_PROCESS_HEADER) {
+            cursor->Done = TRUE;
+            cursor->Corrupt = TRUE;
+            return NULL;
+        }
+        cursor->Offset = offset + p->NextEntryOffset;
+    } else {
+        cursor->Done = TRUE;
+    }
+
+    return p;
+}
+
+void MrtTInfo_CursorReset(MRT_PROCESS_CURSOR* cursor)
+{
+    if (!cursor)
+        return;
+    MrtTInfo_CursorInit(cursor, cursor->Base, cursor->Length);
+}
+
+ULONG MrtTInfo_CursorCount(const MRT_PROCESS_CURSOR* cursor)
+{
+    if (!cursor)
+        return 0;
+
+    MRT_PROCESS_CURSOR walk;
+    ULONG count = 0;
+    MrtTInfo_CursorInit(&walk, cursor->Base, cursor->Length);
+    while (MrtTInfo_CursorNext(&walk))
+        count++;
+    return count;
+}
+
+NTSTATUS MrtCursor_Validate(const void* buffer, ULONG length)
+{
+    MRT_PROCESS_CURSOR walk;
+    if (!MrtTInfo_CursorInit(&walk, buffer, length))
+        return STATUS_DATA_ERROR;
+    while (MrtTInfo_CursorNext(&walk))
+        ;
+    return walk.Corrupt ? STATUS_DATA_ERROR : STATUS_SUCCESS;
+}
+
+// -----------------------------
+// Raw entry accessors
+// -----------------------------
+DWORD MrtTInfo_RawProcessId(const MRT_SYSTEM_PROCESS_INFORMATION* p)
+{
+    return p ? (DWORD)(ULONG_PTR)p->UniqueProcessId : 0;
+}
+
+DWORD MrtTInfo_RawParentProcessId(const MRT_SYSTEM_PROCESS_INFORMATION* p)
+{
+    return p ? (DWORD)(ULONG_PTR)p->InheritedFromUniqueProcessId : 0;
+}
+
+ULONG MrtTInfo_RawThreadCount(const MRT_SYSTEM_PROCESS_INFORMATION* p)
+{
+    return p ? p->NumberOfThreads : 0;
+}
+
+const MRT_SYSTEM_THREAD_INFORMATION* MrtTInfo_RawThread(
+    const MRT_SYSTEM_PROCESS_INFORMATION* p,
+    ULONG index
+)
+{
+    if (!p || index >= p->NumberOfThreads)
+        return NULL;
+    return &p->Threads[index];
+}
+
+DWORD MrtTInfo_RawThreadId(const MRT_SYSTEM_THREAD_INFORMATION* t)
+{
+    return t ? (DWORD)(ULONG_PTR)t->ClientId.UniqueThread : 0;
+}
+
+DWORD MrtTInfo_RawThreadProcessId(const MRT_SYSTEM_THREAD_INFORMATION* t)
+{
+    return t ? (DWORD)(ULONG_PTR)t->ClientId.UniqueProcess : 0;
+}
+
+UNICODE_STRING MrtTInfo_RawImageName(
+    const MRT_PROCESS_CURSOR* cursor,
+    const MRT_SYSTEM_PROCESS_INFORMATION* p
+)
+{
+    UNICODE_STRING view = { 0, 0, NULL };
+    if (!p || !p->ImageName.Buffer || p->ImageName.Length == 0)
+        return view;
+
+    // The kernel places names inside the same buffer; refuse anything else
+    // so a damaged or relocated buffer cannot hand out wild pointers.
+    if (cursor) {
+        const BYTE* name = (const BYTE*)p->ImageName.Buffer;
+        if (name < cursor->Base ||
+            (SIZE_T)(name - cursor->Base) + p->ImageName.Length > cursor->Length)
+            return view;
+    }
+
+    view = p->ImageName;
+    return view;
+}
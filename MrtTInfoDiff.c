@@ -0,0 +1,311 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// -----------------------------
+// Identity keys and linear-time sort
+// -----------------------------
+void MrtSort_Keys(MRT_SORT_KEY* keys, MRT_SORT_KEY* temp, ULONG count)
+{
+    // LSD radix sort on the 32-bit Id, 8 bits per pass, then CreateTime
+    // within equal Ids: the order MrtSort_Compare merges on. Stable, so fully
+    // equal keys (the per-CPU idle threads share TID 0 and CreateTime) keep
+    // their snapshot order and pair up positionally in the merge.
+    if (count < 2)
+        return;
+
+    MRT_SORT_KEY* src = keys;
+    MRT_SORT_KEY* dst = temp;
+
+    for (ULONG shift = 0; shift < 32; shift += 8) {
+        ULONG offsets[256];
+        memset(offsets, 0, sizeof(offsets));
+
+        for (ULONG i = 0; i < count; i++)
+            offsets[(src[i].Id >> shift) & 0xFF]++;
+
+        // Skip passes where every key lands in one bucket
+        if (offsets[(src[0].Id >> shift) & 0xFF] == count)
+            continue;
+
+        ULONG sum = 0;
+        for (ULONG b = 0; b < 256; b++) {
+            ULONG c = offsets[b];
+            offsets[b] = sum;
+            sum += c;
+        }
+
+        for (ULONG i = 0; i < count; i++)
+            dst[offsets[(src[i].Id >> shift) & 0xFF]++] = src[i];
+
+        MRT_SORT_KEY* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != keys)
+        memcpy(keys, src, count * sizeof(MRT_SORT_KEY));
+
+    // Runs of equal Ids are short: insertion sort by CreateTime
+    for (ULONG i = 1; i < count; i++) {
+        if (keys[i].Id != keys[i - 1].Id || keys[i].CreateTime >= keys[i - 1].CreateTime)
+            continue;
+        MRT_SORT_KEY key = keys[i];
+        ULONG j = i;
+        for (; j > 0 && keys[j - 1].Id == key.Id && keys[j - 1].CreateTime > key.CreateTime; j--)
+            keys[j] = keys[j - 1];
+        keys[j] = key;
+    }
+}
+
+ULONG MrtSort_ProcessKeys(const MRT_PROCESS_INFO* procs, ULONG count, MRT_SORT_KEY* keys)
+{
+    for (ULONG i = 0; i < count; i++) {
+        keys[i].Id = procs[i].PID;
+        keys[i].Outer = i;
+        keys[i].Inner = 0;
+        keys[i].CreateTime = MrtFileTimeToU64(&procs[i].CreateTime);
+    }
+    return count;
+}
+
+ULONG MrtSort_ThreadKeys(const MRT_PROCESS_INFO* procs, ULONG count, MRT_SORT_KEY* keys)
+{
+    ULONG n = 0;
+    for (ULONG i = 0; i < count; i++) {
+        if (!procs[i].Threads)
+            continue;
+        for (ULONG t = 0; t < procs[i].ThreadCount; t++) {
+            keys[n].Id = procs[i].Threads[t].TID;
+            keys[n].Outer = i;
+            keys[n].Inner = t;
+            keys[n].CreateTime = MrtFileTimeToU64(&procs[i].Threads[t].CreateTime);
+            n++;
+        }
+    }
+    return n;
+}
+
+static ULONG DiffThreadTotal(const MRT_PROCESS_INFO* procs, ULONG count)
+{
+    ULONG total = 0;
+    for (ULONG i = 0; i < count; i++)
+        total += procs[i].Threads ? procs[i].ThreadCount : 0;
+    return total;
+}
+
+// -----------------------------
+// Delta records
+// -----------------------------
+static void DiffFillProcess(
+    MRT_PROCESS_DELTA* d,
+    const MRT_PROCESS_INFO* o,   // NULL when created
+    const MRT_PROCESS_INFO* n,   // NULL when exited
+    LONGLONG switches            // sum of its live threads' deltas
+)
+{
+    const MRT_PROCESS_INFO* id = n ? n : o;
+
+    memset(d, 0, sizeof(*d));
+    d->Kind       = !o ? MRT_DELTA_CREATED : !n ? MRT_DELTA_EXITED : MRT_DELTA_CHANGED;
+    d->PID        = id->PID;
+    d->ParentPID  = id->ParentPID;
+    d->CreateTime = id->CreateTime;
+
+    // Exited processes have no counters to report: whatever they did after
+    // the old snapshot is unknown.
+    if (!n)
+        return;
+
+    static const MRT_PROCESS_INFO zero;
+    if (!o)
+        o = &zero;
+
+    d->KernelTime      = n->KernelTime.QuadPart - o->KernelTime.QuadPart;
+    d->UserTime        = n->UserTime.QuadPart - o->UserTime.QuadPart;
+    d->CycleTime       = (LONGLONG)(n->CycleTime - o->CycleTime);
+    d->ContextSwitches = switches;
+    d->PageFaultCount  = (LONGLONG)n->PageFaultCount - (LONGLONG)o->PageFaultCount;
+    d->HardFaultCount  = (LONGLONG)n->HardFaultCount - (LONGLONG)o->HardFaultCount;
+    d->WorkingSetSize  = (LONGLONG)n->WorkingSetSize - (LONGLONG)o->WorkingSetSize;
+    d->HandleCount     = (LONG)n->HandleCount - (LONG)o->HandleCount;
+    d->ThreadCount     = (LONG)n->ThreadCount - (LONG)o->ThreadCount;
+
+    d->IoCounters.ReadOperationCount  = n->IoCounters.ReadOperationCount  - o->IoCounters.ReadOperationCount;
+    d->IoCounters.WriteOperationCount = n->IoCounters.WriteOperationCount - o->IoCounters.WriteOperationCount;
+    d->IoCounters.OtherOperationCount = n->IoCounters.OtherOperationCount - o->IoCounters.OtherOperationCount;
+    d->IoCounters.ReadTransferCount   = n->IoCounters.ReadTransferCount   - o->IoCounters.ReadTransferCount;
+    d->IoCounters.WriteTransferCount  = n->IoCounters.WriteTransferCount  - o->IoCounters.WriteTransferCount;
+    d->IoCounters.OtherTransferCount  = n->IoCounters.OtherTransferCount  - o->IoCounters.OtherTransferCount;
+}
+
+static BOOL DiffProcessChanged(const MRT_PROCESS_DELTA* d)
+{
+    return d->KernelTime || d->UserTime || d->CycleTime || d->ContextSwitches ||
+           d->PageFaultCount || d->HardFaultCount || d->WorkingSetSize ||
+           d->HandleCount || d->ThreadCount ||
+           d->IoCounters.ReadOperationCount || d->IoCounters.WriteOperationCount ||
+           d->IoCounters.OtherOperationCount || d->IoCounters.ReadTransferCount ||
+           d->IoCounters.WriteTransferCount || d->IoCounters.OtherTransferCount;
+}
+
+static void DiffFillThread(
+    MRT_THREAD_DELTA* d,
+    const MRT_SORT_KEY* ok, const MRT_THREAD_INFO* o,   // NULL when created
+    const MRT_SORT_KEY* nk, const MRT_THREAD_INFO* n    // NULL when exited
+)
+{
+    const MRT_THREAD_INFO* id = n ? n : o;
+
+    memset(d, 0, sizeof(*d));
+    d->Kind       = !o ? MRT_DELTA_CREATED : !n ? MRT_DELTA_EXITED : MRT_DELTA_CHANGED;
+    d->TID        = id->TID;
+    d->PID        = id->ParentPID;
+    d->CreateTime = id->CreateTime;
+
+    d->OldProcess = ok ? ok->Outer : MRT_DIFF_NONE;
+    d->OldThread  = ok ? ok->Inner : MRT_DIFF_NONE;
+    d->NewProcess = nk ? nk->Outer : MRT_DIFF_NONE;
+    d->NewThread  = nk ? nk->Inner : MRT_DIFF_NONE;
+
+    d->OldState      = o ? o->ThreadState : 0;
+    d->OldWaitReason = o ? o->WaitReason : 0;
+    d->NewState      = n ? n->ThreadState : 0;
+    d->NewWaitReason = n ? n->WaitReason : 0;
+
+    if (!n)
+        return;
+
+    d->KernelTime      = n->KernelTime.QuadPart - (o ? o->KernelTime.QuadPart : 0);
+    d->UserTime        = n->UserTime.QuadPart - (o ? o->UserTime.QuadPart : 0);
+    d->ContextSwitches = n->ContextSwitches - (o ? o->ContextSwitches : 0);
+}
+
+// -----------------------------
+// Diff
+// -----------------------------
+NTSTATUS MrtTInfo_Diff(
+    const MRT_PROCESS_INFO* Old, ULONG OldCount,
+    const MRT_PROCESS_INFO* New, ULONG NewCount,
+    MRT_SNAPSHOT_DIFF** Diff
+)
+{
+    if (!Diff || (!Old && OldCount) || (!New && NewCount))
+        return STATUS_INVALID_PARAMETER;
+
+    *Diff = NULL;
+
+    ULONG oldThreads = DiffThreadTotal(Old, OldCount);
+    ULONG newThreads = DiffThreadTotal(New, NewCount);
+    ULONG maxProcs   = OldCount + NewCount;
+    ULONG maxThreads = oldThreads + newThreads;
+
+    // Result: header + worst-case delta arrays in one block
+    SIZE_T size = sizeof(MRT_SNAPSHOT_DIFF) +
+        maxProcs * sizeof(MRT_PROCESS_DELTA) +
+        maxThreads * sizeof(MRT_THREAD_DELTA);
+    MRT_SNAPSHOT_DIFF* diff = (MRT_SNAPSHOT_DIFF*)calloc(1, size);
+    if (!diff)
+        return STATUS_NO_MEMORY;
+
+    diff->Processes = (MRT_PROCESS_DELTA*)(diff + 1);
+    diff->Threads   = (MRT_THREAD_DELTA*)(diff->Processes + maxProcs);
+
+    // Scratch: old keys, new keys and one radix buffer, sized for the larger set
+    ULONG maxKeys = maxProcs > maxThreads ? maxProcs : maxThreads;
+    ULONG maxSide = OldCount > NewCount ? OldCount : NewCount;
+    if (oldThreads > maxSide) maxSide = oldThreads;
+    if (newThreads > maxSide) maxSide = newThreads;
+
+    // Then the context switch delta of every new process
+    MRT_SORT_KEY* scratch = (MRT_SORT_KEY*)malloc(((SIZE_T)maxKeys + maxSide + 1) * sizeof(MRT_SORT_KEY) +
+                                                  (SIZE_T)NewCount * sizeof(LONGLONG));
+    if (!scratch) {
+        free(diff);
+        return STATUS_NO_MEMORY;
+    }
+
+    MRT_SORT_KEY* ok  = scratch;
+    MRT_SORT_KEY* tmp = scratch + maxKeys + 1;
+    LONGLONG* switches = (LONGLONG*)(tmp + maxSide);
+    memset(switches, 0, (SIZE_T)NewCount * sizeof(LONGLONG));
+
+    // --- Threads: sorted merge-join on (TID, CreateTime) ---
+    // First, so each process gets the deltas of the threads that ran in the
+    // interval: sums over the live threads drop whatever exited threads did.
+    ULONG on = MrtSort_ThreadKeys(Old, OldCount, ok);
+    MRT_SORT_KEY* nk = ok + on;
+    ULONG nn = MrtSort_ThreadKeys(New, NewCount, nk);
+    MrtSort_Keys(ok, tmp, on);
+    MrtSort_Keys(nk, tmp, nn);
+
+    ULONG i = 0, j = 0;
+    while (i < on || j < nn) {
+        MRT_THREAD_DELTA* d = &diff->Threads[diff->ThreadCount];
+        int cmp = i >= on ? 1 : j >= nn ? -1 : MrtSort_Compare(&ok[i], &nk[j]);
+
+        if (cmp < 0) {
+            DiffFillThread(d, &ok[i], &Old[ok[i].Outer].Threads[ok[i].Inner], NULL, NULL);
+            i++;
+            diff->ThreadsExited++;
+            diff->ThreadCount++;
+        } else if (cmp > 0) {
+            DiffFillThread(d, NULL, NULL, &nk[j], &New[nk[j].Outer].Threads[nk[j].Inner]);
+            switches[nk[j++].Outer] += d->ContextSwitches;
+            diff->ThreadsCreated++;
+            diff->ThreadCount++;
+        } else {
+            DiffFillThread(d, &ok[i], &Old[ok[i].Outer].Threads[ok[i].Inner],
+                              &nk[j], &New[nk[j].Outer].Threads[nk[j].Inner]);
+            switches[nk[j].Outer] += d->ContextSwitches;
+            i++;
+            j++;
+            if (d->KernelTime || d->UserTime || d->ContextSwitches ||
+                d->OldState != d->NewState || d->OldWaitReason != d->NewWaitReason)
+                diff->ThreadCount++;
+        }
+    }
+
+    // --- Processes: sorted merge-join on (PID, CreateTime) ---
+    on = MrtSort_ProcessKeys(Old, OldCount, ok);
+    nk = ok + on;
+    nn = MrtSort_ProcessKeys(New, NewCount, nk);
+    MrtSort_Keys(ok, tmp, on);
+    MrtSort_Keys(nk, tmp, nn);
+
+    i = 0;
+    j = 0;
+    while (i < on || j < nn) {
+        MRT_PROCESS_DELTA* d = &diff->Processes[diff->ProcessCount];
+        int cmp = i >= on ? 1 : j >= nn ? -1 : MrtSort_Compare(&ok[i], &nk[j]);
+
+        if (cmp < 0) {
+            DiffFillProcess(d, &Old[ok[i].Outer], NULL, 0);
+            d->OldIndex = ok[i++].Outer;
+            d->NewIndex = MRT_DIFF_NONE;
+            diff->ProcessesExited++;
+            diff->ProcessCount++;
+        } else if (cmp > 0) {
+            DiffFillProcess(d, NULL, &New[nk[j].Outer], switches[nk[j].Outer]);
+            d->OldIndex = MRT_DIFF_NONE;
+            d->NewIndex = nk[j++].Outer;
+            diff->ProcessesCreated++;
+            diff->ProcessCount++;
+        } else {
+            DiffFillProcess(d, &Old[ok[i].Outer], &New[nk[j].Outer], switches[nk[j].Outer]);
+            d->OldIndex = ok[i++].Outer;
+            d->NewIndex = nk[j++].Outer;
+            if (DiffProcessChanged(d))
+                diff->ProcessCount++;
+        }
+    }
+
+    free(scratch);
+    *Diff = diff;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_FreeDiff(MRT_SNAPSHOT_DIFF* Diff)
+{
+    free(Diff);
+}
@@ -0,0 +1,501 @@
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "MrtTInfoInternal.h"
+
+// Room for every fixed part of the widest row: keys, separators and the
+// numbers at full width. Strings add EXPORT_UNIT_MAX bytes per code unit
+// (a JSON \u00XX escape; UTF-8 needs at most 4).
+#define EXPORT_ROW_FIXED 512
+#define EXPORT_UNIT_MAX  6
+
+#define EXPORT_LIT(p, s) (memcpy((p), (s), sizeof(s) - 1), (p) + sizeof(s) - 1)
+
+typedef enum _EXPORT_SINK {
+    EXPORT_FIXED,               // caller's buffer
+    EXPORT_COUNT,               // caller's buffer overflowed: only sizes from here on
+    EXPORT_GROW,                // MRT_EXPORT_BUFFER
+    EXPORT_STREAM,              // chunks written to Fd
+} EXPORT_SINK;
+
+// Rows are formatted straight into Data[Length..Capacity) after ExportReserve
+// made room for the row's upper bound, then ExportCommit takes them. Near the
+// end of a caller's buffer rows are staged in Own and copied while they fit.
+typedef struct _EXPORT_WRITER {
+    char* Data;
+    SIZE_T Capacity;
+    SIZE_T Length;
+    SIZE_T Done;                // bytes before Data: written out, or counted only
+    char* Row;                  // start of the row being formatted
+    EXPORT_SINK Sink;
+    char* Own;                  // staging, and the window of the count and stream sinks
+    SIZE_T OwnCapacity;
+    MRT_EXPORT_BUFFER* Buffer;
+    int Fd;
+    NTSTATUS Status;
+} EXPORT_WRITER;
+
+static const char g_ExportDigits[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char g_ExportHex[] = "0123456789abcdef";
+
+static const char g_ExportCsvHeader[] =
+    "kind,pid,tid,ppid,name,threads,handles,session,working_set,private_bytes,"
+    "create_time,user_time,kernel_time,priority,base_priority,state,wait_reason,"
+    "context_switches,start_address,command_line\n";
+
+// -----------------------------
+// Output window
+// -----------------------------
+// Own buffer of at least bound bytes (MRT_EXPORT_CHUNK normally)
+static char* ExportScratch(EXPORT_WRITER* w, SIZE_T bound)
+{
+    SIZE_T capacity = bound > MRT_EXPORT_CHUNK ? bound : MRT_EXPORT_CHUNK;
+    if (w->OwnCapacity < capacity) {
+        char* own = (char*)realloc(w->Own, capacity);
+        if (!own) {
+            w->Status = STATUS_NO_MEMORY;
+            return NULL;
+        }
+        w->Own = own;
+        w->OwnCapacity = capacity;
+    }
+    return w->Own;
+}
+
+// Where the next row of at most bound bytes goes, NULL once failed
+static char* ExportReserve(EXPORT_WRITER* w, SIZE_T bound)
+{
+    if (w->Capacity - w->Length >= bound)
+        return w->Row = w->Data + w->Length;
+
+    switch (w->Sink) {
+    case EXPORT_FIXED:
+        // Staged: ExportCommit copies it if it fits after all
+        return w->Row = ExportScratch(w, bound);
+
+    case EXPORT_STREAM:
+        w->Status = MrtPlatform_WriteFd(w->Fd, w->Data, w->Length);
+        if (!NT_SUCCESS(w->Status))
+            return NULL;
+        // fall through
+    case EXPORT_COUNT:
+        w->Done += w->Length;
+        w->Length = 0;
+        w->Data = ExportScratch(w, bound);
+        if (!w->Data)
+            return NULL;
+        w->Capacity = w->OwnCapacity;
+        break;
+
+    case EXPORT_GROW: {
+        SIZE_T capacity = w->Capacity ? w->Capacity * 2 : MRT_EXPORT_CHUNK;
+        if (capacity < w->Length + bound)
+            capacity = w->Length + bound;
+        char* data = (char*)realloc(w->Data, capacity);
+        if (!data) {
+            w->Status = STATUS_NO_MEMORY;
+            return NULL;
+        }
+        w->Data = w->Buffer->Data = data;
+        w->Capacity = w->Buffer->Capacity = capacity;
+        break;
+    }
+    }
+    return w->Row = w->Data + w->Length;
+}
+
+// Ends the row formatted up to end
+static void ExportCommit(EXPORT_WRITER* w, const char* end)
+{
+    SIZE_T n = (SIZE_T)(end - w->Row);
+    if (w->Row != w->Data + w->Length) {
+        if (w->Capacity - w->Length >= n) {
+            memcpy(w->Data + w->Length, w->Row, n);
+            w->Length += n;
+            return;
+        }
+        // Whole rows that fit stay in the caller's buffer; the rest is only measured
+        w->Sink = EXPORT_COUNT;
+        w->Done += w->Length;
+        w->Data = w->Own;
+        w->Capacity = w->OwnCapacity;
+        w->Length = 0;
+    }
+    w->Length += n;
+}
+
+// -----------------------------
+// Field formatting
+// -----------------------------
+static char* ExportU64(char* p, ULONGLONG v)
+{
+    char digits[20];
+    char* d = digits + sizeof(digits);
+    while (v >= 100) {
+        const char* pair = &g_ExportDigits[(v % 100) * 2];
+        v /= 100;
+        *--d = pair[1];
+        *--d = pair[0];
+    }
+    if (v >= 10) {
+        *--d = g_ExportDigits[v * 2 + 1];
+        *--d = g_ExportDigits[v * 2];
+    } else {
+        *--d = (char)('0' + v);
+    }
+    SIZE_T n = (SIZE_T)(digits + sizeof(digits) - d);
+    memcpy(p, d, n);
+    return p + n;
+}
+
+static char* ExportI64(char* p, LONGLONG v)
+{
+    if (v < 0) {
+        *p++ = '-';
+        return ExportU64(p, 0 - (ULONGLONG)v);
+    }
+    return ExportU64(p, (ULONGLONG)v);
+}
+
+static char* ExportHex(char* p, ULONGLONG v)
+{
+    char digits[16];
+    char* d = digits + sizeof(digits);
+    do {
+        *--d = g_ExportHex[v & 0xF];
+        v >>= 4;
+    } while (v);
+    p = EXPORT_LIT(p, "0x");
+    SIZE_T n = (SIZE_T)(digits + sizeof(digits) - d);
+    memcpy(p, d, n);
+    return p + n;
+}
+
+static char* ExportAscii(char* p, const char* text, SIZE_T length)
+{
+    memcpy(p, text, length);
+    return p + length;
+}
+
+// UTF-8 of a WCHAR string (UTF-16 on Windows, UTF-32 elsewhere), escaped for
+// a quoted CSV field or JSON string. Unpaired surrogates become U+FFFD.
+static char* ExportText(char* p, const WCHAR* text, SIZE_T units, BOOL json)
+{
+    for (SIZE_T i = 0; i < units; i++) {
+        ULONG c = (ULONG)text[i];
+        if (c < 0x80) {
+            if (json) {
+                if (c == '"' || c == '\\') {
+                    *p++ = '\\';
+                } else if (c < 0x20) {
+                    *p++ = '\\';
+                    if (c == '\n') {
+                        *p++ = 'n';
+                    } else if (c == '\r') {
+                        *p++ = 'r';
+                    } else if (c == '\t') {
+                        *p++ = 't';
+                    } else {
+                        p = EXPORT_LIT(p, "u00");
+                        *p++ = g_ExportHex[c >> 4];
+                        *p++ = g_ExportHex[c & 0xF];
+                    }
+                    continue;
+                }
+            } else if (c == '"') {
+                *p++ = '"';
+            }
+            *p++ = (char)c;
+            continue;
+        }
+
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            ULONG low = i + 1 < units ? (ULONG)text[i + 1] : 0;
+            if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            } else {
+                c = 0xFFFD;
+            }
+        } else if (c > 0x10FFFF) {
+            c = 0xFFFD;
+        }
+
+        if (c < 0x800) {
+            *p++ = (char)(0xC0 | (c >> 6));
+        } else if (c < 0x10000) {
+            *p++ = (char)(0xE0 | (c >> 12));
+            *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+        } else {
+            *p++ = (char)(0xF0 | (c >> 18));
+            *p++ = (char)(0x80 | ((c >> 12) & 0x3F));
+            *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+        }
+        *p++ = (char)(0x80 | (c & 0x3F));
+    }
+    return p;
+}
+
+// -----------------------------
+// Rows
+// -----------------------------
+static BOOL ExportProcess(EXPORT_WRITER* w, const MRT_PROCESS_INFO* proc, BOOL json)
+{
+    const WCHAR* name = proc->ImageName.Buffer;
+    SIZE_T nameUnits = name ? proc->ImageName.Length / sizeof(WCHAR) : 0;
+    const WCHAR* cmd = proc->PebCommandLine;
+    SIZE_T cmdUnits = cmd ? wcslen(cmd) : 0;
+
+    char* p = ExportReserve(w, EXPORT_ROW_FIXED + (nameUnits + cmdUnits) * EXPORT_UNIT_MAX);
+    if (!p)
+        return FALSE;
+
+    if (json) {
+        p = EXPORT_LIT(p, "{\"kind\":\"process\",\"pid\":");
+        p = ExportU64(p, proc->PID);
+        p = EXPORT_LIT(p, ",\"ppid\":");
+        p = ExportU64(p, proc->ParentPID);
+        if (nameUnits) {
+            p = EXPORT_LIT(p, ",\"name\":\"");
+            p = ExportText(p, name, nameUnits, TRUE);
+            *p++ = '"';
+        }
+        p = EXPORT_LIT(p, ",\"threads\":");
+        p = ExportU64(p, proc->ThreadCount);
+        p = EXPORT_LIT(p, ",\"handles\":");
+        p = ExportU64(p, proc->HandleCount);
+        p = EXPORT_LIT(p, ",\"session\":");
+        p = ExportU64(p, proc->SessionId);
+        p = EXPORT_LIT(p, ",\"working_set\":");
+        p = ExportU64(p, proc->WorkingSetSize);
+        p = EXPORT_LIT(p, ",\"private_bytes\":");
+        p = ExportU64(p, proc->PrivatePageCount);
+        p = EXPORT_LIT(p, ",\"create_time\":");
+        p = ExportU64(p, MrtFileTimeToU64(&proc->CreateTime));
+        p = EXPORT_LIT(p, ",\"user_time\":");
+        p = ExportI64(p, proc->UserTime.QuadPart);
+        p = EXPORT_LIT(p, ",\"kernel_time\":");
+        p = ExportI64(p, proc->KernelTime.QuadPart);
+        p = EXPORT_LIT(p, ",\"base_priority\":");
+        p = ExportI64(p, proc->BasePriority);
+        if (cmdUnits) {
+            p = EXPORT_LIT(p, ",\"command_line\":\"");
+            p = ExportText(p, cmd, cmdUnits, TRUE);
+            *p++ = '"';
+        }
+        p = EXPORT_LIT(p, "}\n");
+    } else {
+        p = EXPORT_LIT(p, "process,");
+        p = ExportU64(p, proc->PID);
+        p = EXPORT_LIT(p, ",,");
+        p = ExportU64(p, proc->ParentPID);
+        *p++ = ',';
+        if (nameUnits) {
+            *p++ = '"';
+            p = ExportText(p, name, nameUnits, FALSE);
+            *p++ = '"';
+        }
+        *p++ = ',';
+        p = ExportU64(p, proc->ThreadCount);
+        *p++ = ',';
+        p = ExportU64(p, proc->HandleCount);
+        *p++ = ',';
+        p = ExportU64(p, proc->SessionId);
+        *p++ = ',';
+        p = ExportU64(p, proc->WorkingSetSize);
+        *p++ = ',';
+        p = ExportU64(p, proc->PrivatePageCount);
+        *p++ = ',';
+        p = ExportU64(p, MrtFileTimeToU64(&proc->CreateTime));
+        *p++ = ',';
+        p = ExportI64(p, proc->UserTime.QuadPart);
+        *p++ = ',';
+        p = ExportI64(p, proc->KernelTime.QuadPart);
+        p = EXPORT_LIT(p, ",,");
+        p = ExportI64(p, proc->BasePriority);
+        p = EXPORT_LIT(p, ",,,,,");
+        if (cmdUnits) {
+            *p++ = '"';
+            p = ExportText(p, cmd, cmdUnits, FALSE);
+            *p++ = '"';
+        }
+        *p++ = '\n';
+    }
+
+    ExportCommit(w, p);
+    return TRUE;
+}
+
+static BOOL ExportThread(EXPORT_WRITER* w, const MRT_PROCESS_INFO* proc, const MRT_THREAD_INFO* th, BOOL json)
+{
+    const char* state = MrtHelper_ThreadStateToString(th->ThreadState);
+    const char* wait = MrtHelper_WaitReasonToString(th->WaitReason);
+    SIZE_T stateLength = strlen(state);
+    SIZE_T waitLength = strlen(wait);
+
+    char* p = ExportReserve(w, EXPORT_ROW_FIXED + stateLength + waitLength);
+    if (!p)
+        return FALSE;
+
+    if (json) {
+        p = EXPORT_LIT(p, "{\"kind\":\"thread\",\"pid\":");
+        p = ExportU64(p, proc->PID);
+        p = EXPORT_LIT(p, ",\"tid\":");
+        p = ExportU64(p, th->TID);
+        p = EXPORT_LIT(p, ",\"create_time\":");
+        p = ExportU64(p, MrtFileTimeToU64(&th->CreateTime));
+        p = EXPORT_LIT(p, ",\"user_time\":");
+        p = ExportI64(p, th->UserTime.QuadPart);
+        p = EXPORT_LIT(p, ",\"kernel_time\":");
+        p = ExportI64(p, th->KernelTime.QuadPart);
+        p = EXPORT_LIT(p, ",\"priority\":");
+        p = ExportI64(p, th->Priority);
+        p = EXPORT_LIT(p, ",\"base_priority\":");
+        p = ExportI64(p, th->BasePriority);
+        p = EXPORT_LIT(p, ",\"state\":\"");
+        p = ExportAscii(p, state, stateLength);
+        p = EXPORT_LIT(p, "\",\"wait_reason\":\"");
+        p = ExportAscii(p, wait, waitLength);
+        p = EXPORT_LIT(p, "\",\"context_switches\":");
+        p = ExportU64(p, th->ContextSwitches);
+        if (th->StartAddress) {
+            p = EXPORT_LIT(p, ",\"start_address\":\"");
+            p = ExportHex(p, (ULONG_PTR)th->StartAddress);
+            *p++ = '"';
+        }
+        p = EXPORT_LIT(p, "}\n");
+    } else {
+        p = EXPORT_LIT(p, "thread,");
+        p = ExportU64(p, proc->PID);
+        *p++ = ',';
+        p = ExportU64(p, th->TID);
+        p = EXPORT_LIT(p, ",,,,,,,,");
+        p = ExportU64(p, MrtFileTimeToU64(&th->CreateTime));
+        *p++ = ',';
+        p = ExportI64(p, th->UserTime.QuadPart);
+        *p++ = ',';
+        p = ExportI64(p, th->KernelTime.QuadPart);
+        *p++ = ',';
+        p = ExportI64(p, th->Priority);
+        *p++ = ',';
+        p = ExportI64(p, th->BasePriority);
+        *p++ = ',';
+        p = ExportAscii(p, state, stateLength);
+        *p++ = ',';
+        p = ExportAscii(p, wait, waitLength);
+        *p++ = ',';
+        p = ExportU64(p, th->ContextSwitches);
+        *p++ = ',';
+        if (th->StartAddress)
+            p = ExportHex(p, (ULONG_PTR)th->StartAddress);
+        p = EXPORT_LIT(p, ",\n");
+    }
+
+    ExportCommit(w, p);
+    return TRUE;
+}
+
+static NTSTATUS ExportRun(EXPORT_WRITER* w, const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format)
+{
+    BOOL json = Format == MRT_EXPORT_NDJSON;
+    w->Status = STATUS_SUCCESS;
+
+    if (!json) {
+        char* p = ExportReserve(w, sizeof(g_ExportCsvHeader) - 1);
+        if (!p)
+            return w->Status;
+        p = EXPORT_LIT(p, g_ExportCsvHeader);
+        ExportCommit(w, p);
+    }
+
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* proc = &Processes[i];
+        if (!ExportProcess(w, proc, json))
+            return w->Status;
+        for (ULONG t = 0; t < proc->ThreadCount; t++) {
+            if (!ExportThread(w, proc, &proc->Threads[t], json))
+                return w->Status;
+        }
+    }
+    return w->Status;
+}
+
+static BOOL ExportValid(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format)
+{
+    return (Processes || !Count) && (Format == MRT_EXPORT_CSV || Format == MRT_EXPORT_NDJSON);
+}
+
+// -----------------------------
+// API
+// -----------------------------
+NTSTATUS MrtTInfo_ExportEncode(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format,
+                               void* Buffer, SIZE_T Capacity, SIZE_T* Size)
+{
+    if (!Size || !ExportValid(Processes, Count, Format))
+        return STATUS_INVALID_PARAMETER;
+
+    EXPORT_WRITER w;
+    memset(&w, 0, sizeof(w));
+    w.Sink = EXPORT_FIXED;
+    w.Data = (char*)Buffer;
+    w.Capacity = Buffer ? Capacity : 0;
+
+    NTSTATUS status = ExportRun(&w, Processes, Count, Format);
+    free(w.Own);
+
+    *Size = w.Done + w.Length;
+    if (NT_SUCCESS(status) && w.Sink == EXPORT_COUNT)
+        status = STATUS_BUFFER_TOO_SMALL;
+    return status;
+}
+
+NTSTATUS MrtTInfo_ExportAppend(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format,
+                               MRT_EXPORT_BUFFER* Buffer)
+{
+    if (!Buffer || Buffer->Length > Buffer->Capacity || !ExportValid(Processes, Count, Format))
+        return STATUS_INVALID_PARAMETER;
+
+    EXPORT_WRITER w;
+    memset(&w, 0, sizeof(w));
+    w.Sink = EXPORT_GROW;
+    w.Buffer = Buffer;
+    w.Data = Buffer->Data;
+    w.Capacity = Buffer->Capacity;
+    w.Length = Buffer->Length;
+
+    // Rows of a failed export are dropped whole
+    NTSTATUS status = ExportRun(&w, Processes, Count, Format);
+    if (NT_SUCCESS(status))
+        Buffer->Length = w.Length;
+    return status;
+}
+
+NTSTATUS MrtTInfo_ExportToFd(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_EXPORT_FORMAT Format, int fd)
+{
+    if (fd < 0 || !ExportValid(Processes, Count, Format))
+        return STATUS_INVALID_PARAMETER;
+
+    EXPORT_WRITER w;
+    memset(&w, 0, sizeof(w));
+    w.Sink = EXPORT_STREAM;
+    w.Fd = fd;
+
+    NTSTATUS status = ExportRun(&w, Processes, Count, Format);
+    if (NT_SUCCESS(status) && w.Length)
+        status = MrtPlatform_WriteFd(fd, w.Data, w.Length);
+    free(w.Own);
+    return status;
+}
+
+void MrtTInfo_ExportBufferFree(MRT_EXPORT_BUFFER* Buffer)
+{
+    if (!Buffer)
+        return;
+
+    free(Buffer->Data);
+    memset(Buffer, 0, sizeof(*Buffer));
+}
@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+#include "MrtTInfoInternal.h"
+
+// Compiled filter: sorted PID set, pattern folded to lower case once
+struct _MRT_FILTER {
+    DWORD* Pids;
+    ULONG PidCount;
+    wchar_t* Pattern;           // NULL = any name
+    ULONG PatternLength;
+    BOOLEAN Wildcards;          // FALSE: exact (case-insensitive) comparison
+    ULONG SessionId;
+    MRT_PROCESS_FIELD Field;
+    ULONGLONG Min;
+    ULONGLONG Max;
+};
+
+wchar_t MrtFilter_Fold(wchar_t c)
+{
+    if (c < 0x80)
+        return (c >= L'A' && c <= L'Z') ? (wchar_t)(c + (L'a' - L'A')) : c;
+    return (wchar_t)towlower((wint_t)c);
+}
+
+static int FilterComparePids(const void* a, const void* b)
+{
+    DWORD x = *(const DWORD*)a;
+    DWORD y = *(const DWORD*)b;
+    return x < y ? -1 : x > y;
+}
+
+// '*' matches any run, '?' any one character. Backtracks only to the last
+// star, so the cost stays linear in practice.
+static BOOL FilterGlob(const wchar_t* pattern, const WCHAR* name, ULONG length)
+{
+    const wchar_t* star = NULL;
+    ULONG mark = 0;
+    ULONG i = 0;
+
+    while (i < length) {
+        if (*pattern == L'*') {
+            star = ++pattern;
+            mark = i;
+        } else if (*pattern && (*pattern == L'?' || *pattern == MrtFilter_Fold(name[i]))) {
+            pattern++;
+            i++;
+        } else if (star) {
+            pattern = star;
+            i = ++mark;
+        } else {
+            return FALSE;
+        }
+    }
+
+    while (*pattern == L'*')
+        pattern++;
+    return *pattern == L'\0';
+}
+
+void MrtTInfo_FilterInit(MRT_PROCESS_FILTER* Filter)
+{
+    if (!Filter)
+        return;
+
+    memset(Filter, 0, sizeof(*Filter));
+    Filter->SessionId = MRT_ANY_SESSION;
+    Filter->Field = MRT_FIELD_NONE;
+    Filter->Max = (ULONGLONG)-1;
+}
+
+NTSTATUS MrtFilter_Create(const MRT_PROCESS_FILTER* spec, MRT_FILTER** Filter)
+{
+    if (!spec || !Filter || (!spec->Pids && spec->PidCount) ||
+        (ULONG)spec->Field >= MRT_FIELD_COUNT || spec->Min > spec->Max)
+        return STATUS_INVALID_PARAMETER;
+
+    *Filter = NULL;
+
+    ULONG patternLength = spec->ImageName ? (ULONG)wcslen(spec->ImageName) : 0;
+    SIZE_T size = sizeof(MRT_FILTER) +
+        (SIZE_T)spec->PidCount * sizeof(DWORD) +
+        (spec->ImageName ? (SIZE_T)(patternLength + 1) * sizeof(wchar_t) : 0);
+
+    // One block: header, PIDs, pattern
+    BYTE* block = (BYTE*)malloc(size);
+    if (!block)
+        return STATUS_NO_MEMORY;
+
+    MRT_FILTER* f = (MRT_FILTER*)block;
+    memset(f, 0, sizeof(*f));
+    f->SessionId = spec->SessionId;
+    f->Field = spec->Field;
+    f->Min = spec->Min;
+    f->Max = spec->Max;
+
+    if (spec->PidCount) {
+        f->Pids = (DWORD*)(block + sizeof(MRT_FILTER));
+        memcpy(f->Pids, spec->Pids, spec->PidCount * sizeof(DWORD));
+        qsort(f->Pids, spec->PidCount, sizeof(DWORD), FilterComparePids);
+
+        // Duplicates would only cost probes
+        ULONG unique = 1;
+        for (ULONG i = 1; i < spec->PidCount; i++) {
+            if (f->Pids[i] != f->Pids[unique - 1])
+                f->Pids[unique++] = f->Pids[i];
+        }
+        f->PidCount = unique;
+    }
+
+    if (spec->ImageName) {
+        f->Pattern = (wchar_t*)(block + sizeof(MRT_FILTER) + (SIZE_T)spec->PidCount * sizeof(DWORD));
+        for (ULONG i = 0; i < patternLength; i++) {
+            f->Pattern[i] = MrtFilter_Fold(spec->ImageName[i]);
+            if (f->Pattern[i] == L'*' || f->Pattern[i] == L'?')
+                f->Wildcards = TRUE;
+        }
+        f->Pattern[patternLength] = L'\0';
+        f->PatternLength = patternLength;
+    }
+
+    *Filter = f;
+    return STATUS_SUCCESS;
+}
+
+void MrtFilter_Free(MRT_FILTER* filter)
+{
+    free(filter);
+}
+
+static ULONGLONG FilterRawField(const MRT_SYSTEM_PROCESS_INFORMATION* p, MRT_PROCESS_FIELD field)
+{
+    switch (field) {
+    case MRT_FIELD_THREAD_COUNT:     return p->NumberOfThreads;
+    case MRT_FIELD_HANDLE_COUNT:     return p->HandleCount;
+    case MRT_FIELD_WORKING_SET:      return p->WorkingSetSize;
+    case MRT_FIELD_PEAK_WORKING_SET: return p->PeakWorkingSetSize;
+    case MRT_FIELD_PRIVATE_BYTES:    return p->PrivatePageCount;
+    case MRT_FIELD_VIRTUAL_SIZE:     return p->VirtualSize;
+    case MRT_FIELD_PAGE_FAULTS:      return p->PageFaultCount;
+    case MRT_FIELD_HARD_FAULTS:      return p->HardFaultCount;
+    case MRT_FIELD_USER_TIME:        return (ULONGLONG)p->UserTime.QuadPart;
+    case MRT_FIELD_KERNEL_TIME:      return (ULONGLONG)p->KernelTime.QuadPart;
+    case MRT_FIELD_CPU_TIME:         return (ULONGLONG)p->UserTime.QuadPart + (ULONGLONG)p->KernelTime.QuadPart;
+    case MRT_FIELD_CYCLE_TIME:       return p->CycleTime;
+    case MRT_FIELD_READ_BYTES:       return p->IoCounters.ReadTransferCount;
+    case MRT_FIELD_WRITE_BYTES:      return p->IoCounters.WriteTransferCount;
+    case MRT_FIELD_READ_OPS:         return p->IoCounters.ReadOperationCount;
+    case MRT_FIELD_WRITE_OPS:        return p->IoCounters.WriteOperationCount;
+    case MRT_FIELD_CONTEXT_SWITCHES: {
+        ULONGLONG sum = 0;
+        for (ULONG t = 0; t < p->NumberOfThreads; t++)
+            sum += p->Threads[t].ContextSwitches;
+        return sum;
+    }
+    default:                         return 0;
+    }
+}
+
+ULONGLONG MrtTInfo_GetProcessField(const MRT_PROCESS_INFO* Process, MRT_PROCESS_FIELD Field)
+{
+    if (!Process)
+        return 0;
+
+    switch (Field) {
+    case MRT_FIELD_THREAD_COUNT:     return Process->ThreadCount;
+    case MRT_FIELD_HANDLE_COUNT:     return Process->HandleCount;
+    case MRT_FIELD_WORKING_SET:      return Process->WorkingSetSize;
+    case MRT_FIELD_PEAK_WORKING_SET: return Process->PeakWorkingSetSize;
+    case MRT_FIELD_PRIVATE_BYTES:    return Process->PrivatePageCount;
+    case MRT_FIELD_VIRTUAL_SIZE:     return Process->VirtualSize;
+    case MRT_FIELD_PAGE_FAULTS:      return Process->PageFaultCount;
+    case MRT_FIELD_HARD_FAULTS:      return Process->HardFaultCount;
+    case MRT_FIELD_USER_TIME:        return (ULONGLONG)Process->UserTime.QuadPart;
+    case MRT_FIELD_KERNEL_TIME:      return (ULONGLONG)Process->KernelTime.QuadPart;
+    case MRT_FIELD_CPU_TIME:         return (ULONGLONG)Process->UserTime.QuadPart + (ULONGLONG)Process->KernelTime.QuadPart;
+    case MRT_FIELD_CYCLE_TIME:       return Process->CycleTime;
+    case MRT_FIELD_READ_BYTES:       return Process->IoCounters.ReadTransferCount;
+    case MRT_FIELD_WRITE_BYTES:      return Process->IoCounters.WriteTransferCount;
+    case MRT_FIELD_READ_OPS:         return Process->IoCounters.ReadOperationCount;
+    case MRT_FIELD_WRITE_OPS:        return Process->IoCounters.WriteOperationCount;
+    case MRT_FIELD_CONTEXT_SWITCHES: {
+        ULONGLONG sum = 0;
+        for (ULONG t = 0; t < Process->ThreadCount; t++)
+            sum += Process->Threads[t].ContextSwitches;
+        return sum;
+    }
+    default:                         return 0;
+    }
+}
+
+BOOL MrtFilter_Match(const MRT_FILTER* filter, const MRT_SYSTEM_PROCESS_INFORMATION* p)
+{
+    if (!filter)
+        return TRUE;
+
+    // Cheapest tests first: integers, then the PID probe, then the name
+    if (filter->SessionId != MRT_ANY_SESSION && p->SessionId != filter->SessionId)
+        return FALSE;
+
+    if (filter->Field != MRT_FIELD_NONE) {
+        ULONGLONG value = FilterRawField(p, filter->Field);
+        if (value < filter->Min || value > filter->Max)
+            return FALSE;
+    }
+
+    if (filter->PidCount) {
+        DWORD pid = (DWORD)(ULONG_PTR)p->UniqueProcessId;
+        ULONG lo = 0;
+        ULONG hi = filter->PidCount;
+        while (lo < hi) {
+            ULONG mid = lo + (hi - lo) / 2;
+            if (filter->Pids[mid] < pid)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo == filter->PidCount || filter->Pids[lo] != pid)
+            return FALSE;
+    }
+
+    if (filter->Pattern) {
+        const WCHAR* name = p->ImageName.Buffer;
+        ULONG length = name ? p->ImageName.Length / sizeof(WCHAR) : 0;
+
+        if (!filter->Wildcards) {
+            if (length != filter->PatternLength)
+                return FALSE;
+            for (ULONG i = 0; i < length; i++) {
+                if (MrtFilter_Fold(name[i]) != filter->Pattern[i])
+                    return FALSE;
+            }
+        } else if (!FilterGlob(filter->Pattern, name, length)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// Two open-addressing tables, swapped every refresh. Claim moves a surviving
+// entry from Current into Next (or makes a new one); whatever is left in
+// Current afterwards belongs to threads that are gone and gets closed.
+typedef struct _MRT_HANDLE_TABLE {
+    MRT_HANDLE_ENTRY* Entries;
+    ULONG Capacity;             // power of two, 0 = empty
+    ULONG Count;
+} MRT_HANDLE_TABLE;
+
+struct _MRT_HANDLE_CACHE {
+    MRT_HANDLE_TABLE Current;
+    MRT_HANDLE_TABLE Next;
+    ULONG MaxHandles;
+    ULONGLONG Hits;
+    ULONGLONG Misses;
+    ULONGLONG Evictions;
+};
+
+static ULONG HandlesHash(DWORD tid, ULONGLONG createTime)
+{
+    ULONGLONG h = ((ULONGLONG)tid << 32) ^ createTime;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return (ULONG)(h >> 32);
+}
+
+static void HandlesClose(HANDLE handle)
+{
+#ifdef _WIN32
+    if (handle)
+        CloseHandle(handle);
+#else
+    (void)handle; // never opened off Windows
+#endif
+}
+
+// Slot holding the key, or the empty slot where it belongs
+static MRT_HANDLE_ENTRY* HandlesProbe(MRT_HANDLE_TABLE* table, DWORD tid, ULONGLONG createTime)
+{
+    ULONG mask = table->Capacity - 1;
+    for (ULONG i = HandlesHash(tid, createTime) & mask;; i = (i + 1) & mask) {
+        MRT_HANDLE_ENTRY* e = &table->Entries[i];
+        if (!e->Used || (e->Tid == tid && e->CreateTime == createTime))
+            return e;
+    }
+}
+
+MRT_HANDLE_CACHE* MrtHandles_Create(ULONG maxHandles)
+{
+    MRT_HANDLE_CACHE* cache = (MRT_HANDLE_CACHE*)calloc(1, sizeof(MRT_HANDLE_CACHE));
+    if (cache)
+        cache->MaxHandles = maxHandles;
+    return cache;
+}
+
+void MrtHandles_Destroy(MRT_HANDLE_CACHE* cache)
+{
+    if (!cache)
+        return;
+
+    for (ULONG i = 0; i < cache->Current.Capacity; i++) {
+        if (cache->Current.Entries[i].Used)
+            HandlesClose(cache->Current.Entries[i].Handle);
+    }
+    free(cache->Current.Entries);
+    free(cache->Next.Entries);
+    free(cache);
+}
+
+NTSTATUS MrtHandles_Begin(MRT_HANDLE_CACHE* cache, ULONG threads)
+{
+    // Load factor stays at or below one half
+    ULONG limit = threads < cache->MaxHandles ? threads : cache->MaxHandles;
+    ULONG capacity = 16;
+    while (capacity < limit * 2)
+        capacity *= 2;
+
+    MRT_HANDLE_TABLE* next = &cache->Next;
+    if (next->Capacity < capacity) {
+        MRT_HANDLE_ENTRY* grown = (MRT_HANDLE_ENTRY*)malloc(capacity * sizeof(MRT_HANDLE_ENTRY));
+        if (!grown)
+            return STATUS_NO_MEMORY;
+        free(next->Entries);
+        next->Entries = grown;
+        next->Capacity = capacity;
+    }
+    memset(next->Entries, 0, next->Capacity * sizeof(MRT_HANDLE_ENTRY));
+    next->Count = 0;
+    return STATUS_SUCCESS;
+}
+
+MRT_HANDLE_ENTRY* MrtHandles_Claim(MRT_HANDLE_CACHE* cache, DWORD tid, ULONGLONG createTime)
+{
+    MRT_HANDLE_ENTRY* slot = HandlesProbe(&cache->Next, tid, createTime);
+    if (slot->Used)
+        return NULL; // duplicate record: the first one owns the slot
+
+    MRT_HANDLE_ENTRY* old = cache->Current.Capacity
+        ? HandlesProbe(&cache->Current, tid, createTime) : NULL;
+    BOOL hit = old && old->Used && !old->Moved;
+
+    if (cache->Next.Count >= cache->MaxHandles) {
+        // Over the cap: an existing handle stays in Current and is evicted by End
+        cache->Misses++;
+        return NULL;
+    }
+
+    if (hit) {
+        *slot = *old;
+        old->Moved = TRUE;
+        cache->Hits++;
+    } else {
+        slot->Tid = tid;
+        slot->CreateTime = createTime;
+        slot->Handle = NULL;
+        slot->Opened = FALSE;
+        slot->Used = TRUE;
+        cache->Misses++;
+    }
+    slot->Moved = FALSE;
+    cache->Next.Count++;
+    return slot;
+}
+
+void MrtHandles_End(MRT_HANDLE_CACHE* cache)
+{
+    MRT_HANDLE_TABLE* current = &cache->Current;
+    for (ULONG i = 0; i < current->Capacity; i++) {
+        MRT_HANDLE_ENTRY* e = &current->Entries[i];
+        if (e->Used && !e->Moved) {
+            HandlesClose(e->Handle);
+            cache->Evictions++;
+        }
+    }
+
+    MRT_HANDLE_TABLE swap = cache->Current;
+    cache->Current = cache->Next;
+    cache->Next = swap;
+}
+
+void MrtHandles_GetStats(const MRT_HANDLE_CACHE* cache, MRT_HANDLE_CACHE_STATS* stats)
+{
+    if (!stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!cache)
+        return;
+
+    stats->Hits = cache->Hits;
+    stats->Misses = cache->Misses;
+    stats->Evictions = cache->Evictions;
+    stats->MaxHandles = cache->MaxHandles;
+    for (ULONG i = 0; i < cache->Current.Capacity; i++) {
+        if (cache->Current.Entries[i].Used && cache->Current.Entries[i].Handle)
+            stats->OpenHandles++;
+    }
+}
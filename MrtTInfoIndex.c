@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include "MrtTInfoInternal.h"
+
+// Open-addressing tables with linear probing. Capacity is a power of two at
+// least twice the key count, so probes stay short. Slot index 0 means empty,
+// stored indexes are biased by one.
+typedef struct _MRT_INDEX_PROCESS_SLOT {
+    DWORD PID;
+    ULONG Process;      // index + 1
+} MRT_INDEX_PROCESS_SLOT;
+
+typedef struct _MRT_INDEX_THREAD_SLOT {
+    DWORD TID;
+    ULONG Process;      // index + 1
+    ULONG Thread;
+} MRT_INDEX_THREAD_SLOT;
+
+struct _MRT_SNAPSHOT_INDEX {
+    MRT_PROCESS_INFO* Processes;
+    ULONG Count;
+    ULONG ProcessMask;
+    ULONG ThreadMask;
+    BOOLEAN HeapOwned;
+    MRT_INDEX_PROCESS_SLOT* ProcessSlots;
+    MRT_INDEX_THREAD_SLOT* ThreadSlots;
+};
+
+#define MRT_INDEX_BATCH 16
+
+static ULONG IndexCapacity(ULONG keys)
+{
+    ULONG cap = 16;
+    while (cap < keys * 2 && cap < 0x80000000UL)
+        cap <<= 1;
+    return cap;
+}
+
+NTSTATUS MrtIndex_Build(
+    MRT_BUILD* build,
+    MRT_PROCESS_INFO* processes,
+    ULONG count,
+    MRT_SNAPSHOT_INDEX** Index
+)
+{
+    if (!Index || (!processes && count))
+        return STATUS_INVALID_PARAMETER;
+
+    *Index = NULL;
+
+    ULONG threadTotal = 0;
+    for (ULONG i = 0; i < count; i++)
+        threadTotal += processes[i].Threads ? processes[i].ThreadCount : 0;
+
+    ULONG processCap = IndexCapacity(count);
+    ULONG threadCap = IndexCapacity(threadTotal);
+
+    // One block: header, process slots, thread slots
+    SIZE_T size = sizeof(MRT_SNAPSHOT_INDEX) +
+        processCap * sizeof(MRT_INDEX_PROCESS_SLOT) +
+        threadCap * sizeof(MRT_INDEX_THREAD_SLOT);
+
+    BYTE* block = (BYTE*)MrtBuild_Alloc(build, size);
+    if (!block)
+        return STATUS_NO_MEMORY;
+
+    MRT_SNAPSHOT_INDEX* index = (MRT_SNAPSHOT_INDEX*)block;
+    index->Processes    = processes;
+    index->Count        = count;
+    index->ProcessMask  = processCap - 1;
+    index->ThreadMask   = threadCap - 1;
+    index->HeapOwned    = !(build && build->Arena);
+    index->ProcessSlots = (MRT_INDEX_PROCESS_SLOT*)(block + sizeof(MRT_SNAPSHOT_INDEX));
+    index->ThreadSlots  = (MRT_INDEX_THREAD_SLOT*)
+        ((BYTE*)index->ProcessSlots + processCap * sizeof(MRT_INDEX_PROCESS_SLOT));
+
+    // First occurrence wins, same answer as the linear scans
+    // (several idle threads share TID 0, for instance).
+    for (ULONG i = 0; i < count; i++) {
+        MRT_PROCESS_INFO* proc = &processes[i];
+
+        ULONG slot = MrtHash_Id(proc->PID, index->ProcessMask);
+        while (index->ProcessSlots[slot].Process &&
+               index->ProcessSlots[slot].PID != proc->PID)
+            slot = (slot + 1) & index->ProcessMask;
+
+        if (!index->ProcessSlots[slot].Process) {
+            index->ProcessSlots[slot].PID = proc->PID;
+            index->ProcessSlots[slot].Process = i + 1;
+        }
+
+        if (!proc->Threads)
+            continue;
+
+        for (ULONG t = 0; t < proc->ThreadCount; t++) {
+            DWORD tid = proc->Threads[t].TID;
+
+            slot = MrtHash_Id(tid, index->ThreadMask);
+            while (index->ThreadSlots[slot].Process &&
+                   index->ThreadSlots[slot].TID != tid)
+                slot = (slot + 1) & index->ThreadMask;
+
+            if (!index->ThreadSlots[slot].Process) {
+                index->ThreadSlots[slot].TID = tid;
+                index->ThreadSlots[slot].Process = i + 1;
+                index->ThreadSlots[slot].Thread = t;
+            }
+        }
+    }
+
+    *Index = index;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_IndexBuild(MRT_PROCESS_INFO* processes, ULONG count, MRT_SNAPSHOT_INDEX** Index)
+{
+    MRT_BUILD build = { 0 };
+    return MrtIndex_Build(&build, processes, count, Index);
+}
+
+void MrtTInfo_IndexFree(MRT_SNAPSHOT_INDEX* Index)
+{
+    // Arena-backed indexes go away with their arena
+    if (Index && Index->HeapOwned)
+        free(Index);
+}
+
+static const MRT_INDEX_PROCESS_SLOT* IndexProbeProcess(const MRT_SNAPSHOT_INDEX* index, DWORD pid, ULONG slot)
+{
+    for (;;) {
+        const MRT_INDEX_PROCESS_SLOT* s = &index->ProcessSlots[slot];
+        if (!s->Process)
+            return NULL;
+        if (s->PID == pid)
+            return s;
+        slot = (slot + 1) & index->ProcessMask;
+    }
+}
+
+static const MRT_INDEX_THREAD_SLOT* IndexProbeThread(const MRT_SNAPSHOT_INDEX* index, DWORD tid, ULONG slot)
+{
+    for (;;) {
+        const MRT_INDEX_THREAD_SLOT* s = &index->ThreadSlots[slot];
+        if (!s->Process)
+            return NULL;
+        if (s->TID == tid)
+            return s;
+        slot = (slot + 1) & index->ThreadMask;
+    }
+}
+
+MRT_PROCESS_INFO* MrtTInfo_IndexFindProcess(const MRT_SNAPSHOT_INDEX* Index, DWORD pid)
+{
+    if (!Index)
+        return NULL;
+
+    const MRT_INDEX_PROCESS_SLOT* s =
+        IndexProbeProcess(Index, pid, MrtHash_Id(pid, Index->ProcessMask));
+    return s ? &Index->Processes[s->Process - 1] : NULL;
+}
+
+MRT_THREAD_INFO* MrtTInfo_IndexFindThread(const MRT_SNAPSHOT_INDEX* Index, DWORD tid, MRT_PROCESS_INFO** Owner)
+{
+    if (Owner)
+        *Owner = NULL;
+    if (!Index)
+        return NULL;
+
+    const MRT_INDEX_THREAD_SLOT* s =
+        IndexProbeThread(Index, tid, MrtHash_Id(tid, Index->ThreadMask));
+    if (!s)
+        return NULL;
+
+    MRT_PROCESS_INFO* proc = &Index->Processes[s->Process - 1];
+    if (Owner)
+        *Owner = proc;
+    return &proc->Threads[s->Thread];
+}
+
+ULONG MrtTInfo_IndexFindProcesses(
+    const MRT_SNAPSHOT_INDEX* Index,
+    const DWORD* pids,
+    ULONG count,
+    MRT_PROCESS_INFO** results
+)
+{
+    if (!Index || !pids || !results)
+        return 0;
+
+    ULONG found = 0;
+    ULONG slots[MRT_INDEX_BATCH];
+
+    // Hash a batch and prefetch its home slots before probing, so the cache
+    // misses of one batch overlap instead of being paid one after another.
+    for (ULONG base = 0; base < count; base += MRT_INDEX_BATCH) {
+        ULONG n = count - base < MRT_INDEX_BATCH ? count - base : MRT_INDEX_BATCH;
+
+        for (ULONG i = 0; i < n; i++) {
+            slots[i] = MrtHash_Id(pids[base + i], Index->ProcessMask);
+            MRT_PREFETCH(&Index->ProcessSlots[slots[i]]);
+        }
+
+        for (ULONG i = 0; i < n; i++) {
+            const MRT_INDEX_PROCESS_SLOT* s = IndexProbeProcess(Index, pids[base + i], slots[i]);
+            results[base + i] = s ? &Index->Processes[s->Process - 1] : NULL;
+            found += s != NULL;
+        }
+    }
+
+    return found;
+}
+
+ULONG MrtTInfo_IndexFindThreads(
+    const MRT_SNAPSHOT_INDEX* Index,
+    const DWORD* tids,
+    ULONG count,
+    MRT_THREAD_INFO** results,
+    MRT_PROCESS_INFO** owners
+)
+{
+    if (!Index || !tids || !results)
+        return 0;
+
+    ULONG found = 0;
+    ULONG slots[MRT_INDEX_BATCH];
+
+    for (ULONG base = 0; base < count; base += MRT_INDEX_BATCH) {
+        ULONG n = count - base < MRT_INDEX_BATCH ? count - base : MRT_INDEX_BATCH;
+
+        for (ULONG i = 0; i < n; i++) {
+            slots[i] = MrtHash_Id(tids[base + i], Index->ThreadMask);
+            MRT_PREFETCH(&Index->ThreadSlots[slots[i]]);
+        }
+
+        for (ULONG i = 0; i < n; i++) {
+            const MRT_INDEX_THREAD_SLOT* s = IndexProbeThread(Index, tids[base + i], slots[i]);
+            MRT_PROCESS_INFO* proc = s ? &Index->Processes[s->Process - 1] : NULL;
+
+            results[base + i] = proc ? &proc->Threads[s->Thread] : NULL;
+            if (owners)
+                owners[base + i] = proc;
+            found += s != NULL;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// Refreshes an unused string survives in an owning pool, so names of
+// short-lived processes that keep coming back are not copied every time.
+// Expired strings are swept once every MRT_INTERN_KEEP builds.
+#define MRT_INTERN_KEEP 8
+
+typedef struct _MRT_INTERN_ENTRY {
+    PWSTR Text;                 // NUL-terminated, NULL = empty slot
+    ULONG Hash;
+    USHORT Length;              // bytes, as in UNICODE_STRING
+    ULONG LastUsed;             // generation of the last build that used it
+} MRT_INTERN_ENTRY;
+
+struct _MRT_STRING_POOL {
+    MRT_INTERN_ENTRY* Entries;
+    MRT_INTERN_ENTRY* Spare;    // same capacity, target of the sweep
+    ULONG Capacity;             // power of two, 0 = not usable
+    ULONG Count;
+    ULONG Generation;
+    BOOLEAN Owning;             // FALSE: strings come from the build's allocator
+    BOOLEAN InBuild;            // header and table are one block of build memory
+    BOOLEAN InArena;            // that block is arena memory, freed with the arena
+    ULONGLONG Hits;
+    ULONGLONG Misses;
+    SIZE_T Bytes;
+};
+
+static ULONG InternHash(const WCHAR* text, ULONG units)
+{
+    // FNV-1a over exact code units: names differing only in case stay apart
+    ULONG h = 2166136261u;
+    for (ULONG i = 0; i < units; i++) {
+        h ^= (ULONG)text[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Slot holding the string, or the empty slot where it belongs
+static MRT_INTERN_ENTRY* InternProbe(MRT_INTERN_ENTRY* entries, ULONG capacity, ULONG hash,
+                                     const WCHAR* text, USHORT length)
+{
+    ULONG mask = capacity - 1;
+    for (ULONG i = hash & mask;; i = (i + 1) & mask) {
+        MRT_INTERN_ENTRY* e = &entries[i];
+        if (!e->Text ||
+            (e->Hash == hash && e->Length == length && memcmp(e->Text, text, length) == 0))
+            return e;
+    }
+}
+
+// Moves every live entry into a table of the given capacity, dropping owned
+// strings not used for MRT_INTERN_KEEP generations. The sweep at an unchanged
+// capacity reuses the spare table; growing allocates both tables anew.
+static NTSTATUS InternRehash(MRT_STRING_POOL* pool, ULONG capacity)
+{
+    MRT_INTERN_ENTRY* entries;
+    MRT_INTERN_ENTRY* spare;
+    if (capacity == pool->Capacity) {
+        entries = pool->Spare;
+        spare = pool->Entries;
+    } else {
+        entries = (MRT_INTERN_ENTRY*)malloc(capacity * sizeof(MRT_INTERN_ENTRY));
+        spare = (MRT_INTERN_ENTRY*)malloc(capacity * sizeof(MRT_INTERN_ENTRY));
+        if (!entries || !spare) {
+            free(entries);
+            free(spare);
+            return STATUS_NO_MEMORY;
+        }
+    }
+    memset(entries, 0, capacity * sizeof(MRT_INTERN_ENTRY));
+
+    ULONG count = 0;
+    for (ULONG i = 0; i < pool->Capacity; i++) {
+        MRT_INTERN_ENTRY* e = &pool->Entries[i];
+        if (!e->Text)
+            continue;
+        if (pool->Owning && pool->Generation - e->LastUsed > MRT_INTERN_KEEP) {
+            pool->Bytes -= e->Length + sizeof(WCHAR);
+            free(e->Text);
+            continue;
+        }
+        *InternProbe(entries, capacity, e->Hash, e->Text, e->Length) = *e;
+        count++;
+    }
+
+    if (spare != pool->Entries) {
+        free(pool->Entries);
+        free(pool->Spare);
+    }
+    pool->Entries = entries;
+    pool->Spare = spare;
+    pool->Capacity = capacity;
+    pool->Count = count;
+    return STATUS_SUCCESS;
+}
+
+MRT_STRING_POOL* MrtIntern_Create(BOOL owning)
+{
+    MRT_STRING_POOL* pool = (MRT_STRING_POOL*)calloc(1, sizeof(MRT_STRING_POOL));
+    if (pool)
+        pool->Owning = owning ? TRUE : FALSE;
+    return pool;
+}
+
+MRT_STRING_POOL* MrtIntern_CreateInBuild(MRT_BUILD* build, ULONG strings)
+{
+    // Same load factor as MrtIntern_Begin, which then finds nothing to grow
+    ULONG capacity = 16;
+    while (capacity < strings * 2)
+        capacity *= 2;
+
+    MRT_STRING_POOL* pool = (MRT_STRING_POOL*)MrtBuild_Alloc(build,
+        sizeof(MRT_STRING_POOL) + (SIZE_T)capacity * sizeof(MRT_INTERN_ENTRY));
+    if (!pool)
+        return NULL;
+    pool->Entries = (MRT_INTERN_ENTRY*)(pool + 1);
+    pool->Capacity = capacity;
+    pool->InBuild = TRUE;
+    pool->InArena = build && build->Arena;
+    return pool;
+}
+
+void MrtIntern_Destroy(MRT_STRING_POOL* pool)
+{
+    if (!pool)
+        return;
+
+    // Arena blocks go with the arena; a heap block is the pool itself
+    if (pool->InBuild) {
+        if (!pool->InArena)
+            free(pool);
+        return;
+    }
+
+    if (pool->Owning) {
+        for (ULONG i = 0; i < pool->Capacity; i++)
+            free(pool->Entries[i].Text);
+    }
+    free(pool->Entries);
+    free(pool->Spare);
+    free(pool);
+}
+
+NTSTATUS MrtIntern_Begin(MRT_STRING_POOL* pool, ULONG strings)
+{
+    pool->Generation++;
+
+    // Non-owning pools only dedupe within one build: start empty
+    if (!pool->Owning && pool->Count) {
+        memset(pool->Entries, 0, pool->Capacity * sizeof(MRT_INTERN_ENTRY));
+        pool->Count = 0;
+        pool->Bytes = 0;
+    }
+
+    // Load factor stays at or below one half even if every string is new
+    ULONG capacity = 16;
+    while (capacity < (pool->Count + strings) * 2)
+        capacity *= 2;
+    if (capacity <= pool->Capacity)
+        return STATUS_SUCCESS;
+
+    NTSTATUS status = InternRehash(pool, capacity);
+    if (!NT_SUCCESS(status)) {
+        // Without a table every string is copied (MrtIntern_Get falls back)
+        if (!pool->Owning) {
+            free(pool->Entries);
+            free(pool->Spare);
+            pool->Entries = NULL;
+            pool->Spare = NULL;
+            pool->Capacity = 0;
+        }
+    }
+    return status;
+}
+
+PWSTR MrtIntern_Get(MRT_STRING_POOL* pool, MRT_BUILD* build, const WCHAR* text, USHORT length)
+{
+    if (!text || length == 0)
+        return NULL;
+
+    MRT_INTERN_ENTRY* e = NULL;
+    ULONG hash = 0;
+    if (pool && pool->Capacity && (pool->Count + 1) * 2 <= pool->Capacity) {
+        hash = InternHash(text, length / sizeof(WCHAR));
+        e = InternProbe(pool->Entries, pool->Capacity, hash, text, length);
+        if (e->Text) {
+            e->LastUsed = pool->Generation;
+            pool->Hits++;
+            MRT_STAT_ADD(build, StringsShared, 1);
+            return e->Text;
+        }
+    }
+
+    // Owned strings outlive the snapshot, the others belong to it
+    SIZE_T size = (SIZE_T)length + sizeof(WCHAR);
+    PWSTR copy;
+    if (pool && pool->Owning && e) {
+        copy = (PWSTR)malloc(size);
+        MRT_STAT_ADD(build, Allocations, 1);
+        MRT_STAT_ADD(build, BytesAllocated, size);
+    } else {
+        copy = (PWSTR)MrtBuild_Alloc(build, size);
+    }
+    if (!copy)
+        return NULL;
+    memcpy(copy, text, length);
+    copy[length / sizeof(WCHAR)] = L'\0';
+    MRT_STAT_ADD(build, StringsCopied, 1);
+
+    if (e) {
+        e->Text = copy;
+        e->Hash = hash;
+        e->Length = length;
+        e->LastUsed = pool->Generation;
+        pool->Count++;
+        pool->Bytes += size;
+        pool->Misses++;
+    }
+    return copy;
+}
+
+void MrtIntern_End(MRT_STRING_POOL* pool)
+{
+    // Drop names gone for a while; a rehash of the same size is the sweep
+    if (pool->Owning && pool->Capacity && pool->Generation % MRT_INTERN_KEEP == 0)
+        InternRehash(pool, pool->Capacity);
+}
+
+void MrtIntern_GetStats(const MRT_STRING_POOL* pool, MRT_STRING_POOL_STATS* stats)
+{
+    if (!stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!pool)
+        return;
+
+    stats->Hits = pool->Hits;
+    stats->Misses = pool->Misses;
+    stats->Strings = pool->Count;
+    stats->Bytes = pool->Bytes;
+}
@@ -0,0 +1,352 @@
+#pragma once
+#include "MrtTInfo.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// -----------------------------
+// Internal helpers shared between the MrtTInfo translation units.
+// Not part of the public API.
+// -----------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MRT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define MRT_PREFETCH(p) ((void)(p))
+#endif
+
+// -----------------------------
+// Threads, locks and atomics (Win32 / pthreads)
+// -----------------------------
+typedef struct _MRT_MUTEX {
+#ifdef _WIN32
+    CRITICAL_SECTION Cs;
+#else
+    pthread_mutex_t Mutex;
+#endif
+} MRT_MUTEX;
+
+typedef struct _MRT_COND {
+#ifdef _WIN32
+    CONDITION_VARIABLE Cv;
+#else
+    pthread_cond_t Cond;
+#endif
+} MRT_COND;
+
+typedef struct _MRT_THREAD {
+#ifdef _WIN32
+    HANDLE Handle;
+#else
+    pthread_t Thread;
+    BOOLEAN Started;
+#endif
+} MRT_THREAD;
+
+typedef void (*MRT_THREAD_FN)(void* ctx);
+
+void MrtMutex_Init(MRT_MUTEX* m);
+void MrtMutex_Destroy(MRT_MUTEX* m);
+void MrtMutex_Lock(MRT_MUTEX* m);
+void MrtMutex_Unlock(MRT_MUTEX* m);
+void MrtCond_Init(MRT_COND* c);
+void MrtCond_Destroy(MRT_COND* c);
+void MrtCond_Wait(MRT_COND* c, MRT_MUTEX* m);
+BOOL MrtCond_WaitTimeout(MRT_COND* c, MRT_MUTEX* m, ULONG milliseconds); // FALSE on timeout
+void MrtCond_Broadcast(MRT_COND* c);
+BOOL MrtThread_Start(MRT_THREAD* t, MRT_THREAD_FN fn, void* ctx);
+void MrtThread_Join(MRT_THREAD* t);
+ULONG MrtPlatform_CpuCount(void);
+ULONGLONG MrtPlatform_NowNs(void);  // monotonic
+ULONGLONG MrtPlatform_SystemTimeTicks(void); // wall clock, FILETIME ticks
+NTSTATUS MrtPlatform_WriteFile(const char* path, const void* data, SIZE_T size); // create/truncate
+NTSTATUS MrtPlatform_WriteFd(int fd, const void* data, SIZE_T size); // all of it, retrying short writes
+NTSTATUS MrtPlatform_MapFile(const char* path, const void** Base, SIZE_T* Size); // read-only
+void MrtPlatform_UnmapFile(const void* base, SIZE_T size);
+
+#ifdef _WIN32
+#define MrtAtomic_Add(p, v)   (InterlockedExchangeAdd((p), (v)) + (v))
+#define MrtAtomic_Load(p)     InterlockedCompareExchange((p), 0, 0)
+#define MrtAtomic_Store(p, v) ((void)InterlockedExchange((p), (v)))
+#define MrtAtomic_Add64(p, v) \
+    ((ULONGLONG)InterlockedExchangeAdd64((volatile LONGLONG*)(p), (LONGLONG)(v)) + (v))
+#define MrtAtomic_Load64(p) \
+    ((ULONGLONG)InterlockedCompareExchange64((volatile LONGLONG*)(p), 0, 0))
+#define MrtAtomic_CompareExchange(p, x, c) InterlockedCompareExchange((p), (x), (c))
+#define MrtAtomic_CompareExchange64(p, x, c) \
+    ((ULONGLONG)InterlockedCompareExchange64((volatile LONGLONG*)(p), (LONGLONG)(x), (LONGLONG)(c)))
+#define MrtAtomic_LoadPointer(p) \
+    InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define MrtAtomic_ExchangePointer(p, v) \
+    InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#else
+#define MrtAtomic_Add(p, v)   __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define MrtAtomic_Load(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define MrtAtomic_Store(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define MrtAtomic_Add64(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+#define MrtAtomic_Load64(p)   __atomic_load_n((p), __ATOMIC_SEQ_CST)
+// Return the previous value, like InterlockedCompareExchange(64)
+#define MrtAtomic_CompareExchange(p, x, c)   __sync_val_compare_and_swap((p), (c), (x))
+#define MrtAtomic_CompareExchange64(p, x, c) __sync_val_compare_and_swap((p), (c), (x))
+#define MrtAtomic_LoadPointer(p)        __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define MrtAtomic_ExchangePointer(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#endif
+
+// -----------------------------
+// Worker pool
+// -----------------------------
+// Fixed set of threads that split [0, items) into chunks claimed with an
+// atomic counter. The calling thread works too; Run returns when all chunks
+// are done. Jobs must write to disjoint outputs, the pool adds no locking.
+typedef void (*MRT_WORK_FN)(void* ctx, ULONG begin, ULONG end);
+typedef struct _MRT_WORKER_POOL MRT_WORKER_POOL;
+
+MRT_WORKER_POOL* MrtPool_Create(ULONG threads);  // threads besides the caller
+void MrtPool_Destroy(MRT_WORKER_POOL* pool);
+void MrtPool_Run(MRT_WORKER_POOL* pool, ULONG items, ULONG chunk, MRT_WORK_FN fn, void* ctx);
+
+#define MRT_ENRICH_CHUNK 32
+// Matching entries a filtered conversion tracks on the stack before going to the heap
+#define MRT_MATCH_STACK 512
+
+#define MRT_QUERY_BUFFER_INITIAL  0x10000
+#define MRT_QUERY_BUFFER_HEADROOM 0x4000
+
+// ntdll entry points, resolved once per process by MrtNt_Resolve
+typedef struct _MRT_NTAPI {
+    PFN_NTQUERYSYSTEMINFORMATION NtQuerySystemInformation;
+    PFN_NtQueryInformationThread NtQueryInformationThread;
+} MRT_NTAPI;
+
+// Grow-only SystemProcessInformation buffer
+typedef struct _MRT_QUERY_BUFFER {
+    void* Data;
+    ULONG Capacity;
+    ULONG Length;   // bytes filled by the last successful query
+    ULONG Retries;  // length mismatches during the last query
+} MRT_QUERY_BUFFER;
+
+// -----------------------------
+// Instrumentation (MRT_STATS_ENABLED)
+// -----------------------------
+// Counters of one build live in a frame on the building thread's stack.
+// Enrichment workers count per chunk and merge with MrtStats_Merge;
+// MrtStats_Commit folds the frame into the process-wide totals.
+typedef struct _MRT_STATS_FRAME {
+    MRT_STATS_COUNTERS Counts;
+    ULONGLONG Start;                        // MrtPlatform_NowNs at MrtStats_Begin
+    ULONGLONG PhaseNs[MRT_PHASE_COUNT];
+    ULONG Timed;                            // bit per phase recorded in PhaseNs
+    ULONG QueryBufferSize;                  // 0: the build made no query
+    ULONG QueryLength;
+} MRT_STATS_FRAME;
+
+// MRT_STAT(statement) disappears when MRT_STATS_ENABLED is 0
+#if MRT_STATS_ENABLED
+#define MRT_STAT(...) __VA_ARGS__
+#else
+#define MRT_STAT(...)
+#endif
+
+// Adds to a counter of the build's frame, if it has one (not thread safe)
+#define MRT_STAT_ADD(build, field, v) \
+    MRT_STAT(do { if ((build) && (build)->Stats) (build)->Stats->Counts.field += (v); } while (0))
+
+void MrtStats_Begin(MRT_STATS_FRAME* frame);
+// Time since start charged to phase; no-op for a NULL frame
+void MrtStats_Phase(MRT_STATS_FRAME* frame, MRT_STATS_PHASE phase, ULONGLONG start);
+// Retries and sizes of a finished query, and its duration since start
+void MrtStats_Query(MRT_STATS_FRAME* frame, const MRT_QUERY_BUFFER* qb, ULONGLONG start);
+void MrtStats_Merge(MRT_STATS_COUNTERS* to, const MRT_STATS_COUNTERS* from);   // atomic adds
+void MrtStats_Commit(MRT_STATS_FRAME* frame, NTSTATUS status);
+
+// -----------------------------
+// Thread handle cache (collector, opt-in)
+// -----------------------------
+// Entries keyed by (TID, CreateTime). Claims happen on the building thread
+// before enrichment; each claimed slot is then written only by the worker
+// enriching that thread.
+typedef struct _MRT_HANDLE_ENTRY {
+    ULONGLONG CreateTime;
+    HANDLE Handle;          // NULL with Opened set: OpenThread failed, not retried
+    DWORD Tid;
+    BOOLEAN Used;
+    BOOLEAN Opened;
+    BOOLEAN Moved;          // carried into the next table
+} MRT_HANDLE_ENTRY;
+
+typedef struct _MRT_HANDLE_CACHE MRT_HANDLE_CACHE;
+
+MRT_HANDLE_CACHE* MrtHandles_Create(ULONG maxHandles);
+void MrtHandles_Destroy(MRT_HANDLE_CACHE* cache);      // closes every cached handle
+NTSTATUS MrtHandles_Begin(MRT_HANDLE_CACHE* cache, ULONG threads);
+// Slot for a thread of the snapshot being built, NULL when over the cap
+MRT_HANDLE_ENTRY* MrtHandles_Claim(MRT_HANDLE_CACHE* cache, DWORD tid, ULONGLONG createTime);
+void MrtHandles_End(MRT_HANDLE_CACHE* cache);          // closes handles of unclaimed threads
+void MrtHandles_GetStats(const MRT_HANDLE_CACHE* cache, MRT_HANDLE_CACHE_STATS* stats);
+
+// -----------------------------
+// Compiled process filter (MRT_PROCESS_FILTER)
+// -----------------------------
+typedef struct _MRT_FILTER MRT_FILTER;
+
+// Case folding used for image-name matching and grouping
+wchar_t MrtFilter_Fold(wchar_t c);
+
+NTSTATUS MrtFilter_Create(const MRT_PROCESS_FILTER* spec, MRT_FILTER** Filter);
+void MrtFilter_Free(MRT_FILTER* filter);
+BOOL MrtFilter_Match(const MRT_FILTER* filter, const MRT_SYSTEM_PROCESS_INFORMATION* p); // NULL matches all
+
+// One thread to enrich
+typedef struct _MRT_ENRICH_ITEM {
+    MRT_PROCESS_INFO* Process;
+    MRT_THREAD_INFO* Thread;
+    MRT_HANDLE_ENTRY* Handle;   // NULL: open and close a handle for this build only
+} MRT_ENRICH_ITEM;
+
+// Grow-only work list kept by long-lived owners (collector)
+typedef struct _MRT_ENRICH_SCRATCH {
+    MRT_ENRICH_ITEM* Items;
+    ULONG Capacity;
+} MRT_ENRICH_SCRATCH;
+
+typedef struct _MRT_STRING_POOL MRT_STRING_POOL;
+
+// Allocation context for one snapshot build.
+// Arena == NULL means plain heap allocations (freed by MrtTInfo_FreeProcesses).
+// Pool/Scratch are optional: without a pool enrichment runs on the caller.
+typedef struct _MRT_BUILD {
+    MRT_ARENA* Arena;
+    const MRT_NTAPI* Nt;
+    ULONG Flags;            // normalized MRT_QUERY_FLAGS
+    MRT_WORKER_POOL* Pool;
+    MRT_ENRICH_SCRATCH* Scratch;
+    MRT_HANDLE_CACHE* Handles;  // optional, reuses thread handles across builds
+    const MRT_FILTER* Filter;   // optional, skips raw entries before any copy
+    MRT_STRING_POOL* Strings;   // optional, long-lived; NULL: a pool in build memory
+    const MRT_MEMORY_READER* Reader;    // MRT_QUERY_REMOTE source, NULL: no remote reads
+    MRT_STATS_FRAME* Stats;     // instrumentation, NULL: not recorded
+    DWORD CallerTid;            // thread that runs the build, set before enrichment
+    ULONG CallerProcessor;      // its processor then, (ULONG)-1 unless MRT_QUERY_AFFINITY
+} MRT_BUILD;
+
+NTSTATUS MrtNt_Resolve(const MRT_NTAPI** Api);
+NTSTATUS MrtProvider_Query(const MRT_PROVIDER* provider, MRT_QUERY_BUFFER* qb);
+void MrtNt_FreeQueryBuffer(MRT_QUERY_BUFFER* qb);
+
+// One snapshot built with a collector's settings (query or replay, flags,
+// filter, workers, handle cache, reader) into Arena, which is reset first.
+// The collector refresh passes its own arena and owning string pool; other
+// owners pass a pool that does not outlive their snapshots (or NULL).
+NTSTATUS MrtCollector_BuildInto(
+    MRT_COLLECTOR* Collector,
+    MRT_ARENA* Arena,
+    MRT_STRING_POOL* Strings,
+    MRT_STATS_FRAME* stats,
+    MRT_PROCESS_INFO** Processes,
+    ULONG* Count,
+    BOOL withIndex,
+    MRT_SNAPSHOT_INDEX** Index
+);
+
+// STATUS_SUCCESS when the NextEntryOffset chain of a raw buffer walks cleanly
+NTSTATUS MrtCursor_Validate(const void* buffer, ULONG length);
+
+// Converts (and enriches) a SystemProcessInformation buffer into MRT_PROCESS_INFO records.
+// The buffer is not referenced after the call returns.
+NTSTATUS MrtTInfo_BuildFromBuffer(
+    MRT_BUILD* build,
+    const MRT_SYSTEM_PROCESS_INFORMATION* buffer,
+    MRT_PROCESS_INFO** Processes,
+    ULONG* Count
+);
+
+// Zero-filled allocation from the build's arena or the heap.
+void* MrtBuild_Alloc(MRT_BUILD* build, SIZE_T size);
+
+// Same as MrtTInfo_UnicodeStringToWString but allocated through the build.
+wchar_t* MrtBuild_CopyUnicodeString(MRT_BUILD* build, const UNICODE_STRING* ustr);
+
+// -----------------------------
+// String interning (image names)
+// -----------------------------
+// Identical strings resolve to one copy. An owning pool (collector) keeps its
+// strings across builds and frees names unused for a few builds once no
+// snapshot can reference them; a non-owning pool dedupes within one build and
+// allocates through it, so the copies belong to the snapshot.
+MRT_STRING_POOL* MrtIntern_Create(BOOL owning);
+// Non-owning pool for one build, sized for strings names: a single block from
+// the build's arena (nothing to free) or one counted heap block
+MRT_STRING_POOL* MrtIntern_CreateInBuild(MRT_BUILD* build, ULONG strings);
+void MrtIntern_Destroy(MRT_STRING_POOL* pool);
+NTSTATUS MrtIntern_Begin(MRT_STRING_POOL* pool, ULONG strings);   // sizes for up to strings new entries
+// Shared NUL-terminated copy of length bytes, NULL when empty or out of memory
+PWSTR MrtIntern_Get(MRT_STRING_POOL* pool, MRT_BUILD* build, const WCHAR* text, USHORT length);
+void MrtIntern_End(MRT_STRING_POOL* pool);
+void MrtIntern_GetStats(const MRT_STRING_POOL* pool, MRT_STRING_POOL_STATS* stats);
+
+// Remote TEB/PEB pass (MRT_QUERY_REMOTE) over every process but self whose
+// threads have TEB addresses: one reader open per process, reads through a
+// page cache. Allocates through the build, so it runs single-threaded.
+NTSTATUS MrtRemote_ReadAll(MRT_BUILD* build, MRT_PROCESS_INFO* procs, ULONG count, DWORD self, MRT_REMOTE_STATS* stats);
+
+// UTF-8 (or arbitrary bytes) to host WCHAR, U+FFFD for malformed sequences.
+// Returns the units produced; out == NULL only counts them.
+ULONG MrtUtf8_ToWchar(const char* src, ULONG length, WCHAR* out);
+
+// Snapshot index built through the build's allocator (arena or heap)
+NTSTATUS MrtIndex_Build(
+    MRT_BUILD* build,
+    MRT_PROCESS_INFO* processes,
+    ULONG count,
+    MRT_SNAPSHOT_INDEX** Index
+);
+
+// -----------------------------
+// Identity keys: (PID or TID, CreateTime) plus the record position
+// -----------------------------
+typedef struct _MRT_SORT_KEY {
+    DWORD Id;
+    ULONG Outer;            // process index
+    ULONG Inner;            // thread index within the process
+    ULONGLONG CreateTime;
+} MRT_SORT_KEY;
+
+// Multiplicative hash folded onto the low bits: PIDs/TIDs are multiples of 4
+// and mostly small, the multiply spreads them over the whole table.
+static inline ULONG MrtHash_Id(DWORD key, ULONG mask)
+{
+    ULONG h = (ULONG)key * 2654435761U;
+    return (ULONG)((h ^ (h >> 16)) & mask);
+}
+
+static inline ULONGLONG MrtFileTimeToU64(const FILETIME* ft)
+{
+    return ((ULONGLONG)ft->dwHighDateTime << 32) | ft->dwLowDateTime;
+}
+
+static inline int MrtSort_Compare(const MRT_SORT_KEY* a, const MRT_SORT_KEY* b)
+{
+    if (a->Id != b->Id)
+        return a->Id < b->Id ? -1 : 1;
+    if (a->CreateTime != b->CreateTime)
+        return a->CreateTime < b->CreateTime ? -1 : 1;
+    return 0;
+}
+
+// Stable sort by (Id, CreateTime); temp must hold count keys
+void MrtSort_Keys(MRT_SORT_KEY* keys, MRT_SORT_KEY* temp, ULONG count);
+// Fill keys for every process / every thread, return the number written
+ULONG MrtSort_ProcessKeys(const MRT_PROCESS_INFO* procs, ULONG count, MRT_SORT_KEY* keys);
+ULONG MrtSort_ThreadKeys(const MRT_PROCESS_INFO* procs, ULONG count, MRT_SORT_KEY* keys);
+
+// Arena bump allocation (zero-filled). Returns NULL on OOM.
+void* MrtArena_Alloc(MRT_ARENA* arena, SIZE_T size);
+
+#ifdef __cplusplus
+}
+#endif
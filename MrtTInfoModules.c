@@ -0,0 +1,393 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+#ifndef _WIN32
+#include <link.h>
+#include <unistd.h>
+#endif
+
+#define MRT_MODULES_MAX 65536  // bounds list walks racing a corrupted list
+
+// Loader state identifying one version of the module list
+typedef struct _MRT_MODULE_STAMP {
+    ULONGLONG Generation;   // notifications seen (Windows) / dlpi_adds (ELF)
+    ULONGLONG Removed;      // list length (Windows fallback) / dlpi_subs (ELF)
+    ULONG_PTR Tail;         // last list entry (Windows fallback)
+} MRT_MODULE_STAMP;
+
+struct _MRT_MODULE_CACHE {
+    MRT_MODULE_STAMP Stamp;
+    BOOLEAN Valid;
+    MRT_MODULE_INFO* Modules;   // grow-only
+    ULONG Count;
+    ULONG ModuleCapacity;
+    WCHAR* Names;               // grow-only, NUL-terminated full names
+    ULONG NameUsed;
+    ULONG NameCapacity;
+    ULONG Rebuilds;
+    NTSTATUS WalkStatus;
+#ifdef _WIN32
+    volatile LONG LoaderGeneration;     // bumped by the DLL notification
+    PVOID NotificationCookie;           // NULL: fallback stamp
+#endif
+};
+
+// -----------------------------
+// Record storage
+// -----------------------------
+// Room for one more record and a name of units characters; NULL on failure
+static WCHAR* ModulesReserve(MRT_MODULE_CACHE* c, ULONG units)
+{
+    if (c->Count == c->ModuleCapacity) {
+        ULONG cap = c->ModuleCapacity ? c->ModuleCapacity * 2 : 64;
+        MRT_MODULE_INFO* grown = (MRT_MODULE_INFO*)realloc(c->Modules, cap * sizeof(MRT_MODULE_INFO));
+        if (!grown)
+            return NULL;
+        c->Modules = grown;
+        c->ModuleCapacity = cap;
+    }
+
+    if (c->NameUsed + units + 1 > c->NameCapacity) {
+        ULONG cap = c->NameCapacity ? c->NameCapacity * 2 : 4096;
+        while (cap < c->NameUsed + units + 1)
+            cap *= 2;
+        WCHAR* grown = (WCHAR*)realloc(c->Names, cap * sizeof(WCHAR));
+        if (!grown)
+            return NULL;
+        c->Names = grown;
+        c->NameCapacity = cap;
+    }
+
+    return c->Names + c->NameUsed;
+}
+
+// Names may move while the list is walked: records keep offsets until ModulesFixNames
+static void ModulesCommit(MRT_MODULE_CACHE* c, PVOID base, SIZE_T size, PVOID entry, ULONG units)
+{
+    WCHAR* name = c->Names + c->NameUsed;
+    name[units] = 0;
+
+    ULONG baseStart = units;
+    while (baseStart && name[baseStart - 1] != L'\\' && name[baseStart - 1] != L'/')
+        baseStart--;
+
+    MRT_MODULE_INFO* m = &c->Modules[c->Count++];
+    m->Base = base;
+    m->Size = size;
+    m->EntryPoint = entry;
+    m->FullName.Length = (USHORT)(units * sizeof(WCHAR));
+    m->FullName.MaximumLength = (USHORT)((units + 1) * sizeof(WCHAR));
+    m->FullName.Buffer = (PWSTR)(ULONG_PTR)c->NameUsed;
+    m->BaseName.Length = (USHORT)((units - baseStart) * sizeof(WCHAR));
+    m->BaseName.MaximumLength = (USHORT)((units - baseStart + 1) * sizeof(WCHAR));
+    m->BaseName.Buffer = (PWSTR)(ULONG_PTR)(c->NameUsed + baseStart);
+
+    c->NameUsed += units + 1;
+}
+
+static void ModulesFixNames(MRT_MODULE_CACHE* c)
+{
+    for (ULONG i = 0; i < c->Count; i++) {
+        MRT_MODULE_INFO* m = &c->Modules[i];
+        m->FullName.Buffer = c->Names + (ULONG_PTR)m->FullName.Buffer;
+        m->BaseName.Buffer = c->Names + (ULONG_PTR)m->BaseName.Buffer;
+    }
+}
+
+// UNICODE_STRING lengths are bytes in a USHORT
+#define MRT_MODULE_NAME_MAX ((ULONG)(0xFFFE / sizeof(WCHAR)) - 1)
+
+#ifdef _WIN32
+// -----------------------------
+// Windows: PEB loader list
+// -----------------------------
+typedef NTSTATUS (NTAPI *PFN_LdrLockLoaderLock)(ULONG Flags, ULONG* Disposition, PVOID* Cookie);
+typedef NTSTATUS (NTAPI *PFN_LdrUnlockLoaderLock)(ULONG Flags, PVOID Cookie);
+typedef void (CALLBACK *PFN_LdrDllNotification)(ULONG Reason, const void* Data, PVOID Context);
+typedef NTSTATUS (NTAPI *PFN_LdrRegisterDllNotification)(
+    ULONG Flags, PFN_LdrDllNotification Callback, PVOID Context, PVOID* Cookie);
+typedef NTSTATUS (NTAPI *PFN_LdrUnregisterDllNotification)(PVOID Cookie);
+
+typedef struct _MRT_LDRAPI {
+    PFN_LdrLockLoaderLock LockLoaderLock;               // optional
+    PFN_LdrUnlockLoaderLock UnlockLoaderLock;
+    PFN_LdrRegisterDllNotification RegisterNotification; // Vista and later
+    PFN_LdrUnregisterDllNotification UnregisterNotification;
+} MRT_LDRAPI;
+
+static const MRT_LDRAPI* ModulesLdrApi(void)
+{
+    // Same benign race as MrtNt_Resolve: concurrent first calls store identical values
+    static MRT_LDRAPI api;
+    static volatile LONG resolved = 0;
+
+    if (!resolved) {
+        HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+        if (ntdll) {
+            api.LockLoaderLock = (PFN_LdrLockLoaderLock)GetProcAddress(ntdll, "LdrLockLoaderLock");
+            api.UnlockLoaderLock = (PFN_LdrUnlockLoaderLock)GetProcAddress(ntdll, "LdrUnlockLoaderLock");
+            api.RegisterNotification =
+                (PFN_LdrRegisterDllNotification)GetProcAddress(ntdll, "LdrRegisterDllNotification");
+            api.UnregisterNotification =
+                (PFN_LdrUnregisterDllNotification)GetProcAddress(ntdll, "LdrUnregisterDllNotification");
+        }
+        if (!api.LockLoaderLock || !api.UnlockLoaderLock)
+            api.LockLoaderLock = NULL;
+        if (!api.RegisterNotification || !api.UnregisterNotification)
+            api.RegisterNotification = NULL;
+        resolved = 1;
+    }
+    return &api;
+}
+
+static void CALLBACK ModulesLoaderNotification(ULONG Reason, const void* Data, PVOID Context)
+{
+    (void)Reason;
+    (void)Data;
+    (void)MrtAtomic_Add(&((MRT_MODULE_CACHE*)Context)->LoaderGeneration, 1);
+}
+
+static LIST_ENTRY* ModulesListHead(void)
+{
+    TEB_PARTIAL* teb = (TEB_PARTIAL*)NtCurrentTeb();
+    PEB_PARTIAL* peb = teb ? (PEB_PARTIAL*)teb->ProcessEnvironmentBlock : NULL;
+    PEB_LDR_DATA* ldr = peb ? (PEB_LDR_DATA*)peb->Ldr : NULL;
+    return ldr ? &ldr->InLoadOrderModuleList : NULL;
+}
+
+static PVOID ModulesLock(const MRT_LDRAPI* api)
+{
+    PVOID cookie = NULL;
+    if (api->LockLoaderLock && !NT_SUCCESS(api->LockLoaderLock(0, NULL, &cookie)))
+        cookie = NULL;
+    return cookie;
+}
+
+static void ModulesUnlock(const MRT_LDRAPI* api, PVOID cookie)
+{
+    if (cookie)
+        api->UnlockLoaderLock(0, cookie);
+}
+
+static NTSTATUS ModulesStamp(MRT_MODULE_CACHE* c, MRT_MODULE_STAMP* stamp)
+{
+    memset(stamp, 0, sizeof(*stamp));
+
+    if (c->NotificationCookie) {
+        stamp->Generation = (ULONGLONG)MrtAtomic_Load(&c->LoaderGeneration);
+        return STATUS_SUCCESS;
+    }
+
+    // Loads append to the load-order list, unloads shorten it
+    LIST_ENTRY* head = ModulesListHead();
+    if (!head)
+        return STATUS_UNSUCCESSFUL;
+
+    const MRT_LDRAPI* api = ModulesLdrApi();
+    PVOID cookie = ModulesLock(api);
+    ULONGLONG length = 0;
+    for (LIST_ENTRY* e = head->Flink; e != head && length < MRT_MODULES_MAX; e = e->Flink)
+        length++;
+    stamp->Removed = length;
+    stamp->Tail = (ULONG_PTR)head->Blink;
+    ModulesUnlock(api, cookie);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS ModulesWalk(MRT_MODULE_CACHE* c)
+{
+    LIST_ENTRY* head = ModulesListHead();
+    if (!head)
+        return STATUS_UNSUCCESSFUL;
+
+    const MRT_LDRAPI* api = ModulesLdrApi();
+    PVOID cookie = ModulesLock(api);
+    NTSTATUS status = STATUS_SUCCESS;
+
+    ULONG walked = 0;
+    for (LIST_ENTRY* e = head->Flink; e != head && walked < MRT_MODULES_MAX; e = e->Flink, walked++) {
+        LDR_DATA_TABLE_ENTRY* mod = CONTAINING_RECORD(e, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+
+        ULONG units = mod->FullDllName.Buffer ? mod->FullDllName.Length / sizeof(WCHAR) : 0;
+        WCHAR* name = ModulesReserve(c, units);
+        if (!name) {
+            status = STATUS_NO_MEMORY;
+            break;
+        }
+        if (units)
+            memcpy(name, mod->FullDllName.Buffer, units * sizeof(WCHAR));
+        ModulesCommit(c, mod->DllBase, mod->SizeOfImage, mod->EntryPoint, units);
+    }
+
+    ModulesUnlock(api, cookie);
+    return status;
+}
+
+#else
+// -----------------------------
+// ELF: dl_iterate_phdr
+// -----------------------------
+static int ModulesStampCallback(struct dl_phdr_info* info, size_t size, void* ctx)
+{
+    // dlpi_adds/dlpi_subs are per-process counters, the first object is enough
+    MRT_MODULE_STAMP* stamp = (MRT_MODULE_STAMP*)ctx;
+    if (size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs)) {
+        stamp->Generation = info->dlpi_adds;
+        stamp->Removed = info->dlpi_subs;
+    }
+    return 1;
+}
+
+static NTSTATUS ModulesStamp(MRT_MODULE_CACHE* c, MRT_MODULE_STAMP* stamp)
+{
+    (void)c;
+    memset(stamp, 0, sizeof(*stamp));
+    dl_iterate_phdr(ModulesStampCallback, stamp);
+    return STATUS_SUCCESS;
+}
+
+static int ModulesWalkCallback(struct dl_phdr_info* info, size_t size, void* ctx)
+{
+    (void)size;
+    MRT_MODULE_CACHE* c = (MRT_MODULE_CACHE*)ctx;
+
+    ElfW(Addr) low = (ElfW(Addr))-1, high = 0;
+    const ElfW(Ehdr)* header = NULL;
+    for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* ph = &info->dlpi_phdr[i];
+        if (ph->p_type != PT_LOAD)
+            continue;
+        if (ph->p_vaddr < low)
+            low = ph->p_vaddr;
+        if (ph->p_vaddr + ph->p_memsz > high)
+            high = ph->p_vaddr + ph->p_memsz;
+        if (ph->p_offset == 0)
+            header = (const ElfW(Ehdr)*)(info->dlpi_addr + ph->p_vaddr);
+    }
+    if (high == 0)
+        return 0;
+
+    PVOID entry = NULL;
+    if (header && memcmp(header->e_ident, ELFMAG, SELFMAG) == 0 && header->e_entry)
+        entry = (PVOID)(info->dlpi_addr + header->e_entry);
+
+    // The main program is reported without a name
+    const char* path = info->dlpi_name;
+    char exe[4096];
+    if ((!path || !*path) && c->Count == 0) {
+        ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        exe[n > 0 ? n : 0] = '\0';
+        path = exe;
+    }
+    if (!path)
+        path = "";
+
+    ULONG bytes = (ULONG)strlen(path);
+    ULONG units = MrtUtf8_ToWchar(path, bytes, NULL);
+    if (units > MRT_MODULE_NAME_MAX) {
+        bytes = MRT_MODULE_NAME_MAX;    // at least one unit per byte: fits after decoding
+        units = MrtUtf8_ToWchar(path, bytes, NULL);
+    }
+
+    WCHAR* name = ModulesReserve(c, units);
+    if (!name) {
+        c->WalkStatus = STATUS_NO_MEMORY;
+        return 1;
+    }
+    MrtUtf8_ToWchar(path, bytes, name);
+    ModulesCommit(c, (PVOID)(info->dlpi_addr + low), (SIZE_T)(high - low), entry, units);
+    return 0;
+}
+
+static NTSTATUS ModulesWalk(MRT_MODULE_CACHE* c)
+{
+    c->WalkStatus = STATUS_SUCCESS;
+    dl_iterate_phdr(ModulesWalkCallback, c);
+    return c->WalkStatus;
+}
+#endif
+
+// -----------------------------
+// Public API
+// -----------------------------
+NTSTATUS MrtTInfo_ModuleCacheCreate(MRT_MODULE_CACHE** Cache)
+{
+    if (!Cache)
+        return STATUS_INVALID_PARAMETER;
+
+    MRT_MODULE_CACHE* c = (MRT_MODULE_CACHE*)calloc(1, sizeof(MRT_MODULE_CACHE));
+    if (!c)
+        return STATUS_NO_MEMORY;
+
+#ifdef _WIN32
+    // Without the notification every call compares the list length and tail
+    const MRT_LDRAPI* api = ModulesLdrApi();
+    if (api->RegisterNotification &&
+        !NT_SUCCESS(api->RegisterNotification(0, ModulesLoaderNotification, c, &c->NotificationCookie)))
+        c->NotificationCookie = NULL;
+#endif
+
+    *Cache = c;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_ModuleCacheDestroy(MRT_MODULE_CACHE* Cache)
+{
+    if (!Cache)
+        return;
+
+#ifdef _WIN32
+    if (Cache->NotificationCookie)
+        ModulesLdrApi()->UnregisterNotification(Cache->NotificationCookie);
+#endif
+
+    free(Cache->Modules);
+    free(Cache->Names);
+    free(Cache);
+}
+
+NTSTATUS MrtTInfo_GetModules(MRT_MODULE_CACHE* Cache, const MRT_MODULE_INFO** Modules, ULONG* Count)
+{
+    if (!Cache || !Modules || !Count)
+        return STATUS_INVALID_PARAMETER;
+
+    *Modules = NULL;
+    *Count = 0;
+
+    // Stamp first: a change racing the walk shows up as a new stamp next call
+    MRT_MODULE_STAMP stamp;
+    NTSTATUS status = ModulesStamp(Cache, &stamp);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    BOOL same = Cache->Valid &&
+        stamp.Generation == Cache->Stamp.Generation &&
+        stamp.Removed == Cache->Stamp.Removed &&
+        stamp.Tail == Cache->Stamp.Tail;
+
+    if (!same) {
+        Cache->Valid = FALSE;
+        Cache->Count = 0;
+        Cache->NameUsed = 0;
+
+        status = ModulesWalk(Cache);
+        if (!NT_SUCCESS(status)) {
+            Cache->Count = 0;
+            return status;
+        }
+
+        ModulesFixNames(Cache);
+        Cache->Stamp = stamp;
+        Cache->Valid = TRUE;
+        Cache->Rebuilds++;
+    }
+
+    *Modules = Cache->Modules;
+    *Count = Cache->Count;
+    return STATUS_SUCCESS;
+}
+
+ULONG MrtTInfo_ModuleCacheRebuilds(const MRT_MODULE_CACHE* Cache)
+{
+    return Cache ? Cache->Rebuilds : 0;
+}
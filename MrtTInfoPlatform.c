@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#include "MrtTInfoInternal.h"
+
+// -----------------------------
+// Mutex / condition variable
+// -----------------------------
+void MrtMutex_Init(MRT_MUTEX* m)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(&m->Cs);
+#else
+    pthread_mutex_init(&m->Mutex, NULL);
+#endif
+}
+
+void MrtMutex_Destroy(MRT_MUTEX* m)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(&m->Cs);
+#else
+    pthread_mutex_destroy(&m->Mutex);
+#endif
+}
+
+void MrtMutex_Lock(MRT_MUTEX* m)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&m->Cs);
+#else
+    pthread_mutex_lock(&m->Mutex);
+#endif
+}
+
+void MrtMutex_Unlock(MRT_MUTEX* m)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&m->Cs);
+#else
+    pthread_mutex_unlock(&m->Mutex);
+#endif
+}
+
+void MrtCond_Init(MRT_COND* c)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(&c->Cv);
+#else
+    // Timed waits measure against the monotonic clock, as MrtPlatform_NowNs does,
+    // so wall-clock adjustments neither stretch nor cut them short
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&c->Cond, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+}
+
+void MrtCond_Destroy(MRT_COND* c)
+{
+#ifdef _WIN32
+    (void)c; // condition variables need no cleanup on Windows
+#else
+    pthread_cond_destroy(&c->Cond);
+#endif
+}
+
+void MrtCond_Wait(MRT_COND* c, MRT_MUTEX* m)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(&c->Cv, &m->Cs, INFINITE);
+#else
+    pthread_cond_wait(&c->Cond, &m->Mutex);
+#endif
+}
+
+BOOL MrtCond_WaitTimeout(MRT_COND* c, MRT_MUTEX* m, ULONG milliseconds)
+{
+#ifdef _WIN32
+    return SleepConditionVariableCS(&c->Cv, &m->Cs, milliseconds) ? TRUE : FALSE;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += milliseconds / 1000;
+    ts.tv_nsec += (long)(milliseconds % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(&c->Cond, &m->Mutex, &ts) != ETIMEDOUT;
+#endif
+}
+
+void MrtCond_Broadcast(MRT_COND* c)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(&c->Cv);
+#else
+    pthread_cond_broadcast(&c->Cond);
+#endif
+}
+
+// -----------------------------
+// Threads
+// -----------------------------
+typedef struct _MRT_THREAD_START {
+    MRT_THREAD_FN Fn;
+    void* Ctx;
+} MRT_THREAD_START;
+
+#ifdef _WIN32
+static DWORD WINAPI MrtThread_Trampoline(LPVOID param)
+#else
+static void* MrtThread_Trampoline(void* param)
+#endif
+{
+    MRT_THREAD_START start = *(MRT_THREAD_START*)param;
+    free(param);
+    start.Fn(start.Ctx);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+BOOL MrtThread_Start(MRT_THREAD* t, MRT_THREAD_FN fn, void* ctx)
+{
+    MRT_THREAD_START* start = (MRT_THREAD_START*)malloc(sizeof(MRT_THREAD_START));
+    if (!start)
+        return FALSE;
+
+    start->Fn = fn;
+    start->Ctx = ctx;
+
+#ifdef _WIN32
+    t->Handle = CreateThread(NULL, 0, MrtThread_Trampoline, start, 0, NULL);
+    if (!t->Handle) {
+        free(start);
+        return FALSE;
+    }
+#else
+    t->Started = pthread_create(&t->Thread, NULL, MrtThread_Trampoline, start) == 0;
+    if (!t->Started) {
+        free(start);
+        return FALSE;
+    }
+#endif
+    return TRUE;
+}
+
+void MrtThread_Join(MRT_THREAD* t)
+{
+#ifdef _WIN32
+    if (t->Handle) {
+        WaitForSingleObject(t->Handle, INFINITE);
+        CloseHandle(t->Handle);
+        t->Handle = NULL;
+    }
+#else
+    if (t->Started) {
+        pthread_join(t->Thread, NULL);
+        t->Started = FALSE;
+    }
+#endif
+}
+
+ULONG MrtPlatform_CpuCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (ULONG)n : 1;
+#endif
+}
+
+ULONGLONG MrtPlatform_NowNs(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    // Split to keep the multiply from overflowing on long uptimes
+    ULONGLONG q = (ULONGLONG)now.QuadPart / (ULONGLONG)freq.QuadPart;
+    ULONGLONG r = (ULONGLONG)now.QuadPart % (ULONGLONG)freq.QuadPart;
+    return q * 1000000000ULL + r * 1000000000ULL / (ULONGLONG)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONGLONG)ts.tv_sec * 1000000000ULL + (ULONGLONG)ts.tv_nsec;
+#endif
+}
+
+ULONGLONG MrtPlatform_SystemTimeTicks(void)
+{
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+#else
+    // 100ns ticks since 1601-01-01, the FILETIME epoch
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((ULONGLONG)ts.tv_sec + 11644473600ULL) * 10000000ULL + (ULONGLONG)ts.tv_nsec / 100;
+#endif
+}
+
+// -----------------------------
+// File writes / read-only mapping
+// -----------------------------
+NTSTATUS MrtPlatform_WriteFile(const char* path, const void* data, SIZE_T size)
+{
+    if (!path || (!data && size))
+        return STATUS_INVALID_PARAMETER;
+
+    const BYTE* p = (const BYTE*)data;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return STATUS_OBJECT_PATH_NOT_FOUND;
+
+    while (size) {
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD written = 0;
+        if (!WriteFile(file, p, chunk, &written, NULL) || written == 0) {
+            CloseHandle(file);
+            return STATUS_UNSUCCESSFUL;
+        }
+        p += written;
+        size -= written;
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return errno == EACCES ? STATUS_ACCESS_DENIED : STATUS_OBJECT_PATH_NOT_FOUND;
+
+    NTSTATUS status = MrtPlatform_WriteFd(fd, p, size);
+    if (close(fd) != 0 && NT_SUCCESS(status))
+        status = STATUS_UNSUCCESSFUL;
+    if (!NT_SUCCESS(status))
+        return status;
+#endif
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtPlatform_WriteFd(int fd, const void* data, SIZE_T size)
+{
+    if (fd < 0 || (!data && size))
+        return STATUS_INVALID_PARAMETER;
+
+    const BYTE* p = (const BYTE*)data;
+    while (size) {
+#ifdef _WIN32
+        unsigned int chunk = size > 0x40000000 ? 0x40000000 : (unsigned int)size;
+        int written = _write(fd, p, chunk);
+#else
+        ssize_t written = write(fd, p, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+#endif
+        if (written <= 0)
+            return STATUS_UNSUCCESSFUL;
+        p += written;
+        size -= (SIZE_T)written;
+    }
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtPlatform_MapFile(const char* path, const void** Base, SIZE_T* Size)
+{
+    if (!path || !Base || !Size)
+        return STATUS_INVALID_PARAMETER;
+
+    *Base = NULL;
+    *Size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return STATUS_OBJECT_NAME_NOT_FOUND;
+
+    LARGE_INTEGER size;
+    size.QuadPart = 0;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (ULONGLONG)size.QuadPart > (SIZE_T)-1) {
+        CloseHandle(file);
+        return size.QuadPart == 0 ? STATUS_END_OF_FILE : STATUS_UNSUCCESSFUL;
+    }
+
+    // The view keeps the section alive, both handles can go right away
+    HANDLE section = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!section)
+        return STATUS_UNSUCCESSFUL;
+
+    const void* view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (!view)
+        return STATUS_NO_MEMORY;
+
+    *Base = view;
+    *Size = (SIZE_T)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return errno == EACCES ? STATUS_ACCESS_DENIED : STATUS_OBJECT_NAME_NOT_FOUND;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return STATUS_END_OF_FILE;
+    }
+
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return STATUS_NO_MEMORY;
+
+    *Base = view;
+    *Size = (SIZE_T)st.st_size;
+#endif
+    return STATUS_SUCCESS;
+}
+
+void MrtPlatform_UnmapFile(const void* base, SIZE_T size)
+{
+    if (!base)
+        return;
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(base);
+#else
+    munmap((void*)base, size);
+#endif
+}
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include "MrtTInfoInternal.h"
+
+struct _MRT_WORKER_POOL {
+    MRT_MUTEX Lock;
+    MRT_COND Wake;          // workers wait here for the next job
+    MRT_COND Done;          // Run waits here for the workers
+    ULONG ThreadCount;
+    MRT_THREAD* Threads;
+    BOOLEAN Stop;
+
+    // Current job, published under Lock
+    ULONG Generation;
+    ULONG Busy;             // workers still inside the current job
+    MRT_WORK_FN Fn;
+    void* Ctx;
+    ULONG Items;
+    ULONG Chunk;
+    volatile LONG Next;     // next unclaimed item
+};
+
+static void PoolDrain(MRT_WORKER_POOL* pool, MRT_WORK_FN fn, void* ctx, ULONG items, ULONG chunk)
+{
+    for (;;) {
+        LONG begin = MrtAtomic_Add(&pool->Next, (LONG)chunk) - (LONG)chunk;
+        if (begin < 0 || (ULONG)begin >= items)
+            break;
+
+        ULONG end = (ULONG)begin + chunk;
+        if (end > items)
+            end = items;
+        fn(ctx, (ULONG)begin, end);
+    }
+}
+
+static void PoolWorker(void* param)
+{
+    MRT_WORKER_POOL* pool = (MRT_WORKER_POOL*)param;
+    ULONG seen = 0;
+
+    MrtMutex_Lock(&pool->Lock);
+    for (;;) {
+        while (!pool->Stop && pool->Generation == seen)
+            MrtCond_Wait(&pool->Wake, &pool->Lock);
+        if (pool->Stop)
+            break;
+
+        seen = pool->Generation;
+        MRT_WORK_FN fn = pool->Fn;
+        void* ctx = pool->Ctx;
+        ULONG items = pool->Items;
+        ULONG chunk = pool->Chunk;
+        MrtMutex_Unlock(&pool->Lock);
+
+        PoolDrain(pool, fn, ctx, items, chunk);
+
+        MrtMutex_Lock(&pool->Lock);
+        if (--pool->Busy == 0)
+            MrtCond_Broadcast(&pool->Done);
+    }
+    MrtMutex_Unlock(&pool->Lock);
+}
+
+MRT_WORKER_POOL* MrtPool_Create(ULONG threads)
+{
+    MRT_WORKER_POOL* pool = (MRT_WORKER_POOL*)calloc(1, sizeof(MRT_WORKER_POOL));
+    if (!pool)
+        return NULL;
+
+    pool->Threads = (MRT_THREAD*)calloc(threads ? threads : 1, sizeof(MRT_THREAD));
+    if (!pool->Threads) {
+        free(pool);
+        return NULL;
+    }
+
+    MrtMutex_Init(&pool->Lock);
+    MrtCond_Init(&pool->Wake);
+    MrtCond_Init(&pool->Done);
+
+    for (ULONG i = 0; i < threads; i++) {
+        if (!MrtThread_Start(&pool->Threads[i], PoolWorker, pool))
+            break;
+        pool->ThreadCount++;
+    }
+
+    return pool;
+}
+
+void MrtPool_Destroy(MRT_WORKER_POOL* pool)
+{
+    if (!pool)
+        return;
+
+    MrtMutex_Lock(&pool->Lock);
+    pool->Stop = TRUE;
+    MrtCond_Broadcast(&pool->Wake);
+    MrtMutex_Unlock(&pool->Lock);
+
+    for (ULONG i = 0; i < pool->ThreadCount; i++)
+        MrtThread_Join(&pool->Threads[i]);
+
+    MrtCond_Destroy(&pool->Done);
+    MrtCond_Destroy(&pool->Wake);
+    MrtMutex_Destroy(&pool->Lock);
+    free(pool->Threads);
+    free(pool);
+}
+
+void MrtPool_Run(MRT_WORKER_POOL* pool, ULONG items, ULONG chunk, MRT_WORK_FN fn, void* ctx)
+{
+    if (!fn || items == 0)
+        return;
+    if (chunk == 0)
+        chunk = 1;
+
+    // Not worth waking anyone for a single chunk
+    if (!pool || pool->ThreadCount == 0 || items <= chunk) {
+        fn(ctx, 0, items);
+        return;
+    }
+
+    MrtMutex_Lock(&pool->Lock);
+    pool->Fn = fn;
+    pool->Ctx = ctx;
+    pool->Items = items;
+    pool->Chunk = chunk;
+    pool->Next = 0;
+    pool->Busy = pool->ThreadCount;
+    pool->Generation++;
+    MrtCond_Broadcast(&pool->Wake);
+    MrtMutex_Unlock(&pool->Lock);
+
+    PoolDrain(pool, fn, ctx, items, chunk);
+
+    MrtMutex_Lock(&pool->Lock);
+    while (pool->Busy)
+        MrtCond_Wait(&pool->Done, &pool->Lock);
+    MrtMutex_Unlock(&pool->Lock);
+}
@@ -0,0 +1,522 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+#if defined(__linux__) && !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Linux /proc provider. Emits the same SystemProcessInformation layout as
+// ntdll, so every consumer (builder, cursor, diff, sampler, recordings) works
+// unchanged. Per process it reads <pid>/stat, status and io; per thread
+// task/<tid>/stat plus the switch count from schedstat. Single-threaded
+// processes reuse the process stat for their only thread.
+//
+// Field mapping: times are 100ns units, CreateTime is FILETIME ticks, BasePriority
+// holds the nice value and Priority the kernel priority. I/O counters are the
+// character counts (rchar/wchar, syscr/syscw) and HandleCount is not collected.
+//
+// Everything is read through one /proc directory fd with openat, into buffers
+// reused for the whole scan; numbers are parsed in place. A query that does not
+// fit keeps scanning to report the size needed, like the NT call.
+
+#define PROCFS_TEXT_SIZE    4096
+#define PROCFS_DENTS_SIZE   32768
+#define PROCFS_PATH_SIZE    48
+
+// getdents64 record; glibc only wraps it from 2.30 on
+typedef struct _PROCFS_DIRENT {
+    unsigned long long Ino;
+    long long Off;
+    unsigned short RecLen;
+    unsigned char Type;
+    char Name[];
+} PROCFS_DIRENT;
+
+// Fields of one stat line, in the order of proc(5)
+typedef struct _PROCFS_STAT {
+    const char* Comm;
+    ULONG CommLength;
+    char State;
+    ULONG ParentPID;
+    ULONG Session;
+    ULONGLONG MinorFaults;
+    ULONGLONG MajorFaults;
+    ULONGLONG UserTicks;
+    ULONGLONG KernelTicks;
+    LONG Priority;
+    LONG Nice;
+    ULONG Threads;
+    ULONGLONG StartTicks;
+    ULONGLONG VirtualSize;
+    ULONGLONG ResidentPages;
+} PROCFS_STAT;
+
+typedef struct _PROCFS_SCAN {
+    // Directory buffers first: dirent records need 8-byte alignment
+    char ProcDents[PROCFS_DENTS_SIZE];
+    char TaskDents[PROCFS_DENTS_SIZE / 4];
+    char Text[PROCFS_TEXT_SIZE];
+    int ProcFd;
+    BYTE* Out;
+    ULONG Capacity;
+    ULONG Used;                 // may run past Capacity while sizing
+    BOOLEAN NoSchedstat;        // kernel without CONFIG_SCHED_INFO
+} PROCFS_SCAN;
+
+#define PROCFS_HEADER_SIZE ((ULONG)offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads))
+
+static ULONGLONG g_ProcfsBootTicks;     // FILETIME ticks at boot
+static ULONGLONG g_ProcfsClockTicks;    // USER_HZ
+static ULONGLONG g_ProcfsPageSize;
+static pthread_once_t g_ProcfsOnce = PTHREAD_ONCE_INIT;
+
+static void ProcfsInitOnce(void)
+{
+    // Fixed once per process: CreateTime is part of the (ID, CreateTime)
+    // identity, recomputing the boot instant per scan would make it jitter.
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    ULONGLONG sinceBoot = (ULONGLONG)boot.tv_sec * 10000000ULL + (ULONGLONG)boot.tv_nsec / 100;
+    g_ProcfsBootTicks = MrtPlatform_SystemTimeTicks() - sinceBoot;
+
+    long hz = sysconf(_SC_CLK_TCK);
+    g_ProcfsClockTicks = hz > 0 ? (ULONGLONG)hz : 100;
+
+    long page = sysconf(_SC_PAGESIZE);
+    g_ProcfsPageSize = page > 0 ? (ULONGLONG)page : 4096;
+}
+
+static ULONGLONG ProcfsTicksTo100ns(ULONGLONG ticks)
+{
+    ULONGLONG hz = g_ProcfsClockTicks;
+    return ticks / hz * 10000000ULL + ticks % hz * 10000000ULL / hz;
+}
+
+// -----------------------------
+// Parsing
+// -----------------------------
+static LONGLONG ProcfsNumber(const char** cursor)
+{
+    const char* p = *cursor;
+    while (*p == ' ' || *p == '\t')
+        p++;
+
+    BOOL negative = *p == '-';
+    if (negative)
+        p++;
+
+    ULONGLONG value = 0;
+    while ((unsigned)(*p - '0') < 10)
+        value = value * 10 + (ULONGLONG)(*p++ - '0');
+
+    *cursor = p;
+    return negative ? -(LONGLONG)value : (LONGLONG)value;
+}
+
+static BOOL ProcfsParseStat(const char* text, LONG length, PROCFS_STAT* st)
+{
+    // comm may hold spaces and parentheses: it ends at the last ')'
+    const char* open = memchr(text, '(', (size_t)length);
+    const char* close = memrchr(text, ')', (size_t)length);
+    if (!open || !close || close < open || close + 2 >= text + length)
+        return FALSE;
+
+    st->Comm = open + 1;
+    st->CommLength = (ULONG)(close - open - 1);
+    st->State = close[2];
+
+    // Fields 4..24, numbered as in proc(5)
+    LONGLONG f[25];
+    const char* p = close + 3;
+    for (int i = 4; i <= 24; i++)
+        f[i] = ProcfsNumber(&p);
+
+    st->ParentPID     = (ULONG)f[4];
+    st->Session       = (ULONG)f[6];
+    st->MinorFaults   = (ULONGLONG)f[10];
+    st->MajorFaults   = (ULONGLONG)f[12];
+    st->UserTicks     = (ULONGLONG)f[14];
+    st->KernelTicks   = (ULONGLONG)f[15];
+    st->Priority      = (LONG)f[18];
+    st->Nice          = (LONG)f[19];
+    st->Threads       = (ULONG)f[20];
+    st->StartTicks    = (ULONGLONG)f[22];
+    st->VirtualSize   = (ULONGLONG)f[23];
+    st->ResidentPages = (ULONGLONG)f[24];
+    return TRUE;
+}
+
+// Value of a "Key: value" line, or 0 when the key is absent
+static ULONGLONG ProcfsKeyValue(const char* text, const char* key, ULONG keyLength)
+{
+    const char* p = text;
+    for (;;) {
+        if (strncmp(p, key, keyLength) == 0) {
+            p += keyLength;
+            return (ULONGLONG)ProcfsNumber(&p);
+        }
+        p = strchr(p, '\n');
+        if (!p)
+            return 0;
+        p++;
+    }
+}
+
+#define PROCFS_KEY(text, key) ProcfsKeyValue((text), key, (ULONG)(sizeof(key) - 1))
+
+// Linux scheduler state letter to the NT state/wait reason pair
+static void ProcfsThreadState(char state, MRT_THREAD_STATE* ThreadState, MRT_WAIT_REASON* WaitReason)
+{
+    *WaitReason = 0;
+    switch (state) {
+        case 'R': *ThreadState = 2; break;                      // Running
+        case 'S': *ThreadState = 5; *WaitReason = 6; break;     // UserRequest
+        case 'D': *ThreadState = 5; *WaitReason = 0; break;     // Executive
+        case 'T':
+        case 't': *ThreadState = 5; *WaitReason = 5; break;     // Suspended
+        case 'I': *ThreadState = 5; *WaitReason = 16; break;    // QueueWait
+        case 'Z':
+        case 'X':
+        case 'x': *ThreadState = 4; break;                      // Terminated
+        default:  *ThreadState = 5; break;
+    }
+}
+
+// -----------------------------
+// File access
+// -----------------------------
+static ULONG ProcfsPath(char* out, ULONG id, const char* leaf)
+{
+    char digits[10];
+    ULONG n = 0;
+    do {
+        digits[n++] = (char)('0' + id % 10);
+        id /= 10;
+    } while (id);
+
+    ULONG len = 0;
+    while (n)
+        out[len++] = digits[--n];
+    if (leaf) {
+        out[len++] = '/';
+        while (*leaf)
+            out[len++] = *leaf++;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Reads a whole (small) pseudo-file; -1 with errno set on failure
+static LONG ProcfsReadAt(int dirFd, const char* path, char* text)
+{
+    int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    ssize_t n;
+    do {
+        n = read(fd, text, PROCFS_TEXT_SIZE - 1);
+    } while (n < 0 && errno == EINTR);
+
+    int saved = errno;
+    close(fd);
+    if (n < 0) {
+        errno = saved;
+        return -1;
+    }
+
+    text[n] = '\0';
+    return (LONG)n;
+}
+
+static BOOL ProcfsNumericName(const char* name, ULONG* id)
+{
+    ULONG value = 0;
+    if (!*name)
+        return FALSE;
+    for (; *name; name++) {
+        if ((unsigned)(*name - '0') >= 10)
+            return FALSE;
+        value = value * 10 + (ULONG)(*name - '0');
+    }
+    *id = value;
+    return TRUE;
+}
+
+static ULONG ProcfsSchedSwitches(PROCFS_SCAN* scan, int dirFd, const char* path)
+{
+    if (scan->NoSchedstat)
+        return 0;
+
+    // "<run ns> <wait ns> <timeslices>": a timeslice starts at every switch-in
+    if (ProcfsReadAt(dirFd, path, scan->Text) < 0) {
+        if (errno == ENOENT && dirFd == scan->ProcFd)
+            scan->NoSchedstat = TRUE;
+        return 0;
+    }
+
+    const char* p = scan->Text;
+    ProcfsNumber(&p);
+    ProcfsNumber(&p);
+    return (ULONG)ProcfsNumber(&p);
+}
+
+// -----------------------------
+// Output
+// -----------------------------
+// Advances the output even past the end (sizing); NULL when the range does not fit
+static BYTE* ProcfsReserve(PROCFS_SCAN* scan, ULONG size)
+{
+    ULONG offset = scan->Used;
+    scan->Used += size;
+    return scan->Used <= scan->Capacity ? scan->Out + offset : NULL;
+}
+
+static void ProcfsFillThread(
+    MRT_SYSTEM_THREAD_INFORMATION* t,
+    ULONG pid,
+    ULONG tid,
+    const PROCFS_STAT* st,
+    ULONG switches
+)
+{
+    memset(t, 0, sizeof(*t));
+    t->KernelTime.QuadPart = (LONGLONG)ProcfsTicksTo100ns(st->KernelTicks);
+    t->UserTime.QuadPart = (LONGLONG)ProcfsTicksTo100ns(st->UserTicks);
+    t->CreateTime.QuadPart = (LONGLONG)(g_ProcfsBootTicks + ProcfsTicksTo100ns(st->StartTicks));
+    t->ClientId.UniqueProcess = (HANDLE)(ULONG_PTR)pid;
+    t->ClientId.UniqueThread = (HANDLE)(ULONG_PTR)tid;
+    t->Priority = st->Priority;
+    t->BasePriority = st->Nice;
+    t->ContextSwitches = switches;
+    ProcfsThreadState(st->State, &t->ThreadState, &t->WaitReason);
+}
+
+// Threads of a multi-threaded process, appended right after its header.
+// Returns the number of records written (threads may exit meanwhile).
+static ULONG ProcfsScanTasks(PROCFS_SCAN* scan, ULONG pid)
+{
+    char path[PROCFS_PATH_SIZE];
+    ProcfsPath(path, pid, "task");
+
+    int taskFd = openat(scan->ProcFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (taskFd < 0)
+        return 0;
+
+    ULONG count = 0;
+    for (;;) {
+        long bytes = syscall(SYS_getdents64, taskFd, scan->TaskDents, sizeof(scan->TaskDents));
+        if (bytes <= 0)
+            break;
+
+        for (long off = 0; off < bytes;) {
+            const PROCFS_DIRENT* d = (const PROCFS_DIRENT*)(scan->TaskDents + off);
+            off += d->RecLen;
+
+            ULONG tid;
+            if (!ProcfsNumericName(d->Name, &tid))
+                continue;
+
+            PROCFS_STAT st;
+            ProcfsPath(path, tid, "stat");
+            LONG n = ProcfsReadAt(taskFd, path, scan->Text);
+            if (n < 0 || !ProcfsParseStat(scan->Text, n, &st))
+                continue;
+
+            // schedstat overwrites Text, stat fields are already decoded
+            ProcfsPath(path, tid, "schedstat");
+            ULONG switches = ProcfsSchedSwitches(scan, taskFd, path);
+
+            MRT_SYSTEM_THREAD_INFORMATION* t = (MRT_SYSTEM_THREAD_INFORMATION*)
+                ProcfsReserve(scan, sizeof(MRT_SYSTEM_THREAD_INFORMATION));
+            if (t)
+                ProcfsFillThread(t, pid, tid, &st, switches);
+            count++;
+        }
+    }
+
+    close(taskFd);
+    return count;
+}
+
+// One process entry; returns FALSE (output rolled back) if the process is gone
+static BOOL ProcfsScanProcess(PROCFS_SCAN* scan, ULONG pid, MRT_SYSTEM_PROCESS_INFORMATION** Entry)
+{
+    char path[PROCFS_PATH_SIZE];
+    ULONG start = scan->Used;
+    *Entry = NULL;
+
+    ProcfsPath(path, pid, "stat");
+    LONG n = ProcfsReadAt(scan->ProcFd, path, scan->Text);
+    PROCFS_STAT st;
+    if (n < 0 || !ProcfsParseStat(scan->Text, n, &st))
+        return FALSE;
+
+    // The name is decoded at the end, keep comm out of the reused buffer
+    char comm[64];
+    ULONG commLength = st.CommLength < sizeof(comm) ? st.CommLength : (ULONG)sizeof(comm);
+    memcpy(comm, st.Comm, commLength);
+
+    MRT_SYSTEM_PROCESS_INFORMATION* p =
+        (MRT_SYSTEM_PROCESS_INFORMATION*)ProcfsReserve(scan, PROCFS_HEADER_SIZE);
+
+    ULONG threads;
+    if (st.Threads == 1) {
+        ProcfsPath(path, pid, "schedstat");
+        ULONG switches = ProcfsSchedSwitches(scan, scan->ProcFd, path);
+
+        MRT_SYSTEM_THREAD_INFORMATION* t = (MRT_SYSTEM_THREAD_INFORMATION*)
+            ProcfsReserve(scan, sizeof(MRT_SYSTEM_THREAD_INFORMATION));
+        if (t)
+            ProcfsFillThread(t, pid, pid, &st, switches);
+        threads = 1;
+    } else {
+        threads = ProcfsScanTasks(scan, pid);
+    }
+
+    ULONGLONG peakVirtual = 0, peakResident = 0, privateBytes = 0;
+    ProcfsPath(path, pid, "status");
+    if (ProcfsReadAt(scan->ProcFd, path, scan->Text) >= 0) {
+        peakVirtual  = PROCFS_KEY(scan->Text, "VmPeak:") * 1024;
+        peakResident = PROCFS_KEY(scan->Text, "VmHWM:") * 1024;
+        privateBytes = PROCFS_KEY(scan->Text, "RssAnon:") * 1024;
+    } else if (errno == ENOENT || errno == ESRCH) {
+        scan->Used = start;
+        return FALSE;
+    }
+
+    // Other users' io needs ptrace access: left at zero when denied
+    IO_COUNTERS io;
+    memset(&io, 0, sizeof(io));
+    ProcfsPath(path, pid, "io");
+    if (ProcfsReadAt(scan->ProcFd, path, scan->Text) >= 0) {
+        io.ReadTransferCount   = PROCFS_KEY(scan->Text, "rchar:");
+        io.WriteTransferCount  = PROCFS_KEY(scan->Text, "wchar:");
+        io.ReadOperationCount  = PROCFS_KEY(scan->Text, "syscr:");
+        io.WriteOperationCount = PROCFS_KEY(scan->Text, "syscw:");
+    }
+
+    ULONG nameUnits = MrtUtf8_ToWchar(comm, commLength, NULL);
+    WCHAR* name = (WCHAR*)ProcfsReserve(scan, (nameUnits + 1) * (ULONG)sizeof(WCHAR));
+    if (name) {
+        MrtUtf8_ToWchar(comm, commLength, name);
+        name[nameUnits] = 0;
+    }
+
+    // Entries stay 8-byte aligned like the NT ones
+    ULONG size = (scan->Used - start + 7) & ~7U;
+    scan->Used = start + size;
+
+    if (p && scan->Used <= scan->Capacity) {
+        memset(p, 0, PROCFS_HEADER_SIZE);
+        p->NumberOfThreads = threads;
+        p->NumberOfThreadsHighWatermark = threads;
+        p->WorkingSetPrivateSize.QuadPart = (LONGLONG)privateBytes;
+        p->HardFaultCount = (ULONG)st.MajorFaults;
+        p->CreateTime.QuadPart = (LONGLONG)(g_ProcfsBootTicks + ProcfsTicksTo100ns(st.StartTicks));
+        p->UserTime.QuadPart = (LONGLONG)ProcfsTicksTo100ns(st.UserTicks);
+        p->KernelTime.QuadPart = (LONGLONG)ProcfsTicksTo100ns(st.KernelTicks);
+        p->ImageName.Buffer = name;
+        p->ImageName.Length = (USHORT)(nameUnits * sizeof(WCHAR));
+        p->ImageName.MaximumLength = (USHORT)((nameUnits + 1) * sizeof(WCHAR));
+        p->BasePriority = st.Nice;
+        p->UniqueProcessId = (HANDLE)(ULONG_PTR)pid;
+        p->InheritedFromUniqueProcessId = (HANDLE)(ULONG_PTR)st.ParentPID;
+        p->SessionId = st.Session;
+        p->PeakVirtualSize = (ULONG_PTR)peakVirtual;
+        p->VirtualSize = (ULONG_PTR)st.VirtualSize;
+        p->PageFaultCount = (SIZE_T)(st.MinorFaults + st.MajorFaults);
+        p->PeakWorkingSetSize = (SIZE_T)peakResident;
+        p->WorkingSetSize = (SIZE_T)(st.ResidentPages * g_ProcfsPageSize);
+        p->PrivatePageCount = (SIZE_T)privateBytes;
+        p->IoCounters = io;
+        *Entry = p;
+    }
+    return TRUE;
+}
+
+static NTSTATUS ProcfsQuery(void* Context, void* Buffer, ULONG Capacity, ULONG* Needed)
+{
+    (void)Context;
+
+    if (!Needed || (!Buffer && Capacity))
+        return STATUS_INVALID_PARAMETER;
+
+    *Needed = 0;
+    pthread_once(&g_ProcfsOnce, ProcfsInitOnce);
+
+    PROCFS_SCAN* scan = (PROCFS_SCAN*)malloc(sizeof(PROCFS_SCAN));
+    if (!scan)
+        return STATUS_NO_MEMORY;
+
+    scan->ProcFd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (scan->ProcFd < 0) {
+        free(scan);
+        return STATUS_NOT_SUPPORTED;
+    }
+    scan->Out = (BYTE*)Buffer;
+    scan->Capacity = Capacity;
+    scan->Used = 0;
+    scan->NoSchedstat = FALSE;
+
+    MRT_SYSTEM_PROCESS_INFORMATION* last = NULL;
+    ULONG lastOffset = 0;
+
+    for (;;) {
+        long bytes = syscall(SYS_getdents64, scan->ProcFd, scan->ProcDents, sizeof(scan->ProcDents));
+        if (bytes <= 0)
+            break;
+
+        for (long off = 0; off < bytes;) {
+            const PROCFS_DIRENT* d = (const PROCFS_DIRENT*)(scan->ProcDents + off);
+            off += d->RecLen;
+
+            ULONG pid;
+            if (!ProcfsNumericName(d->Name, &pid))
+                continue;
+
+            ULONG offset = scan->Used;
+            MRT_SYSTEM_PROCESS_INFORMATION* entry;
+            if (!ProcfsScanProcess(scan, pid, &entry))
+                continue;
+
+            if (last)
+                last->NextEntryOffset = offset - lastOffset;
+            last = entry;
+            lastOffset = offset;
+        }
+    }
+
+    close(scan->ProcFd);
+    ULONG used = scan->Used;
+    free(scan);
+
+    *Needed = used;
+    if (used > Capacity)
+        return STATUS_INFO_LENGTH_MISMATCH;
+    if (!used)
+        return STATUS_UNSUCCESSFUL;
+    return STATUS_SUCCESS;
+}
+
+static const MRT_PROVIDER g_ProcfsProvider = { "procfs", ProcfsQuery, NULL, FALSE };
+
+const MRT_PROVIDER* MrtTInfo_GetProcfsProvider(void)
+{
+    return &g_ProcfsProvider;
+}
+
+#else
+
+const MRT_PROVIDER* MrtTInfo_GetProcfsProvider(void)
+{
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// Refs of a slot while a refresh writes it. A reader that raced with the
+// recycle may add and drop a reference meanwhile; publishing adds
+// 1 - MRT_SLOT_BUILDING so those stay balanced.
+#define MRT_SLOT_BUILDING 0x40000000
+
+// Slots are type-stable: never freed before the refresher, so a reader
+// holding a stale Current pointer can still touch Refs safely.
+typedef struct _MRT_REFRESH_SLOT {
+    MRT_SHARED_SNAPSHOT Snapshot;
+    MRT_ARENA* Arena;           // backs every record of the snapshot
+    volatile LONG Refs;         // readers, +1 while latest, +MRT_SLOT_BUILDING while written
+    struct _MRT_REFRESH_SLOT* Next;
+} MRT_REFRESH_SLOT;
+
+struct _MRT_REFRESHER {
+    MRT_REFRESH_SLOT* volatile Current;    // latest published, NULL before the first
+
+    MRT_MUTEX Lock;             // LastStatus, Stop
+    MRT_COND Wake;
+    MRT_THREAD Thread;
+    ULONG IntervalMs;
+    BOOLEAN Stop;
+    NTSTATUS LastStatus;
+
+    // Build state, owned by whoever holds TickLock
+    MRT_MUTEX TickLock;
+    MRT_COLLECTOR* Collector;
+    MRT_STRING_POOL* Strings;   // non-owning: names live in each snapshot's arena
+    MRT_REFRESH_SLOT* Slots;    // every slot made so far
+    ULONG SlotCount;
+    ULONGLONG Sequence;         // last published
+};
+
+static void RefresherDrop(MRT_REFRESH_SLOT* slot)
+{
+    (void)MrtAtomic_Add(&slot->Refs, -1);
+}
+
+// Unreferenced slot, marked as being written; a new one while under the cap
+static MRT_REFRESH_SLOT* RefresherClaimSlot(MRT_REFRESHER* r, NTSTATUS* status)
+{
+    for (MRT_REFRESH_SLOT* slot = r->Slots; slot; slot = slot->Next) {
+        if (MrtAtomic_CompareExchange(&slot->Refs, MRT_SLOT_BUILDING, 0) == 0)
+            return slot;
+    }
+
+    // Every snapshot is held by a reader: skip this refresh
+    *status = STATUS_INSUFFICIENT_RESOURCES;
+    if (r->SlotCount >= MRT_REFRESHER_MAX_SNAPSHOTS)
+        return NULL;
+
+    *status = STATUS_NO_MEMORY;
+    MRT_REFRESH_SLOT* slot = (MRT_REFRESH_SLOT*)calloc(1, sizeof(MRT_REFRESH_SLOT));
+    if (!slot)
+        return NULL;
+    slot->Arena = MrtTInfo_ArenaCreate(0);
+    if (!slot->Arena) {
+        free(slot);
+        return NULL;
+    }
+
+    slot->Refs = MRT_SLOT_BUILDING;
+    slot->Next = r->Slots;
+    r->Slots = slot;
+    r->SlotCount++;
+    return slot;
+}
+
+NTSTATUS MrtTInfo_RefresherTick(MRT_REFRESHER* Refresher)
+{
+    if (!Refresher)
+        return STATUS_INVALID_PARAMETER;
+
+    MRT_REFRESHER* r = Refresher;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    MrtMutex_Lock(&r->TickLock);
+
+    MRT_REFRESH_SLOT* slot = RefresherClaimSlot(r, &status);
+    if (slot) {
+        MRT_STATS_FRAME* stats = NULL;
+        MRT_STAT(MRT_STATS_FRAME frame; MrtStats_Begin(&frame); stats = &frame);
+
+        MRT_PROCESS_INFO* procs = NULL;
+        ULONG count = 0;
+        MRT_SNAPSHOT_INDEX* index = NULL;
+        status = MrtCollector_BuildInto(r->Collector, slot->Arena, r->Strings, stats,
+                                        &procs, &count, TRUE, &index);
+        MRT_STAT(MrtStats_Commit(&frame, status));
+
+        if (NT_SUCCESS(status)) {
+            slot->Snapshot.Sequence = ++r->Sequence;
+            slot->Snapshot.TimestampNs = MrtPlatform_NowNs();
+            slot->Snapshot.Processes = procs;
+            slot->Snapshot.Count = count;
+            slot->Snapshot.Index = index;
+
+            // The swap publishes the finished records; the latest holds one reference
+            (void)MrtAtomic_Add(&slot->Refs, 1 - MRT_SLOT_BUILDING);
+            MRT_REFRESH_SLOT* previous = (MRT_REFRESH_SLOT*)MrtAtomic_ExchangePointer(&r->Current, slot);
+            if (previous)
+                RefresherDrop(previous);
+        } else {
+            (void)MrtAtomic_Add(&slot->Refs, -MRT_SLOT_BUILDING);
+        }
+    }
+
+    MrtMutex_Lock(&r->Lock);
+    r->LastStatus = status;
+    MrtMutex_Unlock(&r->Lock);
+
+    MrtMutex_Unlock(&r->TickLock);
+    return status;
+}
+
+static void RefresherThread(void* param)
+{
+    MRT_REFRESHER* r = (MRT_REFRESHER*)param;
+    ULONGLONG intervalNs = (ULONGLONG)r->IntervalMs * 1000000ULL;
+    ULONGLONG next = MrtPlatform_NowNs();
+
+    MrtMutex_Lock(&r->Lock);
+    while (!r->Stop) {
+        MrtMutex_Unlock(&r->Lock);
+        MrtTInfo_RefresherTick(r);
+        MrtMutex_Lock(&r->Lock);
+
+        // Fixed-rate schedule; refreshes that ran late are skipped, not queued
+        ULONGLONG now = MrtPlatform_NowNs();
+        next += intervalNs;
+        if (next <= now)
+            next = now + intervalNs - (now - next) % intervalNs;
+
+        while (!r->Stop && (now = MrtPlatform_NowNs()) < next) {
+            ULONGLONG waitMs = (next - now + 999999ULL) / 1000000ULL;
+            MrtCond_WaitTimeout(&r->Wake, &r->Lock, (ULONG)waitMs);
+        }
+    }
+    MrtMutex_Unlock(&r->Lock);
+}
+
+static void RefresherFree(MRT_REFRESHER* r)
+{
+    for (MRT_REFRESH_SLOT* slot = r->Slots; slot;) {
+        MRT_REFRESH_SLOT* next = slot->Next;
+        MrtTInfo_ArenaDestroy(slot->Arena);
+        free(slot);
+        slot = next;
+    }
+    MrtIntern_Destroy(r->Strings);
+    MrtTInfo_CollectorDestroy(r->Collector);
+    free(r);
+}
+
+NTSTATUS MrtTInfo_RefresherCreate(MRT_COLLECTOR* Collector, ULONG IntervalMs, MRT_REFRESHER** Refresher)
+{
+    if (!Refresher)
+        return STATUS_INVALID_PARAMETER;
+
+    *Refresher = NULL;
+
+    MRT_REFRESHER* r = (MRT_REFRESHER*)calloc(1, sizeof(MRT_REFRESHER));
+    if (!r)
+        return STATUS_NO_MEMORY;
+
+    r->IntervalMs = IntervalMs;
+    r->LastStatus = STATUS_SUCCESS;
+    r->Strings = MrtIntern_Create(FALSE);
+    if (!r->Strings) {
+        free(r);
+        return STATUS_NO_MEMORY;
+    }
+
+    // A collector passed in stays the caller's until creation succeeds
+    MRT_COLLECTOR* callers = Collector;
+    if (!Collector) {
+        NTSTATUS status = MrtTInfo_CollectorCreate(&Collector);
+        if (!NT_SUCCESS(status)) {
+            RefresherFree(r);
+            return status;
+        }
+    }
+    r->Collector = Collector;
+
+    MrtMutex_Init(&r->Lock);
+    MrtMutex_Init(&r->TickLock);
+    MrtCond_Init(&r->Wake);
+
+    if (IntervalMs && !MrtThread_Start(&r->Thread, RefresherThread, r)) {
+        if (callers)
+            r->Collector = NULL;
+        MrtTInfo_RefresherDestroy(r);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    *Refresher = r;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_RefresherDestroy(MRT_REFRESHER* Refresher)
+{
+    if (!Refresher)
+        return;
+
+    MrtMutex_Lock(&Refresher->Lock);
+    Refresher->Stop = TRUE;
+    MrtCond_Broadcast(&Refresher->Wake);
+    MrtMutex_Unlock(&Refresher->Lock);
+    MrtThread_Join(&Refresher->Thread);
+
+    MrtCond_Destroy(&Refresher->Wake);
+    MrtMutex_Destroy(&Refresher->TickLock);
+    MrtMutex_Destroy(&Refresher->Lock);
+    RefresherFree(Refresher);
+}
+
+NTSTATUS MrtTInfo_RefresherGetLastStatus(MRT_REFRESHER* Refresher)
+{
+    if (!Refresher)
+        return STATUS_INVALID_PARAMETER;
+
+    MrtMutex_Lock(&Refresher->Lock);
+    NTSTATUS status = Refresher->LastStatus;
+    MrtMutex_Unlock(&Refresher->Lock);
+    return status;
+}
+
+const MRT_SHARED_SNAPSHOT* MrtTInfo_RefresherAcquire(MRT_REFRESHER* Refresher)
+{
+    if (!Refresher)
+        return NULL;
+
+    for (;;) {
+        MRT_REFRESH_SLOT* slot = (MRT_REFRESH_SLOT*)MrtAtomic_LoadPointer(&Refresher->Current);
+        if (!slot)
+            return NULL;
+
+        // Still the latest after taking the reference: no refresh can claim
+        // the slot until it is dropped. Otherwise a newer one was published
+        // meanwhile; the slot may be under reconstruction, try again.
+        (void)MrtAtomic_Add(&slot->Refs, 1);
+        if (MrtAtomic_LoadPointer(&Refresher->Current) == slot)
+            return &slot->Snapshot;
+        RefresherDrop(slot);
+    }
+}
+
+void MrtTInfo_RefresherRelease(MRT_REFRESHER* Refresher, const MRT_SHARED_SNAPSHOT* Snapshot)
+{
+    if (!Refresher || !Snapshot)
+        return;
+
+    RefresherDrop(CONTAINING_RECORD(Snapshot, MRT_REFRESH_SLOT, Snapshot));
+}
@@ -0,0 +1,470 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// -----------------------------
+// Page cache
+// -----------------------------
+// Every request is served from whole pages. The TEB pages of a process are
+// known before parsing starts, so a miss reads ahead over the following TEB
+// pages (up to MRT_PAGE_RUN, bridging single pages between them) in one
+// reader call. A run that crosses unreadable memory is retried without the
+// bridged pages, then as the single page. Slots are reused round-robin.
+#define MRT_PAGE_SIZE        4096
+#define MRT_PAGE_CACHE_PAGES 64
+#define MRT_PAGE_RUN         16
+#define MRT_PAGE_GAP         1
+#define MRT_TLS_SLOTS        108    // same count CountTLSSlots walks locally
+
+typedef struct _MRT_CACHED_PAGE {
+    ULONG_PTR Base;
+    BOOLEAN Used;
+    BOOLEAN Failed;             // known unreadable, no data
+} MRT_CACHED_PAGE;
+
+typedef struct _MRT_PAGE_CACHE {
+    const MRT_MEMORY_READER* Reader;
+    void* Target;
+    MRT_CACHED_PAGE Pages[MRT_PAGE_CACHE_PAGES];
+    ULONG Next;                 // first slot of the next run
+    BYTE* Data;                 // MRT_PAGE_CACHE_PAGES pages, slot order
+    const ULONG_PTR* Wanted;    // sorted TEB page bases of the current process
+    ULONG WantedCount;
+    MRT_REMOTE_STATS* Stats;
+} MRT_PAGE_CACHE;
+
+typedef struct _MRT_REMOTE_ORDER {
+    ULONG_PTR Teb;
+    ULONG Thread;
+} MRT_REMOTE_ORDER;
+
+static MRT_CACHED_PAGE* RemoteFindPage(MRT_PAGE_CACHE* c, ULONG_PTR base)
+{
+    for (ULONG i = 0; i < MRT_PAGE_CACHE_PAGES; i++) {
+        if (c->Pages[i].Used && c->Pages[i].Base == base)
+            return &c->Pages[i];
+    }
+    return NULL;
+}
+
+static BOOL RemoteIsWanted(const MRT_PAGE_CACHE* c, ULONG_PTR base)
+{
+    ULONG lo = 0;
+    ULONG hi = c->WantedCount;
+    while (lo < hi) {
+        ULONG mid = lo + (hi - lo) / 2;
+        if (c->Wanted[mid] < base)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < c->WantedCount && c->Wanted[lo] == base;
+}
+
+static BOOL RemoteReadPages(MRT_PAGE_CACHE* c, ULONG_PTR base, BYTE* data, ULONG pages)
+{
+    c->Stats->Reads++;
+    return NT_SUCCESS(c->Reader->Read(c->Reader->Context, c->Target, base, data, (SIZE_T)pages * MRT_PAGE_SIZE));
+}
+
+static MRT_CACHED_PAGE* RemoteFetch(MRT_PAGE_CACHE* c, ULONG_PTR base)
+{
+    if (c->Next >= MRT_PAGE_CACHE_PAGES)
+        c->Next = 0;
+
+    // Extend over wanted pages not already cached, within the contiguous
+    // slots; tight stops at the first gap
+    ULONG run = 1;
+    ULONG tight = 1;
+    ULONG room = MRT_PAGE_CACHE_PAGES - c->Next;
+    for (ULONG k = 1; k < MRT_PAGE_RUN && k < room; k++) {
+        ULONG_PTR page = base + (ULONG_PTR)k * MRT_PAGE_SIZE;
+        if (page < base || RemoteFindPage(c, page))
+            break;
+        if (RemoteIsWanted(c, page)) {
+            if (tight == run && run == k)
+                tight = k + 1;
+            run = k + 1;
+        } else if (k + 1 - run > MRT_PAGE_GAP) {
+            break;
+        }
+    }
+
+    ULONG first = c->Next;
+    for (ULONG i = 0; i < run; i++)
+        c->Pages[first + i].Used = FALSE;
+
+    BYTE* data = c->Data + (SIZE_T)first * MRT_PAGE_SIZE;
+    BOOL ok = RemoteReadPages(c, base, data, run);
+    if (!ok && tight > 1 && tight < run) {
+        run = tight;
+        ok = RemoteReadPages(c, base, data, run);
+    }
+    if (!ok && run > 1) {
+        run = 1;
+        ok = RemoteReadPages(c, base, data, run);
+    }
+
+    for (ULONG i = 0; i < run; i++) {
+        MRT_CACHED_PAGE* page = &c->Pages[first + i];
+        page->Base = base + i * MRT_PAGE_SIZE;
+        page->Used = TRUE;
+        page->Failed = ok ? FALSE : TRUE;
+    }
+    c->Next = first + run;
+    return &c->Pages[first];
+}
+
+// Copies size bytes at address; FALSE if any page is unreadable
+static BOOL RemoteRead(MRT_PAGE_CACHE* c, const void* address, void* buffer, SIZE_T size)
+{
+    ULONG_PTR at = (ULONG_PTR)address;
+    BYTE* out = (BYTE*)buffer;
+
+    c->Stats->Requests++;
+    if (!at || at + size < at) {
+        c->Stats->Failures++;
+        return FALSE;
+    }
+
+    while (size) {
+        ULONG_PTR base = at & ~(ULONG_PTR)(MRT_PAGE_SIZE - 1);
+        SIZE_T offset = at - base;
+        SIZE_T chunk = MRT_PAGE_SIZE - offset < size ? MRT_PAGE_SIZE - offset : size;
+
+        MRT_CACHED_PAGE* page = RemoteFindPage(c, base);
+        if (!page)
+            page = RemoteFetch(c, base);
+        if (page->Failed) {
+            c->Stats->Failures++;
+            return FALSE;
+        }
+
+        memcpy(out, c->Data + (SIZE_T)(page - c->Pages) * MRT_PAGE_SIZE + offset, chunk);
+        out += chunk;
+        at += chunk;
+        size -= chunk;
+    }
+    return TRUE;
+}
+
+// -----------------------------
+// TEB / PEB parsing
+// -----------------------------
+static int RemoteCompareTeb(const void* a, const void* b)
+{
+    ULONG_PTR x = ((const MRT_REMOTE_ORDER*)a)->Teb;
+    ULONG_PTR y = ((const MRT_REMOTE_ORDER*)b)->Teb;
+    return x < y ? -1 : x > y;
+}
+
+// Heap builds free a copy that could not be filled; arena space just stays unused
+static wchar_t* RemoteCopyString(MRT_PAGE_CACHE* c, MRT_BUILD* build, const UNICODE_STRING* ustr)
+{
+    if (!ustr->Buffer || ustr->Length == 0)
+        return NULL;
+
+    SIZE_T len = ustr->Length / sizeof(WCHAR);
+    wchar_t* str = (wchar_t*)MrtBuild_Alloc(build, (len + 1) * sizeof(WCHAR));
+    if (!str)
+        return NULL;
+
+    if (!RemoteRead(c, ustr->Buffer, str, len * sizeof(WCHAR))) {
+        if (!build->Arena)
+            free(str);
+        return NULL;
+    }
+    str[len] = L'\0';
+    MRT_STAT_ADD(build, StringsCopied, 1);
+    return str;
+}
+
+static void RemoteReadProcess(MRT_PAGE_CACHE* c, MRT_BUILD* build, MRT_PROCESS_INFO* mp,
+                              MRT_REMOTE_ORDER* order, ULONG_PTR* wanted)
+{
+    ULONG flags = build->Flags;
+    ULONG count = 0;
+    for (ULONG t = 0; t < mp->ThreadCount; t++) {
+        if (mp->Threads[t].TebAddress) {
+            order[count].Teb = (ULONG_PTR)mp->Threads[t].TebAddress;
+            order[count].Thread = t;
+            count++;
+        }
+    }
+    if (!count)
+        return;
+
+    void* target = NULL;
+    if (c->Reader->Open && !NT_SUCCESS(c->Reader->Open(c->Reader->Context, mp->PID, &target)))
+        return;
+
+    c->Stats->Processes++;
+    c->Target = target;
+    c->Next = 0;
+    memset(c->Pages, 0, sizeof(c->Pages));
+
+    // Ascending TEB addresses turn the read-ahead into sequential runs
+    qsort(order, count, sizeof(MRT_REMOTE_ORDER), RemoteCompareTeb);
+
+    // Pages the TEB reads will touch (at most two per TEB), sorted and unique
+    ULONG pages = 0;
+    for (ULONG i = 0; i < count; i++) {
+        ULONG_PTR first = order[i].Teb & ~(ULONG_PTR)(MRT_PAGE_SIZE - 1);
+        ULONG_PTR last = (order[i].Teb + sizeof(TEB_PARTIAL) - 1) & ~(ULONG_PTR)(MRT_PAGE_SIZE - 1);
+        if (!pages || first > wanted[pages - 1])
+            wanted[pages++] = first;
+        if (last > first && last > wanted[pages - 1])
+            wanted[pages++] = last;
+    }
+    c->Wanted = wanted;
+    c->WantedCount = pages;
+
+    // The PEB and loader data are read once, by the first thread pointing there
+    PEB_PARTIAL peb;
+    PEB_LDR_DATA ldr;
+    PVOID pebAddress = NULL;
+    BOOL pebOk = FALSE;
+    BOOL ldrOk = FALSE;
+
+    for (ULONG i = 0; i < count; i++) {
+        MRT_THREAD_INFO* mt = &mp->Threads[order[i].Thread];
+        TEB_PARTIAL teb;
+        if (!RemoteRead(c, mt->TebAddress, &teb, sizeof(teb)))
+            continue;
+
+        mt->StackBase      = teb.NtTib.StackBase;
+        mt->StackLimit     = teb.NtTib.StackLimit;
+        mt->TlsPointer     = teb.ThreadLocalStoragePointer;
+        mt->PebAddress     = teb.ProcessEnvironmentBlock;
+        mt->LastErrorValue = teb.LastErrorValue;
+        mt->ArbitraryUserPointer          = teb.NtTib.ArbitraryUserPointer;
+        mt->CountOfOwnedCriticalSections  = teb.CountOfOwnedCriticalSections;
+        mt->Win32ThreadInfo               = teb.Win32ThreadInfo;
+        mt->ExceptionList = teb.NtTib.ExceptionList;
+        mt->SubSystemTib  = teb.SubSystemTib;
+        mt->Self = mt->TebAddress;
+
+        mt->TLSSlotCount = 0;
+        PVOID slots[MRT_TLS_SLOTS];
+        if (mt->TlsPointer && RemoteRead(c, mt->TlsPointer, slots, sizeof(slots))) {
+            for (ULONG s = 0; s < MRT_TLS_SLOTS; s++)
+                mt->TLSSlotCount += slots[s] != NULL;
+        }
+
+        if (!mt->PebAddress || !(flags & MRT_QUERY_PEB))
+            continue;
+
+        if (mt->PebAddress != pebAddress) {
+            pebAddress = mt->PebAddress;
+            pebOk = RemoteRead(c, pebAddress, &peb, sizeof(peb));
+            ldrOk = pebOk && peb.Ldr && RemoteRead(c, peb.Ldr, &ldr, sizeof(ldr));
+        }
+        if (!pebOk)
+            continue;
+
+        mt->PebBeingDebugged   = peb.BeingDebugged;
+        mt->PebSessionId       = peb.SessionId;
+        mt->PebLdr             = peb.Ldr;
+        mt->PebLdr_EntryInProgress = ldrOk ? ldr.EntryInProgress : NULL;
+        mt->ShutdownInProgress = peb.ShutdownInProgress;
+        mt->ShutdownThreadId   = peb.ShutdownThreadId;
+    }
+
+    // Strings once per process, shared by the threads (as for the local process)
+    if (pebOk) {
+        mp->PebAddress = pebAddress;
+        RTL_USER_PROCESS_PARAMETERS params;
+        if ((flags & MRT_QUERY_PEB_STRINGS) && peb.ProcessParameters &&
+            RemoteRead(c, peb.ProcessParameters, &params, sizeof(params))) {
+            mp->PebCommandLine = RemoteCopyString(c, build, &params.CommandLine);
+            mp->PebImagePath = RemoteCopyString(c, build, &params.ImagePathName);
+        }
+        for (ULONG t = 0; t < mp->ThreadCount; t++) {
+            MRT_THREAD_INFO* mt = &mp->Threads[t];
+            if (mt->PebAddress == pebAddress) {
+                mt->PebCommandLine = mp->PebCommandLine;
+                mt->PebImagePath = mp->PebImagePath;
+            }
+        }
+    }
+
+    if (c->Reader->Close)
+        c->Reader->Close(c->Reader->Context, target);
+    c->Target = NULL;
+    c->Wanted = NULL;
+    c->WantedCount = 0;
+}
+
+static MRT_PAGE_CACHE* RemoteCacheCreate(const MRT_MEMORY_READER* reader, MRT_REMOTE_STATS* stats)
+{
+    MRT_PAGE_CACHE* c = (MRT_PAGE_CACHE*)calloc(1, sizeof(MRT_PAGE_CACHE));
+    if (!c)
+        return NULL;
+
+    c->Data = (BYTE*)malloc((SIZE_T)MRT_PAGE_CACHE_PAGES * MRT_PAGE_SIZE);
+    if (!c->Data) {
+        free(c);
+        return NULL;
+    }
+    c->Reader = reader;
+    c->Stats = stats;
+    return c;
+}
+
+static void RemoteCacheDestroy(MRT_PAGE_CACHE* c)
+{
+    if (!c)
+        return;
+    free(c->Data);
+    free(c);
+}
+
+NTSTATUS MrtRemote_ReadAll(MRT_BUILD* build, MRT_PROCESS_INFO* procs, ULONG count, DWORD self, MRT_REMOTE_STATS* stats)
+{
+    MRT_REMOTE_STATS local;
+    if (!stats) {
+        memset(&local, 0, sizeof(local));
+        stats = &local;
+    }
+
+    ULONG maxThreads = 0;
+    for (ULONG i = 0; i < count; i++) {
+        if (procs[i].PID != self && procs[i].ThreadCount > maxThreads)
+            maxThreads = procs[i].ThreadCount;
+    }
+    if (!maxThreads)
+        return STATUS_SUCCESS;
+
+    MRT_REMOTE_ORDER* order = (MRT_REMOTE_ORDER*)malloc((SIZE_T)maxThreads * sizeof(MRT_REMOTE_ORDER));
+    ULONG_PTR* wanted = (ULONG_PTR*)malloc((SIZE_T)maxThreads * 2 * sizeof(ULONG_PTR));
+    MRT_PAGE_CACHE* c = RemoteCacheCreate(build->Reader, stats);
+    if (!order || !wanted || !c) {
+        free(order);
+        free(wanted);
+        RemoteCacheDestroy(c);
+        return STATUS_NO_MEMORY;
+    }
+
+    for (ULONG i = 0; i < count; i++) {
+        if (procs[i].PID != self)
+            RemoteReadProcess(c, build, &procs[i], order, wanted);
+    }
+
+    free(order);
+    free(wanted);
+    RemoteCacheDestroy(c);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_ReadProcessEnvironment(const MRT_MEMORY_READER* Reader, MRT_PROCESS_INFO* Process, ULONG Flags, MRT_REMOTE_STATS* Stats)
+{
+    if (!Reader || !Reader->Read || !Process)
+        return STATUS_INVALID_PARAMETER;
+
+    // Heap build: the strings belong to Process like any other snapshot's
+    MRT_BUILD build = { .Flags = MrtTInfo_NormalizeQueryFlags(Flags), .Reader = Reader };
+    return MrtRemote_ReadAll(&build, Process, 1, (DWORD)-1, Stats);
+}
+
+// -----------------------------
+// Readers
+// -----------------------------
+#ifdef _WIN32
+static NTSTATUS RemoteWin32Open(void* Context, DWORD Pid, void** Target)
+{
+    (void)Context;
+    HANDLE process = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, Pid);
+    if (!process)
+        return STATUS_ACCESS_DENIED;
+    *Target = process;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS RemoteWin32Read(void* Context, void* Target, ULONG_PTR Address, void* Buffer, SIZE_T Size)
+{
+    (void)Context;
+    SIZE_T done = 0;
+    if (!ReadProcessMemory((HANDLE)Target, (LPCVOID)Address, Buffer, Size, &done) || done != Size)
+        return STATUS_PARTIAL_COPY;
+    return STATUS_SUCCESS;
+}
+
+static void RemoteWin32Close(void* Context, void* Target)
+{
+    (void)Context;
+    CloseHandle((HANDLE)Target);
+}
+
+static const MRT_MEMORY_READER g_Win32Reader = {
+    "ReadProcessMemory", RemoteWin32Open, RemoteWin32Read, RemoteWin32Close, NULL
+};
+#endif
+
+const MRT_MEMORY_READER* MrtTInfo_GetDefaultMemoryReader(void)
+{
+#ifdef _WIN32
+    return &g_Win32Reader;
+#else
+    return NULL;
+#endif
+}
+
+// Fake reader: the target is the PID itself
+static NTSTATUS RemoteFakeOpen(void* Context, DWORD Pid, void** Target)
+{
+    (void)Context;
+    *Target = (void*)(ULONG_PTR)Pid;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS RemoteFakeRead(void* Context, void* Target, ULONG_PTR Address, void* Buffer, SIZE_T Size)
+{
+    MRT_FAKE_MEMORY* m = (MRT_FAKE_MEMORY*)Context;
+    DWORD pid = (DWORD)(ULONG_PTR)Target;
+    m->Reads++;
+
+    if (Address + Size < Address)
+        return STATUS_PARTIAL_COPY;
+
+    // Every touched page must overlap a region of this process
+    ULONG_PTR first = Address & ~(ULONG_PTR)(MRT_PAGE_SIZE - 1);
+    for (ULONG_PTR page = first; page < Address + Size; page += MRT_PAGE_SIZE) {
+        BOOL mapped = FALSE;
+        for (ULONG r = 0; r < m->RegionCount && !mapped; r++) {
+            const MRT_MEMORY_REGION* region = &m->Regions[r];
+            mapped = (!region->Pid || region->Pid == pid) &&
+                     region->Address < page + MRT_PAGE_SIZE &&
+                     page < region->Address + region->Size;
+        }
+        if (!mapped)
+            return STATUS_PARTIAL_COPY;
+    }
+
+    memset(Buffer, 0, Size);
+    for (ULONG r = 0; r < m->RegionCount; r++) {
+        const MRT_MEMORY_REGION* region = &m->Regions[r];
+        if (region->Pid && region->Pid != pid)
+            continue;
+        ULONG_PTR lo = region->Address > Address ? region->Address : Address;
+        ULONG_PTR hi = region->Address + region->Size < Address + Size ? region->Address + region->Size : Address + Size;
+        if (lo < hi)
+            memcpy((BYTE*)Buffer + (lo - Address), (const BYTE*)region->Data + (lo - region->Address), hi - lo);
+    }
+
+    m->BytesRead += Size;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_FakeReaderInit(MRT_FAKE_MEMORY* Memory, MRT_MEMORY_READER* Reader)
+{
+    if (!Memory || !Reader)
+        return;
+
+    Memory->Reads = 0;
+    Memory->BytesRead = 0;
+    Reader->Name = "fake";
+    Reader->Open = RemoteFakeOpen;
+    Reader->Read = RemoteFakeRead;
+    Reader->Close = NULL;
+    Reader->Context = Memory;
+}
@@ -0,0 +1,513 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// Compact counters kept from the previous tick, sorted by (Id, snapshot order)
+typedef struct _MRT_SAMPLER_PROCESS_COUNTERS {
+    DWORD PID;
+    ULONGLONG CreateTime;
+    LONGLONG KernelTime;
+    LONGLONG UserTime;
+    ULONGLONG CycleTime;
+    ULONGLONG ContextSwitches;
+    IO_COUNTERS IoCounters;
+} MRT_SAMPLER_PROCESS_COUNTERS;
+
+typedef struct _MRT_SAMPLER_THREAD_COUNTERS {
+    DWORD TID;
+    ULONGLONG CreateTime;
+    LONGLONG KernelTime;
+    LONGLONG UserTime;
+    ULONG ContextSwitches;
+} MRT_SAMPLER_THREAD_COUNTERS;
+
+typedef struct _MRT_SAMPLER_SLOT {
+    MRT_SAMPLE Sample;          // Sequence 0 = empty or being written
+    ULONG ProcessCapacity;
+    ULONG ThreadCapacity;
+    ULONG Pins;                 // readers holding the slot
+} MRT_SAMPLER_SLOT;
+
+struct _MRT_SAMPLER {
+    MRT_MUTEX Lock;             // slots, pins, Sequence, LastStatus, Stop
+    MRT_COND Wake;
+    MRT_THREAD Thread;
+    ULONG IntervalMs;
+    BOOLEAN Stop;
+    NTSTATUS LastStatus;
+
+    MRT_SAMPLER_SLOT* Slots;    // Depth + 1: one slot is always writable
+    ULONG SlotCount;
+    ULONG Depth;
+    ULONGLONG Sequence;         // last published
+
+    // Tick state, owned by whoever holds TickLock
+    MRT_MUTEX TickLock;
+    MRT_COLLECTOR* Collector;
+    MRT_SORT_KEY* Keys;
+    MRT_SORT_KEY* KeyTemp;
+    ULONG KeyCapacity;
+    ULONG KeyTempCapacity;
+    MRT_SAMPLER_PROCESS_COUNTERS* ProcessCounters[2];  // [Current], [Current ^ 1] = previous
+    ULONG ProcessCounterCount[2];
+    ULONG ProcessCounterCapacity[2];
+    MRT_SAMPLER_THREAD_COUNTERS* ThreadCounters[2];
+    ULONG ThreadCounterCount[2];
+    ULONG ThreadCounterCapacity[2];
+    ULONG Current;
+    ULONGLONG PreviousNs;
+    BOOLEAN HavePrevious;
+    ULONGLONG HeapAllocations;  // grow-only arrays, lifetime
+    ULONGLONG HeapBytes;
+};
+
+// Grow-only arrays: sized with headroom so small population changes do not reallocate
+static BOOL SamplerReserve(MRT_SAMPLER* s, void** array, ULONG* capacity, ULONG needed, SIZE_T elementSize)
+{
+    if (needed <= *capacity)
+        return TRUE;
+
+    ULONG cap = needed + needed / 4 + 16;
+    void* p = realloc(*array, (SIZE_T)cap * elementSize);
+    if (!p)
+        return FALSE;
+
+    *array = p;
+    *capacity = cap;
+    s->HeapAllocations++;
+    s->HeapBytes += (SIZE_T)cap * elementSize;
+    return TRUE;
+}
+
+// Writable slot: unpinned, not the latest sample, oldest first
+static MRT_SAMPLER_SLOT* SamplerClaimSlot(MRT_SAMPLER* s)
+{
+    MRT_SAMPLER_SLOT* best = NULL;
+
+    MrtMutex_Lock(&s->Lock);
+    for (ULONG i = 0; i < s->SlotCount; i++) {
+        MRT_SAMPLER_SLOT* slot = &s->Slots[i];
+        if (slot->Pins || (s->Sequence && slot->Sample.Sequence == s->Sequence))
+            continue;
+        if (!best || slot->Sample.Sequence < best->Sample.Sequence)
+            best = slot;
+    }
+    if (best)
+        best->Sample.Sequence = 0;  // hidden from readers while written
+    MrtMutex_Unlock(&s->Lock);
+
+    return best;
+}
+
+static double SamplerRate(double delta, double seconds)
+{
+    return delta > 0 ? delta / seconds : 0.0;
+}
+
+static void SamplerProcessRates(
+    MRT_SAMPLER* s,
+    const MRT_PROCESS_INFO* procs,
+    const MRT_SORT_KEY* keys,
+    ULONG count,
+    MRT_SAMPLE* sample,
+    double seconds
+)
+{
+    const MRT_SAMPLER_PROCESS_COUNTERS* prev = s->ProcessCounters[s->Current ^ 1];
+    ULONG prevCount = s->HavePrevious ? s->ProcessCounterCount[s->Current ^ 1] : 0;
+    MRT_SAMPLER_PROCESS_COUNTERS* cur = s->ProcessCounters[s->Current];
+    ULONG j = 0;
+
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* p = &procs[keys[i].Outer];
+        MRT_SAMPLER_PROCESS_COUNTERS* c = &cur[i];
+        MRT_PROCESS_RATE* r = &sample->Processes[i];
+
+        c->PID             = p->PID;
+        c->CreateTime      = keys[i].CreateTime;
+        c->KernelTime      = p->KernelTime.QuadPart;
+        c->UserTime        = p->UserTime.QuadPart;
+        c->CycleTime       = p->CycleTime;
+        c->ContextSwitches = 0;
+        c->IoCounters      = p->IoCounters;
+        if (p->Threads) {
+            for (ULONG t = 0; t < p->ThreadCount; t++)
+                c->ContextSwitches += p->Threads[t].ContextSwitches;
+        }
+
+        memset(r, 0, sizeof(*r));
+        r->PID         = p->PID;
+        r->ParentPID   = p->ParentPID;
+        r->CreateTime  = p->CreateTime;
+        r->ThreadCount = p->ThreadCount;
+
+        // Merge-join against the previous tick; equal PIDs pair up in order
+        while (j < prevCount && prev[j].PID < c->PID)
+            j++;
+        if (j >= prevCount || prev[j].PID != c->PID || prev[j].CreateTime != c->CreateTime) {
+            r->New = TRUE;
+            continue;
+        }
+        const MRT_SAMPLER_PROCESS_COUNTERS* o = &prev[j++];
+
+        // Times are in 100ns units
+        r->KernelCpu             = SamplerRate((double)(c->KernelTime - o->KernelTime) * 1e-7, seconds);
+        r->UserCpu               = SamplerRate((double)(c->UserTime - o->UserTime) * 1e-7, seconds);
+        r->CyclesPerSec          = SamplerRate((double)(LONGLONG)(c->CycleTime - o->CycleTime), seconds);
+        r->ContextSwitchesPerSec = SamplerRate((double)(LONGLONG)(c->ContextSwitches - o->ContextSwitches), seconds);
+        r->ReadBytesPerSec  = SamplerRate((double)(LONGLONG)(c->IoCounters.ReadTransferCount - o->IoCounters.ReadTransferCount), seconds);
+        r->WriteBytesPerSec = SamplerRate((double)(LONGLONG)(c->IoCounters.WriteTransferCount - o->IoCounters.WriteTransferCount), seconds);
+        r->OtherBytesPerSec = SamplerRate((double)(LONGLONG)(c->IoCounters.OtherTransferCount - o->IoCounters.OtherTransferCount), seconds);
+        r->IoOpsPerSec = SamplerRate((double)(LONGLONG)(
+            (c->IoCounters.ReadOperationCount + c->IoCounters.WriteOperationCount + c->IoCounters.OtherOperationCount) -
+            (o->IoCounters.ReadOperationCount + o->IoCounters.WriteOperationCount + o->IoCounters.OtherOperationCount)),
+            seconds);
+    }
+
+    s->ProcessCounterCount[s->Current] = count;
+}
+
+static void SamplerThreadRates(
+    MRT_SAMPLER* s,
+    const MRT_PROCESS_INFO* procs,
+    const MRT_SORT_KEY* keys,
+    ULONG count,
+    MRT_SAMPLE* sample,
+    double seconds
+)
+{
+    const MRT_SAMPLER_THREAD_COUNTERS* prev = s->ThreadCounters[s->Current ^ 1];
+    ULONG prevCount = s->HavePrevious ? s->ThreadCounterCount[s->Current ^ 1] : 0;
+    MRT_SAMPLER_THREAD_COUNTERS* cur = s->ThreadCounters[s->Current];
+    ULONG j = 0;
+
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_THREAD_INFO* t = &procs[keys[i].Outer].Threads[keys[i].Inner];
+        MRT_SAMPLER_THREAD_COUNTERS* c = &cur[i];
+        MRT_THREAD_RATE* r = &sample->Threads[i];
+
+        c->TID             = t->TID;
+        c->CreateTime      = keys[i].CreateTime;
+        c->KernelTime      = t->KernelTime.QuadPart;
+        c->UserTime        = t->UserTime.QuadPart;
+        c->ContextSwitches = t->ContextSwitches;
+
+        memset(r, 0, sizeof(*r));
+        r->TID         = t->TID;
+        r->PID         = t->ParentPID;
+        r->CreateTime  = t->CreateTime;
+        r->ThreadState = t->ThreadState;
+        r->WaitReason  = t->WaitReason;
+
+        while (j < prevCount && prev[j].TID < c->TID)
+            j++;
+        if (j >= prevCount || prev[j].TID != c->TID || prev[j].CreateTime != c->CreateTime) {
+            r->New = TRUE;
+            continue;
+        }
+        const MRT_SAMPLER_THREAD_COUNTERS* o = &prev[j++];
+
+        r->KernelCpu             = SamplerRate((double)(c->KernelTime - o->KernelTime) * 1e-7, seconds);
+        r->UserCpu               = SamplerRate((double)(c->UserTime - o->UserTime) * 1e-7, seconds);
+        r->ContextSwitchesPerSec = SamplerRate((double)(ULONG)(c->ContextSwitches - o->ContextSwitches), seconds);
+    }
+
+    s->ThreadCounterCount[s->Current] = count;
+}
+
+// Turns one snapshot into the sample of a claimed slot. Caller holds TickLock.
+static NTSTATUS SamplerIngest(
+    MRT_SAMPLER* s,
+    MRT_SAMPLER_SLOT* slot,
+    const MRT_PROCESS_INFO* procs,
+    ULONG count,
+    ULONGLONG nowNs
+)
+{
+    ULONG threadTotal = 0;
+    for (ULONG i = 0; i < count; i++)
+        threadTotal += procs[i].Threads ? procs[i].ThreadCount : 0;
+
+    ULONG keyNeed = count > threadTotal ? count : threadTotal;
+    ULONG cur = s->Current;
+
+    if (!SamplerReserve(s, (void**)&s->Keys, &s->KeyCapacity, keyNeed, sizeof(MRT_SORT_KEY)) ||
+        !SamplerReserve(s, (void**)&s->KeyTemp, &s->KeyTempCapacity, keyNeed, sizeof(MRT_SORT_KEY)) ||
+        !SamplerReserve(s, (void**)&s->ProcessCounters[cur], &s->ProcessCounterCapacity[cur],
+                        count, sizeof(MRT_SAMPLER_PROCESS_COUNTERS)) ||
+        !SamplerReserve(s, (void**)&s->ThreadCounters[cur], &s->ThreadCounterCapacity[cur],
+                        threadTotal, sizeof(MRT_SAMPLER_THREAD_COUNTERS)) ||
+        !SamplerReserve(s, (void**)&slot->Sample.Processes, &slot->ProcessCapacity,
+                        count, sizeof(MRT_PROCESS_RATE)) ||
+        !SamplerReserve(s, (void**)&slot->Sample.Threads, &slot->ThreadCapacity,
+                        threadTotal, sizeof(MRT_THREAD_RATE)))
+        return STATUS_NO_MEMORY;
+
+    ULONGLONG intervalNs = s->HavePrevious && nowNs > s->PreviousNs ? nowNs - s->PreviousNs : 0;
+    double seconds = intervalNs ? (double)intervalNs * 1e-9 : 1.0;
+    if (!intervalNs)
+        s->HavePrevious = FALSE;    // no usable interval: everything is new
+
+    MRT_SAMPLE* sample = &slot->Sample;
+    sample->TimestampNs = nowNs;
+    sample->IntervalNs = intervalNs;
+
+    ULONG n = MrtSort_ProcessKeys(procs, count, s->Keys);
+    MrtSort_Keys(s->Keys, s->KeyTemp, n);
+    SamplerProcessRates(s, procs, s->Keys, n, sample, seconds);
+    sample->ProcessCount = n;
+
+    n = MrtSort_ThreadKeys(procs, count, s->Keys);
+    MrtSort_Keys(s->Keys, s->KeyTemp, n);
+    SamplerThreadRates(s, procs, s->Keys, n, sample, seconds);
+    sample->ThreadCount = n;
+
+    s->Current ^= 1;
+    s->PreviousNs = nowNs;
+    s->HavePrevious = TRUE;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_SamplerTick(MRT_SAMPLER* Sampler)
+{
+    if (!Sampler)
+        return STATUS_INVALID_PARAMETER;
+
+    MRT_SAMPLER* s = Sampler;
+    NTSTATUS status;
+
+    MrtMutex_Lock(&s->TickLock);
+
+    // Every slot pinned by readers: skip the tick. The next one measures
+    // from the last published counters, so no CPU time is lost.
+    MRT_SAMPLER_SLOT* slot = SamplerClaimSlot(s);
+    if (!slot) {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+    } else {
+        MRT_PROCESS_INFO* procs = NULL;
+        ULONG count = 0;
+        status = MrtTInfo_CollectorRefresh(s->Collector, &procs, &count);
+        if (NT_SUCCESS(status))
+            status = SamplerIngest(s, slot, procs, count, MrtPlatform_NowNs());
+    }
+
+    MrtMutex_Lock(&s->Lock);
+    if (NT_SUCCESS(status))
+        slot->Sample.Sequence = ++s->Sequence;
+    s->LastStatus = status;
+    MrtMutex_Unlock(&s->Lock);
+
+    MrtMutex_Unlock(&s->TickLock);
+    return status;
+}
+
+static void SamplerThread(void* param)
+{
+    MRT_SAMPLER* s = (MRT_SAMPLER*)param;
+    ULONGLONG intervalNs = (ULONGLONG)s->IntervalMs * 1000000ULL;
+    ULONGLONG next = MrtPlatform_NowNs();
+
+    MrtMutex_Lock(&s->Lock);
+    while (!s->Stop) {
+        MrtMutex_Unlock(&s->Lock);
+        MrtTInfo_SamplerTick(s);
+        MrtMutex_Lock(&s->Lock);
+
+        // Fixed-rate schedule; ticks that ran late are skipped, not queued
+        ULONGLONG now = MrtPlatform_NowNs();
+        next += intervalNs;
+        if (next <= now)
+            next = now + intervalNs - (now - next) % intervalNs;
+
+        while (!s->Stop && (now = MrtPlatform_NowNs()) < next) {
+            ULONGLONG waitMs = (next - now + 999999ULL) / 1000000ULL;
+            MrtCond_WaitTimeout(&s->Wake, &s->Lock, (ULONG)waitMs);
+        }
+    }
+    MrtMutex_Unlock(&s->Lock);
+}
+
+NTSTATUS MrtTInfo_SamplerCreate(ULONG IntervalMs, ULONG HistoryDepth, MRT_SAMPLER** Sampler)
+{
+    if (!Sampler)
+        return STATUS_INVALID_PARAMETER;
+
+    *Sampler = NULL;
+
+    if (HistoryDepth == 0)
+        HistoryDepth = MRT_SAMPLER_DEFAULT_DEPTH;
+
+    MRT_SAMPLER* s = (MRT_SAMPLER*)calloc(1, sizeof(MRT_SAMPLER));
+    if (!s)
+        return STATUS_NO_MEMORY;
+
+    s->IntervalMs = IntervalMs;
+    s->Depth = HistoryDepth;
+    s->SlotCount = HistoryDepth + 1;
+    s->LastStatus = STATUS_SUCCESS;
+    s->Slots = (MRT_SAMPLER_SLOT*)calloc(s->SlotCount, sizeof(MRT_SAMPLER_SLOT));
+    if (!s->Slots) {
+        free(s);
+        return STATUS_NO_MEMORY;
+    }
+
+    NTSTATUS status = MrtTInfo_CollectorCreate(&s->Collector);
+    if (!NT_SUCCESS(status)) {
+        free(s->Slots);
+        free(s);
+        return status;
+    }
+
+    // Rates only need the counters of the single query call
+    MrtTInfo_CollectorSetQueryFlags(s->Collector, MRT_QUERY_COUNTERS);
+
+    MrtMutex_Init(&s->Lock);
+    MrtMutex_Init(&s->TickLock);
+    MrtCond_Init(&s->Wake);
+
+    if (IntervalMs && !MrtThread_Start(&s->Thread, SamplerThread, s)) {
+        MrtTInfo_SamplerDestroy(s);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    *Sampler = s;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_SamplerDestroy(MRT_SAMPLER* Sampler)
+{
+    if (!Sampler)
+        return;
+
+    MrtMutex_Lock(&Sampler->Lock);
+    Sampler->Stop = TRUE;
+    MrtCond_Broadcast(&Sampler->Wake);
+    MrtMutex_Unlock(&Sampler->Lock);
+    MrtThread_Join(&Sampler->Thread);
+
+    for (ULONG i = 0; i < Sampler->SlotCount; i++) {
+        free(Sampler->Slots[i].Sample.Processes);
+        free(Sampler->Slots[i].Sample.Threads);
+    }
+    for (ULONG i = 0; i < 2; i++) {
+        free(Sampler->ProcessCounters[i]);
+        free(Sampler->ThreadCounters[i]);
+    }
+    free(Sampler->Keys);
+    free(Sampler->KeyTemp);
+    free(Sampler->Slots);
+    MrtTInfo_CollectorDestroy(Sampler->Collector);
+    MrtCond_Destroy(&Sampler->Wake);
+    MrtMutex_Destroy(&Sampler->TickLock);
+    MrtMutex_Destroy(&Sampler->Lock);
+    free(Sampler);
+}
+
+NTSTATUS MrtTInfo_SamplerSetReplayBuffer(MRT_SAMPLER* Sampler, const void* Buffer, ULONG Length)
+{
+    if (!Sampler)
+        return STATUS_INVALID_PARAMETER;
+
+    // The collector belongs to whoever holds TickLock
+    MrtMutex_Lock(&Sampler->TickLock);
+    NTSTATUS status = MrtTInfo_CollectorSetReplayBuffer(Sampler->Collector, Buffer, Length);
+    MrtMutex_Unlock(&Sampler->TickLock);
+    return status;
+}
+
+void MrtTInfo_SamplerGetAllocStats(MRT_SAMPLER* Sampler, MRT_ALLOC_STATS* stats)
+{
+    if (!Sampler) {
+        MrtTInfo_ArenaGetStats(NULL, stats);
+        return;
+    }
+
+    // Snapshot arena of the collector plus the sampler's own arrays
+    MrtMutex_Lock(&Sampler->TickLock);
+    MrtTInfo_CollectorGetAllocStats(Sampler->Collector, stats);
+    if (stats) {
+        stats->HeapAllocations += Sampler->HeapAllocations;
+        stats->HeapBytes += Sampler->HeapBytes;
+    }
+    MrtMutex_Unlock(&Sampler->TickLock);
+}
+
+NTSTATUS MrtTInfo_SamplerGetLastStatus(MRT_SAMPLER* Sampler)
+{
+    if (!Sampler)
+        return STATUS_INVALID_PARAMETER;
+
+    MrtMutex_Lock(&Sampler->Lock);
+    NTSTATUS status = Sampler->LastStatus;
+    MrtMutex_Unlock(&Sampler->Lock);
+    return status;
+}
+
+const MRT_SAMPLE* MrtTInfo_SamplerAcquire(MRT_SAMPLER* Sampler, ULONG Age)
+{
+    if (!Sampler)
+        return NULL;
+
+    const MRT_SAMPLE* sample = NULL;
+
+    MrtMutex_Lock(&Sampler->Lock);
+    if (Age < Sampler->Depth && Age < Sampler->Sequence) {
+        ULONGLONG wanted = Sampler->Sequence - Age;
+        for (ULONG i = 0; i < Sampler->SlotCount; i++) {
+            if (Sampler->Slots[i].Sample.Sequence == wanted) {
+                Sampler->Slots[i].Pins++;
+                sample = &Sampler->Slots[i].Sample;
+                break;
+            }
+        }
+    }
+    MrtMutex_Unlock(&Sampler->Lock);
+
+    return sample;
+}
+
+void MrtTInfo_SamplerRelease(MRT_SAMPLER* Sampler, const MRT_SAMPLE* Sample)
+{
+    if (!Sampler || !Sample)
+        return;
+
+    MRT_SAMPLER_SLOT* slot = CONTAINING_RECORD(Sample, MRT_SAMPLER_SLOT, Sample);
+
+    MrtMutex_Lock(&Sampler->Lock);
+    if (slot->Pins)
+        slot->Pins--;
+    MrtMutex_Unlock(&Sampler->Lock);
+}
+
+// Binary search for the first record with the Id; both arrays are Id-sorted
+const MRT_PROCESS_RATE* MrtTInfo_SampleFindProcess(const MRT_SAMPLE* Sample, DWORD pid)
+{
+    if (!Sample)
+        return NULL;
+
+    ULONG lo = 0, hi = Sample->ProcessCount;
+    while (lo < hi) {
+        ULONG mid = lo + (hi - lo) / 2;
+        if (Sample->Processes[mid].PID < pid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < Sample->ProcessCount && Sample->Processes[lo].PID == pid ? &Sample->Processes[lo] : NULL;
+}
+
+const MRT_THREAD_RATE* MrtTInfo_SampleFindThread(const MRT_SAMPLE* Sample, DWORD tid)
+{
+    if (!Sample)
+        return NULL;
+
+    ULONG lo = 0, hi = Sample->ThreadCount;
+    while (lo < hi) {
+        ULONG mid = lo + (hi - lo) / 2;
+        if (Sample->Threads[mid].TID < tid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < Sample->ThreadCount && Sample->Threads[lo].TID == tid ? &Sample->Threads[lo] : NULL;
+}
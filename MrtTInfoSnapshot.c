@@ -0,0 +1,695 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+#define MRT_BYTE_ORDER_MARK 0x01020304UL
+
+// Record layouts are part of the file format
+_Static_assert(sizeof(MRT_SNAPSHOT_HEADER) == 72, "snapshot header layout");
+_Static_assert(sizeof(MRT_SNAPSHOT_PROCESS) == 168, "snapshot process record layout");
+_Static_assert(sizeof(MRT_SNAPSHOT_THREAD) == 88, "snapshot thread record layout");
+
+// -----------------------------
+// UTF-16 <-> host WCHAR
+// -----------------------------
+// WCHAR is UTF-16 on Windows and UTF-32 (wchar_t) elsewhere; files always
+// carry UTF-16 so a snapshot written on one host reads the same on another.
+static ULONG SnapshotUtf16Units(const WCHAR* s, SIZE_T n)
+{
+    ULONG units = 0;
+    for (SIZE_T i = 0; i < n; i++)
+        units += ((ULONG)s[i] > 0xFFFF && (ULONG)s[i] <= 0x10FFFF) ? 2 : 1;
+    return units;
+}
+
+static USHORT* SnapshotPutUtf16(USHORT* out, const WCHAR* s, SIZE_T n)
+{
+    for (SIZE_T i = 0; i < n; i++) {
+        ULONG c = (ULONG)s[i];
+        if (c > 0x10FFFF) {
+            *out++ = 0xFFFD;
+        } else if (c > 0xFFFF) {
+            c -= 0x10000;
+            *out++ = (USHORT)(0xD800 | (c >> 10));
+            *out++ = (USHORT)(0xDC00 | (c & 0x3FF));
+        } else {
+            *out++ = (USHORT)c;
+        }
+    }
+    return out;
+}
+
+// Decodes one code point from UTF-16 or UTF-32 units of the given width
+static ULONG SnapshotNextCodePoint(const BYTE* src, ULONG units, ULONG width, ULONG* i)
+{
+    if (width == 4) {
+        ULONG c;
+        memcpy(&c, src + (SIZE_T)*i * 4, 4);
+        (*i)++;
+        return c <= 0x10FFFF ? c : 0xFFFD;
+    }
+
+    USHORT hi, lo;
+    memcpy(&hi, src + (SIZE_T)*i * 2, 2);
+    (*i)++;
+    if (hi >= 0xD800 && hi <= 0xDBFF && *i < units) {
+        memcpy(&lo, src + (SIZE_T)*i * 2, 2);
+        if (lo >= 0xDC00 && lo <= 0xDFFF) {
+            (*i)++;
+            return 0x10000 + (((ULONG)hi - 0xD800) << 10) + ((ULONG)lo - 0xDC00);
+        }
+    }
+    return hi;
+}
+
+// Host WCHAR units for a code point, written to out when not NULL
+static ULONG SnapshotPutWchar(WCHAR* out, ULONG c)
+{
+    if (sizeof(WCHAR) == 2 && c > 0xFFFF) {
+        if (out) {
+            c -= 0x10000;
+            out[0] = (WCHAR)(0xD800 | (c >> 10));
+            out[1] = (WCHAR)(0xDC00 | (c & 0x3FF));
+        }
+        return 2;
+    }
+    if (out)
+        out[0] = (WCHAR)c;
+    return 1;
+}
+
+// -----------------------------
+// Encoding
+// -----------------------------
+typedef struct _MRT_SNAPSHOT_STRINGS {
+    USHORT* Out;        // NULL while sizing
+    ULONG Units;
+} MRT_SNAPSHOT_STRINGS;
+
+static void SnapshotPutString(MRT_SNAPSHOT_STRINGS* st, const WCHAR* s, SIZE_T n, ULONG* offset, ULONG* length)
+{
+    *offset = MRT_SNAPSHOT_NO_STRING;
+    *length = 0;
+    if (!s || n == 0)
+        return;
+
+    ULONG units = SnapshotUtf16Units(s, n);
+    *offset = st->Units;
+    *length = units;
+    if (st->Out) {
+        USHORT* end = SnapshotPutUtf16(st->Out + st->Units, s, n);
+        *end = 0;
+    }
+    st->Units += units + 1;
+}
+
+static BOOL SnapshotSameString(const wchar_t* a, const wchar_t* b)
+{
+    // Threads of a process share their PEB strings: usually the same pointer
+    return a && b && (a == b || wcscmp(a, b) == 0);
+}
+
+// Emits records and strings; with NULL record arrays it only sizes the string table.
+// Identical PEB strings on consecutive threads of a process are stored once.
+static void SnapshotEmit(
+    const MRT_PROCESS_INFO* procs,
+    ULONG count,
+    MRT_SNAPSHOT_PROCESS* outProcs,
+    MRT_SNAPSHOT_THREAD* outThreads,
+    MRT_SNAPSHOT_STRINGS* st
+)
+{
+    MRT_SNAPSHOT_PROCESS scratchProc;
+    MRT_SNAPSHOT_THREAD scratchThread;
+    ULONG threadIndex = 0;
+
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* p = &procs[i];
+        MRT_SNAPSHOT_PROCESS* r = outProcs ? &outProcs[i] : &scratchProc;
+        ULONG threads = p->Threads ? p->ThreadCount : 0;
+
+        r->PID                = p->PID;
+        r->ParentPID          = p->ParentPID;
+        r->CreateTime         = MrtFileTimeToU64(&p->CreateTime);
+        r->UserTime           = p->UserTime.QuadPart;
+        r->KernelTime         = p->KernelTime.QuadPart;
+        r->CycleTime          = p->CycleTime;
+        r->WorkingSetSize     = p->WorkingSetSize;
+        r->VirtualSize        = p->VirtualSize;
+        r->PeakWorkingSetSize = p->PeakWorkingSetSize;
+        r->PrivatePageCount   = p->PrivatePageCount;
+        r->PageFaultCount     = p->PageFaultCount;
+        r->PeakVirtualSize    = p->PeakVirtualSize;
+        r->IoCounters         = p->IoCounters;
+        r->HandleCount        = p->HandleCount;
+        r->SessionId          = p->SessionId;
+        r->HardFaultCount     = p->HardFaultCount;
+        r->BasePriority       = p->BasePriority;
+        r->FirstThread        = threadIndex;
+        r->ThreadCount        = threads;
+        SnapshotPutString(st, p->ImageName.Buffer, p->ImageName.Length / sizeof(WCHAR),
+                          &r->ImageName, &r->ImageNameLength);
+
+        const MRT_SNAPSHOT_THREAD* prev = NULL;
+        const MRT_THREAD_INFO* prevInfo = NULL;
+
+        for (ULONG t = 0; t < threads; t++, threadIndex++) {
+            const MRT_THREAD_INFO* mt = &p->Threads[t];
+            MRT_SNAPSHOT_THREAD* tr = outThreads ? &outThreads[threadIndex] : &scratchThread;
+
+            tr->TID             = mt->TID;
+            tr->PID             = mt->ParentPID;
+            tr->CreateTime      = MrtFileTimeToU64(&mt->CreateTime);
+            tr->KernelTime      = mt->KernelTime.QuadPart;
+            tr->UserTime        = mt->UserTime.QuadPart;
+            tr->StartAddress    = (ULONG_PTR)mt->StartAddress;
+            tr->TebAddress      = (ULONG_PTR)mt->TebAddress;
+            tr->BasePriority    = mt->BasePriority;
+            tr->Priority        = mt->Priority;
+            tr->ContextSwitches = mt->ContextSwitches;
+            tr->ThreadState     = mt->ThreadState;
+            tr->WaitReason      = mt->WaitReason;
+            tr->Reserved        = 0;
+
+            if (prev && SnapshotSameString(mt->PebCommandLine, prevInfo->PebCommandLine)) {
+                tr->CommandLine = prev->CommandLine;
+                tr->CommandLineLength = prev->CommandLineLength;
+            } else {
+                SnapshotPutString(st, mt->PebCommandLine,
+                                  mt->PebCommandLine ? wcslen(mt->PebCommandLine) : 0,
+                                  &tr->CommandLine, &tr->CommandLineLength);
+            }
+
+            if (prev && SnapshotSameString(mt->PebImagePath, prevInfo->PebImagePath)) {
+                tr->ImagePath = prev->ImagePath;
+                tr->ImagePathLength = prev->ImagePathLength;
+            } else {
+                SnapshotPutString(st, mt->PebImagePath,
+                                  mt->PebImagePath ? wcslen(mt->PebImagePath) : 0,
+                                  &tr->ImagePath, &tr->ImagePathLength);
+            }
+
+            // While sizing prev is the scratch record itself; its string
+            // fields are only overwritten after they were copied above.
+            prev = tr;
+            prevInfo = mt;
+        }
+    }
+}
+
+NTSTATUS MrtTInfo_SnapshotEncode(const MRT_PROCESS_INFO* Processes, ULONG Count, void* Buffer, SIZE_T Capacity, SIZE_T* Size)
+{
+    if (!Size || (!Processes && Count))
+        return STATUS_INVALID_PARAMETER;
+
+    *Size = 0;
+
+    ULONGLONG threadTotal = 0;
+    for (ULONG i = 0; i < Count; i++)
+        threadTotal += Processes[i].Threads ? Processes[i].ThreadCount : 0;
+    if (threadTotal > 0xFFFFFFFFULL)
+        return STATUS_INVALID_PARAMETER;
+
+    MRT_SNAPSHOT_STRINGS st = { NULL, 0 };
+    SnapshotEmit(Processes, Count, NULL, NULL, &st);
+
+    ULONGLONG processOffset = sizeof(MRT_SNAPSHOT_HEADER);
+    ULONGLONG threadOffset  = processOffset + (ULONGLONG)Count * sizeof(MRT_SNAPSHOT_PROCESS);
+    ULONGLONG stringOffset  = threadOffset + threadTotal * sizeof(MRT_SNAPSHOT_THREAD);
+    ULONGLONG imageSize     = (stringOffset + (ULONGLONG)st.Units * sizeof(USHORT) + 7) & ~7ULL;
+    if (imageSize > (SIZE_T)-1)
+        return STATUS_NO_MEMORY;
+
+    *Size = (SIZE_T)imageSize;
+    if (!Buffer || Capacity < imageSize)
+        return STATUS_BUFFER_TOO_SMALL;
+
+    BYTE* image = (BYTE*)Buffer;
+    memset(image, 0, (SIZE_T)imageSize);
+
+    MRT_SNAPSHOT_HEADER* h = (MRT_SNAPSHOT_HEADER*)image;
+    h->Magic             = MRT_SNAPSHOT_MAGIC;
+    h->Version           = MRT_SNAPSHOT_VERSION;
+    h->HeaderSize        = sizeof(MRT_SNAPSHOT_HEADER);
+    h->ByteOrder         = MRT_BYTE_ORDER_MARK;
+    h->ProcessRecordSize = sizeof(MRT_SNAPSHOT_PROCESS);
+    h->ThreadRecordSize  = sizeof(MRT_SNAPSHOT_THREAD);
+    h->ProcessCount      = Count;
+    h->ThreadCount       = (ULONG)threadTotal;
+    h->StringCount       = st.Units;
+    h->ProcessOffset     = processOffset;
+    h->ThreadOffset      = threadOffset;
+    h->StringOffset      = stringOffset;
+    h->ImageSize         = imageSize;
+    h->CaptureTime       = MrtPlatform_SystemTimeTicks();
+
+    st.Out = (USHORT*)(image + stringOffset);
+    st.Units = 0;
+    SnapshotEmit(Processes, Count,
+                 (MRT_SNAPSHOT_PROCESS*)(image + processOffset),
+                 (MRT_SNAPSHOT_THREAD*)(image + threadOffset),
+                 &st);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_SnapshotWrite(const MRT_PROCESS_INFO* Processes, ULONG Count, const char* path)
+{
+    if (!path)
+        return STATUS_INVALID_PARAMETER;
+
+    SIZE_T size = 0;
+    NTSTATUS status = MrtTInfo_SnapshotEncode(Processes, Count, NULL, 0, &size);
+    if (status != STATUS_BUFFER_TOO_SMALL)
+        return NT_SUCCESS(status) ? STATUS_UNSUCCESSFUL : status;
+
+    void* image = malloc(size);
+    if (!image)
+        return STATUS_NO_MEMORY;
+
+    status = MrtTInfo_SnapshotEncode(Processes, Count, image, size, &size);
+    if (NT_SUCCESS(status))
+        status = MrtPlatform_WriteFile(path, image, size);
+
+    free(image);
+    return status;
+}
+
+// -----------------------------
+// Reading
+// -----------------------------
+static BOOL SnapshotTableFits(ULONGLONG offset, ULONGLONG count, ULONGLONG recordSize, ULONGLONG imageSize)
+{
+    return offset % 8 == 0 && offset <= imageSize && count * recordSize <= imageSize - offset;
+}
+
+NTSTATUS MrtTInfo_SnapshotView(const void* image, SIZE_T size, MRT_SNAPSHOT_VIEW* View)
+{
+    if (!View)
+        return STATUS_INVALID_PARAMETER;
+
+    memset(View, 0, sizeof(*View));
+
+    if (!image || (ULONG_PTR)image % 8 != 0)
+        return STATUS_INVALID_PARAMETER;
+    if (size < sizeof(MRT_SNAPSHOT_HEADER))
+        return STATUS_INVALID_IMAGE_FORMAT;
+
+    const MRT_SNAPSHOT_HEADER* h = (const MRT_SNAPSHOT_HEADER*)image;
+    if (h->Magic != MRT_SNAPSHOT_MAGIC || h->ByteOrder != MRT_BYTE_ORDER_MARK)
+        return STATUS_INVALID_IMAGE_FORMAT;
+    if (h->Version != MRT_SNAPSHOT_VERSION ||
+        h->HeaderSize != sizeof(MRT_SNAPSHOT_HEADER) ||
+        h->ProcessRecordSize != sizeof(MRT_SNAPSHOT_PROCESS) ||
+        h->ThreadRecordSize != sizeof(MRT_SNAPSHOT_THREAD))
+        return STATUS_REVISION_MISMATCH;
+
+    // Header only: records are bounds-checked by the accessors when used
+    if (h->ImageSize > size ||
+        !SnapshotTableFits(h->ProcessOffset, h->ProcessCount, sizeof(MRT_SNAPSHOT_PROCESS), h->ImageSize) ||
+        !SnapshotTableFits(h->ThreadOffset, h->ThreadCount, sizeof(MRT_SNAPSHOT_THREAD), h->ImageSize) ||
+        !SnapshotTableFits(h->StringOffset, h->StringCount, sizeof(USHORT), h->ImageSize))
+        return STATUS_DATA_ERROR;
+
+    const BYTE* base = (const BYTE*)image;
+    View->Header       = h;
+    View->Processes    = (const MRT_SNAPSHOT_PROCESS*)(base + h->ProcessOffset);
+    View->Threads      = (const MRT_SNAPSHOT_THREAD*)(base + h->ThreadOffset);
+    View->Strings      = (const USHORT*)(base + h->StringOffset);
+    View->ProcessCount = h->ProcessCount;
+    View->ThreadCount  = h->ThreadCount;
+    View->StringCount  = h->StringCount;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS MrtTInfo_SnapshotOpen(const char* path, MRT_SNAPSHOT_VIEW* View)
+{
+    if (!path || !View)
+        return STATUS_INVALID_PARAMETER;
+
+    memset(View, 0, sizeof(*View));
+
+    const void* base = NULL;
+    SIZE_T size = 0;
+    NTSTATUS status = MrtPlatform_MapFile(path, &base, &size);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    status = MrtTInfo_SnapshotView(base, size, View);
+    if (!NT_SUCCESS(status)) {
+        MrtPlatform_UnmapFile(base, size);
+        return status;
+    }
+
+    View->Mapping = base;
+    View->MappingSize = size;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_SnapshotClose(MRT_SNAPSHOT_VIEW* View)
+{
+    if (!View)
+        return;
+    MrtPlatform_UnmapFile(View->Mapping, View->MappingSize);
+    memset(View, 0, sizeof(*View));
+}
+
+const USHORT* MrtTInfo_SnapshotString(const MRT_SNAPSHOT_VIEW* View, ULONG offset, ULONG length)
+{
+    // The terminator must be inside the table too
+    if (!View || !View->Strings || offset == MRT_SNAPSHOT_NO_STRING ||
+        offset >= View->StringCount || length >= View->StringCount - offset)
+        return NULL;
+    return &View->Strings[offset];
+}
+
+const MRT_SNAPSHOT_THREAD* MrtTInfo_SnapshotThreads(const MRT_SNAPSHOT_VIEW* View, const MRT_SNAPSHOT_PROCESS* Process)
+{
+    if (!View || !Process ||
+        (ULONGLONG)Process->FirstThread + Process->ThreadCount > View->ThreadCount)
+        return NULL;
+    return &View->Threads[Process->FirstThread];
+}
+
+// -----------------------------
+// Raw buffer recordings
+// -----------------------------
+#define MRT_RAW_MAGIC   0x5752524DUL    // "MRRW"
+#define MRT_RAW_VERSION 1
+
+typedef struct _MRT_RAW_HEADER {
+    ULONG Magic;
+    USHORT Version;
+    USHORT HeaderSize;
+    ULONG ByteOrder;
+    USHORT PointerSize;
+    USHORT WcharSize;
+    ULONG ProcessEntrySize;     // bytes before the thread array
+    ULONG ThreadEntrySize;
+    ULONG Length;               // bytes of raw buffer following the header
+    ULONG Reserved;
+    ULONGLONG OriginalBase;     // address the buffer had when recorded
+} MRT_RAW_HEADER;
+
+_Static_assert(sizeof(MRT_RAW_HEADER) % 8 == 0, "raw header keeps the buffer aligned");
+
+NTSTATUS MrtTInfo_RecordRawBuffer(const char* path, const void* Buffer, ULONG Length)
+{
+    if (!path || !Buffer)
+        return STATUS_INVALID_PARAMETER;
+
+    NTSTATUS status = MrtCursor_Validate(Buffer, Length);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    SIZE_T size = sizeof(MRT_RAW_HEADER) + Length;
+    BYTE* image = (BYTE*)malloc(size);
+    if (!image)
+        return STATUS_NO_MEMORY;
+
+    MRT_RAW_HEADER h;
+    memset(&h, 0, sizeof(h));
+    h.Magic            = MRT_RAW_MAGIC;
+    h.Version          = MRT_RAW_VERSION;
+    h.HeaderSize       = sizeof(MRT_RAW_HEADER);
+    h.ByteOrder        = MRT_BYTE_ORDER_MARK;
+    h.PointerSize      = sizeof(void*);
+    h.WcharSize        = sizeof(WCHAR);
+    h.ProcessEntrySize = offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads);
+    h.ThreadEntrySize  = sizeof(MRT_SYSTEM_THREAD_INFORMATION);
+    h.Length           = Length;
+    h.OriginalBase     = (ULONG_PTR)Buffer;
+
+    memcpy(image, &h, sizeof(h));
+    memcpy(image + sizeof(h), Buffer, Length);
+
+    status = MrtPlatform_WriteFile(path, image, size);
+    free(image);
+    return status;
+}
+
+// Points the ImageName of a copied entry at a host-WCHAR copy in the tail area.
+// Names outside the recorded buffer are dropped rather than followed.
+static WCHAR* RawRelocateName(
+    MRT_SYSTEM_PROCESS_INFORMATION* e,
+    const MRT_RAW_HEADER* h,
+    const BYTE* copy,
+    WCHAR* tail
+)
+{
+    ULONGLONG name = (ULONG_PTR)e->ImageName.Buffer;
+    ULONG bytes = e->ImageName.Length;
+    ULONG units = bytes / h->WcharSize;
+
+    e->ImageName.Buffer = NULL;
+    e->ImageName.Length = 0;
+    e->ImageName.MaximumLength = 0;
+
+    if (!name || !units || name < h->OriginalBase ||
+        name - h->OriginalBase > h->Length ||
+        bytes > h->Length - (name - h->OriginalBase))
+        return tail;
+
+    const BYTE* src = copy + (SIZE_T)(name - h->OriginalBase);
+    const ULONG maxUnits = (0xFFFF - sizeof(WCHAR)) / sizeof(WCHAR);
+    ULONG written = 0;
+
+    for (ULONG i = 0; i < units;) {
+        ULONG c = SnapshotNextCodePoint(src, units, h->WcharSize, &i);
+        if (written + SnapshotPutWchar(NULL, c) > maxUnits)
+            break;
+        written += SnapshotPutWchar(tail + written, c);
+    }
+    tail[written] = L'\0';
+
+    e->ImageName.Buffer = tail;
+    e->ImageName.Length = (USHORT)(written * sizeof(WCHAR));
+    e->ImageName.MaximumLength = (USHORT)((written + 1) * sizeof(WCHAR));
+    return tail + written + 1;
+}
+
+NTSTATUS MrtTInfo_LoadRawBuffer(const char* path, void** Buffer, ULONG* Length)
+{
+    if (!path || !Buffer || !Length)
+        return STATUS_INVALID_PARAMETER;
+
+    *Buffer = NULL;
+    *Length = 0;
+
+    const void* base = NULL;
+    SIZE_T size = 0;
+    NTSTATUS status = MrtPlatform_MapFile(path, &base, &size);
+    if (!NT_SUCCESS(status))
+        return status;
+
+    const MRT_RAW_HEADER* h = (const MRT_RAW_HEADER*)base;
+    BYTE* copy = NULL;
+
+    if (size < sizeof(MRT_RAW_HEADER) || h->Magic != MRT_RAW_MAGIC || h->ByteOrder != MRT_BYTE_ORDER_MARK) {
+        status = STATUS_INVALID_IMAGE_FORMAT;
+        goto done;
+    }
+    // Entry layout depends on the pointer size, a recording only replays on a like host
+    if (h->Version != MRT_RAW_VERSION || h->HeaderSize != sizeof(MRT_RAW_HEADER) ||
+        h->PointerSize != sizeof(void*) ||
+        h->ProcessEntrySize != offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads) ||
+        h->ThreadEntrySize != sizeof(MRT_SYSTEM_THREAD_INFORMATION) ||
+        (h->WcharSize != 2 && h->WcharSize != 4)) {
+        status = STATUS_REVISION_MISMATCH;
+        goto done;
+    }
+    if (h->Length > size - sizeof(MRT_RAW_HEADER)) {
+        status = STATUS_DATA_ERROR;
+        goto done;
+    }
+
+    const BYTE* raw = (const BYTE*)base + sizeof(MRT_RAW_HEADER);
+    status = MrtCursor_Validate(raw, h->Length);
+    if (!NT_SUCCESS(status))
+        goto done;
+
+    // Tail for the converted names: UTF-32 -> UTF-16 at most doubles the units
+    MRT_PROCESS_CURSOR cursor;
+    const MRT_SYSTEM_PROCESS_INFORMATION* e;
+    ULONGLONG tailUnits = 0;
+    MrtTInfo_CursorInit(&cursor, raw, h->Length);
+    while ((e = MrtTInfo_CursorNext(&cursor)) != NULL)
+        tailUnits += (ULONGLONG)(e->ImageName.Length / h->WcharSize) * 2 + 1;
+
+    ULONGLONG head = ((ULONGLONG)h->Length + 7) & ~7ULL;
+    ULONGLONG total = head + tailUnits * sizeof(WCHAR);
+    if (total > 0xFFFFFFFFULL) {
+        status = STATUS_DATA_ERROR;
+        goto done;
+    }
+
+    copy = (BYTE*)malloc((SIZE_T)total);
+    if (!copy) {
+        status = STATUS_NO_MEMORY;
+        goto done;
+    }
+    memcpy(copy, raw, h->Length);
+
+    WCHAR* tail = (WCHAR*)(copy + head);
+    MrtTInfo_CursorInit(&cursor, copy, h->Length);
+    while ((e = MrtTInfo_CursorNext(&cursor)) != NULL)
+        tail = RawRelocateName((MRT_SYSTEM_PROCESS_INFORMATION*)e, h, copy, tail);
+
+    // The names live in the tail, keep it inside the walkable length
+    *Buffer = copy;
+    *Length = (ULONG)total;
+    copy = NULL;
+    status = STATUS_SUCCESS;
+
+done:
+    free(copy);
+    MrtPlatform_UnmapFile(base, size);
+    return status;
+}
+
+void MrtTInfo_FreeRawBuffer(void* Buffer)
+{
+    free(Buffer);
+}
+
+// -----------------------------
+// Synthetic buffers
+// -----------------------------
+// Image names in rough proportion to a busy desktop: many hosts share a
+// name, the rest are spread over a long tail of mostly short names.
+static const char* const g_GenerateNames[] = {
+    "svchost.exe", "svchost.exe", "svchost.exe", "svchost.exe", "svchost.exe",
+    "svchost.exe", "chrome.exe", "chrome.exe", "chrome.exe", "msedge.exe",
+    "msedge.exe", "conhost.exe", "RuntimeBroker.exe", "dllhost.exe",
+    "explorer.exe", "csrss.exe", "lsass.exe", "services.exe", "wininit.exe",
+    "smss.exe", "winlogon.exe", "dwm.exe", "fontdrvhost.exe", "sihost.exe",
+    "taskhostw.exe", "ctfmon.exe", "SearchIndexer.exe", "spoolsv.exe",
+    "MsMpEng.exe", "WmiPrvSE.exe", "audiodg.exe", "ShellExperienceHost.exe",
+    "StartMenuExperienceHost.exe", "ApplicationFrameHost.exe",
+    "SecurityHealthService.exe", "MicrosoftEdgeUpdate.exe",
+    "msedgewebview2.exe", "Code.exe", "devenv.exe", "cmd.exe", "powershell.exe",
+};
+
+static ULONG GenerateRand(ULONG* state)
+{
+    ULONG x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// One in eight processes gets a name of its own ("worker_1234.exe")
+static ULONG GenerateName(ULONG* state, ULONG index, WCHAR* out)
+{
+    char text[32];
+    const char* name = text;
+    ULONG r = GenerateRand(state);
+    if (r % 8 == 0)
+        snprintf(text, sizeof(text), "worker_%lu.exe", (unsigned long)index);
+    else
+        name = g_GenerateNames[(r >> 3) % (sizeof(g_GenerateNames) / sizeof(g_GenerateNames[0]))];
+
+    ULONG units = 0;
+    for (; name[units]; units++) {
+        if (out)
+            out[units] = (WCHAR)(unsigned char)name[units];
+    }
+    return units;
+}
+
+NTSTATUS MrtTInfo_GenerateRawBuffer(
+    ULONG Processes,
+    ULONG ThreadsPerProcess,
+    ULONG Seed,
+    void** Buffer,
+    ULONG* Length
+)
+{
+    if (!Buffer || !Length || Processes == 0)
+        return STATUS_INVALID_PARAMETER;
+    *Buffer = NULL;
+    *Length = 0;
+
+    // Longest name is well under 32 units; entries stay 8-byte aligned
+    const SIZE_T nameRoom = 32 * sizeof(WCHAR);
+    const SIZE_T entry = (offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads) +
+        (SIZE_T)ThreadsPerProcess * sizeof(MRT_SYSTEM_THREAD_INFORMATION) + nameRoom + 7) & ~(SIZE_T)7;
+    const SIZE_T limit = 0xFFFFFFFF;    // Length is a ULONG
+    if (ThreadsPerProcess > limit / sizeof(MRT_SYSTEM_THREAD_INFORMATION) ||
+        entry > limit / Processes)
+        return STATUS_INVALID_PARAMETER;
+
+    BYTE* out = (BYTE*)calloc(Processes, entry);
+    if (!out)
+        return STATUS_NO_MEMORY;
+
+    ULONG state = Seed ? Seed : 0x9E3779B9u;
+    const LONGLONG boot = 133000000000000000LL;     // FILETIME ticks, 2022
+    ULONG used = 0;
+    MRT_SYSTEM_PROCESS_INFORMATION* last = NULL;
+
+    for (ULONG i = 0; i < Processes; i++) {
+        MRT_SYSTEM_PROCESS_INFORMATION* p = (MRT_SYSTEM_PROCESS_INFORMATION*)(out + used);
+        MRT_SYSTEM_THREAD_INFORMATION* t = p->Threads;
+        WCHAR* name = (WCHAR*)&t[ThreadsPerProcess];
+
+        // Entry 0 is the idle process: PID 0, no name, like the live buffer
+        DWORD pid = i * 4;
+        LONGLONG created = boot + (LONGLONG)i * 10000;
+        if (i > 0) {
+            ULONG units = GenerateName(&state, i, name);
+            p->ImageName.Buffer = name;
+            p->ImageName.Length = (USHORT)(units * sizeof(WCHAR));
+            p->ImageName.MaximumLength = (USHORT)((units + 1) * sizeof(WCHAR));
+            p->InheritedFromUniqueProcessId = (HANDLE)(ULONG_PTR)((GenerateRand(&state) % i) * 4);
+            p->SessionId = i < 16 ? 0 : 1 + GenerateRand(&state) % 2;
+            p->BasePriority = 8;
+            p->HandleCount = 50 + GenerateRand(&state) % 2000;
+        }
+        p->UniqueProcessId = (HANDLE)(ULONG_PTR)pid;
+        p->NumberOfThreads = ThreadsPerProcess;
+        p->NumberOfThreadsHighWatermark = ThreadsPerProcess;
+        p->CreateTime.QuadPart = created;
+        p->VirtualSize = (ULONG_PTR)(GenerateRand(&state) % 4096 + 64) << 20;
+        p->PeakVirtualSize = p->VirtualSize;
+        p->WorkingSetSize = (SIZE_T)(GenerateRand(&state) % 512 + 1) << 20;
+        p->PeakWorkingSetSize = p->WorkingSetSize;
+        p->PrivatePageCount = p->WorkingSetSize / 2;
+        p->WorkingSetPrivateSize.QuadPart = (LONGLONG)p->PrivatePageCount;
+        p->PageFaultCount = GenerateRand(&state) % 1000000;
+
+        for (ULONG k = 0; k < ThreadsPerProcess; k++, t++) {
+            // Mostly waiting, as on a real system; reasons cover the common ones
+            static const MRT_WAIT_REASON reasons[] = { 6, 6, 6, 15, 15, 13, 4, 5, 18, 31 };
+            ULONG r = GenerateRand(&state);
+            t->ClientId.UniqueProcess = (HANDLE)(ULONG_PTR)pid;
+            t->ClientId.UniqueThread = (HANDLE)(ULONG_PTR)((i * ThreadsPerProcess + k + 1) * 4);
+            t->CreateTime.QuadPart = created + (LONGLONG)k * 1000;
+            t->KernelTime.QuadPart = r % 10000000;
+            t->UserTime.QuadPart = (r >> 8) % 50000000;
+            t->StartAddress = (PVOID)(ULONG_PTR)(0x7FF600001000ULL + (r % 4096) * 16);
+            t->Priority = 8 + (LONG)(r % 8);
+            t->BasePriority = 8;
+            t->ContextSwitches = r % 100000;
+            t->WaitTime = r % 5000;
+            t->ThreadState = r % 16 == 0 ? 2 : r % 16 == 1 ? 1 : 5;   // Running / Ready / Waiting
+            t->WaitReason = t->ThreadState == 5 ? reasons[(r >> 4) % 10] : 0;
+        }
+
+        // Chain only the space this entry uses, rounded like the kernel does
+        ULONG units = p->ImageName.Length / sizeof(WCHAR);
+        ULONG size = (ULONG)((offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads) +
+            (SIZE_T)ThreadsPerProcess * sizeof(MRT_SYSTEM_THREAD_INFORMATION) +
+            (units + 1) * sizeof(WCHAR) + 7) & ~(SIZE_T)7);
+        if (last)
+            last->NextEntryOffset = (ULONG)((BYTE*)p - (BYTE*)last);
+        last = p;
+        used += size;
+    }
+
+    *Buffer = out;
+    *Length = used;
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,219 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// -----------------------------
+// Decoding tables
+// -----------------------------
+// Indexed by the raw KTHREAD_STATE / KWAIT_REASON value; holes and values past
+// the end decode to the default name.
+static const char* const g_ThreadStateNames[] = {
+    [0]  = "Initialized",
+    [1]  = "Ready",
+    [2]  = "Running",
+    [3]  = "Standby",
+    [4]  = "Terminated",
+    [5]  = "Waiting",
+    [6]  = "Transition",
+    [7]  = "DeferredReady",
+    [8]  = "GateWaitObsolete",
+    [9]  = "WaitingForProcessInSwap",
+};
+
+static const char* const g_WaitReasonNames[] = {
+    [0]  = "Executive",
+    [1]  = "FreePage",
+    [2]  = "PageIn",
+    [3]  = "PoolAllocation",
+    [4]  = "DelayExecution",
+    [5]  = "Suspended",
+    [6]  = "UserRequest",
+    [7]  = "WrExecutive",
+    [8]  = "WrFreePage",
+    [9]  = "WrPageIn",
+    [10] = "WrPoolAllocation",
+    [11] = "WrDelayExecution",
+    [12] = "WrSuspended",
+    [13] = "WrUserRequest",
+    [14] = "WrEventPair",
+    [15] = "WrQueue",
+    [16] = "WrLpcReceive",
+    [17] = "WrLpcReply",
+    [18] = "WrVirtualMemory",
+    [19] = "WrPageOut",
+    [20] = "WrRendezvous",
+    [21] = "WrKeyedEvent",
+    [22] = "WrTerminated",
+    [23] = "WrProcessInSwap",
+    [24] = "WrCpuRateControl",
+    [25] = "WrCalloutStack",
+    [26] = "WrKernel",
+    [27] = "WrResource",
+    [28] = "WrPushLock",
+    [29] = "WrMutex",
+    [30] = "WrQuantumEnd",
+    [31] = "WrDispatchInt",
+    [32] = "WrPreempted",
+    [33] = "WrYieldExecution",
+    [34] = "WrFastMutex",
+    [35] = "WrGuardedMutex",
+    [36] = "WrRundown",
+    [37] = "WrAlertByThreadId",
+    [38] = "WrDeferredPreempt",
+    [39] = "WrPhysicalFault",
+};
+
+// Loader-lock waits have no reason of their own: StatesCount attributes them
+static const BYTE g_WaitReasonClass[MRT_WAIT_BUCKETS] = {
+    [1]  = MRT_WAIT_CLASS_PAGING,   // FreePage
+    [2]  = MRT_WAIT_CLASS_PAGING,   // PageIn
+    [8]  = MRT_WAIT_CLASS_PAGING,   // WrFreePage
+    [9]  = MRT_WAIT_CLASS_PAGING,   // WrPageIn
+    [18] = MRT_WAIT_CLASS_PAGING,   // WrVirtualMemory
+    [19] = MRT_WAIT_CLASS_PAGING,   // WrPageOut
+};
+
+#define MRT_TABLE_COUNT(t) (sizeof(t) / sizeof((t)[0]))
+#define MRT_THREAD_STATE_WAITING 5
+
+const char* MrtHelper_ThreadStateToString(ULONG state)
+{
+    const char* name = state < MRT_TABLE_COUNT(g_ThreadStateNames) ? g_ThreadStateNames[state] : NULL;
+    return name ? name : "Unknown";
+}
+
+const char* MrtHelper_WaitReasonToString(ULONG reason)
+{
+    const char* name = reason < MRT_TABLE_COUNT(g_WaitReasonNames) ? g_WaitReasonNames[reason] : NULL;
+    return name ? name : "Other";
+}
+
+ULONG MrtTInfo_StateBucket(MRT_THREAD_STATE State)
+{
+    return State < MRT_STATE_BUCKETS - 1 ? State : MRT_STATE_BUCKETS - 1;
+}
+
+ULONG MrtTInfo_WaitBucket(MRT_WAIT_REASON WaitReason)
+{
+    return WaitReason < MRT_WAIT_BUCKETS - 1 ? WaitReason : MRT_WAIT_BUCKETS - 1;
+}
+
+MRT_WAIT_CLASS MrtTInfo_WaitReasonClass(MRT_WAIT_REASON WaitReason)
+{
+    return (MRT_WAIT_CLASS)g_WaitReasonClass[MrtTInfo_WaitBucket(WaitReason)];
+}
+
+// -----------------------------
+// Contention report
+// -----------------------------
+// Threads of a process whose loader is mid-load wait on the loader lock
+// through an ordinary event or critical section: every non-paging wait there
+// counts as a loader-lock wait.
+static void StatesCount(MRT_STATE_COUNTS* counts, const MRT_THREAD_INFO* t, BOOL loading)
+{
+    counts->Threads++;
+    counts->States[MrtTInfo_StateBucket(t->ThreadState)]++;
+    if (t->ThreadState != MRT_THREAD_STATE_WAITING)
+        return;
+
+    ULONG w = MrtTInfo_WaitBucket(t->WaitReason);
+    MRT_WAIT_CLASS c = (MRT_WAIT_CLASS)g_WaitReasonClass[w];
+    if (c == MRT_WAIT_CLASS_OTHER && loading)
+        c = MRT_WAIT_CLASS_LOADER_LOCK;
+    counts->WaitReasons[w]++;
+    counts->Classes[c]++;
+}
+
+// Only threads whose PEB was read (local or remote pass) carry the loader state
+static BOOL StatesLoading(const MRT_PROCESS_INFO* p)
+{
+    for (ULONG t = 0; p->Threads && t < p->ThreadCount; t++) {
+        if (p->Threads[t].PebLdr_EntryInProgress)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void StatesMerge(MRT_STATE_COUNTS* into, const MRT_STATE_COUNTS* from)
+{
+    into->Threads += from->Threads;
+    for (ULONG i = 0; i < MRT_STATE_BUCKETS; i++)
+        into->States[i] += from->States[i];
+    for (ULONG i = 0; i < MRT_WAIT_BUCKETS; i++)
+        into->WaitReasons[i] += from->WaitReasons[i];
+    for (ULONG i = 0; i < MRT_WAIT_CLASS_COUNT; i++)
+        into->Classes[i] += from->Classes[i];
+}
+
+NTSTATUS MrtTInfo_ContentionReport(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_CONTENTION_REPORT** Report)
+{
+    if (!Report || (!Processes && Count))
+        return STATUS_INVALID_PARAMETER;
+
+    *Report = NULL;
+
+    // One block: header and per-process counts
+    MRT_CONTENTION_REPORT* report = (MRT_CONTENTION_REPORT*)calloc(1,
+        sizeof(MRT_CONTENTION_REPORT) + (SIZE_T)Count * sizeof(MRT_STATE_COUNTS));
+    if (!report)
+        return STATUS_NO_MEMORY;
+
+    report->Processes = (MRT_STATE_COUNTS*)(report + 1);
+    report->ProcessCount = Count;
+
+    // Counting pass per process; the system row is the sum of the process rows
+    for (ULONG i = 0; i < Count; i++) {
+        const MRT_PROCESS_INFO* p = &Processes[i];
+        MRT_STATE_COUNTS* counts = &report->Processes[i];
+        BOOL loading = StatesLoading(p);
+        for (ULONG t = 0; p->Threads && t < p->ThreadCount; t++)
+            StatesCount(counts, &p->Threads[t], loading);
+        StatesMerge(&report->System, counts);
+    }
+
+    *Report = report;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_FreeContentionReport(MRT_CONTENTION_REPORT* Report)
+{
+    free(Report);
+}
+
+void MrtTInfo_StateTransitions(const MRT_SNAPSHOT_DIFF* Diff, MRT_STATE_TRANSITIONS* Transitions)
+{
+    if (!Transitions)
+        return;
+
+    memset(Transitions, 0, sizeof(*Transitions));
+    if (!Diff)
+        return;
+
+    for (ULONG i = 0; i < Diff->ThreadCount; i++) {
+        const MRT_THREAD_DELTA* d = &Diff->Threads[i];
+        ULONG from = MrtTInfo_StateBucket(d->OldState);
+        ULONG to = MrtTInfo_StateBucket(d->NewState);
+
+        if (d->Kind == MRT_DELTA_CREATED) {
+            Transitions->Created[to]++;
+            continue;
+        }
+        if (d->Kind == MRT_DELTA_EXITED) {
+            Transitions->Exited[from]++;
+            continue;
+        }
+
+        if (from != to)
+            Transitions->States[from][to]++;
+
+        // A wait is left or entered when the state or the reason changes
+        BOOL wasWaiting = d->OldState == MRT_THREAD_STATE_WAITING;
+        BOOL isWaiting = d->NewState == MRT_THREAD_STATE_WAITING;
+        if (wasWaiting && isWaiting && d->OldWaitReason == d->NewWaitReason)
+            continue;
+        if (wasWaiting)
+            Transitions->LeftWait[MrtTInfo_WaitBucket(d->OldWaitReason)]++;
+        if (isWaiting)
+            Transitions->EnteredWait[MrtTInfo_WaitBucket(d->NewWaitReason)]++;
+    }
+}
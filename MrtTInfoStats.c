@@ -0,0 +1,130 @@
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// The counters are added field by field as one array
+_Static_assert(sizeof(MRT_STATS_COUNTERS) % sizeof(ULONGLONG) == 0, "counters are ULONGLONG only");
+
+#if MRT_STATS_ENABLED
+// Process-wide totals, updated with atomics so concurrent snapshots (collectors,
+// samplers, one-shot calls) need no lock
+static MRT_STATS g_Stats;
+
+static ULONG StatsBucket(ULONGLONG ns)
+{
+    ULONG bucket = 0;
+    while (ns > 1 && bucket < MRT_STATS_BUCKETS - 1) {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void StatsMax(ULONGLONG* target, ULONGLONG value)
+{
+    ULONGLONG seen = MrtAtomic_Load64(target);
+    while (value > seen) {
+        ULONGLONG prior = MrtAtomic_CompareExchange64(target, value, seen);
+        if (prior == seen)
+            break;
+        seen = prior;
+    }
+}
+#endif
+
+void MrtStats_Begin(MRT_STATS_FRAME* frame)
+{
+    memset(frame, 0, sizeof(*frame));
+    MRT_STAT(frame->Start = MrtPlatform_NowNs());
+}
+
+void MrtStats_Phase(MRT_STATS_FRAME* frame, MRT_STATS_PHASE phase, ULONGLONG start)
+{
+    if (!frame)
+        return;
+    frame->PhaseNs[phase] += MrtPlatform_NowNs() - start;
+    frame->Timed |= 1u << phase;
+}
+
+void MrtStats_Query(MRT_STATS_FRAME* frame, const MRT_QUERY_BUFFER* qb, ULONGLONG start)
+{
+    if (!frame)
+        return;
+    MrtStats_Phase(frame, MRT_PHASE_QUERY, start);
+    frame->Counts.Queries++;
+    frame->Counts.QueryRetries += qb->Retries;
+    frame->QueryBufferSize = qb->Capacity;
+    frame->QueryLength = qb->Length;
+}
+
+void MrtStats_Merge(MRT_STATS_COUNTERS* to, const MRT_STATS_COUNTERS* from)
+{
+    ULONGLONG* dst = (ULONGLONG*)to;
+    const ULONGLONG* src = (const ULONGLONG*)from;
+    for (SIZE_T i = 0; i < sizeof(*from) / sizeof(ULONGLONG); i++) {
+        if (src[i])
+            (void)MrtAtomic_Add64(&dst[i], src[i]);
+    }
+}
+
+void MrtStats_Commit(MRT_STATS_FRAME* frame, NTSTATUS status)
+{
+#if MRT_STATS_ENABLED
+    if (NT_SUCCESS(status))
+        frame->Counts.Snapshots++;
+    else
+        frame->Counts.Failures++;
+    MrtStats_Phase(frame, MRT_PHASE_SNAPSHOT, frame->Start);
+
+    MrtStats_Merge(&g_Stats.Totals, &frame->Counts);
+
+    // Only a query that succeeded says how big the buffer had to be
+    if (frame->QueryBufferSize && NT_SUCCESS(status)) {
+        MrtAtomic_Store((volatile LONG*)&g_Stats.QueryBufferSize, (LONG)frame->QueryBufferSize);
+        MrtAtomic_Store((volatile LONG*)&g_Stats.QueryLength, (LONG)frame->QueryLength);
+    }
+
+    for (ULONG phase = 0; phase < MRT_PHASE_COUNT; phase++) {
+        if (!(frame->Timed & (1u << phase)))
+            continue;
+        MRT_PHASE_STATS* ps = &g_Stats.Phases[phase];
+        ULONGLONG ns = frame->PhaseNs[phase];
+        (void)MrtAtomic_Add64(&ps->Count, 1);
+        (void)MrtAtomic_Add64(&ps->TotalNs, ns);
+        (void)MrtAtomic_Add64(&ps->Histogram[StatsBucket(ns)], 1);
+        StatsMax(&ps->MaxNs, ns);
+    }
+#else
+    (void)frame;
+    (void)status;
+#endif
+}
+
+NTSTATUS MrtTInfo_GetStats(MRT_STATS* Stats)
+{
+    if (!Stats)
+        return STATUS_INVALID_PARAMETER;
+
+    memset(Stats, 0, sizeof(*Stats));
+#if MRT_STATS_ENABLED
+    ULONGLONG* dst = (ULONGLONG*)&Stats->Totals;
+    ULONGLONG* src = (ULONGLONG*)&g_Stats.Totals;
+    for (SIZE_T i = 0; i < sizeof(Stats->Totals) / sizeof(ULONGLONG); i++)
+        dst[i] = MrtAtomic_Load64(&src[i]);
+
+    Stats->QueryBufferSize = (ULONG)MrtAtomic_Load((volatile LONG*)&g_Stats.QueryBufferSize);
+    Stats->QueryLength = (ULONG)MrtAtomic_Load((volatile LONG*)&g_Stats.QueryLength);
+
+    for (ULONG phase = 0; phase < MRT_PHASE_COUNT; phase++) {
+        MRT_PHASE_STATS* from = &g_Stats.Phases[phase];
+        MRT_PHASE_STATS* to = &Stats->Phases[phase];
+        to->Count = MrtAtomic_Load64(&from->Count);
+        to->TotalNs = MrtAtomic_Load64(&from->TotalNs);
+        to->MaxNs = MrtAtomic_Load64(&from->MaxNs);
+        for (ULONG b = 0; b < MRT_STATS_BUCKETS; b++)
+            to->Histogram[b] = MrtAtomic_Load64(&from->Histogram[b]);
+    }
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
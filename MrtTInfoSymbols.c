@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include "MrtTInfoInternal.h"
+
+// Module ranges sorted by base. The search runs over a separate Eytzinger
+// array of bases (1-based, padded with MAX to a full tree of 2^Levels - 1
+// nodes) so the hot loop only touches dense base values; each node records
+// its sorted position, read once at the end of a lookup.
+typedef struct _MRT_ADDRESS_RANGE {
+    ULONG_PTR Base;
+    ULONG_PTR End;
+    ULONG Module;
+} MRT_ADDRESS_RANGE;
+
+struct _MRT_ADDRESS_INDEX {
+    ULONG Count;                // ranges after clipping
+    ULONG ModuleCount;          // modules the index was built from
+    ULONG Levels;
+    MRT_ADDRESS_RANGE* Ranges;  // sorted by Base
+    ULONG_PTR* Bases;           // Eytzinger order, [0] unused
+    ULONG* Ranks;               // sorted position per node, Count for padding
+};
+
+#define MRT_ADDRESS_BATCH 16
+
+static int SymbolsCompareRanges(const void* a, const void* b)
+{
+    const MRT_ADDRESS_RANGE* x = (const MRT_ADDRESS_RANGE*)a;
+    const MRT_ADDRESS_RANGE* y = (const MRT_ADDRESS_RANGE*)b;
+    if (x->Base != y->Base)
+        return x->Base < y->Base ? -1 : 1;
+    return x->Module < y->Module ? -1 : x->Module > y->Module;
+}
+
+// In-order walk of the implicit tree hands out sorted positions
+static void SymbolsFill(MRT_ADDRESS_INDEX* index, ULONG nodes, ULONG k, ULONG* next)
+{
+    if (k > nodes)
+        return;
+
+    SymbolsFill(index, nodes, 2 * k, next);
+    ULONG rank = (*next)++;
+    index->Bases[k] = rank < index->Count ? index->Ranges[rank].Base : (ULONG_PTR)-1;
+    index->Ranks[k] = rank < index->Count ? rank : index->Count;
+    SymbolsFill(index, nodes, 2 * k + 1, next);
+}
+
+static ULONG SymbolsTrailingOnes(ULONG k)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (ULONG)__builtin_ctz(~k);
+#else
+    ULONG n = 0;
+    while (k & 1) {
+        k >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Leaf position after the descent -> containing range
+static MRT_ADDRESS_SYMBOL SymbolsFinish(const MRT_ADDRESS_INDEX* index, ULONG k, ULONG_PTR address)
+{
+    // Dropping the trailing right turns (and the last left one) lands on the
+    // first node greater than the address; none means every range starts at or below it.
+    k >>= SymbolsTrailingOnes(k) + 1;
+    ULONG upper = k ? index->Ranks[k] : index->Count;
+
+    MRT_ADDRESS_SYMBOL symbol;
+    symbol.Module = MRT_NO_MODULE;
+    symbol.Offset = address;
+    if (upper) {
+        const MRT_ADDRESS_RANGE* r = &index->Ranges[upper - 1];
+        if (address < r->End) {
+            symbol.Module = r->Module;
+            symbol.Offset = address - r->Base;
+        }
+    }
+    return symbol;
+}
+
+NTSTATUS MrtTInfo_AddressIndexBuild(const MRT_MODULE_INFO* Modules, ULONG Count, MRT_ADDRESS_INDEX** Index)
+{
+    if (!Index || (!Modules && Count))
+        return STATUS_INVALID_PARAMETER;
+
+    *Index = NULL;
+
+    ULONG levels = 0;
+    while (((1UL << levels) - 1) < Count)
+        levels++;
+    ULONG nodes = (1UL << levels) - 1;
+
+    // One block: header, ranges, bases, ranks
+    SIZE_T size = sizeof(MRT_ADDRESS_INDEX) +
+        (SIZE_T)Count * sizeof(MRT_ADDRESS_RANGE) +
+        (SIZE_T)(nodes + 1) * sizeof(ULONG_PTR) +
+        (SIZE_T)(nodes + 1) * sizeof(ULONG);
+
+    BYTE* block = (BYTE*)malloc(size);
+    if (!block)
+        return STATUS_NO_MEMORY;
+
+    MRT_ADDRESS_INDEX* index = (MRT_ADDRESS_INDEX*)block;
+    index->ModuleCount = Count;
+    index->Ranges = (MRT_ADDRESS_RANGE*)(block + sizeof(MRT_ADDRESS_INDEX));
+    index->Bases  = (ULONG_PTR*)(index->Ranges + Count);
+    index->Ranks  = (ULONG*)(index->Bases + nodes + 1);
+
+    for (ULONG i = 0; i < Count; i++) {
+        index->Ranges[i].Base = (ULONG_PTR)Modules[i].Base;
+        index->Ranges[i].End = (ULONG_PTR)Modules[i].Base + Modules[i].Size;
+        index->Ranges[i].Module = i;
+    }
+    if (Count > 1)
+        qsort(index->Ranges, Count, sizeof(MRT_ADDRESS_RANGE), SymbolsCompareRanges);
+
+    // Clip overlaps so each address has one owner: a range nested in the
+    // previous one is dropped, a partial overlap ends the previous range early.
+    ULONG kept = 0;
+    for (ULONG i = 0; i < Count; i++) {
+        MRT_ADDRESS_RANGE r = index->Ranges[i];
+        if (r.End <= r.Base)
+            continue;
+        if (kept && index->Ranges[kept - 1].End >= r.End)
+            continue;
+        if (kept && index->Ranges[kept - 1].End > r.Base) {
+            index->Ranges[kept - 1].End = r.Base;
+            if (index->Ranges[kept - 1].End <= index->Ranges[kept - 1].Base)
+                kept--;
+        }
+        index->Ranges[kept++] = r;
+    }
+    index->Count = kept;
+
+    // Clipping only shrinks the tree: recompute its height for the kept ranges
+    levels = 0;
+    while (((1UL << levels) - 1) < kept)
+        levels++;
+    index->Levels = levels;
+
+    ULONG next = 0;
+    index->Bases[0] = 0;
+    index->Ranks[0] = kept;
+    SymbolsFill(index, (1UL << levels) - 1, 1, &next);
+
+    *Index = index;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_AddressIndexFree(MRT_ADDRESS_INDEX* Index)
+{
+    free(Index);
+}
+
+ULONG MrtTInfo_AddressIndexModuleCount(const MRT_ADDRESS_INDEX* Index)
+{
+    return Index ? Index->ModuleCount : 0;
+}
+
+MRT_ADDRESS_SYMBOL MrtTInfo_AddressIndexLookup(const MRT_ADDRESS_INDEX* Index, PVOID Address)
+{
+    ULONG_PTR x = (ULONG_PTR)Address;
+    if (!Index) {
+        MRT_ADDRESS_SYMBOL none = { MRT_NO_MODULE, x };
+        return none;
+    }
+
+    ULONG k = 1;
+    for (ULONG l = 0; l < Index->Levels; l++)
+        k = 2 * k + (Index->Bases[k] <= x);
+    return SymbolsFinish(Index, k, x);
+}
+
+ULONG MrtTInfo_AddressIndexLookupBatch(
+    const MRT_ADDRESS_INDEX* Index,
+    const PVOID* Addresses,
+    ULONG Count,
+    MRT_ADDRESS_SYMBOL* Symbols
+)
+{
+    if (!Index || !Addresses || !Symbols)
+        return 0;
+
+    ULONG resolved = 0;
+    ULONG k[MRT_ADDRESS_BATCH];
+
+    // Lockstep descent: one level for every lookup of the batch before the
+    // next, so the loads of different lookups are in flight together.
+    for (ULONG base = 0; base < Count; base += MRT_ADDRESS_BATCH) {
+        ULONG n = Count - base < MRT_ADDRESS_BATCH ? Count - base : MRT_ADDRESS_BATCH;
+        const PVOID* x = Addresses + base;
+
+        for (ULONG i = 0; i < n; i++)
+            k[i] = 1;
+
+        for (ULONG l = 0; l < Index->Levels; l++) {
+            for (ULONG i = 0; i < n; i++) {
+                k[i] = 2 * k[i] + (Index->Bases[k[i]] <= (ULONG_PTR)x[i]);
+                if (l + 1 < Index->Levels)
+                    MRT_PREFETCH(&Index->Bases[k[i]]);
+            }
+        }
+
+        for (ULONG i = 0; i < n; i++) {
+            Symbols[base + i] = SymbolsFinish(Index, k[i], (ULONG_PTR)x[i]);
+            resolved += Symbols[base + i].Module != MRT_NO_MODULE;
+        }
+    }
+
+    return resolved;
+}
+
+static void SymbolsFlush(
+    const MRT_ADDRESS_INDEX* index,
+    const PVOID* addresses,
+    ULONG count,
+    MRT_ADDRESS_SYMBOL* symbols,
+    ULONG* moduleThreads
+)
+{
+    MRT_ADDRESS_SYMBOL batch[MRT_ADDRESS_BATCH];
+    MrtTInfo_AddressIndexLookupBatch(index, addresses, count, batch);
+
+    for (ULONG i = 0; i < count; i++) {
+        if (symbols)
+            symbols[i] = batch[i];
+        if (moduleThreads && batch[i].Module != MRT_NO_MODULE)
+            moduleThreads[batch[i].Module]++;
+    }
+}
+
+ULONG MrtTInfo_ResolveStartAddresses(
+    const MRT_ADDRESS_INDEX* Index,
+    const MRT_PROCESS_INFO* Processes,
+    ULONG Count,
+    DWORD PID,
+    MRT_ADDRESS_SYMBOL* Symbols,
+    ULONG* ModuleThreads
+)
+{
+    if (!Index || (!Processes && Count))
+        return 0;
+
+    PVOID addresses[MRT_ADDRESS_BATCH];
+    ULONG pending = 0;
+    ULONG walked = 0;
+
+    for (ULONG p = 0; p < Count; p++) {
+        const MRT_PROCESS_INFO* proc = &Processes[p];
+        if ((PID && proc->PID != PID) || !proc->Threads)
+            continue;
+
+        for (ULONG t = 0; t < proc->ThreadCount; t++) {
+            addresses[pending++] = proc->Threads[t].StartAddress;
+            if (pending == MRT_ADDRESS_BATCH) {
+                SymbolsFlush(Index, addresses, pending, Symbols ? Symbols + walked : NULL, ModuleThreads);
+                walked += pending;
+                pending = 0;
+            }
+        }
+    }
+
+    if (pending) {
+        SymbolsFlush(Index, addresses, pending, Symbols ? Symbols + walked : NULL, ModuleThreads);
+        walked += pending;
+    }
+    return walked;
+}
@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+#include "MrtTInfoInternal.h"
+
+// PID lookup: open addressing with linear probing as in the snapshot index
+struct _MRT_TREE_SLOT {
+    DWORD PID;
+    ULONG Process;      // index + 1, 0 = empty
+};
+
+static ULONG TreeCapacity(ULONG keys)
+{
+    ULONG cap = 16;
+    while (cap < keys * 2 && cap < 0x80000000UL)
+        cap <<= 1;
+    return cap;
+}
+
+static ULONG TreeLookup(const MRT_PROCESS_TREE* tree, DWORD pid)
+{
+    for (ULONG slot = MrtHash_Id(pid, tree->PidMask);; slot = (slot + 1) & tree->PidMask) {
+        const MRT_TREE_SLOT* s = &tree->PidSlots[slot];
+        if (!s->Process)
+            return MRT_TREE_NONE;
+        if (s->PID == pid)
+            return s->Process - 1;
+    }
+}
+
+// Parent of process i, unless it is i itself or was created after i (its
+// PID was reused). An unknown (zero) creation time does not veto the link.
+static ULONG TreeParent(const MRT_PROCESS_TREE* tree, ULONG i)
+{
+    const MRT_PROCESS_INFO* proc = &tree->Processes[i];
+    ULONG parent = TreeLookup(tree, proc->ParentPID);
+    if (parent == MRT_TREE_NONE || parent == i)
+        return MRT_TREE_NONE;
+
+    ULONGLONG created = MrtFileTimeToU64(&proc->CreateTime);
+    ULONGLONG parentCreated = MrtFileTimeToU64(&tree->Processes[parent].CreateTime);
+    if (created && parentCreated > created)
+        return MRT_TREE_NONE;
+    return parent;
+}
+
+NTSTATUS MrtTInfo_TreeBuild(const MRT_PROCESS_INFO* Processes, ULONG Count, MRT_PROCESS_TREE** Tree)
+{
+    if (!Tree || (!Processes && Count) || Count >= MRT_TREE_NONE - 1)
+        return STATUS_INVALID_PARAMETER;
+
+    *Tree = NULL;
+
+    // One block: header, PID slots, then the arrays
+    ULONG cap = TreeCapacity(Count);
+    SIZE_T n = Count;
+    SIZE_T size = sizeof(MRT_PROCESS_TREE) + cap * sizeof(MRT_TREE_SLOT) +
+        (5 * n + n + 2) * sizeof(ULONG);
+    BYTE* block = (BYTE*)calloc(1, size);
+    if (!block)
+        return STATUS_NO_MEMORY;
+
+    MRT_PROCESS_TREE* tree = (MRT_PROCESS_TREE*)block;
+    tree->Processes  = Processes;
+    tree->Count      = Count;
+    tree->PidMask    = cap - 1;
+    tree->PidSlots   = (MRT_TREE_SLOT*)(block + sizeof(MRT_PROCESS_TREE));
+    tree->Parent     = (ULONG*)(tree->PidSlots + cap);
+    tree->Children   = tree->Parent + n;
+    tree->Order      = tree->Children + n;
+    tree->Position   = tree->Order + n;
+    tree->Subtree    = tree->Position + n;
+    tree->ChildStart = tree->Subtree + n;
+
+    ULONG* parent = tree->Parent;
+    ULONG* start = tree->ChildStart;
+    ULONG* scratch = tree->Subtree;     // walk state, then DFS cursors
+
+    for (ULONG i = 0; i < Count; i++) {
+        DWORD pid = Processes[i].PID;
+        ULONG slot = MrtHash_Id(pid, tree->PidMask);
+        while (tree->PidSlots[slot].Process && tree->PidSlots[slot].PID != pid)
+            slot = (slot + 1) & tree->PidMask;
+        if (!tree->PidSlots[slot].Process) {
+            tree->PidSlots[slot].PID = pid;
+            tree->PidSlots[slot].Process = i + 1;
+        }
+    }
+
+    for (ULONG i = 0; i < Count; i++)
+        parent[i] = TreeParent(tree, i);
+
+    // Equal or unknown creation times can still close a cycle; the process
+    // where a walk up the parents meets itself becomes a root. States: 0 new,
+    // 1 on the current walk, 2 settled. Every process is walked over once.
+    for (ULONG i = 0; i < Count; i++) {
+        ULONG v = i;
+        while (v != MRT_TREE_NONE && scratch[v] == 0) {
+            scratch[v] = 1;
+            v = parent[v];
+        }
+        // Settle the walk before cutting it, or the cut stops the settling
+        ULONG meet = v != MRT_TREE_NONE && scratch[v] == 1 ? v : MRT_TREE_NONE;
+        for (v = i; v != MRT_TREE_NONE && scratch[v] == 1; v = parent[v])
+            scratch[v] = 2;
+        if (meet != MRT_TREE_NONE)
+            parent[meet] = MRT_TREE_NONE;
+    }
+
+    // Child lists: count per parent (slot Count for roots), running sums give
+    // the ends, filling backwards moves each back to its start
+    for (ULONG i = 0; i < Count; i++)
+        start[parent[i] == MRT_TREE_NONE ? Count : parent[i]]++;
+    ULONG sum = 0;
+    for (ULONG k = 0; k <= Count; k++) {
+        sum += start[k];
+        start[k] = sum;
+    }
+    start[Count + 1] = sum;
+    for (ULONG i = Count; i-- > 0;)
+        tree->Children[--start[parent[i] == MRT_TREE_NONE ? Count : parent[i]]] = i;
+    tree->RootCount = start[Count + 1] - start[Count];
+
+    // Preorder without a stack: each process keeps a cursor into its child
+    // list, finished subtrees climb back through Parent
+    ULONG* cursor = scratch;
+    ULONG next = 0;
+    for (ULONG r = start[Count]; r < start[Count + 1]; r++) {
+        ULONG v = tree->Children[r];
+        tree->Order[next] = v;
+        tree->Position[v] = next++;
+        cursor[v] = start[v];
+        while (v != MRT_TREE_NONE) {
+            if (cursor[v] < start[v + 1]) {
+                ULONG c = tree->Children[cursor[v]++];
+                tree->Order[next] = c;
+                tree->Position[c] = next++;
+                cursor[c] = start[c];
+                v = c;
+            } else {
+                v = parent[v];
+            }
+        }
+    }
+
+    // Reverse preorder visits children before their parent
+    memset(tree->Subtree, 0, n * sizeof(ULONG));
+    for (ULONG pos = Count; pos-- > 0;) {
+        ULONG v = tree->Order[pos];
+        tree->Subtree[v]++;
+        if (parent[v] != MRT_TREE_NONE)
+            tree->Subtree[parent[v]] += tree->Subtree[v];
+    }
+
+    *Tree = tree;
+    return STATUS_SUCCESS;
+}
+
+void MrtTInfo_TreeFree(MRT_PROCESS_TREE* Tree)
+{
+    free(Tree);
+}
+
+ULONG MrtTInfo_TreeFind(const MRT_PROCESS_TREE* Tree, DWORD pid)
+{
+    return Tree ? TreeLookup(Tree, pid) : MRT_TREE_NONE;
+}
+
+NTSTATUS MrtTInfo_TreeRollup(const MRT_PROCESS_TREE* Tree, const MRT_PROCESS_FIELD* Fields, ULONG FieldCount, ULONGLONG* Totals)
+{
+    if (!Tree || !Fields || !FieldCount || (!Totals && Tree->Count))
+        return STATUS_INVALID_PARAMETER;
+    for (ULONG f = 0; f < FieldCount; f++) {
+        if ((ULONG)Fields[f] >= MRT_FIELD_COUNT)
+            return STATUS_INVALID_PARAMETER;
+    }
+
+    for (ULONG i = 0; i < Tree->Count; i++) {
+        ULONGLONG* row = &Totals[(SIZE_T)i * FieldCount];
+        for (ULONG f = 0; f < FieldCount; f++) {
+            row[f] = Fields[f] == MRT_FIELD_NONE ? 1 :
+                MrtTInfo_GetProcessField(&Tree->Processes[i], Fields[f]);
+        }
+    }
+
+    // Post-order: each finished subtree adds into its parent's row
+    for (ULONG pos = Tree->Count; pos-- > 0;) {
+        ULONG v = Tree->Order[pos];
+        ULONG p = Tree->Parent[v];
+        if (p == MRT_TREE_NONE)
+            continue;
+        const ULONGLONG* from = &Totals[(SIZE_T)v * FieldCount];
+        ULONGLONG* to = &Totals[(SIZE_T)p * FieldCount];
+        for (ULONG f = 0; f < FieldCount; f++)
+            to[f] += from[f];
+    }
+    return STATUS_SUCCESS;
+}
+
+ULONG MrtTInfo_TreeDescendants(const MRT_PROCESS_TREE* Tree, DWORD pid, const ULONG** Descendants)
+{
+    if (!Descendants)
+        return 0;
+
+    *Descendants = NULL;
+    ULONG i = MrtTInfo_TreeFind(Tree, pid);
+    if (i == MRT_TREE_NONE || Tree->Subtree[i] < 2)
+        return 0;
+
+    *Descendants = &Tree->Order[Tree->Position[i] + 1];
+    return Tree->Subtree[i] - 1;
+}
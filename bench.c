@@ -0,0 +1,1211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#define BENCH_NULL_DEVICE "NUL"
+#else
+#include <time.h>
+#include <unistd.h>
+#define BENCH_NULL_DEVICE "/dev/null"
+#endif
+#include "MrtTInfo.h"
+
+// -----------------------------
+// Timing helpers
+// -----------------------------
+static double BenchNowNs(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+static ULONG g_Seed = 0x12345678;
+
+static ULONG BenchRand(void)
+{
+    g_Seed ^= g_Seed << 13;
+    g_Seed ^= g_Seed >> 17;
+    g_Seed ^= g_Seed << 5;
+    return g_Seed;
+}
+
+// Volatile sink so lookups are not optimised away
+static volatile ULONG_PTR g_Sink;
+
+// -----------------------------
+// Synthetic snapshot (heap records, no enrichment)
+// -----------------------------
+static MRT_PROCESS_INFO* BenchMakeProcesses(ULONG processCount, ULONG threadsPerProcess)
+{
+    MRT_PROCESS_INFO* procs = (MRT_PROCESS_INFO*)calloc(processCount, sizeof(MRT_PROCESS_INFO));
+    if (!procs)
+        return NULL;
+
+    DWORD nextTid = 4;
+    for (ULONG i = 0; i < processCount; i++) {
+        procs[i].PID = (i + 1) * 4;
+        procs[i].ThreadCount = threadsPerProcess;
+        procs[i].Threads = (MRT_THREAD_INFO*)calloc(threadsPerProcess, sizeof(MRT_THREAD_INFO));
+        for (ULONG t = 0; procs[i].Threads && t < threadsPerProcess; t++) {
+            procs[i].Threads[t].TID = nextTid;
+            procs[i].Threads[t].ParentPID = procs[i].PID;
+            nextTid += 4;
+        }
+    }
+    return procs;
+}
+
+// -----------------------------
+// Lookup: linear scans vs index
+// -----------------------------
+static void BenchLookups(ULONG processCount, ULONG threadsPerProcess)
+{
+    const ULONG queries = 4096;
+    ULONG threadTotal = processCount * threadsPerProcess;
+
+    MRT_PROCESS_INFO* procs = BenchMakeProcesses(processCount, threadsPerProcess);
+    DWORD* pids = (DWORD*)malloc(queries * sizeof(DWORD));
+    DWORD* tids = (DWORD*)malloc(queries * sizeof(DWORD));
+    MRT_PROCESS_INFO** procHits = (MRT_PROCESS_INFO**)malloc(queries * sizeof(MRT_PROCESS_INFO*));
+    MRT_THREAD_INFO** threadHits = (MRT_THREAD_INFO**)malloc(queries * sizeof(MRT_THREAD_INFO*));
+    if (!procs || !pids || !tids || !procHits || !threadHits) {
+        wprintf(L"  out of memory\n");
+        goto done;
+    }
+
+    for (ULONG q = 0; q < queries; q++) {
+        pids[q] = (BenchRand() % processCount + 1) * 4;
+        tids[q] = (BenchRand() % threadTotal + 1) * 4;
+    }
+
+    double t0 = BenchNowNs();
+    for (ULONG q = 0; q < queries; q++)
+        g_Sink += (ULONG_PTR)MrtTInfo_FindProcessByPID(procs, processCount, pids[q]);
+    double scanPid = (BenchNowNs() - t0) / queries;
+
+    t0 = BenchNowNs();
+    for (ULONG q = 0; q < queries; q++)
+        g_Sink += (ULONG_PTR)MrtTInfo_FindThreadByTID(procs, processCount, tids[q]);
+    double scanTid = (BenchNowNs() - t0) / queries;
+
+    t0 = BenchNowNs();
+    MRT_SNAPSHOT_INDEX* index = NULL;
+    MrtTInfo_IndexBuild(procs, processCount, &index);
+    double build = BenchNowNs() - t0;
+
+    t0 = BenchNowNs();
+    for (ULONG q = 0; q < queries; q++)
+        g_Sink += (ULONG_PTR)MrtTInfo_IndexFindProcess(index, pids[q]);
+    double idxPid = (BenchNowNs() - t0) / queries;
+
+    t0 = BenchNowNs();
+    for (ULONG q = 0; q < queries; q++)
+        g_Sink += (ULONG_PTR)MrtTInfo_IndexFindThread(index, tids[q], NULL);
+    double idxTid = (BenchNowNs() - t0) / queries;
+
+    t0 = BenchNowNs();
+    g_Sink += MrtTInfo_IndexFindProcesses(index, pids, queries, procHits);
+    g_Sink += MrtTInfo_IndexFindThreads(index, tids, queries, threadHits, NULL);
+    double batch = (BenchNowNs() - t0) / (2.0 * queries);
+
+    // Lookups needed before building the index pays for itself (thread lookups)
+    double crossover = scanTid > idxTid ? build / (scanTid - idxTid) : -1.0;
+
+    wprintf(L"  %7lu x %-4lu | scan pid %9.1f tid %10.1f | index pid %6.1f tid %6.1f batch %6.1f | build %10.0f | crossover %8.1f\n",
+            processCount, threadsPerProcess,
+            scanPid, scanTid, idxPid, idxTid, batch, build, crossover);
+
+    MrtTInfo_IndexFree(index);
+
+done:
+    free(pids);
+    free(tids);
+    free(procHits);
+    free(threadHits);
+    MrtTInfo_FreeProcesses(procs, procs ? processCount : 0);
+}
+
+// -----------------------------
+// Start address symbolisation: per-address module scan vs address index
+// -----------------------------
+static void BenchSymbols(ULONG moduleCount, ULONG processCount, ULONG threadsPerProcess)
+{
+    const ULONG_PTR imageBase = (ULONG_PTR)0x10000000;
+    const ULONG_PTR stride = 0x100000;
+    ULONG threadTotal = processCount * threadsPerProcess;
+
+    MRT_MODULE_INFO* modules = (MRT_MODULE_INFO*)calloc(moduleCount, sizeof(MRT_MODULE_INFO));
+    ULONG* counts = (ULONG*)calloc(moduleCount, sizeof(ULONG));
+    MRT_PROCESS_INFO* procs = BenchMakeProcesses(processCount, threadsPerProcess);
+    if (!modules || !counts || !procs)
+        goto done;
+
+    // Modules in load order (not sorted), each covering half its stride
+    for (ULONG m = 0; m < moduleCount; m++) {
+        modules[m].Base = (PVOID)(imageBase + (ULONG_PTR)((m * 7919) % moduleCount) * stride);
+        modules[m].Size = stride / 2;
+    }
+    for (ULONG p = 0; p < processCount; p++)
+        for (ULONG t = 0; procs[p].Threads && t < threadsPerProcess; t++)
+            procs[p].Threads[t].StartAddress =
+                (PVOID)(imageBase + (ULONG_PTR)BenchRand() % (moduleCount * stride));
+
+    double t0 = BenchNowNs();
+    ULONG hits = 0;
+    for (ULONG p = 0; p < processCount; p++) {
+        for (ULONG t = 0; procs[p].Threads && t < threadsPerProcess; t++) {
+            ULONG_PTR a = (ULONG_PTR)procs[p].Threads[t].StartAddress;
+            for (ULONG m = 0; m < moduleCount; m++) {
+                if (a - (ULONG_PTR)modules[m].Base < modules[m].Size) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+    }
+    double scan = BenchNowNs() - t0;
+    g_Sink += hits;
+
+    MRT_ADDRESS_INDEX* index = NULL;
+    t0 = BenchNowNs();
+    if (!NT_SUCCESS(MrtTInfo_AddressIndexBuild(modules, moduleCount, &index)))
+        goto done;
+    double build = BenchNowNs() - t0;
+
+    t0 = BenchNowNs();
+    ULONG walked = MrtTInfo_ResolveStartAddresses(index, procs, processCount, 0, NULL, counts);
+    double resolve = BenchNowNs() - t0;
+    g_Sink += walked + counts[0];
+
+    wprintf(L"  %4lu modules, %6lu threads: scan %8.1f us  index build %6.1f us  resolve %7.1f us  (%.1f ns/thread)\n",
+            moduleCount, threadTotal, scan / 1e3, build / 1e3, resolve / 1e3,
+            threadTotal ? resolve / threadTotal : 0.0);
+    MrtTInfo_AddressIndexFree(index);
+
+done:
+    free(modules);
+    free(counts);
+    MrtTInfo_FreeProcesses(procs, procs ? processCount : 0);
+}
+
+// -----------------------------
+// Top-N threads: bounded heap vs sorting every thread
+// -----------------------------
+static int BenchCompareDescending(const void* a, const void* b)
+{
+    ULONG x = *(const ULONG*)a;
+    ULONG y = *(const ULONG*)b;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void BenchTopN(ULONG processCount, ULONG threadsPerProcess, ULONG n)
+{
+    ULONG threadTotal = processCount * threadsPerProcess;
+    MRT_PROCESS_INFO* procs = BenchMakeProcesses(processCount, threadsPerProcess);
+    ULONG* values = (ULONG*)malloc(threadTotal * sizeof(ULONG));
+    MRT_TOP_ENTRY* top = (MRT_TOP_ENTRY*)malloc(n * sizeof(MRT_TOP_ENTRY));
+    if (!procs || !values || !top)
+        goto done;
+
+    for (ULONG p = 0; p < processCount; p++) {
+        procs[p].SessionId = p % 4;
+        for (ULONG t = 0; procs[p].Threads && t < threadsPerProcess; t++)
+            procs[p].Threads[t].ContextSwitches = BenchRand() % 1000000;
+    }
+
+    double t0 = BenchNowNs();
+    ULONG k = 0;
+    for (ULONG p = 0; p < processCount; p++)
+        for (ULONG t = 0; procs[p].Threads && t < threadsPerProcess; t++)
+            values[k++] = procs[p].Threads[t].ContextSwitches;
+    qsort(values, k, sizeof(ULONG), BenchCompareDescending);
+    double sorted = BenchNowNs() - t0;
+    g_Sink += values[0];
+
+    t0 = BenchNowNs();
+    ULONG got = MrtTInfo_TopThreads(procs, processCount, MRT_THREAD_FIELD_CONTEXT_SWITCHES, n, top);
+    double heap = BenchNowNs() - t0;
+    g_Sink += got ? (ULONG_PTR)top[0].Value : 0;
+
+    MRT_AGGREGATE_SPEC spec = { MRT_GROUP_SESSION, TRUE, MRT_FIELD_NONE, MRT_THREAD_FIELD_CONTEXT_SWITCHES };
+    MRT_AGGREGATE* groups = NULL;
+    t0 = BenchNowNs();
+    if (NT_SUCCESS(MrtTInfo_Aggregate(procs, processCount, &spec, &groups)))
+        g_Sink += groups->GroupCount;
+    double grouped = BenchNowNs() - t0;
+    MrtTInfo_FreeAggregate(groups);
+
+    wprintf(L"  %6lu threads, top %3lu: full sort %8.1f us  heap %7.1f us  group by session %7.1f us\n",
+            threadTotal, n, sorted / 1e3, heap / 1e3, grouped / 1e3);
+
+done:
+    free(values);
+    free(top);
+    MrtTInfo_FreeProcesses(procs, procs ? processCount : 0);
+}
+
+// -----------------------------
+// Scans over one thread counter: record array vs columns (best of 20)
+// -----------------------------
+static void BenchColumns(ULONG processCount, ULONG threadsPerProcess)
+{
+    const int rounds = 20;
+    ULONG threadTotal = processCount * threadsPerProcess;
+    MRT_PROCESS_INFO* procs = BenchMakeProcesses(processCount, threadsPerProcess);
+    MRT_THREAD_COLUMNS* columns = NULL;
+    if (!procs)
+        return;
+
+    for (ULONG p = 0; p < processCount; p++) {
+        for (ULONG t = 0; procs[p].Threads && t < threadsPerProcess; t++) {
+            MRT_THREAD_INFO* mt = &procs[p].Threads[t];
+            mt->KernelTime.QuadPart = BenchRand();
+            mt->ContextSwitches = BenchRand() % 100000;
+            mt->ThreadState = BenchRand() % 8;
+        }
+    }
+
+    double t0 = BenchNowNs();
+    if (!NT_SUCCESS(MrtTInfo_ColumnsBuild(procs, processCount, &columns)))
+        goto done;
+    double build = BenchNowNs() - t0;
+
+    double aos[3] = { 0, 0, 0 };
+    double soa[3] = { 0, 0, 0 };
+    for (int r = 0; r < rounds; r++) {
+        ULONG hist[256];
+        LONGLONG kernel = 0;
+        ULONG maxSwitches = 0;
+
+        t0 = BenchNowNs();
+        for (ULONG p = 0; p < processCount; p++)
+            for (ULONG t = 0; t < threadsPerProcess; t++)
+                kernel += procs[p].Threads[t].KernelTime.QuadPart;
+        double a0 = BenchNowNs() - t0;
+
+        t0 = BenchNowNs();
+        for (ULONG p = 0; p < processCount; p++)
+            for (ULONG t = 0; t < threadsPerProcess; t++)
+                if (procs[p].Threads[t].ContextSwitches > maxSwitches)
+                    maxSwitches = procs[p].Threads[t].ContextSwitches;
+        double a1 = BenchNowNs() - t0;
+
+        memset(hist, 0, sizeof(hist));
+        t0 = BenchNowNs();
+        for (ULONG p = 0; p < processCount; p++)
+            for (ULONG t = 0; t < threadsPerProcess; t++)
+                hist[procs[p].Threads[t].ThreadState & 0xFF]++;
+        double a2 = BenchNowNs() - t0;
+        g_Sink += (ULONG_PTR)kernel + maxSwitches + hist[1];
+
+        t0 = BenchNowNs();
+        kernel = MrtTInfo_ColumnSumI64(columns->KernelTime, columns->ThreadCount);
+        double s0 = BenchNowNs() - t0;
+
+        t0 = BenchNowNs();
+        maxSwitches = MrtTInfo_ColumnMaxU32(columns->ContextSwitches, columns->ThreadCount);
+        double s1 = BenchNowNs() - t0;
+
+        memset(hist, 0, sizeof(hist));
+        t0 = BenchNowNs();
+        MrtTInfo_ColumnHistogramU8(columns->ThreadState, columns->ThreadCount, hist);
+        double s2 = BenchNowNs() - t0;
+        g_Sink += (ULONG_PTR)kernel + maxSwitches + hist[1];
+
+        double a[3] = { a0, a1, a2 };
+        double s[3] = { s0, s1, s2 };
+        for (int k = 0; k < 3; k++) {
+            if (r == 0 || a[k] < aos[k])
+                aos[k] = a[k];
+            if (r == 0 || s[k] < soa[k])
+                soa[k] = s[k];
+        }
+    }
+
+    wprintf(L"  %6lu threads (columns built in %.1f us)\n", threadTotal, build / 1e3);
+    static const wchar_t* names[] = { L"sum KernelTime", L"max ContextSwitches", L"histogram ThreadState" };
+    for (int k = 0; k < 3; k++)
+        wprintf(L"    %-22ls records %8.1f us  columns %7.1f us  (%.1fx)\n",
+                names[k], aos[k] / 1e3, soa[k] / 1e3, soa[k] > 0 ? aos[k] / soa[k] : 0.0);
+
+done:
+    MrtTInfo_ColumnsFree(columns);
+    MrtTInfo_FreeProcesses(procs, processCount);
+}
+
+// -----------------------------
+// Synthetic pipeline: latency percentiles per phase
+// -----------------------------
+static int BenchCompareDouble(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+// Sorts the samples in place
+static void BenchPrintPercentiles(const wchar_t* label, double* samples, ULONG count, double scale)
+{
+    qsort(samples, count, sizeof(double), BenchCompareDouble);
+    wprintf(L"    %-8ls p50 %10.2f  p90 %10.2f  p99 %10.2f  max %10.2f\n", label,
+            samples[count / 2] / scale, samples[count * 9 / 10] / scale,
+            samples[count * 99 / 100] / scale, samples[count - 1] / scale);
+}
+
+// Times conversion (heap and arena), index lookups, free and text formatting
+// of a generated buffer. Allocation counts come from the arena, which sees
+// the same requests as the heap path.
+static void BenchPipeline(ULONG processCount, ULONG threadsPerProcess)
+{
+    const ULONG lookups = 1024;
+    ULONG threadTotal = processCount * threadsPerProcess;
+    ULONG rounds = 2000000 / threadTotal;
+    rounds = rounds < 20 ? 20 : rounds > 1000 ? 1000 : rounds;
+
+    void* raw = NULL;
+    ULONG length = 0;
+    MRT_ARENA* arena = MrtTInfo_ArenaCreate(0);
+    double* samples = (double*)malloc(6 * rounds * sizeof(double));
+    DWORD* tids = (DWORD*)malloc(lookups * sizeof(DWORD));
+    char* line = (char*)malloc(512);
+    if (!arena || !samples || !tids || !line ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 42, &raw, &length))) {
+        wprintf(L"  out of memory\n");
+        goto done;
+    }
+
+    double* convert = samples;
+    double* arenaConvert = samples + rounds;
+    double* indexBuild = samples + 2 * rounds;
+    double* lookup = samples + 3 * rounds;
+    double* release = samples + 4 * rounds;
+    double* format = samples + 5 * rounds;
+
+    for (ULONG q = 0; q < lookups; q++)
+        tids[q] = (BenchRand() % threadTotal + 1) * 4;
+
+    MrtTInfo_SetReplayBuffer(raw, length);
+
+    MRT_ALLOC_STATS warm, stats;
+    memset(&warm, 0, sizeof(warm));
+    ULONG formatted = 0;
+    for (ULONG r = 0; r < rounds; r++) {
+        MRT_PROCESS_INFO* procs = NULL;
+        ULONG count = 0;
+        double t0 = BenchNowNs();
+        if (!NT_SUCCESS(MrtTInfo_GetAllProcesses(&procs, &count)))
+            break;
+        convert[r] = BenchNowNs() - t0;
+
+        MRT_SNAPSHOT_INDEX* index = NULL;
+        t0 = BenchNowNs();
+        MrtTInfo_IndexBuild(procs, count, &index);
+        indexBuild[r] = BenchNowNs() - t0;
+
+        t0 = BenchNowNs();
+        for (ULONG q = 0; q < lookups; q++)
+            g_Sink += (ULONG_PTR)MrtTInfo_IndexFindThread(index, tids[q], NULL);
+        lookup[r] = (BenchNowNs() - t0) / lookups;
+        MrtTInfo_IndexFree(index);
+
+        // One text row per thread, as a table or log exporter would write
+        t0 = BenchNowNs();
+        formatted = 0;
+        for (ULONG p = 0; p < count; p++) {
+            const wchar_t* name = procs[p].ImageName.Buffer ? procs[p].ImageName.Buffer : L"";
+            for (ULONG t = 0; t < procs[p].ThreadCount; t++) {
+                const MRT_THREAD_INFO* th = &procs[p].Threads[t];
+                int n = snprintf(line, 512, "%6lu %6lu %-28ls %-12s %-16s %3ld %10lu\n",
+                                 (unsigned long)procs[p].PID, (unsigned long)th->TID, name,
+                                 MrtHelper_ThreadStateToString(th->ThreadState),
+                                 MrtHelper_WaitReasonToString(th->WaitReason),
+                                 (long)th->Priority, (unsigned long)th->ContextSwitches);
+                formatted += n > 0 ? (ULONG)n : 0;
+            }
+        }
+        format[r] = BenchNowNs() - t0;
+        g_Sink += formatted;
+
+        t0 = BenchNowNs();
+        MrtTInfo_FreeProcesses(procs, count);
+        release[r] = BenchNowNs() - t0;
+
+        t0 = BenchNowNs();
+        if (!NT_SUCCESS(MrtTInfo_GetAllProcessesInArena(arena, &procs, &count)))
+            break;
+        arenaConvert[r] = BenchNowNs() - t0;
+        MrtTInfo_ArenaGetStats(arena, &stats);
+        MrtTInfo_ArenaReset(arena);
+        if (r == 0)
+            warm = stats;
+    }
+
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+
+    wprintf(L"  %6lu threads (%lu x %lu), %lu KB buffer, %lu rounds\n",
+            threadTotal, processCount, threadsPerProcess, length / 1024, rounds);
+    BenchPrintPercentiles(L"convert", convert, rounds, 1e3);
+    BenchPrintPercentiles(L"arena", arenaConvert, rounds, 1e3);
+    BenchPrintPercentiles(L"index", indexBuild, rounds, 1e3);
+    BenchPrintPercentiles(L"lookup", lookup, rounds, 1.0);
+    BenchPrintPercentiles(L"free", release, rounds, 1e3);
+    BenchPrintPercentiles(L"format", format, rounds, 1e3);
+    wprintf(L"    allocations %llu per snapshot (%llu KB), heap blocks after the first %llu, %lu KB text\n",
+            stats.Allocations, stats.BytesUsed / 1024,
+            stats.HeapAllocations - warm.HeapAllocations, formatted / 1024);
+
+done:
+    free(samples);
+    free(tids);
+    free(line);
+    MrtTInfo_ArenaDestroy(arena);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Refresher: publication and reader cost
+// -----------------------------
+// Times manual refreshes of a generated buffer, then Acquire/Release pairs
+// alone and while a background refresher keeps publishing.
+static void BenchRefresher(ULONG processCount, ULONG threadsPerProcess)
+{
+    const ULONG rounds = 200;
+    const ULONG pairs = 1000;
+
+    void* raw = NULL;
+    ULONG length = 0;
+    MRT_COLLECTOR* collector = NULL;
+    MRT_REFRESHER* refresher = NULL;
+    double* samples = (double*)malloc(3 * rounds * sizeof(double));
+    if (!samples ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 42, &raw, &length)) ||
+        !NT_SUCCESS(MrtTInfo_CollectorCreate(&collector))) {
+        wprintf(L"  out of memory\n");
+        goto done;
+    }
+    MrtTInfo_CollectorSetReplayBuffer(collector, raw, length);
+
+    double* tick = samples;
+    double* quiet = samples + rounds;
+    double* busy = samples + 2 * rounds;
+
+    for (int pass = 0; pass < 2; pass++) {
+        // Manual first, then refreshing every millisecond behind the readers
+        if (!NT_SUCCESS(MrtTInfo_RefresherCreate(collector, pass ? 1 : 0, &refresher))) {
+            wprintf(L"  cannot create refresher\n");
+            goto done;
+        }
+        collector = NULL;
+
+        // Readers under load: long enough to span several publications
+        ULONG batch = pass ? pairs * 10 : pairs;
+        const MRT_SHARED_SNAPSHOT* published = NULL;
+        while (pass && !(published = MrtTInfo_RefresherAcquire(refresher)) &&
+               NT_SUCCESS(MrtTInfo_RefresherGetLastStatus(refresher)))
+            ;
+        if (pass)
+            MrtTInfo_RefresherRelease(refresher, published);
+
+        ULONGLONG first = 0, last = 0;
+        for (ULONG r = 0; r < rounds; r++) {
+            double t0;
+            if (!pass) {
+                t0 = BenchNowNs();
+                MrtTInfo_RefresherTick(refresher);
+                tick[r] = BenchNowNs() - t0;
+            }
+
+            t0 = BenchNowNs();
+            for (ULONG i = 0; i < batch; i++) {
+                const MRT_SHARED_SNAPSHOT* snapshot = MrtTInfo_RefresherAcquire(refresher);
+                if (snapshot) {
+                    g_Sink += snapshot->Count;
+                    last = snapshot->Sequence;
+                    if (!first)
+                        first = last;
+                }
+                MrtTInfo_RefresherRelease(refresher, snapshot);
+            }
+            (pass ? busy : quiet)[r] = (BenchNowNs() - t0) / batch;
+        }
+        MrtTInfo_RefresherDestroy(refresher);
+        refresher = NULL;
+
+        if (!pass) {
+            wprintf(L"  %6lu threads (%lu x %lu), %lu rounds\n",
+                    processCount * threadsPerProcess, processCount, threadsPerProcess, rounds);
+            BenchPrintPercentiles(L"tick", tick, rounds, 1e3);
+            BenchPrintPercentiles(L"acquire", quiet, rounds, 1.0);
+            if (!NT_SUCCESS(MrtTInfo_CollectorCreate(&collector)))
+                break;
+            MrtTInfo_CollectorSetReplayBuffer(collector, raw, length);
+        } else {
+            BenchPrintPercentiles(L"busy", busy, rounds, 1.0);
+            wprintf(L"    %llu snapshots published while reading\n", last - first);
+        }
+    }
+
+done:
+    MrtTInfo_RefresherDestroy(refresher);
+    MrtTInfo_CollectorDestroy(collector);
+    MrtTInfo_FreeRawBuffer(raw);
+    free(samples);
+}
+
+// -----------------------------
+// Sampler: tick cost and steady-state allocations
+// -----------------------------
+// Manual ticks alternating between two generated buffers of the same
+// population (different counters). Heap blocks are counted once every ring
+// slot has been written.
+static void BenchSampler(ULONG processCount, ULONG threadsPerProcess)
+{
+    const ULONG depth = MRT_SAMPLER_DEFAULT_DEPTH;
+    const ULONG rounds = 200;
+
+    void* raw[2] = { NULL, NULL };
+    ULONG length[2] = { 0, 0 };
+    MRT_SAMPLER* sampler = NULL;
+    double* tick = (double*)malloc(rounds * sizeof(double));
+    if (!tick ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 42, &raw[0], &length[0])) ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 43, &raw[1], &length[1])) ||
+        !NT_SUCCESS(MrtTInfo_SamplerCreate(0, depth, &sampler))) {
+        wprintf(L"  out of memory\n");
+        goto done;
+    }
+
+    MRT_ALLOC_STATS warm, stats;
+    for (ULONG r = 0; r < depth + 1; r++) {
+        MrtTInfo_SamplerSetReplayBuffer(sampler, raw[r & 1], length[r & 1]);
+        MrtTInfo_SamplerTick(sampler);
+    }
+    MrtTInfo_SamplerGetAllocStats(sampler, &warm);
+
+    for (ULONG r = 0; r < rounds; r++) {
+        MrtTInfo_SamplerSetReplayBuffer(sampler, raw[r & 1], length[r & 1]);
+        double t0 = BenchNowNs();
+        MrtTInfo_SamplerTick(sampler);
+        tick[r] = BenchNowNs() - t0;
+    }
+    MrtTInfo_SamplerGetAllocStats(sampler, &stats);
+
+    wprintf(L"  %6lu threads (%lu x %lu), depth %lu, %lu rounds\n",
+            processCount * threadsPerProcess, processCount, threadsPerProcess, depth, rounds);
+    BenchPrintPercentiles(L"tick", tick, rounds, 1e3);
+    wprintf(L"    %.1f ns per thread at p50, heap blocks after warm-up %llu (%llu during)\n",
+            tick[rounds / 2] / (processCount * threadsPerProcess),
+            stats.HeapAllocations - warm.HeapAllocations, warm.HeapAllocations);
+
+done:
+    MrtTInfo_SamplerDestroy(sampler);
+    MrtTInfo_FreeRawBuffer(raw[0]);
+    MrtTInfo_FreeRawBuffer(raw[1]);
+    free(tick);
+}
+
+// -----------------------------
+// Text export vs per-field printing
+// -----------------------------
+// The demo's output path: one wide fwprintf per line, every thread listed.
+// Returns the characters written.
+static SIZE_T BenchPrintSnapshot(FILE* out, const MRT_PROCESS_INFO* procs, ULONG count)
+{
+    SIZE_T written = 0;
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* p = &procs[i];
+        written += fwprintf(out, L"PID: %-5lu  PPID: %-5lu  Name: %.*ls\n",
+                 (unsigned long)p->PID, (unsigned long)p->ParentPID,
+                 (int)(p->ImageName.Length / sizeof(WCHAR)), p->ImageName.Buffer ? p->ImageName.Buffer : L"");
+        written += fwprintf(out, L"    Threads: %lu  Handles: %lu  WS: %zu KB\n",
+                 (unsigned long)p->ThreadCount, (unsigned long)p->HandleCount, (size_t)(p->WorkingSetSize / 1024));
+        for (ULONG t = 0; t < p->ThreadCount; t++) {
+            const MRT_THREAD_INFO* th = &p->Threads[t];
+            written += fwprintf(out, L"      TID: %-6lu  BasePrio: %-2ld  State: %-20hs  Wait: %hs\n",
+                     (unsigned long)th->TID, (long)th->BasePriority,
+                     MrtHelper_ThreadStateToString(th->ThreadState),
+                     MrtHelper_WaitReasonToString(th->WaitReason));
+            written += fwprintf(out, L"        StartAddress: %p\n", th->StartAddress);
+        }
+    }
+    return written;
+}
+
+static void BenchExportRate(const wchar_t* label, double ns, ULONG rows, SIZE_T bytes)
+{
+    wprintf(L"    %-8ls %8.2f ms  %7.2f M rows/s  %8.1f MB/s\n", label, ns / 1e6,
+            rows / (ns / 1e9) / 1e6, bytes / (ns / 1e9) / (1024.0 * 1024.0));
+}
+
+// Rows per second of the exporters (reused buffer, streamed to the null
+// device) against fwprintf to the null device, best of 10
+static void BenchExport(ULONG processCount, ULONG threadsPerProcess)
+{
+    const int rounds = 10;
+    void* raw = NULL;
+    ULONG length = 0;
+    MRT_PROCESS_INFO* procs = NULL;
+    ULONG count = 0;
+    MRT_EXPORT_BUFFER buffer;
+    memset(&buffer, 0, sizeof(buffer));
+
+    FILE* out = fopen(BENCH_NULL_DEVICE, "w");
+#ifdef _WIN32
+    int fd = _open(BENCH_NULL_DEVICE, _O_WRONLY);
+#else
+    int fd = open(BENCH_NULL_DEVICE, O_WRONLY);
+#endif
+    if (!out || fd < 0 ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 42, &raw, &length))) {
+        wprintf(L"  cannot set up\n");
+        goto done;
+    }
+    MrtTInfo_SetReplayBuffer(raw, length);
+    NTSTATUS status = MrtTInfo_GetAllProcesses(&procs, &count);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+    if (!NT_SUCCESS(status))
+        goto done;
+
+    ULONG rows = count;
+    for (ULONG i = 0; i < count; i++)
+        rows += procs[i].ThreadCount;
+
+    double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+    SIZE_T bytes[4] = { 0 };
+    for (int r = 0; r < rounds; r++) {
+        double t0 = BenchNowNs();
+        bytes[0] = BenchPrintSnapshot(out, procs, count);
+        fflush(out);
+        double dt = BenchNowNs() - t0;
+        if (dt < best[0])
+            best[0] = dt;
+
+        for (int f = 0; f < 2; f++) {
+            buffer.Length = 0;
+            t0 = BenchNowNs();
+            MrtTInfo_ExportAppend(procs, count, f ? MRT_EXPORT_NDJSON : MRT_EXPORT_CSV, &buffer);
+            dt = BenchNowNs() - t0;
+            if (dt < best[1 + f])
+                best[1 + f] = dt;
+            bytes[1 + f] = buffer.Length;
+        }
+
+        t0 = BenchNowNs();
+        MrtTInfo_ExportToFd(procs, count, MRT_EXPORT_CSV, fd);
+        dt = BenchNowNs() - t0;
+        if (dt < best[3])
+            best[3] = dt;
+        bytes[3] = bytes[1];
+    }
+
+    wprintf(L"  %6lu rows (%lu x %lu)\n", rows, processCount, threadsPerProcess);
+    BenchExportRate(L"fwprintf", best[0], rows, bytes[0]);
+    BenchExportRate(L"csv", best[1], rows, bytes[1]);
+    BenchExportRate(L"ndjson", best[2], rows, bytes[2]);
+    BenchExportRate(L"csv fd", best[3], rows, bytes[3]);
+    wprintf(L"    csv %.1fx faster than fwprintf\n", best[0] / best[1]);
+
+done:
+    if (out)
+        fclose(out);
+    if (fd >= 0)
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    MrtTInfo_ExportBufferFree(&buffer);
+    MrtTInfo_FreeProcesses(procs, count);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Process tree
+// -----------------------------
+// Build, one rollup of three fields over every subtree, and the same rollup
+// done by walking each process' ancestors through the index, best of 20
+static void BenchTree(ULONG processCount)
+{
+    const int rounds = 20;
+    static const MRT_PROCESS_FIELD fields[] = { MRT_FIELD_CPU_TIME, MRT_FIELD_WORKING_SET, MRT_FIELD_THREAD_COUNT };
+    const ULONG fieldCount = sizeof(fields) / sizeof(fields[0]);
+
+    void* raw = NULL;
+    ULONG length = 0;
+    MRT_PROCESS_INFO* procs = NULL;
+    ULONG count = 0;
+    MRT_SNAPSHOT_INDEX* index = NULL;
+    ULONGLONG* totals = NULL;
+    ULONGLONG* walked = NULL;
+
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, 4, 42, &raw, &length))) {
+        wprintf(L"  out of memory\n");
+        return;
+    }
+    MrtTInfo_SetReplayBuffer(raw, length);
+    NTSTATUS status = MrtTInfo_GetAllProcesses(&procs, &count);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+    totals = (ULONGLONG*)malloc((SIZE_T)count * fieldCount * sizeof(ULONGLONG));
+    walked = (ULONGLONG*)malloc((SIZE_T)count * fieldCount * sizeof(ULONGLONG));
+    if (!NT_SUCCESS(status) || !totals || !walked || !NT_SUCCESS(MrtTInfo_IndexBuild(procs, count, &index))) {
+        wprintf(L"  out of memory\n");
+        goto done;
+    }
+
+    double bestBuild = 1e30, bestRollup = 1e30, bestWalk = 1e30, bestDesc = 1e30;
+    ULONG roots = 0, descendants = 0;
+    for (int r = 0; r < rounds; r++) {
+        MRT_PROCESS_TREE* tree = NULL;
+        double t0 = BenchNowNs();
+        if (!NT_SUCCESS(MrtTInfo_TreeBuild(procs, count, &tree)))
+            break;
+        double dt = BenchNowNs() - t0;
+        if (dt < bestBuild)
+            bestBuild = dt;
+        roots = tree->RootCount;
+
+        t0 = BenchNowNs();
+        MrtTInfo_TreeRollup(tree, fields, fieldCount, totals);
+        dt = BenchNowNs() - t0;
+        if (dt < bestRollup)
+            bestRollup = dt;
+
+        // Descendants of every process (the sum of all subtree sizes)
+        t0 = BenchNowNs();
+        descendants = 0;
+        for (ULONG i = 0; i < count; i++) {
+            const ULONG* d = NULL;
+            ULONG n = MrtTInfo_TreeDescendants(tree, procs[i].PID, &d);
+            for (ULONG k = 0; k < n; k++)
+                g_Sink += d[k];
+            descendants += n;
+        }
+        dt = BenchNowNs() - t0;
+        if (dt < bestDesc)
+            bestDesc = dt;
+        MrtTInfo_TreeFree(tree);
+
+        // Without a tree: add each process to every ancestor found by PID
+        t0 = BenchNowNs();
+        memset(walked, 0, (SIZE_T)count * fieldCount * sizeof(ULONGLONG));
+        for (ULONG i = 0; i < count; i++) {
+            ULONGLONG values[3];
+            for (ULONG f = 0; f < fieldCount; f++)
+                values[f] = MrtTInfo_GetProcessField(&procs[i], fields[f]);
+            const MRT_PROCESS_INFO* p = &procs[i];
+            for (ULONG depth = 0; p && depth < count; depth++) {
+                ULONGLONG* row = &walked[(SIZE_T)(p - procs) * fieldCount];
+                for (ULONG f = 0; f < fieldCount; f++)
+                    row[f] += values[f];
+                const MRT_PROCESS_INFO* up = p->PID ? MrtTInfo_IndexFindProcess(index, p->ParentPID) : NULL;
+                p = up != p ? up : NULL;
+            }
+        }
+        dt = BenchNowNs() - t0;
+        if (dt < bestWalk)
+            bestWalk = dt;
+    }
+
+    wprintf(L"  %6lu processes, %lu roots: build %8.1f us  rollup %7.1f us  ancestor walk %8.1f us  "
+            L"all descendants %7.1f us (%lu)\n",
+            count, roots, bestBuild / 1e3, bestRollup / 1e3, bestWalk / 1e3, bestDesc / 1e3, descendants);
+
+done:
+    free(totals);
+    free(walked);
+    MrtTInfo_IndexFree(index);
+    MrtTInfo_FreeProcesses(procs, count);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Conversion of a recorded raw buffer (replay)
+// -----------------------------
+static void BenchReplay(const char* path)
+{
+    void* raw = NULL;
+    ULONG length = 0;
+    NTSTATUS status = MrtTInfo_LoadRawBuffer(path, &raw, &length);
+    if (!NT_SUCCESS(status)) {
+        wprintf(L"  cannot load %hs (NTSTATUS 0x%08X)\n", path, status);
+        return;
+    }
+
+    MrtTInfo_SetReplayBuffer(raw, length);
+
+    const int rounds = 50;
+    double best = 0;
+    ULONG processes = 0, threads = 0;
+    for (int r = 0; r < rounds; r++) {
+        MRT_PROCESS_INFO* procs = NULL;
+        ULONG count = 0;
+        double t0 = BenchNowNs();
+        if (!NT_SUCCESS(MrtTInfo_GetAllProcesses(&procs, &count)))
+            break;
+        double dt = BenchNowNs() - t0;
+        if (r == 0 || dt < best)
+            best = dt;
+        processes = count;
+        threads = 0;
+        for (ULONG p = 0; p < count; p++)
+            threads += procs[p].ThreadCount;
+        MrtTInfo_FreeProcesses(procs, count);
+    }
+
+    wprintf(L"  %lu processes, %lu threads: %9.1f us  (%.0f ns/thread)\n",
+            processes, threads, best / 1e3, threads ? best / threads : 0.0);
+
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// Remote TEB/PEB parsing against the fake reader: one process whose TEBs sit
+// in adjacent two-page slots, as on a live system
+static void BenchRemote(ULONG threadCount)
+{
+    const ULONG_PTR tebBase = (ULONG_PTR)0x10000000;
+    const ULONG_PTR pebBase = tebBase + (ULONG_PTR)threadCount * 0x2000 + 0x10000;
+    static const wchar_t commandLine[] = L"svchost.exe -k netsvcs -p";
+
+    TEB_PARTIAL* tebs = (TEB_PARTIAL*)calloc(threadCount, 0x2000);
+    MRT_MEMORY_REGION* regions = (MRT_MEMORY_REGION*)calloc(threadCount + 4, sizeof(MRT_MEMORY_REGION));
+    MRT_PROCESS_INFO* proc = (MRT_PROCESS_INFO*)calloc(1, sizeof(MRT_PROCESS_INFO));
+    MRT_THREAD_INFO* threads = (MRT_THREAD_INFO*)calloc(threadCount, sizeof(MRT_THREAD_INFO));
+    if (!tebs || !regions || !proc || !threads) {
+        free(tebs);
+        free(regions);
+        free(proc);
+        free(threads);
+        return;
+    }
+
+    PEB_PARTIAL peb;
+    RTL_USER_PROCESS_PARAMETERS params;
+    memset(&peb, 0, sizeof(peb));
+    memset(&params, 0, sizeof(params));
+    peb.ProcessParameters = (PVOID)(pebBase + 0x1000);
+    params.CommandLine.Length = (USHORT)(wcslen(commandLine) * sizeof(WCHAR));
+    params.CommandLine.Buffer = (PWSTR)(pebBase + 0x2000);
+
+    ULONG regionCount = 0;
+    for (ULONG t = 0; t < threadCount; t++) {
+        // Creation order runs downwards, like TEB allocation
+        ULONG_PTR teb = tebBase + (ULONG_PTR)(threadCount - 1 - t) * 0x2000;
+        TEB_PARTIAL* image = (TEB_PARTIAL*)((BYTE*)tebs + (SIZE_T)t * 0x2000);
+        image->ProcessEnvironmentBlock = (PVOID)pebBase;
+        image->LastErrorValue = t;
+        regions[regionCount++] = (MRT_MEMORY_REGION){ 0, teb, image, 0x2000 };
+        threads[t].TID = 1000 + t;
+        threads[t].TebAddress = (PVOID)teb;
+    }
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, pebBase, &peb, sizeof(peb) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, pebBase + 0x1000, &params, sizeof(params) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, pebBase + 0x2000, commandLine, sizeof(commandLine) };
+
+    MRT_FAKE_MEMORY memory = { regions, regionCount, 0, 0 };
+    MRT_MEMORY_READER reader;
+    MrtTInfo_FakeReaderInit(&memory, &reader);
+
+    const int rounds = 20;
+    double best = 0;
+    MRT_REMOTE_STATS stats;
+    for (int r = 0; r < rounds; r++) {
+        memset(proc, 0, sizeof(*proc));
+        memset(&stats, 0, sizeof(stats));
+        for (ULONG t = 0; t < threadCount; t++) {
+            threads[t].PebCommandLine = NULL;
+            threads[t].PebImagePath = NULL;
+        }
+        proc->PID = 42;
+        proc->ThreadCount = threadCount;
+        proc->Threads = threads;
+
+        double t0 = BenchNowNs();
+        MrtTInfo_ReadProcessEnvironment(&reader, proc, MRT_QUERY_ALL, &stats);
+        double dt = BenchNowNs() - t0;
+        if (r == 0 || dt < best)
+            best = dt;
+
+        free(proc->PebCommandLine);
+        free(proc->PebImagePath);
+    }
+
+    wprintf(L"  %5lu threads: %5lu structure reads -> %4lu reader calls  %8.1f us\n",
+            threadCount, stats.Requests, stats.Reads, best / 1e3);
+
+    free(tebs);
+    free(regions);
+    free(proc);
+    free(threads);
+}
+
+#ifdef _WIN32
+// -----------------------------
+// Live snapshot cost per query flag (Windows only)
+// -----------------------------
+static void BenchQueryFlags(void)
+{
+    static const struct { ULONG Flags; const wchar_t* Name; } cases[] = {
+        { MRT_QUERY_COUNTERS,      L"COUNTERS" },
+        { MRT_QUERY_TEB,           L"TEB" },
+        { MRT_QUERY_START_ADDRESS, L"START_ADDRESS" },
+        { MRT_QUERY_PEB,           L"PEB" },
+        { MRT_QUERY_PEB_STRINGS,   L"PEB_STRINGS" },
+        { MRT_QUERY_AFFINITY,      L"AFFINITY" },
+        { MRT_QUERY_ALL,           L"ALL" },
+        { MRT_QUERY_ALL_REMOTE,    L"ALL_REMOTE" },
+    };
+    const int rounds = 10;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        double best = 0;
+        ULONG threads = 0;
+        for (int r = 0; r < rounds; r++) {
+            MRT_PROCESS_INFO* procs = NULL;
+            ULONG count = 0;
+            double t0 = BenchNowNs();
+            if (!NT_SUCCESS(MrtTInfo_GetAllProcessesEx(cases[i].Flags, &procs, &count)))
+                break;
+            double dt = BenchNowNs() - t0;
+            if (r == 0 || dt < best)
+                best = dt;
+            threads = 0;
+            for (ULONG p = 0; p < count; p++)
+                threads += procs[p].ThreadCount;
+            MrtTInfo_FreeProcesses(procs, count);
+        }
+        wprintf(L"  %-14s %9.2f ms  (%lu threads, %.0f ns/thread)\n",
+                cases[i].Name, best / 1e6, threads, threads ? best / threads : 0.0);
+    }
+}
+
+// -----------------------------
+// Collector refresh with and without the thread handle cache
+// -----------------------------
+static void BenchHandleCache(void)
+{
+    const int rounds = 10;
+
+    for (int cached = 0; cached < 2; cached++) {
+        MRT_COLLECTOR* collector = NULL;
+        if (!NT_SUCCESS(MrtTInfo_CollectorCreate(&collector)))
+            return;
+        MrtTInfo_CollectorSetQueryFlags(collector, MRT_QUERY_TEB | MRT_QUERY_START_ADDRESS);
+        if (cached)
+            MrtTInfo_CollectorEnableHandleCache(collector, 65536);
+
+        double best = 0;
+        for (int r = 0; r < rounds; r++) {
+            MRT_PROCESS_INFO* procs = NULL;
+            ULONG count = 0;
+            double t0 = BenchNowNs();
+            if (!NT_SUCCESS(MrtTInfo_CollectorRefresh(collector, &procs, &count)))
+                break;
+            double dt = BenchNowNs() - t0;
+            if (r == 0 || dt < best)
+                best = dt;
+        }
+
+        MRT_HANDLE_CACHE_STATS stats;
+        MrtTInfo_CollectorGetHandleCacheStats(collector, &stats);
+        wprintf(L"  %-10s %9.2f ms  (hits %llu, misses %llu, evictions %llu, open %lu)\n",
+                cached ? L"cached" : L"uncached", best / 1e6,
+                stats.Hits, stats.Misses, stats.Evictions, stats.OpenHandles);
+        MrtTInfo_CollectorDestroy(collector);
+    }
+}
+#endif
+
+#ifdef __linux__
+// -----------------------------
+// Live /proc scan: raw provider query and full refresh through a collector
+// -----------------------------
+static void BenchProcfs(void)
+{
+    MRT_COLLECTOR* collector = NULL;
+    if (!NT_SUCCESS(MrtTInfo_CollectorCreate(&collector)))
+        return;
+    MrtTInfo_CollectorSetQueryFlags(collector, MRT_QUERY_COUNTERS);
+
+    const int rounds = 10;
+    double bestQuery = 0, bestRefresh = 0;
+    ULONG processes = 0, threads = 0;
+    for (int r = 0; r < rounds; r++) {
+        const void* raw = NULL;
+        ULONG length = 0;
+        double t0 = BenchNowNs();
+        NTSTATUS status = MrtTInfo_CollectorQueryRaw(collector, &raw, &length);
+        double dt = BenchNowNs() - t0;
+        if (!NT_SUCCESS(status)) {
+            wprintf(L"  /proc query failed (NTSTATUS 0x%08X)\n", status);
+            break;
+        }
+        if (r == 0 || dt < bestQuery)
+            bestQuery = dt;
+
+        MRT_PROCESS_INFO* procs = NULL;
+        ULONG count = 0;
+        t0 = BenchNowNs();
+        if (!NT_SUCCESS(MrtTInfo_CollectorRefresh(collector, &procs, &count)))
+            break;
+        dt = BenchNowNs() - t0;
+        if (r == 0 || dt < bestRefresh)
+            bestRefresh = dt;
+
+        processes = count;
+        threads = 0;
+        for (ULONG p = 0; p < count; p++)
+            threads += procs[p].ThreadCount;
+    }
+
+    wprintf(L"  %lu processes, %lu threads: query %.2f ms, refresh %.2f ms  (%.0f ns/thread)\n",
+            processes, threads, bestQuery / 1e6, bestRefresh / 1e6,
+            threads ? bestRefresh / threads : 0.0);
+
+    MRT_STRING_POOL_STATS strings;
+    MrtTInfo_CollectorGetStringPoolStats(collector, &strings);
+    wprintf(L"  image names: %lu distinct, %zu bytes, %llu reused / %llu copied\n",
+            strings.Strings, strings.Bytes, strings.Hits, strings.Misses);
+
+    MrtTInfo_CollectorDestroy(collector);
+}
+
+// -----------------------------
+// Instrumentation totals of every snapshot the bench built
+// -----------------------------
+// Upper bound of the histogram bucket holding the given fraction of samples
+static double BenchBucketPercentile(const MRT_PHASE_STATS* ps, double fraction)
+{
+    ULONGLONG wanted = (ULONGLONG)(ps->Count * fraction);
+    ULONGLONG seen = 0;
+    for (ULONG b = 0; b < MRT_STATS_BUCKETS; b++) {
+        seen += ps->Histogram[b];
+        if (seen > wanted)
+            return (double)(2ULL << b);
+    }
+    return (double)ps->MaxNs;
+}
+
+static void BenchStats(void)
+{
+    static const wchar_t* const phases[MRT_PHASE_COUNT] = {
+        L"snapshot", L"query", L"convert", L"enrich", L"remote", L"strings"
+    };
+
+    MRT_STATS stats;
+    NTSTATUS status = MrtTInfo_GetStats(&stats);
+    if (!NT_SUCCESS(status)) {
+        wprintf(L"  not available (NTSTATUS 0x%08X, built with STATS=0?)\n", status);
+        return;
+    }
+
+    const MRT_STATS_COUNTERS* t = &stats.Totals;
+    wprintf(L"  %llu snapshots (%llu failed), %llu queries, %llu retries, last buffer %lu of %lu bytes\n",
+            t->Snapshots, t->Failures, t->Queries, t->QueryRetries,
+            stats.QueryLength, stats.QueryBufferSize);
+    wprintf(L"  handles %llu opened / %llu failed / %llu reused, %llu calls, %llu threads not enriched\n",
+            t->HandlesOpened, t->HandlesFailed, t->HandlesReused, t->EnrichCalls, t->EnrichSkipped);
+    wprintf(L"  %llu remote reads (%llu failed), %llu allocations (%llu MB), strings %llu copied / %llu shared\n",
+            t->RemoteReads, t->RemoteFailures, t->Allocations, t->BytesAllocated >> 20,
+            t->StringsCopied, t->StringsShared);
+    for (ULONG ph = 0; ph < MRT_PHASE_COUNT; ph++) {
+        const MRT_PHASE_STATS* ps = &stats.Phases[ph];
+        if (!ps->Count)
+            continue;
+        wprintf(L"    %-8ls %7llu runs  mean %10.1f us  p50 < %10.1f us  p99 < %10.1f us  max %10.1f us\n",
+                phases[ph], ps->Count, ps->TotalNs / 1e3 / ps->Count,
+                BenchBucketPercentile(ps, 0.5) / 1e3, BenchBucketPercentile(ps, 0.99) / 1e3,
+                ps->MaxNs / 1e3);
+    }
+}
+#endif
+
+// Usage: MrtTInfoBench [recording]   (recording from MrtTInfo_RecordRawBuffer)
+int main(int argc, char** argv)
+{
+    wprintf(L"[MrtTInfo Bench]\n\n");
+
+    wprintf(L"Lookup (ns per lookup, build in ns, crossover in lookups)\n");
+    static const ULONG sizes[][2] = {
+        { 8, 4 }, { 32, 8 }, { 128, 8 }, { 512, 16 }, { 2048, 16 }, { 8192, 12 }
+    };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        BenchLookups(sizes[i][0], sizes[i][1]);
+
+    wprintf(L"\nStart address symbolisation\n");
+    BenchSymbols(64, 256, 8);
+    BenchSymbols(300, 500, 20);
+    BenchSymbols(2000, 1000, 50);
+
+    wprintf(L"\nTop-N and group-by over thread context switches\n");
+    BenchTopN(500, 20, 20);
+    BenchTopN(2000, 50, 20);
+    BenchTopN(2000, 50, 200);
+
+    wprintf(L"\nThread counter scans: records vs columns (best of 20)\n");
+    BenchColumns(500, 20);
+    BenchColumns(2000, 50);
+
+    wprintf(L"\nRemote TEB/PEB parsing through the page cache (fake reader, best of 20)\n");
+    BenchRemote(8);
+    BenchRemote(64);
+    BenchRemote(512);
+
+    wprintf(L"\nGenerated buffer: convert, index, lookup (ns), free, format (us unless noted)\n");
+    BenchPipeline(5, 20);
+    BenchPipeline(50, 20);
+    BenchPipeline(250, 40);
+    BenchPipeline(2000, 50);
+
+    wprintf(L"\nRefresher: tick (us), Acquire+Release (ns) alone and during 1 ms refreshes\n");
+    BenchRefresher(50, 20);
+    BenchRefresher(2000, 50);
+
+    wprintf(L"\nSampler: manual tick (us) over two alternating buffers\n");
+    BenchSampler(50, 20);
+    BenchSampler(2000, 50);
+
+    wprintf(L"\nSnapshot export: main.c-style fwprintf vs CSV / NDJSON exporters (best of 10)\n");
+    BenchExport(50, 20);
+    BenchExport(2000, 50);
+
+    wprintf(L"\nProcess tree: CSR build, subtree rollup of 3 fields vs ancestor walks (best of 20)\n");
+    BenchTree(500);
+    BenchTree(5000);
+    BenchTree(50000);
+
+    if (argc > 1) {
+        wprintf(L"\nReplayed conversion (best of 50)\n");
+        BenchReplay(argv[1]);
+    }
+
+#ifdef _WIN32
+    wprintf(L"\nLive snapshot by query flag (best of 10)\n");
+    BenchQueryFlags();
+
+    wprintf(L"\nCollector refresh, TEB+START_ADDRESS (best of 10)\n");
+    BenchHandleCache();
+#endif
+#ifdef __linux__
+    wprintf(L"\nLive /proc snapshot (best of 10)\n");
+    BenchProcfs();
+#endif
+
+    wprintf(L"\nInstrumentation totals (MrtTInfo_GetStats)\n");
+    BenchStats();
+
+    wprintf(L"\nDone.\n");
+    return 0;
+}
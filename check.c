@@ -0,0 +1,1815 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+#include "MrtTInfo.h"
+#include "MrtTInfoInternal.h"     // worker pool, MrtCursor_Validate
+
+// -----------------------------
+// Check helpers
+// -----------------------------
+static ULONG g_Checks;
+static ULONG g_Failures;
+
+static void CheckResult(BOOL ok, const char* expr, int line)
+{
+    g_Checks++;
+    if (!ok) {
+        g_Failures++;
+        wprintf(L"  FAILED line %d: %hs\n", line, expr);
+    }
+}
+
+#define CHECK(cond) CheckResult((cond) ? TRUE : FALSE, #cond, __LINE__)
+
+static BOOL CheckSameString(const wchar_t* a, const wchar_t* b)
+{
+    return a && b && wcscmp(a, b) == 0;
+}
+
+static BOOL CheckSameName(const UNICODE_STRING* a, const UNICODE_STRING* b)
+{
+    if (a->Length != b->Length)
+        return FALSE;
+    return a->Length == 0 || (a->Buffer && b->Buffer && memcmp(a->Buffer, b->Buffer, a->Length) == 0);
+}
+
+// Every counter, every thread record and the image name of two conversions
+static BOOL CheckSameProcesses(const MRT_PROCESS_INFO* a, ULONG countA, const MRT_PROCESS_INFO* b, ULONG countB)
+{
+    if (countA != countB)
+        return FALSE;
+
+    for (ULONG i = 0; i < countA; i++) {
+        const MRT_PROCESS_INFO* p = &a[i];
+        const MRT_PROCESS_INFO* q = &b[i];
+        if (p->PID != q->PID || p->ParentPID != q->ParentPID || !CheckSameName(&p->ImageName, &q->ImageName) ||
+            memcmp(&p->CreateTime, &q->CreateTime, sizeof(FILETIME)) != 0 ||
+            p->UserTime.QuadPart != q->UserTime.QuadPart || p->KernelTime.QuadPart != q->KernelTime.QuadPart ||
+            p->WorkingSetSize != q->WorkingSetSize || p->VirtualSize != q->VirtualSize ||
+            p->PeakWorkingSetSize != q->PeakWorkingSetSize || p->PrivatePageCount != q->PrivatePageCount ||
+            p->PageFaultCount != q->PageFaultCount || p->HandleCount != q->HandleCount ||
+            p->SessionId != q->SessionId || p->HardFaultCount != q->HardFaultCount ||
+            p->PeakVirtualSize != q->PeakVirtualSize || p->CycleTime != q->CycleTime ||
+            p->BasePriority != q->BasePriority ||
+            memcmp(&p->IoCounters, &q->IoCounters, sizeof(IO_COUNTERS)) != 0 ||
+            p->ThreadCount != q->ThreadCount)
+            return FALSE;
+
+        for (ULONG t = 0; t < p->ThreadCount; t++) {
+            const MRT_THREAD_INFO* x = &p->Threads[t];
+            const MRT_THREAD_INFO* y = &q->Threads[t];
+            if (x->TID != y->TID || x->ParentPID != y->ParentPID ||
+                memcmp(&x->CreateTime, &y->CreateTime, sizeof(FILETIME)) != 0 ||
+                x->KernelTime.QuadPart != y->KernelTime.QuadPart || x->UserTime.QuadPart != y->UserTime.QuadPart ||
+                x->BasePriority != y->BasePriority || x->Priority != y->Priority ||
+                x->ContextSwitches != y->ContextSwitches || x->ThreadState != y->ThreadState ||
+                x->WaitReason != y->WaitReason || x->StartAddress != y->StartAddress ||
+                x->TebAddress != y->TebAddress)
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static BOOL CheckWriteBytes(const char* path, const void* data, SIZE_T size)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return FALSE;
+    BOOL ok = fwrite(data, 1, size, f) == size;
+    return fclose(f) == 0 && ok;
+}
+
+// Whole file into a heap buffer
+static BYTE* CheckReadBytes(const char* path, SIZE_T* size)
+{
+    *size = 0;
+    FILE* f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+
+    BYTE* data = NULL;
+    long end = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (end > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = (BYTE*)malloc((SIZE_T)end);
+        if (data && fread(data, 1, (SIZE_T)end, f) != (SIZE_T)end) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    if (data)
+        *size = (SIZE_T)end;
+    return data;
+}
+
+// -----------------------------
+// Remote TEB/PEB parsing (fake reader)
+// -----------------------------
+#define CHECK_PAGE 0x1000
+
+// Three TEBs on adjacent pages, one page of TLS arrays, the PEB with its
+// loader data on one page, the process parameters with both strings on another
+static void CheckRemote(void)
+{
+    const ULONG_PTR tebBase = (ULONG_PTR)0x10000000;
+    const ULONG_PTR tlsBase = tebBase + 0x10000;
+    const ULONG_PTR pebBase = tebBase + 0x20000;
+    const ULONG_PTR ldrBase = pebBase + 0x800;
+    const ULONG_PTR paramsBase = tebBase + 0x30000;
+    static const wchar_t commandLine[] = L"svchost.exe -k netsvcs -p";
+    static const wchar_t imagePath[] = L"C:\\Windows\\System32\\svchost.exe";
+    enum { threadCount = 3, tlsStride = 0x400 };
+
+    static TEB_PARTIAL tebs[threadCount];
+    static PVOID tls[threadCount][tlsStride / sizeof(PVOID)];
+    PEB_PARTIAL peb;
+    PEB_LDR_DATA ldr;
+    RTL_USER_PROCESS_PARAMETERS params;
+    memset(tebs, 0, sizeof(tebs));
+    memset(tls, 0, sizeof(tls));
+    memset(&peb, 0, sizeof(peb));
+    memset(&ldr, 0, sizeof(ldr));
+    memset(&params, 0, sizeof(params));
+
+    peb.Ldr = (PVOID)ldrBase;
+    peb.ProcessParameters = (PVOID)paramsBase;
+    peb.SessionId = 3;
+    ldr.EntryInProgress = (PVOID)(ULONG_PTR)0x7FF00000;
+    params.CommandLine.Length = (USHORT)(wcslen(commandLine) * sizeof(WCHAR));
+    params.CommandLine.Buffer = (PWSTR)(paramsBase + 0x400);
+    params.ImagePathName.Length = (USHORT)(wcslen(imagePath) * sizeof(WCHAR));
+    params.ImagePathName.Buffer = (PWSTR)(paramsBase + 0x600);
+
+    MRT_MEMORY_REGION regions[threadCount + 6];
+    ULONG regionCount = 0;
+    for (ULONG t = 0; t < threadCount; t++) {
+        tebs[t].NtTib.StackBase = (PVOID)(ULONG_PTR)(0x500000 + t * 0x100000);
+        tebs[t].NtTib.StackLimit = (PVOID)(ULONG_PTR)(0x4F0000 + t * 0x100000);
+        tebs[t].ThreadLocalStoragePointer = (PVOID)(tlsBase + t * tlsStride);
+        tebs[t].ProcessEnvironmentBlock = (PVOID)pebBase;
+        for (ULONG s = 0; s <= t; s++)
+            tls[t][s * 7] = (PVOID)(ULONG_PTR)(0x1000 + s);
+        regions[regionCount++] = (MRT_MEMORY_REGION){ 0, tebBase + t * CHECK_PAGE, &tebs[t], sizeof(TEB_PARTIAL) };
+    }
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, tlsBase, tls, sizeof(tls) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, pebBase, &peb, sizeof(peb) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, ldrBase, &ldr, sizeof(ldr) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, paramsBase, &params, sizeof(params) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, paramsBase + 0x400, commandLine, sizeof(commandLine) };
+    regions[regionCount++] = (MRT_MEMORY_REGION){ 0, paramsBase + 0x600, imagePath, sizeof(imagePath) };
+
+    MRT_FAKE_MEMORY memory = { regions, regionCount, 0, 0 };
+    MRT_MEMORY_READER reader;
+    MrtTInfo_FakeReaderInit(&memory, &reader);
+
+    MRT_THREAD_INFO threads[threadCount];
+    MRT_PROCESS_INFO proc;
+    memset(threads, 0, sizeof(threads));
+    memset(&proc, 0, sizeof(proc));
+    proc.PID = 42;
+    proc.ThreadCount = threadCount;
+    proc.Threads = threads;
+    for (ULONG t = 0; t < threadCount; t++) {
+        threads[t].TID = 100 + t;
+        // Listed in reverse address order: parsing sorts them
+        threads[t].TebAddress = (PVOID)(tebBase + (threadCount - 1 - t) * CHECK_PAGE);
+    }
+
+    MRT_REMOTE_STATS stats;
+    memset(&stats, 0, sizeof(stats));
+    CHECK(MrtTInfo_ReadProcessEnvironment(&reader, &proc, MRT_QUERY_ALL_REMOTE, &stats) == STATUS_SUCCESS);
+
+    for (ULONG t = 0; t < threadCount; t++) {
+        const MRT_THREAD_INFO* mt = &threads[t];
+        ULONG image = threadCount - 1 - t;
+        CHECK(mt->StackBase == tebs[image].NtTib.StackBase);
+        CHECK(mt->StackLimit == tebs[image].NtTib.StackLimit);
+        CHECK(mt->TLSSlotCount == image + 1);
+        CHECK(mt->PebAddress == (PVOID)pebBase);
+        CHECK(mt->PebLdr == (PVOID)ldrBase);
+        CHECK(mt->PebLdr_EntryInProgress == ldr.EntryInProgress);
+        CHECK(mt->PebSessionId == 3);
+        CHECK(mt->PebCommandLine == proc.PebCommandLine);
+        CHECK(mt->PebImagePath == proc.PebImagePath);
+    }
+    CHECK(CheckSameString(proc.PebCommandLine, commandLine));
+    CHECK(CheckSameString(proc.PebImagePath, imagePath));
+
+    // 3 TEBs, 3 TLS arrays, PEB, loader data, parameters, 2 strings; the TEB
+    // pages come in one run, the rest from one page each
+    CHECK(stats.Processes == 1);
+    CHECK(stats.Requests == 11);
+    CHECK(stats.Reads == 4);
+    CHECK(stats.Failures == 0);
+    CHECK(memory.Reads == 4);
+    CHECK(memory.BytesRead == 6 * CHECK_PAGE);
+    free(proc.PebCommandLine);
+    free(proc.PebImagePath);
+
+    // Unmapped PEB: the TEB fields survive, nothing of the PEB is filled
+    tebs[0].ThreadLocalStoragePointer = NULL;
+    tebs[0].ProcessEnvironmentBlock = (PVOID)(tebBase + 0x80000);
+    memset(threads, 0, sizeof(threads));
+    memset(&proc, 0, sizeof(proc));
+    memset(&stats, 0, sizeof(stats));
+    memory.Reads = 0;
+    memory.BytesRead = 0;
+    proc.PID = 42;
+    proc.ThreadCount = 1;
+    proc.Threads = threads;
+    threads[0].TebAddress = (PVOID)tebBase;
+
+    CHECK(MrtTInfo_ReadProcessEnvironment(&reader, &proc, MRT_QUERY_ALL_REMOTE, &stats) == STATUS_SUCCESS);
+    CHECK(threads[0].StackBase == tebs[0].NtTib.StackBase);
+    CHECK(threads[0].PebAddress == tebs[0].ProcessEnvironmentBlock);
+    CHECK(threads[0].PebLdr == NULL);
+    CHECK(threads[0].PebCommandLine == NULL);
+    CHECK(proc.PebAddress == NULL);
+    CHECK(proc.PebCommandLine == NULL && proc.PebImagePath == NULL);
+    CHECK(stats.Requests == 2);
+    CHECK(stats.Reads == 2);
+    CHECK(stats.Failures == 1);
+    CHECK(memory.Reads == 2);
+    CHECK(memory.BytesRead == CHECK_PAGE);
+
+    // Truncated PEB: its first bytes end a mapped page, the rest is unmapped
+    const ULONG_PTR cutPeb = tebBase + 0x50000 - 16;
+    regions[threadCount + 1] = (MRT_MEMORY_REGION){ 0, cutPeb, &peb, 16 };
+    tebs[0].ProcessEnvironmentBlock = (PVOID)cutPeb;
+    memset(threads, 0, sizeof(threads));
+    memset(&proc, 0, sizeof(proc));
+    memset(&stats, 0, sizeof(stats));
+    memory.Reads = 0;
+    memory.BytesRead = 0;
+    proc.PID = 42;
+    proc.ThreadCount = 1;
+    proc.Threads = threads;
+    threads[0].TebAddress = (PVOID)tebBase;
+
+    CHECK(MrtTInfo_ReadProcessEnvironment(&reader, &proc, MRT_QUERY_ALL_REMOTE, &stats) == STATUS_SUCCESS);
+    CHECK(threads[0].StackLimit == tebs[0].NtTib.StackLimit);
+    CHECK(threads[0].PebLdr == NULL);
+    CHECK(threads[0].PebSessionId == 0);
+    CHECK(proc.PebAddress == NULL);
+    CHECK(proc.PebCommandLine == NULL);
+    CHECK(stats.Requests == 2);
+    CHECK(stats.Reads == 3);
+    CHECK(stats.Failures == 1);
+    CHECK(memory.Reads == 3);
+    CHECK(memory.BytesRead == 2 * CHECK_PAGE);
+}
+
+// -----------------------------
+// Snapshot files and raw recordings
+// -----------------------------
+#define CHECK_SNAPSHOT_PATH "MrtTInfoCheck.snap"
+#define CHECK_RAW_PATH      "MrtTInfoCheck.raw"
+
+// Offsets into the raw recording header (MrtTInfoSnapshot.c)
+#define CHECK_RAW_VERSION      4
+#define CHECK_RAW_POINTER_SIZE 12
+
+static wchar_t* CheckCopyString(const wchar_t* s)
+{
+    wchar_t* copy = (wchar_t*)malloc((wcslen(s) + 1) * sizeof(wchar_t));
+    if (copy)
+        wcscpy(copy, s);
+    return copy;
+}
+
+// A string table entry against the host string it was written from
+static BOOL CheckSnapshotString(const MRT_SNAPSHOT_VIEW* view, ULONG offset, ULONG length, const wchar_t* s, SIZE_T n)
+{
+    if (!s || n == 0)
+        return offset == MRT_SNAPSHOT_NO_STRING && length == 0;
+
+    const USHORT* u = MrtTInfo_SnapshotString(view, offset, length);
+    if (!u)
+        return FALSE;
+
+    ULONG k = 0;
+    for (SIZE_T i = 0; i < n; i++) {
+        ULONG c = (ULONG)s[i];
+        if (c > 0xFFFF) {
+            c -= 0x10000;
+            if (k + 2 > length || u[k] != 0xD800 + (c >> 10) || u[k + 1] != 0xDC00 + (c & 0x3FF))
+                return FALSE;
+            k += 2;
+        } else {
+            if (k >= length || u[k] != c)
+                return FALSE;
+            k++;
+        }
+    }
+    return k == length && u[k] == 0;
+}
+
+static BOOL CheckSnapshotMatches(const MRT_SNAPSHOT_VIEW* view, const MRT_PROCESS_INFO* procs, ULONG count)
+{
+    if (view->ProcessCount != count)
+        return FALSE;
+
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* p = &procs[i];
+        const MRT_SNAPSHOT_PROCESS* r = &view->Processes[i];
+        if (r->PID != p->PID || r->ParentPID != p->ParentPID ||
+            r->CreateTime != (((ULONGLONG)p->CreateTime.dwHighDateTime << 32) | p->CreateTime.dwLowDateTime) ||
+            r->UserTime != p->UserTime.QuadPart || r->KernelTime != p->KernelTime.QuadPart ||
+            r->CycleTime != p->CycleTime || r->WorkingSetSize != p->WorkingSetSize ||
+            r->VirtualSize != p->VirtualSize || r->PeakWorkingSetSize != p->PeakWorkingSetSize ||
+            r->PrivatePageCount != p->PrivatePageCount || r->PageFaultCount != p->PageFaultCount ||
+            r->PeakVirtualSize != p->PeakVirtualSize ||
+            memcmp(&r->IoCounters, &p->IoCounters, sizeof(IO_COUNTERS)) != 0 ||
+            r->HandleCount != p->HandleCount || r->SessionId != p->SessionId ||
+            r->HardFaultCount != p->HardFaultCount || r->BasePriority != p->BasePriority ||
+            r->ThreadCount != p->ThreadCount ||
+            !CheckSnapshotString(view, r->ImageName, r->ImageNameLength,
+                                 p->ImageName.Buffer, p->ImageName.Length / sizeof(WCHAR)))
+            return FALSE;
+
+        const MRT_SNAPSHOT_THREAD* threads = MrtTInfo_SnapshotThreads(view, r);
+        if (!threads && r->ThreadCount)
+            return FALSE;
+        for (ULONG t = 0; t < p->ThreadCount; t++) {
+            const MRT_THREAD_INFO* mt = &p->Threads[t];
+            const MRT_SNAPSHOT_THREAD* tr = &threads[t];
+            const wchar_t* cmd = mt->PebCommandLine;
+            const wchar_t* path = mt->PebImagePath;
+            if (tr->TID != mt->TID || tr->PID != mt->ParentPID ||
+                tr->CreateTime != (((ULONGLONG)mt->CreateTime.dwHighDateTime << 32) | mt->CreateTime.dwLowDateTime) ||
+                tr->KernelTime != mt->KernelTime.QuadPart || tr->UserTime != mt->UserTime.QuadPart ||
+                tr->StartAddress != (ULONG_PTR)mt->StartAddress || tr->TebAddress != (ULONG_PTR)mt->TebAddress ||
+                tr->BasePriority != mt->BasePriority || tr->Priority != mt->Priority ||
+                tr->ContextSwitches != mt->ContextSwitches || tr->ThreadState != mt->ThreadState ||
+                tr->WaitReason != mt->WaitReason ||
+                !CheckSnapshotString(view, tr->CommandLine, tr->CommandLineLength, cmd, cmd ? wcslen(cmd) : 0) ||
+                !CheckSnapshotString(view, tr->ImagePath, tr->ImagePathLength, path, path ? wcslen(path) : 0))
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void CheckSnapshotRejects(const BYTE* image, SIZE_T size, SIZE_T keep, ULONG patchOffset, USHORT patch, NTSTATUS expected)
+{
+    BYTE* copy = (BYTE*)malloc(size);
+    if (!copy) {
+        CHECK(copy != NULL);
+        return;
+    }
+    memcpy(copy, image, size);
+    if (patchOffset != (ULONG)-1)
+        memcpy(copy + patchOffset, &patch, sizeof(patch));
+
+    MRT_SNAPSHOT_VIEW view;
+    CHECK(CheckWriteBytes(CHECK_SNAPSHOT_PATH, copy, keep));
+    CHECK(MrtTInfo_SnapshotOpen(CHECK_SNAPSHOT_PATH, &view) == expected);
+    CHECK(view.Processes == NULL && view.Mapping == NULL);
+    free(copy);
+}
+
+static void CheckRawRejects(const BYTE* image, SIZE_T size, SIZE_T keep, ULONG patchOffset, USHORT patch, NTSTATUS expected)
+{
+    BYTE* copy = (BYTE*)malloc(size);
+    if (!copy) {
+        CHECK(copy != NULL);
+        return;
+    }
+    memcpy(copy, image, size);
+    if (patchOffset != (ULONG)-1)
+        memcpy(copy + patchOffset, &patch, sizeof(patch));
+
+    void* loaded = (void*)copy;
+    ULONG length = 1;
+    CHECK(CheckWriteBytes(CHECK_RAW_PATH, copy, keep));
+    CHECK(MrtTInfo_LoadRawBuffer(CHECK_RAW_PATH, &loaded, &length) == expected);
+    CHECK(loaded == NULL && length == 0);
+    free(copy);
+}
+
+static void CheckSnapshots(ULONG processCount, ULONG threadsPerProcess)
+{
+    void* raw = NULL;
+    ULONG rawLength = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 7, &raw, &rawLength))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+
+    MRT_PROCESS_INFO* procs = NULL;
+    ULONG count = 0;
+    CHECK(MrtTInfo_SetReplayBuffer(raw, rawLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_GetAllProcesses(&procs, &count) == STATUS_SUCCESS);
+    CHECK(count == processCount);
+
+    // Replay never queries affinity: processor numbers stay unknown, not 0
+    BOOL unknown = TRUE;
+    for (ULONG i = 0; i < count; i++) {
+        for (ULONG t = 0; t < procs[i].ThreadCount; t++) {
+            unknown = unknown && procs[i].Threads[t].IdealProcessor == (ULONG)-1 &&
+                procs[i].Threads[t].CurrentProcessor == (ULONG)-1;
+        }
+    }
+    CHECK(unknown);
+
+    // Raw recording: load relocates the names, replay converts the same records
+    void* loaded = NULL;
+    ULONG loadedLength = 0;
+    MRT_PROCESS_INFO* replayed = NULL;
+    ULONG replayedCount = 0;
+    CHECK(MrtTInfo_RecordRawBuffer(CHECK_RAW_PATH, raw, rawLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_LoadRawBuffer(CHECK_RAW_PATH, &loaded, &loadedLength) == STATUS_SUCCESS);
+    CHECK(loaded != raw && loadedLength >= rawLength);
+    CHECK(MrtTInfo_SetReplayBuffer(loaded, loadedLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_GetAllProcesses(&replayed, &replayedCount) == STATUS_SUCCESS);
+    CHECK(CheckSameProcesses(procs, count, replayed, replayedCount));
+    MrtTInfo_FreeProcesses(replayed, replayedCount);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+
+    SIZE_T recordingSize = 0;
+    BYTE* recording = CheckReadBytes(CHECK_RAW_PATH, &recordingSize);
+    CHECK(recording != NULL);
+    if (recording) {
+        USHORT pointerSize = sizeof(void*) == 8 ? 4 : 8;
+        CheckRawRejects(recording, recordingSize, recordingSize - 64, (ULONG)-1, 0, STATUS_DATA_ERROR);
+        CheckRawRejects(recording, recordingSize, 16, (ULONG)-1, 0, STATUS_INVALID_IMAGE_FORMAT);
+        CheckRawRejects(recording, recordingSize, recordingSize, 0, 0, STATUS_INVALID_IMAGE_FORMAT);
+        CheckRawRejects(recording, recordingSize, recordingSize, CHECK_RAW_VERSION, 2, STATUS_REVISION_MISMATCH);
+        CheckRawRejects(recording, recordingSize, recordingSize, CHECK_RAW_POINTER_SIZE, pointerSize, STATUS_REVISION_MISMATCH);
+        free(recording);
+    }
+    MrtTInfo_FreeRawBuffer(loaded);
+
+    // Fields the replayed counters leave zero, and PEB strings: shared by every
+    // thread, on every other thread only, and one outside the BMP
+    for (ULONG i = 0; i < count; i++) {
+        MRT_PROCESS_INFO* p = &procs[i];
+        p->CycleTime = (ULONGLONG)i * 1000003;
+        p->HardFaultCount = i * 3;
+        p->IoCounters.ReadOperationCount = i;
+        p->IoCounters.OtherTransferCount = (ULONGLONG)i << 20;
+        if (i % 3 == 0)
+            continue;
+        p->PebCommandLine = CheckCopyString(i % 3 == 1 ? L"svchost.exe -k netsvcs" : L"emoji \U0001F600 -q");
+        p->PebImagePath = CheckCopyString(L"C:\\Windows\\System32\\svchost.exe");
+        for (ULONG t = 0; t < p->ThreadCount; t++) {
+            MRT_THREAD_INFO* mt = &p->Threads[t];
+            mt->TebAddress = (PVOID)(ULONG_PTR)(0x7FF000000000ULL + (ULONGLONG)mt->TID * 0x2000);
+            if (i % 3 == 1 || t % 2 == 0) {
+                mt->PebCommandLine = p->PebCommandLine;
+                mt->PebImagePath = p->PebImagePath;
+            }
+        }
+    }
+
+    MRT_SNAPSHOT_VIEW view;
+    CHECK(MrtTInfo_SnapshotWrite(procs, count, CHECK_SNAPSHOT_PATH) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_SnapshotOpen(CHECK_SNAPSHOT_PATH, &view) == STATUS_SUCCESS);
+    CHECK(view.ThreadCount == processCount * threadsPerProcess);
+    CHECK(CheckSnapshotMatches(&view, procs, count));
+    MrtTInfo_SnapshotClose(&view);
+
+    SIZE_T imageSize = 0;
+    BYTE* image = CheckReadBytes(CHECK_SNAPSHOT_PATH, &imageSize);
+    CHECK(image != NULL);
+    if (image) {
+        CheckSnapshotRejects(image, imageSize, imageSize - 8, (ULONG)-1, 0, STATUS_DATA_ERROR);
+        CheckSnapshotRejects(image, imageSize, sizeof(MRT_SNAPSHOT_HEADER) - 1, (ULONG)-1, 0, STATUS_INVALID_IMAGE_FORMAT);
+        CheckSnapshotRejects(image, imageSize, imageSize, 0, 0, STATUS_INVALID_IMAGE_FORMAT);
+        CheckSnapshotRejects(image, imageSize, imageSize, 4, MRT_SNAPSHOT_VERSION + 1, STATUS_REVISION_MISMATCH);
+        free(image);
+    }
+
+    remove(CHECK_SNAPSHOT_PATH);
+    remove(CHECK_RAW_PATH);
+    MrtTInfo_FreeProcesses(procs, count);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Serial vs parallel conversion
+// -----------------------------
+typedef struct _CHECK_POOL_JOB {
+    volatile LONG* Hits;
+    ULONG Chunk;
+    volatile LONG Calls;
+    volatile LONG BadRanges;
+} CHECK_POOL_JOB;
+
+static void CheckPoolRange(void* ctx, ULONG begin, ULONG end)
+{
+    CHECK_POOL_JOB* job = (CHECK_POOL_JOB*)ctx;
+    (void)MrtAtomic_Add(&job->Calls, 1);
+    if (begin % job->Chunk != 0 || end <= begin || end - begin > job->Chunk)
+        (void)MrtAtomic_Add(&job->BadRanges, 1);
+    for (ULONG i = begin; i < end; i++)
+        (void)MrtAtomic_Add(&job->Hits[i], 1);
+}
+
+// Every item exactly once, in whole chunks; without a pool, or for one chunk
+// or less, as a single inline range
+static void CheckPool(MRT_WORKER_POOL* pool, ULONG items, ULONG chunk)
+{
+    BOOL single = !pool || items <= chunk;
+    volatile LONG* hits = (volatile LONG*)calloc(items + 1, sizeof(LONG));
+    if (!hits) {
+        CHECK(hits != NULL);
+        return;
+    }
+
+    CHECK_POOL_JOB job = { hits, single ? items : chunk, 0, 0 };
+    MrtPool_Run(pool, items, chunk, CheckPoolRange, &job);
+
+    ULONG once = 0;
+    for (ULONG i = 0; i < items; i++)
+        once += hits[i] == 1;
+    CHECK(once == items);
+    CHECK(hits[items] == 0);
+    CHECK(job.BadRanges == 0);
+    CHECK((ULONG)job.Calls == (single ? 1 : (items + chunk - 1) / chunk));
+    free((void*)hits);
+}
+
+static BOOL CheckRefresh(ULONG workers, const void* raw, ULONG rawLength, MRT_COLLECTOR** collector,
+                         MRT_PROCESS_INFO** procs, ULONG* count, MRT_STATS_COUNTERS* delta)
+{
+    MRT_STATS before, after;
+    BOOL stats = NT_SUCCESS(MrtTInfo_GetStats(&before));
+
+    if (!NT_SUCCESS(MrtTInfo_CollectorCreate(collector)))
+        return FALSE;
+    if (!NT_SUCCESS(MrtTInfo_CollectorSetWorkerCount(*collector, workers)) ||
+        !NT_SUCCESS(MrtTInfo_CollectorSetReplayBuffer(*collector, raw, rawLength)) ||
+        !NT_SUCCESS(MrtTInfo_CollectorRefresh(*collector, procs, count)))
+        return FALSE;
+
+    // Counters are process-wide: the difference is this refresh
+    memset(delta, 0, sizeof(*delta));
+    if (stats && NT_SUCCESS(MrtTInfo_GetStats(&after))) {
+        const ULONGLONG* a = (const ULONGLONG*)&after.Totals;
+        const ULONGLONG* b = (const ULONGLONG*)&before.Totals;
+        ULONGLONG* d = (ULONGLONG*)delta;
+        for (SIZE_T k = 0; k < sizeof(MRT_STATS_COUNTERS) / sizeof(ULONGLONG); k++)
+            d[k] = a[k] - b[k];
+    }
+    return TRUE;
+}
+
+static void CheckParallel(ULONG processCount, ULONG threadsPerProcess, ULONG workers)
+{
+    void* raw = NULL;
+    ULONG rawLength = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(processCount, threadsPerProcess, 11, &raw, &rawLength))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+
+    MRT_COLLECTOR* serial = NULL;
+    MRT_COLLECTOR* parallel = NULL;
+    MRT_PROCESS_INFO* a = NULL;
+    MRT_PROCESS_INFO* b = NULL;
+    ULONG countA = 0, countB = 0;
+    MRT_STATS_COUNTERS deltaA, deltaB;
+
+    CHECK(CheckRefresh(1, raw, rawLength, &serial, &a, &countA, &deltaA));
+    CHECK(CheckRefresh(workers, raw, rawLength, &parallel, &b, &countB, &deltaB));
+    CHECK(countA == processCount);
+    CHECK(CheckSameProcesses(a, countA, b, countB));
+    CHECK(memcmp(&deltaA, &deltaB, sizeof(MRT_STATS_COUNTERS)) == 0);
+#if MRT_STATS_ENABLED
+    CHECK(deltaA.Snapshots == 1 && deltaA.Failures == 0);
+#ifndef _WIN32
+    // Nothing to enrich a replayed buffer with off Windows
+    CHECK(deltaA.EnrichSkipped == (ULONGLONG)processCount * threadsPerProcess);
+#endif
+#endif
+
+    MrtTInfo_CollectorDestroy(serial);
+    MrtTInfo_CollectorDestroy(parallel);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Malformed raw buffers
+// -----------------------------
+#define CHECK_CURSOR_ENTRIES 6
+
+typedef struct _CHECK_WALK {
+    ULONG Entries;
+    BOOLEAN Corrupt;
+    NTSTATUS Validate;
+    NTSTATUS Replay;
+} CHECK_WALK;
+
+static CHECK_WALK CheckWalk(const BYTE* buffer, ULONG length)
+{
+    CHECK_WALK walk = { 0, FALSE, STATUS_SUCCESS, STATUS_SUCCESS };
+    MRT_PROCESS_CURSOR cursor;
+    MrtTInfo_CursorInit(&cursor, buffer, length);
+    // Bounded: a chain that never ends is a failure too
+    while (walk.Entries <= CHECK_CURSOR_ENTRIES && MrtTInfo_CursorNext(&cursor))
+        walk.Entries++;
+    walk.Corrupt = cursor.Corrupt;
+    walk.Validate = MrtCursor_Validate(buffer, length);
+    walk.Replay = MrtTInfo_SetReplayBuffer(buffer, length);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+    return walk;
+}
+
+static BOOL CheckRejected(CHECK_WALK walk, ULONG entries)
+{
+    return walk.Entries == entries && walk.Corrupt &&
+           walk.Validate == STATUS_DATA_ERROR && walk.Replay == STATUS_DATA_ERROR;
+}
+
+static void CheckCursor(void)
+{
+    void* raw = NULL;
+    ULONG length = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(CHECK_CURSOR_ENTRIES, 3, 5, &raw, &length))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+
+    // Entries are corrupted in a copy; names still point into the original
+    BYTE* pristine = (BYTE*)raw;
+    BYTE* buffer = (BYTE*)malloc(length);
+    if (!buffer) {
+        CHECK(buffer != NULL);
+        MrtTInfo_FreeRawBuffer(raw);
+        return;
+    }
+    memcpy(buffer, pristine, length);
+
+    ULONG offsets[CHECK_CURSOR_ENTRIES];
+    ULONG entries = 0;
+    MRT_PROCESS_CURSOR cursor;
+    const MRT_SYSTEM_PROCESS_INFORMATION* e;
+    MrtTInfo_CursorInit(&cursor, buffer, length);
+    while (entries < CHECK_CURSOR_ENTRIES && (e = MrtTInfo_CursorNext(&cursor)) != NULL)
+        offsets[entries++] = (ULONG)((const BYTE*)e - buffer);
+    CHECK(entries == CHECK_CURSOR_ENTRIES && !cursor.Corrupt && cursor.Done);
+    CHECK(MrtTInfo_CursorCount(&cursor) == CHECK_CURSOR_ENTRIES);
+
+    CHECK_WALK walk = CheckWalk(buffer, length);
+    CHECK(walk.Entries == CHECK_CURSOR_ENTRIES && !walk.Corrupt &&
+          walk.Validate == STATUS_SUCCESS && walk.Replay == STATUS_SUCCESS);
+
+    MRT_SYSTEM_PROCESS_INFORMATION* second = (MRT_SYSTEM_PROCESS_INFORMATION*)(buffer + offsets[1]);
+    MRT_SYSTEM_PROCESS_INFORMATION* last = (MRT_SYSTEM_PROCESS_INFORMATION*)(buffer + offsets[CHECK_CURSOR_ENTRIES - 1]);
+
+    // Misaligned NextEntryOffset
+    second->NextEntryOffset += 4;
+    CHECK(CheckRejected(CheckWalk(buffer, length), 1));
+    memcpy(buffer, pristine, length);
+
+    // NextEntryOffset past the end, and leaving no room for the next header
+    second->NextEntryOffset = length;
+    CHECK(CheckRejected(CheckWalk(buffer, length), 1));
+    second->NextEntryOffset = (length - offsets[1] - 8) & ~7u;
+    CHECK(CheckRejected(CheckWalk(buffer, length), 1));
+    memcpy(buffer, pristine, length);
+
+    // Loops: the last entry chains back to the first, the second one step back
+    last->NextEntryOffset = 0u - offsets[CHECK_CURSOR_ENTRIES - 1];
+    CHECK(CheckRejected(CheckWalk(buffer, length), CHECK_CURSOR_ENTRIES - 1));
+    second->NextEntryOffset = 0u - (ULONG)sizeof(ULONG_PTR);
+    CHECK(CheckRejected(CheckWalk(buffer, length), 1));
+    memcpy(buffer, pristine, length);
+
+    // Threads overrunning the entry, in the middle and at the end of the chain
+    second->NumberOfThreads = 1000;
+    CHECK(CheckRejected(CheckWalk(buffer, length), 1));
+    memcpy(buffer, pristine, length);
+    last->NumberOfThreads = 0x10000000;
+    CHECK(CheckRejected(CheckWalk(buffer, length), CHECK_CURSOR_ENTRIES - 1));
+    memcpy(buffer, pristine, length);
+
+    // Truncated inside the last thread array, and shorter than one header
+    ULONG cut = offsets[CHECK_CURSOR_ENTRIES - 1] + (ULONG)offsetof(MRT_SYSTEM_PROCESS_INFORMATION, Threads) + 8;
+    CHECK(CheckRejected(CheckWalk(buffer, cut), CHECK_CURSOR_ENTRIES - 1));
+    CHECK(!MrtTInfo_CursorInit(&cursor, buffer, 16) && MrtTInfo_CursorNext(&cursor) == NULL);
+    CHECK(MrtCursor_Validate(buffer, 16) == STATUS_DATA_ERROR);
+
+    // ImageName outside the buffer: the chain is fine, the name is refused
+    MRT_PROCESS_CURSOR bounds;
+    MrtTInfo_CursorInit(&bounds, pristine, length);
+    MRT_SYSTEM_PROCESS_INFORMATION* named = (MRT_SYSTEM_PROCESS_INFORMATION*)(pristine + offsets[2]);
+    UNICODE_STRING name = MrtTInfo_RawImageName(&bounds, named);
+    CHECK(name.Buffer == named->ImageName.Buffer && name.Length == named->ImageName.Length && name.Length > 0);
+
+    PWSTR inside = named->ImageName.Buffer;
+    named->ImageName.Buffer = (PWSTR)(pristine + length);
+    CHECK(MrtTInfo_RawImageName(&bounds, named).Buffer == NULL);
+    named->ImageName.Buffer = (PWSTR)(pristine + length - sizeof(WCHAR));
+    CHECK(MrtTInfo_RawImageName(&bounds, named).Buffer == NULL);
+    named->ImageName.Buffer = (PWSTR)buffer;     // another allocation
+    CHECK(MrtTInfo_RawImageName(&bounds, named).Length == 0);
+    CHECK(MrtCursor_Validate(pristine, length) == STATUS_SUCCESS);
+    named->ImageName.Buffer = inside;
+
+    free(buffer);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Thread states and contention
+// -----------------------------
+static MRT_THREAD_INFO CheckThread(DWORD tid, DWORD pid, ULONG state, ULONG reason)
+{
+    MRT_THREAD_INFO t;
+    memset(&t, 0, sizeof(t));
+    t.TID = tid;
+    t.ParentPID = pid;
+    t.ThreadState = state;
+    t.WaitReason = reason;
+    return t;
+}
+
+static void CheckStates(void)
+{
+    CHECK(strcmp(MrtHelper_WaitReasonToString(11), "WrDelayExecution") == 0);
+    CHECK(strcmp(MrtHelper_WaitReasonToString(19), "WrPageOut") == 0);
+    CHECK(strcmp(MrtHelper_ThreadStateToString(7), "DeferredReady") == 0);
+    CHECK(MrtTInfo_WaitReasonClass(11) == MRT_WAIT_CLASS_OTHER);      // Sleep
+    CHECK(MrtTInfo_WaitReasonClass(12) == MRT_WAIT_CLASS_OTHER);      // WrSuspended
+    CHECK(MrtTInfo_WaitReasonClass(9) == MRT_WAIT_CLASS_PAGING);
+    CHECK(MrtTInfo_WaitReasonClass(18) == MRT_WAIT_CLASS_PAGING);
+    CHECK(MrtTInfo_WaitReasonClass(1000) == MRT_WAIT_CLASS_OTHER);
+
+    // 10: running, sleeping, two paging waits, a user wait, a state and a
+    // reason past the buckets. 20: loader busy. 30: no thread records.
+    MRT_THREAD_INFO oldThreads[] = {
+        CheckThread(100, 10, 2, 0),
+        CheckThread(104, 10, 5, 11),
+        CheckThread(108, 10, 5, 2),
+        CheckThread(112, 10, 5, 19),
+        CheckThread(116, 10, 5, 13),
+        CheckThread(120, 10, 40, 0),
+        CheckThread(124, 10, 5, 200),
+        CheckThread(200, 20, 5, 13),
+        CheckThread(204, 20, 5, 9),
+        CheckThread(208, 20, 1, 0),
+    };
+    oldThreads[7].PebLdr_EntryInProgress = (PVOID)(ULONG_PTR)0x1000;
+
+    MRT_PROCESS_INFO oldProcs[3];
+    memset(oldProcs, 0, sizeof(oldProcs));
+    oldProcs[0].PID = 10;
+    oldProcs[0].Threads = &oldThreads[0];
+    oldProcs[0].ThreadCount = 7;
+    oldProcs[1].PID = 20;
+    oldProcs[1].Threads = &oldThreads[7];
+    oldProcs[1].ThreadCount = 3;
+    oldProcs[2].PID = 30;
+
+    MRT_CONTENTION_REPORT* report = NULL;
+    CHECK(MrtTInfo_ContentionReport(oldProcs, 3, &report) == STATUS_SUCCESS);
+    if (report) {
+        const MRT_STATE_COUNTS* sys = &report->System;
+        CHECK(report->ProcessCount == 3);
+        CHECK(sys->Threads == 10);
+        CHECK(sys->States[5] == 7 && sys->States[2] == 1 && sys->States[1] == 1);
+        CHECK(sys->States[MRT_STATE_BUCKETS - 1] == 1);
+        CHECK(sys->WaitReasons[11] == 1 && sys->WaitReasons[13] == 2);
+        CHECK(sys->WaitReasons[MRT_WAIT_BUCKETS - 1] == 1);
+        CHECK(sys->Classes[MRT_WAIT_CLASS_PAGING] == 3);
+        CHECK(sys->Classes[MRT_WAIT_CLASS_LOADER_LOCK] == 1);
+        CHECK(sys->Classes[MRT_WAIT_CLASS_OTHER] == 3);
+        CHECK(report->Processes[0].Classes[MRT_WAIT_CLASS_LOADER_LOCK] == 0);
+        CHECK(report->Processes[1].Classes[MRT_WAIT_CLASS_LOADER_LOCK] == 1);
+        CHECK(report->Processes[1].Classes[MRT_WAIT_CLASS_PAGING] == 1);
+        CHECK(report->Processes[2].Threads == 0);
+        MrtTInfo_FreeContentionReport(report);
+    }
+
+    // 100 starts sleeping, 104 changes reason, 108 leaves its wait, 112 exits,
+    // 116 and the rest are unchanged, 128 is new and waiting
+    MRT_THREAD_INFO newThreads[] = {
+        CheckThread(100, 10, 5, 11),
+        CheckThread(104, 10, 5, 13),
+        CheckThread(108, 10, 1, 0),
+        CheckThread(116, 10, 5, 13),
+        CheckThread(120, 10, 40, 0),
+        CheckThread(124, 10, 5, 200),
+        CheckThread(128, 10, 5, 9),
+    };
+    MRT_PROCESS_INFO newProcs[1];
+    memset(newProcs, 0, sizeof(newProcs));
+    newProcs[0].PID = 10;
+    newProcs[0].Threads = newThreads;
+    newProcs[0].ThreadCount = 7;
+
+    MRT_SNAPSHOT_DIFF* diff = NULL;
+    CHECK(MrtTInfo_Diff(oldProcs, 1, newProcs, 1, &diff) == STATUS_SUCCESS);
+    if (diff) {
+        MRT_STATE_TRANSITIONS tr;
+        MrtTInfo_StateTransitions(diff, &tr);
+        CHECK(diff->ThreadCount == 5);
+        CHECK(tr.States[2][5] == 1 && tr.States[5][1] == 1);
+        CHECK(tr.States[5][5] == 0);
+        CHECK(tr.EnteredWait[11] == 1 && tr.EnteredWait[13] == 1 && tr.EnteredWait[9] == 0);
+        CHECK(tr.LeftWait[11] == 1 && tr.LeftWait[2] == 1 && tr.LeftWait[19] == 0);
+        CHECK(tr.Created[5] == 1 && tr.Exited[5] == 1);
+
+        ULONG entered = 0, left = 0, moved = 0;
+        for (ULONG w = 0; w < MRT_WAIT_BUCKETS; w++) {
+            entered += tr.EnteredWait[w];
+            left += tr.LeftWait[w];
+        }
+        for (ULONG a = 0; a < MRT_STATE_BUCKETS; a++) {
+            for (ULONG b = 0; b < MRT_STATE_BUCKETS; b++)
+                moved += tr.States[a][b];
+        }
+        CHECK(entered == 2 && left == 2 && moved == 2);     // exits count in Exited only
+        MrtTInfo_FreeDiff(diff);
+    }
+
+    MRT_STATE_TRANSITIONS none;
+    MrtTInfo_StateTransitions(NULL, &none);
+    CHECK(none.Created[0] == 0 && none.States[0][0] == 0);
+}
+
+// -----------------------------
+// Snapshot diff
+// -----------------------------
+static MRT_PROCESS_INFO CheckProcess(DWORD pid, ULONGLONG created, MRT_THREAD_INFO* threads, ULONG threadCount)
+{
+    MRT_PROCESS_INFO p;
+    memset(&p, 0, sizeof(p));
+    p.PID = pid;
+    p.CreateTime.dwLowDateTime = (DWORD)created;
+    p.CreateTime.dwHighDateTime = (DWORD)(created >> 32);
+    p.Threads = threads;
+    p.ThreadCount = threadCount;
+    for (ULONG t = 0; t < threadCount; t++)
+        threads[t].ParentPID = pid;
+    return p;
+}
+
+static const MRT_PROCESS_DELTA* CheckFindDelta(const MRT_SNAPSHOT_DIFF* diff, DWORD pid, DWORD created)
+{
+    for (ULONG i = 0; i < diff->ProcessCount; i++) {
+        const MRT_PROCESS_DELTA* d = &diff->Processes[i];
+        if (d->PID == pid && d->CreateTime.dwLowDateTime == created)
+            return d;
+    }
+    return NULL;
+}
+
+static void CheckDiff(void)
+{
+    // 50 loses its busiest thread and gains one; the two 40s (a reused PID)
+    // are listed in opposite CreateTime order in the two snapshots
+    MRT_THREAD_INFO old50[] = { CheckThread(500, 0, 5, 6), CheckThread(504, 0, 5, 6) };
+    MRT_THREAD_INFO old60[] = { CheckThread(600, 0, 5, 6) };
+    MRT_THREAD_INFO new50[] = { CheckThread(504, 0, 5, 6), CheckThread(508, 0, 2, 0) };
+    MRT_THREAD_INFO new60[] = { CheckThread(600, 0, 5, 6) };
+    old50[0].ContextSwitches = 1000;
+    old50[1].ContextSwitches = 10;
+    old60[0].ContextSwitches = 50;
+    new50[0].ContextSwitches = 30;
+    new50[1].ContextSwitches = 7;
+    new60[0].ContextSwitches = 55;
+
+    MRT_PROCESS_INFO oldProcs[] = {
+        CheckProcess(40, 9, NULL, 0),
+        CheckProcess(40, 5, NULL, 0),
+        CheckProcess(50, 100, old50, 2),
+        CheckProcess(60, 100, old60, 1),
+    };
+    MRT_PROCESS_INFO newProcs[] = {
+        CheckProcess(60, 100, new60, 1),
+        CheckProcess(40, 5, NULL, 0),
+        CheckProcess(50, 100, new50, 2),
+        CheckProcess(40, 9, NULL, 0),
+    };
+    newProcs[1].HandleCount = 1;
+    newProcs[3].HandleCount = 2;
+
+    MRT_SNAPSHOT_DIFF* diff = NULL;
+    CHECK(MrtTInfo_Diff(oldProcs, 4, newProcs, 4, &diff) == STATUS_SUCCESS);
+    if (!diff)
+        return;
+
+    CHECK(diff->ProcessesCreated == 0 && diff->ProcessesExited == 0);
+    CHECK(diff->ThreadsCreated == 1 && diff->ThreadsExited == 1);
+    CHECK(diff->ProcessCount == 4);
+
+    const MRT_PROCESS_DELTA* early = CheckFindDelta(diff, 40, 5);
+    const MRT_PROCESS_DELTA* late = CheckFindDelta(diff, 40, 9);
+    CHECK(early && early->HandleCount == 1 && early->OldIndex == 1 && early->NewIndex == 1);
+    CHECK(late && late->HandleCount == 2 && late->OldIndex == 0 && late->NewIndex == 3);
+
+    // Thread deltas: 504 +20, 508 new +7; 500's last 1000 switches are not lost work
+    const MRT_PROCESS_DELTA* busy = CheckFindDelta(diff, 50, 100);
+    const MRT_PROCESS_DELTA* calm = CheckFindDelta(diff, 60, 100);
+    CHECK(busy && busy->ContextSwitches == 27 && busy->ThreadCount == 0);
+    CHECK(calm && calm->ContextSwitches == 5);
+
+    MRT_TOP_ENTRY top[4];
+    ULONG n = MrtTInfo_TopProcessDeltas(diff, MRT_FIELD_CONTEXT_SWITCHES, 4, top);
+    CHECK(n == 4);
+    CHECK(top[0].Value == 27 && &diff->Processes[top[0].Process] == busy);
+    CHECK(top[1].Value == 5 && &diff->Processes[top[1].Process] == calm);
+    CHECK(top[2].Value == 0 && top[3].Value == 0);
+    MrtTInfo_FreeDiff(diff);
+}
+
+// -----------------------------
+// Sampler
+// -----------------------------
+// Entry i of a raw buffer
+static MRT_SYSTEM_PROCESS_INFORMATION* CheckRawEntry(void* raw, ULONG i)
+{
+    BYTE* p = (BYTE*)raw;
+    while (i--)
+        p += ((MRT_SYSTEM_PROCESS_INFORMATION*)p)->NextEntryOffset;
+    return (MRT_SYSTEM_PROCESS_INFORMATION*)p;
+}
+
+// value / seconds, whatever the measured interval was
+static BOOL CheckRate(double rate, double value, const MRT_SAMPLE* sample)
+{
+    double expected = value / ((double)sample->IntervalNs * 1e-9);
+    double error = rate - expected;
+    return (error < 0 ? -error : error) <= expected * 1e-9;
+}
+
+static void CheckSampler(void)
+{
+    const ULONG depth = 3;
+    void* first = NULL;
+    void* second = NULL;
+    ULONG firstLength = 0, secondLength = 0;
+    MRT_SAMPLER* sampler = NULL;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(20, 4, 3, &first, &firstLength)) ||
+        !NT_SUCCESS(MrtTInfo_GenerateRawBuffer(20, 4, 3, &second, &secondLength)) ||
+        !NT_SUCCESS(MrtTInfo_SamplerCreate(0, depth, &sampler))) {
+        CHECK(!"sampler setup");
+        goto done;
+    }
+
+    // Second buffer: PID 20 ran 2 s kernel and 1 s user, its first thread
+    // (TID 84) 0.5 s and 500 switches; PID 28 is another process with the
+    // same PID, TID 156 another thread with the same TID
+    MRT_SYSTEM_PROCESS_INFORMATION* busy = CheckRawEntry(second, 5);
+    busy->KernelTime.QuadPart += 20000000;
+    busy->UserTime.QuadPart += 10000000;
+    busy->CycleTime += 3000000000ULL;
+    busy->IoCounters.ReadTransferCount += 65536;
+    busy->IoCounters.ReadOperationCount += 4;
+    busy->IoCounters.WriteOperationCount += 2;
+    busy->Threads[0].KernelTime.QuadPart += 5000000;
+    busy->Threads[0].ContextSwitches += 500;
+    CheckRawEntry(second, 7)->CreateTime.QuadPart += 1;
+    CheckRawEntry(second, 9)->Threads[2].CreateTime.QuadPart += 1;
+
+    CHECK(MrtTInfo_SamplerAcquire(sampler, 0) == NULL);
+    CHECK(MrtTInfo_SamplerSetReplayBuffer(sampler, first, firstLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_SamplerTick(sampler) == STATUS_SUCCESS);
+
+    // First sample: everything new, no rates; stays pinned through the ticks below
+    const MRT_SAMPLE* pinned = MrtTInfo_SamplerAcquire(sampler, 0);
+    CHECK(pinned && pinned->Sequence == 1 && pinned->IntervalNs == 0);
+    if (!pinned)
+        goto done;
+    CHECK(pinned->ProcessCount == 20 && pinned->ThreadCount == 80);
+    BOOL allNew = TRUE;
+    for (ULONG i = 0; i < pinned->ProcessCount; i++)
+        allNew = allNew && pinned->Processes[i].New && pinned->Processes[i].KernelCpu == 0.0;
+    for (ULONG i = 0; i < pinned->ThreadCount; i++)
+        allNew = allNew && pinned->Threads[i].New && pinned->Threads[i].ContextSwitchesPerSec == 0.0;
+    CHECK(allNew);
+    MRT_PROCESS_RATE pinnedFirst = pinned->Processes[0];
+
+    CHECK(MrtTInfo_SamplerSetReplayBuffer(sampler, second, secondLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_SamplerTick(sampler) == STATUS_SUCCESS);
+    const MRT_SAMPLE* sample = MrtTInfo_SamplerAcquire(sampler, 0);
+    CHECK(sample && sample->Sequence == 2 && sample->IntervalNs > 0);
+    if (sample) {
+        const MRT_PROCESS_RATE* p = MrtTInfo_SampleFindProcess(sample, 20);
+        CHECK(p && !p->New && p->ThreadCount == 4);
+        CHECK(p && CheckRate(p->KernelCpu, 2.0, sample) && CheckRate(p->UserCpu, 1.0, sample));
+        CHECK(p && CheckRate(p->CyclesPerSec, 3e9, sample) && CheckRate(p->ContextSwitchesPerSec, 500, sample));
+        CHECK(p && CheckRate(p->ReadBytesPerSec, 65536, sample) && CheckRate(p->IoOpsPerSec, 6, sample));
+        CHECK(p && p->WriteBytesPerSec == 0.0);
+
+        const MRT_PROCESS_RATE* idle = MrtTInfo_SampleFindProcess(sample, 24);
+        CHECK(idle && !idle->New && idle->KernelCpu == 0.0 && idle->ContextSwitchesPerSec == 0.0);
+        const MRT_PROCESS_RATE* reused = MrtTInfo_SampleFindProcess(sample, 28);
+        CHECK(reused && reused->New && reused->KernelCpu == 0.0);
+
+        const MRT_THREAD_RATE* t = MrtTInfo_SampleFindThread(sample, 84);
+        CHECK(t && !t->New && t->PID == 20);
+        CHECK(t && CheckRate(t->KernelCpu, 0.5, sample) && CheckRate(t->ContextSwitchesPerSec, 500, sample));
+        const MRT_THREAD_RATE* other = MrtTInfo_SampleFindThread(sample, 156);
+        CHECK(other && other->New && other->ContextSwitchesPerSec == 0.0);
+        CHECK(MrtTInfo_SampleFindThread(sample, 88) && !MrtTInfo_SampleFindThread(sample, 88)->New);
+        CHECK(MrtTInfo_SampleFindProcess(sample, 30) == NULL && MrtTInfo_SampleFindThread(sample, 2) == NULL);
+    }
+    MrtTInfo_SamplerRelease(sampler, sample);
+
+    // Ring: ages up to depth - 1, oldest first out; the pinned sample survives
+    // unchanged however many ticks go by, and the others keep rotating
+    const MRT_SAMPLE* older = MrtTInfo_SamplerAcquire(sampler, 1);
+    CHECK(older == pinned);
+    MrtTInfo_SamplerRelease(sampler, older);
+    CHECK(MrtTInfo_SamplerAcquire(sampler, 2) == NULL);
+
+    MRT_ALLOC_STATS warm, stats;
+    memset(&warm, 0, sizeof(warm));
+    for (ULONG tick = 3; tick <= 12; tick++) {
+        CHECK(MrtTInfo_SamplerSetReplayBuffer(sampler, tick % 2 ? first : second,
+                                              tick % 2 ? firstLength : secondLength) == STATUS_SUCCESS);
+        CHECK(MrtTInfo_SamplerTick(sampler) == STATUS_SUCCESS);
+        if (tick == depth + 1)
+            MrtTInfo_SamplerGetAllocStats(sampler, &warm);
+    }
+    MrtTInfo_SamplerGetAllocStats(sampler, &stats);
+    CHECK(warm.HeapAllocations > 0 && stats.HeapAllocations == warm.HeapAllocations);
+    CHECK(stats.HeapBytes == warm.HeapBytes);
+
+    for (ULONG age = 0; age < depth; age++) {
+        const MRT_SAMPLE* s = MrtTInfo_SamplerAcquire(sampler, age);
+        CHECK(s && s->Sequence == 12 - age && s != pinned);
+        MrtTInfo_SamplerRelease(sampler, s);
+    }
+    CHECK(MrtTInfo_SamplerAcquire(sampler, depth) == NULL);
+    CHECK(pinned->Sequence == 1 && pinned->ProcessCount == 20 &&
+          memcmp(&pinned->Processes[0], &pinnedFirst, sizeof(pinnedFirst)) == 0);
+
+    // Released: the oldest slot, so the next tick writes it
+    MrtTInfo_SamplerRelease(sampler, pinned);
+    BOOL reused = FALSE;
+    for (ULONG tick = 0; tick < depth; tick++)
+        CHECK(MrtTInfo_SamplerTick(sampler) == STATUS_SUCCESS);
+    for (ULONG age = 0; age < depth; age++) {
+        const MRT_SAMPLE* s = MrtTInfo_SamplerAcquire(sampler, age);
+        reused = reused || (s == pinned && s->Sequence == 13);
+        MrtTInfo_SamplerRelease(sampler, s);
+    }
+    CHECK(reused);
+    CHECK(MrtTInfo_SamplerGetLastStatus(sampler) == STATUS_SUCCESS);
+
+done:
+    MrtTInfo_SamplerDestroy(sampler);
+    MrtTInfo_FreeRawBuffer(first);
+    MrtTInfo_FreeRawBuffer(second);
+}
+
+// -----------------------------
+// Process filter
+// -----------------------------
+// '*' and '?' the slow way, folding both sides
+static BOOL CheckGlob(const wchar_t* pattern, const WCHAR* name, ULONG length)
+{
+    if (!*pattern)
+        return length == 0;
+    if (*pattern == L'*')
+        return CheckGlob(pattern + 1, name, length) || (length && CheckGlob(pattern, name + 1, length - 1));
+    return length && (*pattern == L'?' || towlower((wint_t)*pattern) == towlower((wint_t)*name)) &&
+        CheckGlob(pattern + 1, name + 1, length - 1);
+}
+
+static BOOL CheckFilterMatch(const MRT_PROCESS_FILTER* f, const MRT_PROCESS_INFO* p)
+{
+    BOOL pid = f->PidCount == 0;
+    for (ULONG i = 0; i < f->PidCount; i++)
+        pid = pid || f->Pids[i] == p->PID;
+
+    ULONGLONG value = MrtTInfo_GetProcessField(p, f->Field);
+    return pid &&
+        (!f->ImageName || CheckGlob(f->ImageName, p->ImageName.Buffer, p->ImageName.Length / sizeof(WCHAR))) &&
+        (f->SessionId == MRT_ANY_SESSION || p->SessionId == f->SessionId) &&
+        (f->Field == MRT_FIELD_NONE || (value >= f->Min && value <= f->Max));
+}
+
+// The filtered build against the unfiltered one, filtered afterwards;
+// returns how many processes matched
+static ULONG CheckFilter(const MRT_PROCESS_FILTER* f, const MRT_PROCESS_INFO* all, ULONG allCount)
+{
+    MRT_PROCESS_INFO* expected = (MRT_PROCESS_INFO*)malloc((allCount + 1) * sizeof(MRT_PROCESS_INFO));
+    MRT_PROCESS_INFO* filtered = NULL;
+    ULONG expectedCount = 0, filteredCount = 0;
+    if (!expected) {
+        CHECK(!"out of memory");
+        return 0;
+    }
+    for (ULONG i = 0; i < allCount; i++) {
+        if (CheckFilterMatch(f, &all[i]))
+            expected[expectedCount++] = all[i];
+    }
+
+    CHECK(MrtTInfo_GetProcessesFiltered(f, MRT_QUERY_COUNTERS, &filtered, &filteredCount) == STATUS_SUCCESS);
+    CHECK(CheckSameProcesses(filtered, filteredCount, expected, expectedCount));
+    MrtTInfo_FreeProcesses(filtered, filteredCount);
+    free(expected);
+    return expectedCount;
+}
+
+static void CheckFilters(void)
+{
+    void* raw = NULL;
+    ULONG rawLength = 0;
+    MRT_PROCESS_INFO* all = NULL;
+    ULONG allCount = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(600, 3, 13, &raw, &rawLength))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+    CHECK(MrtTInfo_SetReplayBuffer(raw, rawLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_GetAllProcesses(&all, &allCount) == STATUS_SUCCESS);
+    CHECK(allCount == 600);
+
+    MRT_PROCESS_FILTER f;
+    MrtTInfo_FilterInit(&f);
+    CHECK(CheckFilter(&f, all, allCount) == 600);
+
+    // PID set: unsorted, duplicated, one PID past the end, the idle process
+    static const DWORD pids[] = { 40, 8, 40, 2000, 8, 4000, 0, 2396, 2000 };
+    f.Pids = pids;
+    f.PidCount = sizeof(pids) / sizeof(pids[0]);
+    CHECK(CheckFilter(&f, all, allCount) == 5);
+    f.PidCount = 1;
+    CHECK(CheckFilter(&f, all, allCount) == 1);
+    f.Pids = NULL;
+    f.PidCount = 0;
+
+    // Names: exact but folded, '*' anywhere, '?' for one unit, nothing at all
+    static const wchar_t* const names[] = {
+        L"SVCHOST.EXE", L"*HOST*.EXE", L"w*r_??.exe", L"?hrome.*", L"*", L"*.exe", L"runtime*", L"*.dll",
+    };
+    ULONG matched[sizeof(names) / sizeof(names[0])];
+    for (ULONG i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        f.ImageName = names[i];
+        matched[i] = CheckFilter(&f, all, allCount);
+    }
+    CHECK(matched[0] > 0 && matched[1] > matched[0] && matched[2] > 0 && matched[3] > 0 && matched[6] > 0);
+    CHECK(matched[4] == 600 && matched[5] == 599 && matched[7] == 0);
+    f.ImageName = NULL;
+
+    // Session and a field range, alone and with a name
+    f.SessionId = 2;
+    ULONG session = CheckFilter(&f, all, allCount);
+    CHECK(session > 0 && session < 600);
+    f.SessionId = MRT_ANY_SESSION;
+
+    f.Field = MRT_FIELD_HANDLE_COUNT;
+    f.Min = 500;
+    f.Max = 1000;
+    ULONG handles = CheckFilter(&f, all, allCount);
+    CHECK(handles > 0 && handles < 600);
+    f.Field = MRT_FIELD_CONTEXT_SWITCHES;
+    f.Min = 100000;
+    f.Max = 200000;
+    CHECK(CheckFilter(&f, all, allCount) > 0);
+    f.Min = f.Max = MrtTInfo_GetProcessField(&all[7], MRT_FIELD_CONTEXT_SWITCHES);
+    CHECK(CheckFilter(&f, all, allCount) >= 1);     // bounds are inclusive
+
+    f.Field = MRT_FIELD_HANDLE_COUNT;
+    f.Min = 500;
+    f.Max = 1000;
+    f.SessionId = 1;
+    f.ImageName = L"*S*";
+    ULONG combined = CheckFilter(&f, all, allCount);
+    CHECK(combined > 0 && combined < handles);
+
+    MrtTInfo_FilterInit(&f);
+    f.Min = 2;
+    f.Max = 1;
+    MRT_PROCESS_INFO* none = NULL;
+    ULONG noneCount = 0;
+    CHECK(MrtTInfo_GetProcessesFiltered(&f, MRT_QUERY_COUNTERS, &none, &noneCount) == STATUS_INVALID_PARAMETER);
+
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+    MrtTInfo_FreeProcesses(all, allCount);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Aggregation and top-N
+// -----------------------------
+// Group key of one record the slow way; names fold with towlower
+static BOOL CheckSameGroup(MRT_GROUP_BY groupBy, const MRT_GROUP* g, ULONGLONG key, const UNICODE_STRING* name)
+{
+    if (groupBy != MRT_GROUP_IMAGE_NAME)
+        return g->Key == key;
+    if (g->Name.Length != name->Length)
+        return FALSE;
+    for (ULONG i = 0; i < name->Length / sizeof(WCHAR); i++) {
+        if (towlower((wint_t)g->Name.Buffer[i]) != towlower((wint_t)name->Buffer[i]))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void CheckGroupAdd(MRT_GROUP* groups, ULONG* count, MRT_GROUP_BY groupBy, ULONGLONG key,
+                          const UNICODE_STRING* name, ULONGLONG value)
+{
+    ULONG g = 0;
+    while (g < *count && !CheckSameGroup(groupBy, &groups[g], key, name))
+        g++;
+    if (g == *count) {
+        memset(&groups[g], 0, sizeof(groups[g]));
+        groups[g].Key = key;
+        if (groupBy == MRT_GROUP_IMAGE_NAME)
+            groups[g].Name = *name;
+        groups[g].Min = value;
+        groups[g].Max = value;
+        (*count)++;
+    }
+    groups[g].Count++;
+    groups[g].Sum += value;
+    if (value < groups[g].Min)
+        groups[g].Min = value;
+    if (value > groups[g].Max)
+        groups[g].Max = value;
+}
+
+// Aggregate against a linear scan over every record; returns the group count
+static ULONG CheckAggregate(const MRT_PROCESS_INFO* procs, ULONG count, MRT_GROUP_BY groupBy, BOOL threads,
+                            MRT_PROCESS_FIELD processField, MRT_THREAD_FIELD threadField)
+{
+    ULONG records = count;
+    for (ULONG i = 0; i < count; i++)
+        records += procs[i].ThreadCount;
+    MRT_GROUP* expected = (MRT_GROUP*)malloc(records * sizeof(MRT_GROUP));
+    if (!expected) {
+        CHECK(!"out of memory");
+        return 0;
+    }
+
+    ULONG expectedCount = 0;
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* p = &procs[i];
+        ULONGLONG key = groupBy == MRT_GROUP_SESSION ? p->SessionId :
+                        groupBy == MRT_GROUP_PARENT_PID ? p->ParentPID : 0;
+        if (!threads) {
+            CheckGroupAdd(expected, &expectedCount, groupBy, key, &p->ImageName,
+                          MrtTInfo_GetProcessField(p, processField));
+            continue;
+        }
+        for (ULONG t = 0; p->Threads && t < p->ThreadCount; t++) {
+            const MRT_THREAD_INFO* mt = &p->Threads[t];
+            if (groupBy == MRT_GROUP_THREAD_STATE)
+                key = (ULONG)mt->ThreadState < MRT_STATE_BUCKETS ? (ULONG)mt->ThreadState : MRT_STATE_BUCKETS - 1;
+            CheckGroupAdd(expected, &expectedCount, groupBy, key, &p->ImageName,
+                          MrtTInfo_GetThreadField(mt, threadField));
+        }
+    }
+
+    MRT_AGGREGATE_SPEC spec = { groupBy, (BOOLEAN)threads, processField, threadField };
+    MRT_AGGREGATE* result = NULL;
+    CHECK(MrtTInfo_Aggregate(procs, count, &spec, &result) == STATUS_SUCCESS);
+    BOOL same = result && result->GroupCount == expectedCount;
+    for (ULONG g = 0; same && g < expectedCount; g++) {
+        const MRT_GROUP* a = &result->Groups[g];
+        const MRT_GROUP* e = &expected[g];
+        same = a->Key == e->Key && a->Count == e->Count && a->Sum == e->Sum &&
+               a->Min == e->Min && a->Max == e->Max &&
+               a->Name.Buffer == e->Name.Buffer && a->Name.Length == e->Name.Length;
+    }
+    CHECK(same);
+
+    MrtTInfo_FreeAggregate(result);
+    free(expected);
+    return expectedCount;
+}
+
+// Largest value first, ties by process then thread position
+static int CheckTopCompare(const void* a, const void* b)
+{
+    const MRT_TOP_ENTRY* x = (const MRT_TOP_ENTRY*)a;
+    const MRT_TOP_ENTRY* y = (const MRT_TOP_ENTRY*)b;
+    if (x->Value != y->Value)
+        return x->Value > y->Value ? -1 : 1;
+    if (x->Process != y->Process)
+        return x->Process < y->Process ? -1 : 1;
+    return x->Thread < y->Thread ? -1 : x->Thread > y->Thread;
+}
+
+// Top N against every record sorted; thread is FALSE for processes
+static void CheckTop(const MRT_PROCESS_INFO* procs, ULONG count, BOOL threads, ULONG field, ULONG n)
+{
+    ULONG records = 0;
+    for (ULONG i = 0; i < count; i++)
+        records += threads ? (procs[i].Threads ? procs[i].ThreadCount : 0) : 1;
+    MRT_TOP_ENTRY* all = (MRT_TOP_ENTRY*)malloc((records + 1) * sizeof(MRT_TOP_ENTRY));
+    MRT_TOP_ENTRY* top = (MRT_TOP_ENTRY*)malloc((n + 1) * sizeof(MRT_TOP_ENTRY));
+    if (!all || !top) {
+        CHECK(!"out of memory");
+        free(all);
+        free(top);
+        return;
+    }
+
+    ULONG used = 0;
+    for (ULONG i = 0; i < count; i++) {
+        if (!threads) {
+            MRT_TOP_ENTRY e = { (LONGLONG)MrtTInfo_GetProcessField(&procs[i], (MRT_PROCESS_FIELD)field), i, MRT_DIFF_NONE };
+            all[used++] = e;
+            continue;
+        }
+        for (ULONG t = 0; procs[i].Threads && t < procs[i].ThreadCount; t++) {
+            MRT_TOP_ENTRY e = { (LONGLONG)MrtTInfo_GetThreadField(&procs[i].Threads[t], (MRT_THREAD_FIELD)field), i, t };
+            all[used++] = e;
+        }
+    }
+    qsort(all, used, sizeof(MRT_TOP_ENTRY), CheckTopCompare);
+
+    ULONG filled = threads
+        ? MrtTInfo_TopThreads(procs, count, (MRT_THREAD_FIELD)field, n, top)
+        : MrtTInfo_TopProcesses(procs, count, (MRT_PROCESS_FIELD)field, n, top);
+    CHECK(filled == (n < used ? n : used));
+    CHECK(memcmp(top, all, filled * sizeof(MRT_TOP_ENTRY)) == 0);
+    free(all);
+    free(top);
+}
+
+static void CheckAggregates(void)
+{
+    void* raw = NULL;
+    ULONG rawLength = 0;
+    MRT_PROCESS_INFO* generated = NULL;
+    ULONG count = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(200, 5, 17, &raw, &rawLength))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+    CHECK(MrtTInfo_SetReplayBuffer(raw, rawLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_GetAllProcesses(&generated, &count) == STATUS_SUCCESS);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+
+    // Record copies to bend: threadless processes (no array, or an empty
+    // one), raw states past the bucket table, a name differing only in case
+    MRT_PROCESS_INFO* procs = (MRT_PROCESS_INFO*)malloc((count + 1) * sizeof(MRT_PROCESS_INFO));
+    if (!procs || count != 200) {
+        CHECK(!"aggregate setup");
+        goto done;
+    }
+    memcpy(procs, generated, count * sizeof(MRT_PROCESS_INFO));
+    procs[3].Threads = NULL;
+    procs[3].ThreadCount = 0;
+    procs[4].ThreadCount = 0;
+    procs[count - 1].Threads = NULL;
+    procs[10].Threads[0].ThreadState = (MRT_THREAD_STATE)(MRT_STATE_BUCKETS - 1);
+    procs[11].Threads[1].ThreadState = (MRT_THREAD_STATE)MRT_STATE_BUCKETS;
+    procs[12].Threads[2].ThreadState = (MRT_THREAD_STATE)200;
+
+    static WCHAR upper[64];
+    ULONG units = procs[20].ImageName.Length / sizeof(WCHAR);
+    for (ULONG i = 0; i < units && i < 64; i++)
+        upper[i] = (WCHAR)towupper((wint_t)procs[20].ImageName.Buffer[i]);
+    procs[30].ImageName.Buffer = upper;
+    procs[30].ImageName.Length = procs[20].ImageName.Length;
+
+    static const MRT_GROUP_BY byProcess[] = {
+        MRT_GROUP_ALL, MRT_GROUP_IMAGE_NAME, MRT_GROUP_SESSION, MRT_GROUP_PARENT_PID,
+    };
+    for (ULONG i = 0; i < sizeof(byProcess) / sizeof(byProcess[0]); i++) {
+        CheckAggregate(procs, count, byProcess[i], FALSE, MRT_FIELD_HANDLE_COUNT, MRT_THREAD_FIELD_NONE);
+        CheckAggregate(procs, count, byProcess[i], FALSE, MRT_FIELD_NONE, MRT_THREAD_FIELD_NONE);
+        CheckAggregate(procs, count, byProcess[i], TRUE, MRT_FIELD_NONE, MRT_THREAD_FIELD_CPU_TIME);
+    }
+    ULONG states = CheckAggregate(procs, count, MRT_GROUP_THREAD_STATE, TRUE, MRT_FIELD_NONE, MRT_THREAD_FIELD_CONTEXT_SWITCHES);
+    CHECK(states == 4);     // waiting, ready, running, and 31 with the states past it
+    CHECK(CheckAggregate(procs, count, MRT_GROUP_ALL, TRUE, MRT_FIELD_NONE, MRT_THREAD_FIELD_PRIORITY) == 1);
+    CHECK(CheckAggregate(procs, 0, MRT_GROUP_ALL, FALSE, MRT_FIELD_NONE, MRT_THREAD_FIELD_NONE) == 0);
+    CHECK(CheckAggregate(procs + 3, 2, MRT_GROUP_SESSION, TRUE, MRT_FIELD_NONE, MRT_THREAD_FIELD_NONE) == 0);
+
+    MRT_AGGREGATE_SPEC invalid = { MRT_GROUP_THREAD_STATE, FALSE, MRT_FIELD_NONE, MRT_THREAD_FIELD_NONE };
+    MRT_AGGREGATE* result = NULL;
+    CHECK(MrtTInfo_Aggregate(procs, count, &invalid, &result) == STATUS_INVALID_PARAMETER && result == NULL);
+
+    // Top-N: distinct values, values with many ties (priorities, thread
+    // counts) and one big tie (base priority); N below, at and past the records
+    static const ULONG ns[] = { 1, 7, 64, 995, 2000 };
+    for (ULONG i = 0; i < sizeof(ns) / sizeof(ns[0]); i++) {
+        CheckTop(procs, count, TRUE, MRT_THREAD_FIELD_CPU_TIME, ns[i]);
+        CheckTop(procs, count, TRUE, MRT_THREAD_FIELD_PRIORITY, ns[i]);
+        CheckTop(procs, count, TRUE, MRT_THREAD_FIELD_BASE_PRIORITY, ns[i]);
+        CheckTop(procs, count, FALSE, MRT_FIELD_WORKING_SET, ns[i]);
+        CheckTop(procs, count, FALSE, MRT_FIELD_THREAD_COUNT, ns[i]);
+    }
+
+done:
+    free(procs);
+    MrtTInfo_FreeProcesses(generated, count);
+    MrtTInfo_FreeRawBuffer(raw);
+}
+
+// -----------------------------
+// Process tree
+// -----------------------------
+static void CheckTree(void)
+{
+    // PID, parent PID, creation time; handle counts 10, 20, ... by position
+    static const struct { DWORD Pid, Parent; ULONGLONG Created; } shape[] = {
+        {    4,    0,  100 },   //  0 root: parent not in the snapshot
+        {  100,    4,  200 },   //  1 under 0
+        {  200,  100,  300 },   //  2 under 1
+        {  300,  300,  400 },   //  3 root: its own parent
+        {  400,  500,  500 },   //  4 root: closes the 2-cycle with 5 (same time)
+        {  500,  400,  500 },   //  5 under 4
+        {  600,  700,  600 },   //  6 root: PID 700 was reused by a younger process
+        {  700,    4,  900 },   //  7 under 0
+        {  800, 9999, 1000 },   //  8 root: orphan
+        {  900,  600, 1100 },   //  9 under 6
+        { 1000,  200,    0 },   // 10 under 2: an unknown time does not veto
+        {  200,    4, 1200 },   // 11 under 0; the first PID 200 wins lookups
+    };
+    enum { COUNT = sizeof(shape) / sizeof(shape[0]) };
+    static const ULONG parents[COUNT] = {
+        MRT_TREE_NONE, 0, 1, MRT_TREE_NONE, MRT_TREE_NONE, 4, MRT_TREE_NONE, 0, MRT_TREE_NONE, 6, 2, 0,
+    };
+    static const ULONG order[COUNT] = { 0, 1, 2, 10, 7, 11, 3, 4, 5, 6, 9, 8 };
+    static const ULONGLONG totals[COUNT][2] = {
+        { 6, 370 }, { 3, 160 }, { 2, 140 }, { 1, 40 }, { 2, 110 }, { 1, 60 },
+        { 2, 170 }, { 1, 80 }, { 1, 90 }, { 1, 100 }, { 1, 110 }, { 1, 120 },
+    };
+
+    MRT_PROCESS_INFO procs[COUNT];
+    for (ULONG i = 0; i < COUNT; i++) {
+        procs[i] = CheckProcess(shape[i].Pid, shape[i].Created, NULL, 0);
+        procs[i].ParentPID = shape[i].Parent;
+        procs[i].HandleCount = (i + 1) * 10;
+    }
+
+    MRT_PROCESS_TREE* tree = NULL;
+    CHECK(MrtTInfo_TreeBuild(procs, COUNT, &tree) == STATUS_SUCCESS);
+    if (!tree)
+        return;
+    CHECK(tree->RootCount == 5);
+    CHECK(memcmp(tree->Parent, parents, sizeof(parents)) == 0);
+    CHECK(memcmp(tree->Order, order, sizeof(order)) == 0);
+    BOOL positions = TRUE;
+    for (ULONG i = 0; i < COUNT; i++)
+        positions = positions && tree->Order[tree->Position[i]] == i && tree->Subtree[i] == totals[i][0];
+    CHECK(positions);
+    CHECK(MrtTInfo_TreeFind(tree, 200) == 2 && MrtTInfo_TreeFind(tree, 9999) == MRT_TREE_NONE);
+
+    const ULONG* descendants = NULL;
+    CHECK(MrtTInfo_TreeDescendants(tree, 4, &descendants) == 5 && descendants &&
+          memcmp(descendants, &order[1], 5 * sizeof(ULONG)) == 0);
+    CHECK(MrtTInfo_TreeDescendants(tree, 400, &descendants) == 1 && descendants && descendants[0] == 5);
+    CHECK(MrtTInfo_TreeDescendants(tree, 500, &descendants) == 0 && descendants == NULL);
+    CHECK(MrtTInfo_TreeDescendants(tree, 600, &descendants) == 1 && descendants && descendants[0] == 9);
+    CHECK(MrtTInfo_TreeDescendants(tree, 700, &descendants) == 0);
+    CHECK(MrtTInfo_TreeDescendants(tree, 300, &descendants) == 0);
+    CHECK(MrtTInfo_TreeDescendants(tree, 200, &descendants) == 1 && descendants && descendants[0] == 10);
+    CHECK(MrtTInfo_TreeDescendants(tree, 9999, &descendants) == 0 && descendants == NULL);
+
+    static const MRT_PROCESS_FIELD fields[] = { MRT_FIELD_NONE, MRT_FIELD_HANDLE_COUNT };
+    ULONGLONG rollup[COUNT][2];
+    CHECK(MrtTInfo_TreeRollup(tree, fields, 2, &rollup[0][0]) == STATUS_SUCCESS);
+    CHECK(memcmp(rollup, totals, sizeof(totals)) == 0);
+    static const MRT_PROCESS_FIELD invalid[] = { MRT_FIELD_COUNT };
+    CHECK(MrtTInfo_TreeRollup(tree, invalid, 1, &rollup[0][0]) == STATUS_INVALID_PARAMETER);
+    MrtTInfo_TreeFree(tree);
+
+    // The 2-cycle listed the other way round: the first walk's start becomes the root
+    MRT_PROCESS_INFO swapped[2] = { procs[5], procs[4] };
+    CHECK(MrtTInfo_TreeBuild(swapped, 2, &tree) == STATUS_SUCCESS);
+    CHECK(tree && tree->RootCount == 1 && tree->Parent[0] == MRT_TREE_NONE && tree->Parent[1] == 0);
+    MrtTInfo_TreeFree(tree);
+
+    CHECK(MrtTInfo_TreeBuild(NULL, 0, &tree) == STATUS_SUCCESS);
+    CHECK(tree && tree->RootCount == 0 && MrtTInfo_TreeDescendants(tree, 4, &descendants) == 0);
+    MrtTInfo_TreeFree(tree);
+}
+
+// -----------------------------
+// Text export
+// -----------------------------
+#define CHECK_EXPORT_PATH   "MrtTInfoCheck.export"
+#define CHECK_CSV_COLUMNS   20
+#define CHECK_CSV_FIELD     96
+
+// One CSV record from *p, quotes undone; fields past the columns are only counted
+static ULONG CheckCsvRecord(const char** p, const char* end, char fields[CHECK_CSV_COLUMNS][CHECK_CSV_FIELD])
+{
+    ULONG count = 0;
+    for (;;) {
+        char* out = count < CHECK_CSV_COLUMNS ? fields[count] : NULL;
+        SIZE_T n = 0;
+        BOOL quoted = *p < end && **p == '"';
+        if (quoted)
+            (*p)++;
+        while (*p < end) {
+            char c = **p;
+            if (quoted && c == '"') {
+                if (*p + 1 < end && (*p)[1] == '"') {
+                    (*p)++;
+                } else {
+                    quoted = FALSE;
+                    (*p)++;
+                    continue;
+                }
+            } else if (!quoted && (c == ',' || c == '\n')) {
+                break;
+            }
+            if (out && n + 1 < CHECK_CSV_FIELD)
+                out[n++] = c;
+            (*p)++;
+        }
+        if (out)
+            out[n] = '\0';
+        count++;
+        if (*p >= end || **p == '\n') {
+            if (*p < end)
+                (*p)++;
+            return count;
+        }
+        (*p)++;
+    }
+}
+
+static BOOL CheckCsvNumber(const char* field, ULONGLONG value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    return strcmp(field, text) == 0;
+}
+
+// Every record has the header's columns, and the columns hold the right fields
+static BOOL CheckCsvColumns(const char* data, SIZE_T size, const MRT_PROCESS_INFO* procs, ULONG count)
+{
+    static char fields[CHECK_CSV_COLUMNS][CHECK_CSV_FIELD];
+    const char* p = data;
+    const char* end = data + size;
+    if (CheckCsvRecord(&p, end, fields) != CHECK_CSV_COLUMNS ||
+        strcmp(fields[0], "kind") != 0 || strcmp(fields[2], "tid") != 0 || strcmp(fields[4], "name") != 0 ||
+        strcmp(fields[15], "state") != 0 || strcmp(fields[19], "command_line") != 0)
+        return FALSE;
+
+    for (ULONG i = 0; i < count; i++) {
+        const MRT_PROCESS_INFO* proc = &procs[i];
+        if (CheckCsvRecord(&p, end, fields) != CHECK_CSV_COLUMNS || strcmp(fields[0], "process") != 0 ||
+            !CheckCsvNumber(fields[1], proc->PID) || fields[2][0] || !CheckCsvNumber(fields[3], proc->ParentPID) ||
+            !CheckCsvNumber(fields[5], proc->ThreadCount) || !CheckCsvNumber(fields[6], proc->HandleCount) ||
+            !CheckCsvNumber(fields[8], proc->WorkingSetSize) || fields[13][0] || fields[15][0])
+            return FALSE;
+        for (ULONG t = 0; t < proc->ThreadCount; t++) {
+            const MRT_THREAD_INFO* th = &proc->Threads[t];
+            if (CheckCsvRecord(&p, end, fields) != CHECK_CSV_COLUMNS || strcmp(fields[0], "thread") != 0 ||
+                !CheckCsvNumber(fields[1], proc->PID) || !CheckCsvNumber(fields[2], th->TID) || fields[4][0] ||
+                !CheckCsvNumber(fields[10], MrtFileTimeToU64(&th->CreateTime)) ||
+                strcmp(fields[15], MrtHelper_ThreadStateToString(th->ThreadState)) != 0 ||
+                strcmp(fields[16], MrtHelper_WaitReasonToString(th->WaitReason)) != 0 ||
+                !CheckCsvNumber(fields[17], th->ContextSwitches) || fields[19][0])
+                return FALSE;
+        }
+    }
+    return p == end;
+}
+
+static BOOL CheckContains(const char* data, SIZE_T size, const char* text)
+{
+    SIZE_T n = strlen(text);
+    for (SIZE_T i = 0; n <= size && i <= size - n; i++) {
+        if (memcmp(data + i, text, n) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+// Encode into a buffer of capacity bytes: too small, the exact size, and
+// only the whole rows that fit, the rest of the buffer untouched
+static void CheckExportShort(const MRT_PROCESS_INFO* procs, ULONG count, MRT_EXPORT_FORMAT format,
+                             const char* full, SIZE_T size, SIZE_T capacity)
+{
+    char* buffer = (char*)malloc(capacity + 1);
+    if (!buffer) {
+        CHECK(!"out of memory");
+        return;
+    }
+    memset(buffer, 0x5A, capacity + 1);
+
+    SIZE_T needed = 0;
+    CHECK(MrtTInfo_ExportEncode(procs, count, format, buffer, capacity, &needed) == STATUS_BUFFER_TOO_SMALL);
+    CHECK(needed == size);
+
+    SIZE_T rows = 0;
+    for (SIZE_T i = 0; i < capacity; i++) {
+        if (full[i] == '\n')
+            rows = i + 1;
+    }
+    BOOL untouched = TRUE;
+    for (SIZE_T i = rows; i <= capacity; i++)
+        untouched = untouched && buffer[i] == 0x5A;
+    CHECK(memcmp(buffer, full, rows) == 0 && untouched);
+    free(buffer);
+}
+
+// The same bytes from all three sinks, and Encode's sizing around them
+static void CheckExportSinks(const MRT_PROCESS_INFO* procs, ULONG count, MRT_EXPORT_FORMAT format,
+                             const char* expectedTail)
+{
+    SIZE_T size = 0;
+    CHECK(MrtTInfo_ExportEncode(procs, count, format, NULL, 0, &size) == STATUS_BUFFER_TOO_SMALL);
+    char* encoded = (char*)malloc(size + 1);
+    if (!encoded) {
+        CHECK(!"out of memory");
+        return;
+    }
+    SIZE_T written = 0;
+    CHECK(MrtTInfo_ExportEncode(procs, count, format, encoded, size, &written) == STATUS_SUCCESS);
+    CHECK(written == size);
+    encoded[size] = '\0';
+
+    // The hand-built rows come last
+    SIZE_T tail = strlen(expectedTail);
+    CHECK(size >= tail && memcmp(encoded + size - tail, expectedTail, tail) == 0);
+
+    // Appending after existing content grows the buffer past several chunks
+    MRT_EXPORT_BUFFER grown;
+    memset(&grown, 0, sizeof(grown));
+    CHECK(MrtTInfo_ExportAppend(procs, 0, format, &grown) == STATUS_SUCCESS);
+    SIZE_T header = grown.Length;
+    CHECK(MrtTInfo_ExportAppend(procs, count, format, &grown) == STATUS_SUCCESS);
+    CHECK(grown.Length == header + size && memcmp(grown.Data + header, encoded, size) == 0);
+    MrtTInfo_ExportBufferFree(&grown);
+
+    FILE* f = fopen(CHECK_EXPORT_PATH, "wb");
+    CHECK(f != NULL);
+    if (f) {
+        CHECK(MrtTInfo_ExportToFd(procs, count, format, fileno(f)) == STATUS_SUCCESS);
+        fclose(f);
+        SIZE_T streamedSize = 0;
+        BYTE* streamed = CheckReadBytes(CHECK_EXPORT_PATH, &streamedSize);
+        CHECK(streamed && streamedSize == size && memcmp(streamed, encoded, size) == 0);
+        free(streamed);
+    }
+
+    // Short by one byte (the last row), inside the first rows, and empty
+    CheckExportShort(procs, count, format, encoded, size, size - 1);
+    CheckExportShort(procs, count, format, encoded, size, size / 3);
+    CheckExportShort(procs, count, format, encoded, size, 3);
+
+    if (format == MRT_EXPORT_CSV) {
+        CHECK(CheckCsvColumns(encoded, size, procs, count));
+    } else {
+        ULONG rows = 0;
+        for (SIZE_T i = 0; i < size; i++)
+            rows += encoded[i] == '\n';
+        ULONG records = count;
+        for (ULONG i = 0; i < count; i++)
+            records += procs[i].ThreadCount;
+        CHECK(rows == records && encoded[0] == '{');
+    }
+    free(encoded);
+}
+
+static void CheckExport(void)
+{
+    void* raw = NULL;
+    ULONG rawLength = 0;
+    MRT_PROCESS_INFO* generated = NULL;
+    ULONG generatedCount = 0;
+    if (!NT_SUCCESS(MrtTInfo_GenerateRawBuffer(300, 20, 5, &raw, &rawLength))) {
+        CHECK(!"GenerateRawBuffer");
+        return;
+    }
+    CHECK(MrtTInfo_SetReplayBuffer(raw, rawLength) == STATUS_SUCCESS);
+    CHECK(MrtTInfo_GetAllProcesses(&generated, &generatedCount) == STATUS_SUCCESS);
+    MrtTInfo_SetReplayBuffer(NULL, 0);
+
+    MRT_PROCESS_INFO* procs = (MRT_PROCESS_INFO*)malloc((generatedCount + 1) * sizeof(MRT_PROCESS_INFO));
+    if (!procs || !generated) {
+        CHECK(!"out of memory");
+        goto done;
+    }
+    memcpy(procs, generated, generatedCount * sizeof(MRT_PROCESS_INFO));
+
+    // Last: quote, comma, backslash, control characters, two- and three-byte
+    // UTF-8, a surrogate pair and an unpaired surrogate
+    static const WCHAR name[] = {
+        'q', '"', 'a', ',', 'b', '\\', 0x01, '\t', '\n', 0xE9, 0x20AC, 0xD83D, 0xDE00, 0xD800, 'z'
+    };
+    static WCHAR commandLine[] = L"run \"x\"";
+    MRT_THREAD_INFO thread;
+    memset(&thread, 0, sizeof(thread));
+    thread.TID = 4243;
+    thread.ParentPID = 4242;
+    thread.CreateTime.dwLowDateTime = 1000;
+    thread.UserTime.QuadPart = 30;
+    thread.KernelTime.QuadPart = 40;
+    thread.Priority = -2;
+    thread.BasePriority = 8;
+    thread.ThreadState = 5;
+    thread.WaitReason = 11;
+    thread.ContextSwitches = 77;
+    thread.StartAddress = (PVOID)(ULONG_PTR)0x1234ABCD;
+
+    MRT_PROCESS_INFO* special = &procs[generatedCount];
+    memset(special, 0, sizeof(*special));
+    special->PID = 4242;
+    special->ParentPID = 7;
+    special->ImageName.Buffer = (PWSTR)name;
+    special->ImageName.Length = (USHORT)sizeof(name);
+    special->ImageName.MaximumLength = (USHORT)sizeof(name);
+    special->ThreadCount = 1;
+    special->Threads = &thread;
+    special->HandleCount = 10;
+    special->SessionId = 2;
+    special->WorkingSetSize = 4096;
+    special->PrivatePageCount = 2048;
+    special->CreateTime.dwLowDateTime = 900;
+    special->UserTime.QuadPart = 5;
+    special->KernelTime.QuadPart = -6;
+    special->BasePriority = 8;
+    special->PebCommandLine = commandLine;
+
+    static const char csvTail[] =
+        "process,4242,,7,\"q\"\"a,b\\\x01\t\n\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xEF\xBF\xBDz\","
+        "1,10,2,4096,2048,900,5,-6,,8,,,,,\"run \"\"x\"\"\"\n"
+        "thread,4242,4243,,,,,,,,1000,30,40,-2,8,Waiting,WrDelayExecution,77,0x1234abcd,\n";
+    static const char jsonTail[] =
+        "{\"kind\":\"process\",\"pid\":4242,\"ppid\":7,"
+        "\"name\":\"q\\\"a,b\\\\\\u0001\\t\\n\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\xEF\xBF\xBDz\","
+        "\"threads\":1,\"handles\":10,\"session\":2,\"working_set\":4096,\"private_bytes\":2048,"
+        "\"create_time\":900,\"user_time\":5,\"kernel_time\":-6,\"base_priority\":8,"
+        "\"command_line\":\"run \\\"x\\\"\"}\n"
+        "{\"kind\":\"thread\",\"pid\":4242,\"tid\":4243,\"create_time\":1000,\"user_time\":30,"
+        "\"kernel_time\":40,\"priority\":-2,\"base_priority\":8,\"state\":\"Waiting\","
+        "\"wait_reason\":\"WrDelayExecution\",\"context_switches\":77,\"start_address\":\"0x1234abcd\"}\n";
+
+    CheckExportSinks(procs, generatedCount + 1, MRT_EXPORT_CSV, csvTail);
+    CheckExportSinks(procs, generatedCount + 1, MRT_EXPORT_NDJSON, jsonTail);
+
+    // Header only, and nothing at all
+    SIZE_T size = 0;
+    char header[256];
+    CHECK(MrtTInfo_ExportEncode(NULL, 0, MRT_EXPORT_CSV, header, sizeof(header), &size) == STATUS_SUCCESS);
+    CHECK(size > 0 && size < sizeof(header) && CheckContains(header, size, "context_switches,start_address,command_line\n"));
+    CHECK(MrtTInfo_ExportEncode(NULL, 0, MRT_EXPORT_NDJSON, header, sizeof(header), &size) == STATUS_SUCCESS);
+    CHECK(size == 0);
+    CHECK(MrtTInfo_ExportEncode(procs, 1, (MRT_EXPORT_FORMAT)7, header, sizeof(header), &size) == STATUS_INVALID_PARAMETER);
+
+done:
+    free(procs);
+    MrtTInfo_FreeProcesses(generated, generatedCount);
+    MrtTInfo_FreeRawBuffer(raw);
+    remove(CHECK_EXPORT_PATH);
+}
+
+int main(void)
+{
+    wprintf(L"[MrtTInfo Check]\n");
+
+    wprintf(L"Remote TEB/PEB parsing\n");
+    CheckRemote();
+
+    wprintf(L"Malformed raw buffers\n");
+    CheckCursor();
+
+    wprintf(L"Snapshot files and raw recordings\n");
+    CheckSnapshots(1, 1);
+    CheckSnapshots(40, 6);
+
+    wprintf(L"Serial vs parallel conversion, worker pool chunks\n");
+    // Threads below, at and off a multiple of MRT_ENRICH_CHUNK
+    CheckParallel(1, 1, 4);
+    CheckParallel(1, MRT_ENRICH_CHUNK, 4);
+    CheckParallel(5, MRT_ENRICH_CHUNK + 1, 4);
+    CheckParallel(300, 20, 0);
+
+    MRT_WORKER_POOL* pool = MrtPool_Create(3);
+    CHECK(pool != NULL);
+    static const ULONG items[] = { 1, 31, 32, 33, 64, 100, 1000 };
+    for (ULONG i = 0; i < sizeof(items) / sizeof(items[0]); i++) {
+        CheckPool(pool, items[i], MRT_ENRICH_CHUNK);
+        CheckPool(NULL, items[i], MRT_ENRICH_CHUNK);
+    }
+    CheckPool(pool, 10, 1);
+    MrtPool_Destroy(pool);
+
+    wprintf(L"Thread states and contention\n");
+    CheckStates();
+
+    wprintf(L"Snapshot diff\n");
+    CheckDiff();
+
+    wprintf(L"Sampler\n");
+    CheckSampler();
+
+    wprintf(L"Process filter\n");
+    CheckFilters();
+
+    wprintf(L"Aggregation and top-N\n");
+    CheckAggregates();
+
+    wprintf(L"Process tree\n");
+    CheckTree();
+
+    wprintf(L"Text export\n");
+    CheckExport();
+
+    wprintf(L"%lu checks, %lu failed\n", g_Checks, g_Failures);
+    return g_Failures ? 1 : 0;
+}
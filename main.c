@@ -63,13 +63,10 @@ int main(void)
             }
 
             if (th->PebLdr) {
-                PEB_LDR_DATA* ldr = (PEB_LDR_DATA*)th->PebLdr;
                 wprintf(L"        Ldr: %p  EntryInProgress: %p  Shutdown: %s\n",
                         th->PebLdr,
                         th->PebLdr_EntryInProgress,
                         th->ShutdownInProgress ? L"YES" : L"NO");
-                if (p->PID == GetCurrentProcessId())
-                    MrtHelper_PrintModules(ldr);
             }
 
             if (th->PebCommandLine)
@@ -103,6 +100,58 @@ int main(void)
         wprintf(L"[Lookup] Current thread not found!\n");
     }
 
+    // System-wide thread states and wait reasons
+    MRT_CONTENTION_REPORT* report = NULL;
+    if (NT_SUCCESS(MrtTInfo_ContentionReport(processes, processCount, &report))) {
+        wprintf(L"\n[Contention] %lu threads  Paging: %lu  LoaderLock: %lu\n",
+            report->System.Threads,
+            report->System.Classes[MRT_WAIT_CLASS_PAGING],
+            report->System.Classes[MRT_WAIT_CLASS_LOADER_LOCK]);
+        for (ULONG s = 0; s < MRT_STATE_BUCKETS; s++) {
+            if (report->System.States[s])
+                wprintf(L"  State %-20hs %lu\n", MrtHelper_ThreadStateToString(s), report->System.States[s]);
+        }
+        for (ULONG w = 0; w < MRT_WAIT_BUCKETS; w++) {
+            if (report->System.WaitReasons[w])
+                wprintf(L"  Wait  %-20hs %lu\n", MrtHelper_WaitReasonToString(w), report->System.WaitReasons[w]);
+        }
+        MrtTInfo_FreeContentionReport(report);
+    }
+
+    // What the snapshot above cost, by phase
+    MRT_STATS stats;
+    if (NT_SUCCESS(MrtTInfo_GetStats(&stats))) {
+        static const char* const phases[MRT_PHASE_COUNT] = {
+            "Snapshot", "Query", "Convert", "Enrich", "Remote", "Strings"
+        };
+        wprintf(L"\n[Stats] retries: %llu  buffer: %lu/%lu bytes  handles: %llu opened, %llu failed  "
+                L"calls: %llu  skipped: %llu  allocations: %llu (%llu bytes)  strings: %llu copied, %llu shared\n",
+            stats.Totals.QueryRetries, stats.QueryLength, stats.QueryBufferSize,
+            stats.Totals.HandlesOpened, stats.Totals.HandlesFailed,
+            stats.Totals.EnrichCalls, stats.Totals.EnrichSkipped,
+            stats.Totals.Allocations, stats.Totals.BytesAllocated,
+            stats.Totals.StringsCopied, stats.Totals.StringsShared);
+        for (ULONG ph = 0; ph < MRT_PHASE_COUNT; ph++) {
+            if (stats.Phases[ph].Count)
+                wprintf(L"  %-10hs %8.3f ms\n", phases[ph], stats.Phases[ph].TotalNs / 1e6);
+        }
+    }
+
+    // Modules of this process, listed once
+    MRT_MODULE_CACHE* modules = NULL;
+    if (NT_SUCCESS(MrtTInfo_ModuleCacheCreate(&modules))) {
+        const MRT_MODULE_INFO* mods = NULL;
+        ULONG modCount = 0;
+        if (NT_SUCCESS(MrtTInfo_GetModules(modules, &mods, &modCount))) {
+            wprintf(L"\n[Modules] %lu loaded\n", modCount);
+            for (ULONG m = 0; m < modCount; m++)
+                wprintf(L"  %-24.*s  Base: %p  Size: %zu  Entry: %p\n",
+                        (int)(mods[m].BaseName.Length / sizeof(WCHAR)), mods[m].BaseName.Buffer,
+                        mods[m].Base, mods[m].Size, mods[m].EntryPoint);
+        }
+        MrtTInfo_ModuleCacheDestroy(modules);
+    }
+
     MrtTInfo_FreeProcesses(processes, processCount);
     wprintf(L"\nDone.\n");
     return 0;